@@ -0,0 +1,133 @@
+/*  FrameBufferPool.cpp
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+// Pool of reference counted buffers for large array data such as camera frames.
+// Refer to FrameBufferPool.h for details.
+
+#include <FrameBufferPool.h>
+#include <QList>
+#include <QMutex>
+
+// Buffers smaller than this are not worth pooling. Small arrays (and scalars) are allocated as required.
+#define MIN_POOLED_SIZE 65536
+
+// Maximum number of idle buffers of the same size kept for reuse.
+// (Enough for a frame arriving while the previous frame is still being processed and displayed)
+#define MAX_IDLE_PER_SIZE 3
+
+// Maximum total size of idle buffers kept for reuse.
+#define MAX_IDLE_BYTES (256*1024*1024)
+
+// This mutex controls access to the pool.
+static QMutex *poolMutex = new QMutex();
+
+// Idle buffers.
+// The pool holds the only reference to each of these. Buffers in use are not referenced by the pool.
+static QList<QByteArray> pool;
+
+// Provide a new or idle buffer of the requested size.
+// The buffer returned is not referenced by any other holder (including the pool itself)
+// so it may be written without a detach (copy).
+QByteArray FrameBufferPool::getBuffer( unsigned long size )
+{
+    // Don't bother pooling small buffers
+    if( size < MIN_POOLED_SIZE )
+    {
+        return QByteArray( (int)size, '\0' );
+    }
+
+    // Reuse an idle buffer of the right size if available.
+    // The pool gives up its reference as it hands the buffer out.
+    {
+        QMutexLocker locker( poolMutex );
+        for( int i = pool.count()-1; i >= 0; i-- )
+        {
+            if( (unsigned long)(pool[i].size()) == size )
+            {
+                return pool.takeAt( i );
+            }
+        }
+    }
+
+    // No idle buffer available, create a new one
+    return QByteArray( (int)size, '\0' );
+}
+
+// Release a reference to a buffer.
+// If the reference is the last one, keep the buffer for reuse (within limits).
+// The caller's reference is cleared either way.
+void FrameBufferPool::releaseBuffer( QByteArray& buffer )
+{
+    // Only the last reference returns a buffer to the pool. Other holders still have it in use.
+    // (Note, if this is the last reference no other holder can add a reference to it concurrently)
+    unsigned long size = buffer.size();
+    if( size < MIN_POOLED_SIZE || !buffer.isDetached() )
+    {
+        buffer = QByteArray();
+        return;
+    }
+
+    QMutexLocker locker( poolMutex );
+
+    // Note how many idle buffers there are so any excess can be released.
+    // Most recently returned buffers are kept in preference to older ones.
+    int idleSameSize = 0;
+    unsigned long idleBytes = size;
+    for( int i = pool.count()-1; i >= 0; i-- )
+    {
+        unsigned long idleSize = pool[i].size();
+        if( idleSize == size )
+        {
+            idleSameSize++;
+        }
+        if( ( idleSize == size && idleSameSize >= MAX_IDLE_PER_SIZE ) ||
+            idleBytes + idleSize > MAX_IDLE_BYTES )
+        {
+            pool.removeAt( i );
+            continue;
+        }
+        idleBytes += idleSize;
+    }
+
+    // Keep the buffer (if it fits at all) and clear the caller's reference to it
+    if( size <= MAX_IDLE_BYTES )
+    {
+        pool.append( buffer );
+    }
+    buffer = QByteArray();
+}
+
+// Return the total size of idle buffers held by the pool
+unsigned long FrameBufferPool::getPooledBytes()
+{
+    QMutexLocker locker( poolMutex );
+
+    unsigned long total = 0;
+    for( int i = 0; i < pool.count(); i++ )
+    {
+        total += pool[i].size();
+    }
+    return total;
+}
@@ -0,0 +1,61 @@
+/*  FrameBufferPool.h
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+// Large array data, such as camera frames, used to be copied several times on its
+// way from a CA callback to a consumer such as the QEImage image processor.
+// Buffer lifetime was also managed implicitly by relying on Qt::DirectConnection
+// signal/slot connections.
+//
+// This pool provides reference counted buffers (QByteArray) for large arrays.
+// A buffer is written once (for example, by the CA callback), then shared (not copied)
+// by each holder, for example, a CaRecord copy, a QCaObject data signal, the image
+// processor and the image processing thread.
+// A buffer's lifetime is explicit: it remains in use while any holder references it.
+//
+// The pool only holds idle buffers. A buffer handed out by getBuffer() is not referenced
+// by the pool, so the requester may write to it (through data()) without a detach (copy).
+// A holder that is finished with a buffer returns it with releaseBuffer(). If that holder
+// holds the last reference, the buffer becomes idle and will be reused for the next request
+// of the same size, avoiding an allocation (and the page faulting of fresh memory) for every
+// frame. If not, only the holder's reference is released. A buffer whose last reference is
+// released other than through releaseBuffer() is simply freed.
+//
+// Note, as a buffer is shared, it must only be written by the holder that requested it,
+// before it passes the buffer on.
+
+#ifndef FRAMEBUFFERPOOL_H_
+#define FRAMEBUFFERPOOL_H_
+
+#include <QByteArray>
+
+class FrameBufferPool
+{
+public:
+    static QByteArray getBuffer( unsigned long size );  // Provide a new or idle buffer of the requested size. Content is undefined.
+    static void releaseBuffer( QByteArray& buffer );    // Release a reference to a buffer. The buffer is kept for reuse if this was the last reference. The reference is cleared.
+    static unsigned long getPooledBytes();              // Return the total size of idle buffers held by the pool - diagnostic only
+};
+
+#endif  // FRAMEBUFFERPOOL_H_
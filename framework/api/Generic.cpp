@@ -26,6 +26,7 @@
 // Provides a generic holder for different types.
 
 #include <Generic.h>
+#include <FrameBufferPool.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -150,6 +151,9 @@ Generic::~Generic() {
     Copy constructor for deep copy
 */
 Generic::Generic( Generic &param ) {
+    value = NULL;
+    arrayCount = 0;
+    type = generic::GENERIC_UNKNOWN;
     cloneValue( &param );
 }
 
@@ -182,7 +186,7 @@ void Generic::setShort( short newValue ) {
 */
 void Generic::setShort( short* newValueArray, unsigned long arrayCountIn ) {
     deleteValue();
-    value = new short[arrayCountIn];
+    value = allocateValue( sizeof(short)*arrayCountIn );
     if( newValueArray )
     {
         memcpy( value, newValueArray, sizeof(short)*arrayCountIn );
@@ -195,6 +199,7 @@ void Generic::updateShort( short newValue, unsigned long arrayIndex ) {
     if( arrayIndex >= arrayCount )
         return;
 
+    detachValue();
     short* valueArray = (short*)value;
     valueArray[arrayIndex] = newValue;
 }
@@ -211,7 +216,7 @@ void Generic::setUnsignedShort( unsigned short newValue ) {
 */
 void Generic::setUnsignedShort( unsigned short* newValueArray, unsigned long arrayCountIn ) {
     deleteValue();
-    value = new unsigned short[arrayCountIn];
+    value = allocateValue( sizeof(unsigned short)*arrayCountIn );
     if( newValueArray )
     {
         memcpy( value, newValueArray, sizeof(unsigned short)*arrayCountIn );
@@ -224,6 +229,7 @@ void Generic::updateUnsignedShort( unsigned short newValue, unsigned long arrayI
     if( arrayIndex >= arrayCount )
         return;
 
+    detachValue();
     unsigned short* valueArray = (unsigned short*)value;
     valueArray[arrayIndex] = newValue;
 }
@@ -240,7 +246,7 @@ void Generic::setUnsignedChar( unsigned char newValue ) {
 */
 void Generic::setUnsignedChar( unsigned char* newValueArray, unsigned long arrayCountIn ) {
     deleteValue();
-    value = new unsigned char[arrayCountIn];
+    value = allocateValue( sizeof(unsigned char)*arrayCountIn );
     if( newValueArray )
     {
         memcpy( value, newValueArray, sizeof(unsigned char)*arrayCountIn );
@@ -253,6 +259,7 @@ void Generic::updateUnsignedChar( unsigned char newValue, unsigned long arrayInd
     if( arrayIndex >= arrayCount )
         return;
 
+    detachValue();
     unsigned char* valueArray = (unsigned char*)value;
     valueArray[arrayIndex] = newValue;
 }
@@ -269,7 +276,7 @@ void Generic::setLong( qint32 newValue ) {
 */
 void Generic::setLong( qint32* newValueArray, unsigned long arrayCountIn ) {
     deleteValue();
-    value = new qint32[arrayCountIn];
+    value = allocateValue( sizeof(qint32)*arrayCountIn );
     if( newValueArray )
     {
         memcpy( value, newValueArray, sizeof(qint32)*arrayCountIn );
@@ -282,6 +289,7 @@ void Generic::updateLong( qint32 newValue, unsigned long arrayIndex ) {
     if( arrayIndex >= arrayCount )
         return;
 
+    detachValue();
     qint32* valueArray = (qint32*)value;
     valueArray[arrayIndex] = newValue;
 }
@@ -298,7 +306,7 @@ void Generic::setUnsignedLong( quint32 newValue ) {
 */
 void Generic::setUnsignedLong( quint32* newValueArray, unsigned long arrayCountIn ) {
     deleteValue();
-    value = new quint32[arrayCountIn];
+    value = allocateValue( sizeof(quint32)*arrayCountIn );
     if( newValueArray )
     {
         memcpy( value, newValueArray, sizeof(quint32)*arrayCountIn );
@@ -311,6 +319,7 @@ void Generic::updateUnsignedLong( quint32 newValue, unsigned long arrayIndex ) {
     if( arrayIndex >= arrayCount )
         return;
 
+    detachValue();
     quint32* valueArray = (quint32*)value;
     valueArray[arrayIndex] = newValue;
 }
@@ -326,7 +335,7 @@ void Generic::setFloat( float newValue ) {
 */
 void Generic::setFloat( float* newValueArray, unsigned long arrayCountIn ) {
     deleteValue();
-    value = new float[arrayCountIn];
+    value = allocateValue( sizeof(float)*arrayCountIn );
     if( newValueArray )
     {
         memcpy( value, newValueArray, sizeof(float)*arrayCountIn );
@@ -339,6 +348,7 @@ void Generic::updateFloat( float newValue, unsigned long arrayIndex ) {
     if( arrayIndex >= arrayCount )
         return;
 
+    detachValue();
     float* valueArray = (float*)value;
     valueArray[arrayIndex] = newValue;
 }
@@ -355,7 +365,7 @@ void Generic::setDouble( double newValue ) {
 */
 void Generic::setDouble( double* newValueArray, unsigned long arrayCountIn ) {
     deleteValue();
-    value = new double[arrayCountIn];
+    value = allocateValue( sizeof(double)*arrayCountIn );
     if( newValueArray )
     {
         memcpy( value, newValueArray, sizeof(double)*arrayCountIn );
@@ -368,6 +378,7 @@ void Generic::updateDouble( double newValue, unsigned long arrayIndex ) {
     if( arrayIndex >= arrayCount )
         return;
 
+    detachValue();
     double* valueArray = (double*)value;
     valueArray[arrayIndex] = newValue;
 }
@@ -608,25 +619,15 @@ void Generic::deleteValue() {
             delete (std::string*)value;
         break;
         case GENERIC_SHORT :
-            delete (short*)value;
-        break;
         case GENERIC_UNSIGNED_SHORT :
-            delete (unsigned short*)value;
-        break;
         case GENERIC_UNSIGNED_CHAR :
-            delete (char*)value;
-        break;
         case GENERIC_LONG :
-            delete (qint32*)value;
-        break;
         case GENERIC_UNSIGNED_LONG :
-            delete (quint32*)value;
-        break;
         case GENERIC_FLOAT :
-            delete (float*)value;
-        break;
         case GENERIC_DOUBLE :
-            delete (double*)value;
+            // Release this reference to the value buffer.
+            // (If this is the last reference the buffer is returned to the pool)
+            FrameBufferPool::releaseBuffer( valueBuffer );
         break;
         case GENERIC_UNKNOWN :
             value = NULL;
@@ -637,6 +638,39 @@ void Generic::deleteValue() {
     type = GENERIC_UNKNOWN;
 }
 
+/*
+    Allocate a buffer for an array (or scalar) value and return a pointer to it.
+    Large buffers come from the frame buffer pool. The buffer is reference counted so
+    copies of this Generic (such as a CaRecord copied to pass to QCaObject) share it rather than copy it.
+    The buffer is not referenced by the pool while in use, so it is not shared until this Generic is copied.
+*/
+void* Generic::allocateValue( unsigned long size ) {
+    valueBuffer = FrameBufferPool::getBuffer( size );
+    return (void*)(valueBuffer.data());
+}
+
+/*
+    Ensure the value buffer is not shared (with a copy of this Generic) before it is modified in place
+*/
+void Generic::detachValue() {
+    if( !valueBuffer.isDetached() ) {
+        valueBuffer.detach();
+        value = (void*)(valueBuffer.data());
+    }
+}
+
+/*
+    Return the buffer holding an array (or scalar) value.
+    The buffer is shared, not copied. It must not be modified.
+    An empty buffer is returned for string values.
+*/
+QByteArray Generic::getValueBuffer() {
+    if( getType() == GENERIC_STRING ) {
+        return QByteArray();
+    }
+    return valueBuffer;
+}
+
 /*
     Clone from given Generic
 */
@@ -645,60 +679,24 @@ void Generic::cloneValue( Generic *param ) {
         case GENERIC_STRING :
             setString( param->getString() );
         break;
-        case GENERIC_UNSIGNED_SHORT :
-            {
-                unsigned short* paramValue;
-                unsigned long paramCount;
-                param->getUnsignedShort( &paramValue, &paramCount );
-                setUnsignedShort( paramValue, paramCount );
-            }
-        break;
         case GENERIC_SHORT :
-            {
-                short* paramValue;
-                unsigned long paramCount;
-                param->getShort( &paramValue, &paramCount );
-                setShort( paramValue, paramCount );
-            }
-        break;
+        case GENERIC_UNSIGNED_SHORT :
         case GENERIC_UNSIGNED_CHAR :
-            {
-                unsigned char* paramValue;
-                unsigned long paramCount;
-                param->getUnsignedChar( &paramValue, &paramCount );
-                setUnsignedChar( paramValue, paramCount );
-            }
-        break;
         case GENERIC_LONG :
-            {
-                qint32* paramValue;
-                unsigned long paramCount;
-                param->getLong( &paramValue, &paramCount );
-                setLong( paramValue, paramCount );
-            }
-        break;
-         case GENERIC_UNSIGNED_LONG :
-            {
-                quint32* paramValue;
-                unsigned long paramCount;
-                param->getUnsignedLong( &paramValue, &paramCount );
-                setUnsignedLong( paramValue, paramCount );
-            }
-        break;
+        case GENERIC_UNSIGNED_LONG :
         case GENERIC_FLOAT :
-            {
-                float* paramValue;
-                unsigned long paramCount;
-                param->getFloat( &paramValue, &paramCount );
-                setFloat( paramValue, paramCount );
-            }
-        break;
         case GENERIC_DOUBLE :
+            // Share the value buffer rather than copy it
+            // (Take the reference before releasing any current buffer in case this is self assignment)
             {
-                double* paramValue;
-                unsigned long paramCount;
-                param->getDouble( &paramValue, &paramCount );
-                setDouble( paramValue, paramCount );
+                QByteArray paramBuffer = param->valueBuffer;
+                unsigned long paramCount = param->arrayCount;
+                generic_types paramType = param->getType();
+                deleteValue();
+                valueBuffer = paramBuffer;
+                value = (void*)(valueBuffer.constData());
+                arrayCount = paramCount;
+                type = paramType;
             }
         break;
         case GENERIC_UNKNOWN :
@@ -28,6 +28,7 @@
 
 #include <string>
 #include <QtGlobal>
+#include <QByteArray>
 
 namespace generic {
 
@@ -102,6 +103,7 @@ namespace generic {
       void   getDouble( double** valueArray, unsigned long* countOut = NULL );
 
       unsigned long getArrayCount();
+      QByteArray getValueBuffer();
 
       generic_types getType();
 
@@ -112,9 +114,12 @@ namespace generic {
       unsigned long arrayCount;
       generic_types type;
       void* value;
+      QByteArray valueBuffer;   // Reference counted buffer holding array (and scalar) values. Shared, not copied, between Generic copies
 
       void setType( generic_types newType );
       void deleteValue();
+      void* allocateValue( unsigned long size );
+      void detachValue();
   };
 
 }
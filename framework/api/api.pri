@@ -11,6 +11,7 @@ HEADERS += \
     api/Generic.h \
     api/CaRecord.h \
     api/CaRef.h \
+    api/FrameBufferPool.h \
     api/CaObject.h \
     api/CaConnection.h \
     api/CaObjectPrivate.h
@@ -20,6 +21,7 @@ SOURCES += \
     api/CaRecord.cpp \
     api/CaObject.cpp \
     api/CaConnection.cpp \
-    api/CaRef.cpp
+    api/CaRef.cpp \
+    api/FrameBufferPool.cpp
 
 # end
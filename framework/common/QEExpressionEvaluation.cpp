@@ -24,6 +24,8 @@
  *    andrew.starritt@synchrotron.org.au
  */
 
+#include <math.h>
+#include <string.h>
 #include <QDebug>
 #include <QECommon.h>
 
@@ -31,6 +33,49 @@
 
 #include <QEExpressionEvaluation.h>
 
+#if CALCPERFORM_NARGS != 12
+#error "QEExpressionEvaluation assumes CALCPERFORM_NARGS is 12"
+#endif
+
+//---------------------------------------------------------------------------------
+// Functions available to the byte code. These are the calc functions that are
+// defined for all inputs, and so never cause calcPerform to fail.
+//
+static double absoluteValue (double x)
+{
+   // As per calcPerform - differs from fabs for -0.0
+   //
+   return (x < 0.0) ? -x : x;
+}
+
+struct FunctionSpecifications {
+   const char* name;
+   double (*function) (double);
+};
+
+static const FunctionSpecifications functionList [] = {
+   { "ABS",   absoluteValue },
+   { "EXP",   exp   },
+   { "SIN",   sin   },
+   { "COS",   cos   },
+   { "TAN",   tan   },
+   { "ATAN",  atan  },
+   { "SINH",  sinh  },
+   { "COSH",  cosh  },
+   { "TANH",  tanh  },
+   { "CEIL",  ceil  },
+   { "FLOOR", floor }
+};
+
+static const double pi = 3.14159265358979323846;
+
+// Argument values used to check the byte code against calcPerform.
+// Includes zero, negative and fractional values.
+//
+static const double probeValues [] = {
+   0.0, 1.0, -1.0, 2.5, -3.75, 0.5, 7.0, -0.25, 1.0E6, -1.0E-3, 3.0, -2.0, 0.1
+};
+
 
 //---------------------------------------------------------------------------------
 //
@@ -55,6 +100,14 @@ bool QEExpressionEvaluation::initialise (const QString& expression)
    bool okay;
    QString translated;
 
+   this->byteCode.clear ();
+   this->byteCodeIsValid = false;
+   this->stackDepth = 0;
+   this->maxStackDepth = 0;
+   for (int j = 0; j < NumberPostfixArguments; j++) {
+      this->argumentSource [j] = -1;
+   }
+
    // Tooo big ?
    //
    if (expression.length() > MaxInfixSize) {
@@ -70,15 +123,25 @@ bool QEExpressionEvaluation::initialise (const QString& expression)
 
    // Now apply map
    //
-   const char* pinfix;
+   QByteArray infix;
    long status;
    short error;
 
-   pinfix = translated.toLatin1 ().data ();
+   infix = translated.toLatin1 ();
 
-   status = postfix (pinfix, this->postFix, &error);
+   status = postfix (infix.constData (), this->postFix, &error);
    this->calcError = QString (calcErrorStr (error));
 
+   // Set up the postfix argument source table.
+   //
+   for (int j = 0; j < NumberPostfixArguments; j++) {
+      this->argumentSource [j] = this->argumentMap.value (j, -1);
+   }
+
+   // Attempt to compile to byte code - only used if identical to calcPerform.
+   //
+   this->byteCodeIsValid = (status == 0) && this->compile (translated) && this->verifyByteCode ();
+
    return (status == 0);
 }
 
@@ -94,6 +157,25 @@ void QEExpressionEvaluation::clear (CalculateArguments& userArgs)
    }
 }
 
+//---------------------------------------------------------------------------------
+//
+void QEExpressionEvaluation::clear (CalculateArrayArguments& arrayArgs)
+{
+   int i, j;
+   for (i = 0; i < ARRAY_LENGTH (arrayArgs); i++) {
+      for (j = 0; j < ARRAY_LENGTH (arrayArgs [i]); j++) {
+         arrayArgs [i][j] = NULL;
+      }
+   }
+}
+
+//---------------------------------------------------------------------------------
+//
+bool QEExpressionEvaluation::isArgumentUsed (const InputKinds kind, const int index) const
+{
+   return this->userInputMap.contains ((NumberUserArguments * kind) + index);
+}
+
 //---------------------------------------------------------------------------------
 //
 int QEExpressionEvaluation::indexOf (const char c)
@@ -116,24 +198,10 @@ double QEExpressionEvaluation::evaluate (const CalculateArguments& userArgs, boo
    double result = 0.0;
    long status;
    double args [CALCPERFORM_NARGS];
-   int j;
-   int u;
-   int kind;
-   int letter;
 
    // convert user arguments into post fix arguments.
    //
-   for (j = 0; j < ARRAY_LENGTH (args); j++) {
-      args [j] = 0.0;
-      if (this->argumentMap.contains (j)) {
-         u = this->argumentMap.value (j);
-         if (u >= 0 && u < 2*NumberUserArguments) {
-            kind   = u / NumberUserArguments;
-            letter = u % NumberUserArguments;
-            args [j] = userArgs [kind] [letter];
-         }
-      }
-   }
+   this->postfixArguments (userArgs, args);
 
    status = calcPerform (args, &result, this->postFix);
    if (okayOut) {
@@ -143,6 +211,164 @@ double QEExpressionEvaluation::evaluate (const CalculateArguments& userArgs, boo
    return result;
 }
 
+//---------------------------------------------------------------------------------
+//
+void QEExpressionEvaluation::evaluateArray (const CalculateArguments& userArgs,
+                                            const CalculateArrayArguments& arrayArgs,
+                                            const int number, QVector<double>& result,
+                                            bool* okayOut)
+{
+   bool okay = true;
+
+   result.resize (MAX (number, 0));
+   double* out = result.data ();
+
+   if (this->byteCodeIsValid) {
+      // Evaluate a block of elements per instruction.
+      //
+      QVector<double> stack (this->maxStackDepth * BlockSize);
+
+      for (int offset = 0; offset < number; offset += BlockSize) {
+         const int count = MIN (BlockSize, number - offset);
+         this->evaluateBlock (userArgs, arrayArgs, offset, count,
+                              stack.data (), out + offset);
+      }
+
+   } else {
+      // Fall back to calcPerform for each element.
+      //
+      CalculateArguments elementArgs;
+      double args [CALCPERFORM_NARGS];
+      int i, k;
+
+      for (i = 0; i < NumberInputKinds; i++) {
+         for (k = 0; k < NumberUserArguments; k++) {
+            elementArgs [i][k] = userArgs [i][k];
+         }
+      }
+
+      for (int j = 0; j < number; j++) {
+         for (i = 0; i < NumberInputKinds; i++) {
+            for (k = 0; k < NumberUserArguments; k++) {
+               const QVector<double>* array = arrayArgs [i][k];
+               if (array) {
+                  elementArgs [i][k] = (j < array->count ()) ? array->at (j) : userArgs [i][k];
+               }
+            }
+         }
+
+         this->postfixArguments (elementArgs, args);
+
+         double value = 0.0;
+         if (calcPerform (args, &value, this->postFix) != 0) {
+            okay = false;
+         }
+         out [j] = value;
+      }
+   }
+
+   if (okayOut) {
+      *okayOut = okay;
+   }
+}
+
+//---------------------------------------------------------------------------------
+//
+void QEExpressionEvaluation::postfixArguments (const CalculateArguments& userArgs,
+                                               double* args) const
+{
+   for (int j = 0; j < NumberPostfixArguments; j++) {
+      const int u = this->argumentSource [j];
+      if (u >= 0 && u < 2*NumberUserArguments) {
+         const int kind   = u / NumberUserArguments;
+         const int letter = u % NumberUserArguments;
+         args [j] = userArgs [kind] [letter];
+      } else {
+         args [j] = 0.0;
+      }
+   }
+}
+
+//---------------------------------------------------------------------------------
+// Evaluates elements offset to offset + count - 1. The stack holds one block of
+// values per stack entry, so each instruction is a simple loop over the block.
+//
+void QEExpressionEvaluation::evaluateBlock (const CalculateArguments& userArgs,
+                                            const CalculateArrayArguments& arrayArgs,
+                                            const int offset, const int count,
+                                            double* stack, double* out) const
+{
+   const int n = this->byteCode.count ();
+   double* top = stack - BlockSize;   // top of stack block
+   int j;
+
+   for (int pc = 0; pc < n; pc++) {
+      const Instruction& instruction = this->byteCode.at (pc);
+
+      switch (instruction.op) {
+
+         case opArgument: {
+               const int kind   = instruction.index / NumberUserArguments;
+               const int letter = instruction.index % NumberUserArguments;
+               const QVector<double>* array = arrayArgs [kind][letter];
+               const double defaultValue = userArgs [kind][letter];
+               int available = 0;
+
+               top += BlockSize;
+               if (array) {
+                  available = MAX (0, MIN (count, array->count () - offset));
+                  const double* source = array->constData () + offset;
+                  for (j = 0; j < available; j++) top [j] = source [j];
+               }
+               for (j = available; j < count; j++) top [j] = defaultValue;
+            }
+            break;
+
+         case opConstant:
+            top += BlockSize;
+            for (j = 0; j < count; j++) top [j] = instruction.value;
+            break;
+
+         case opNegate:
+            for (j = 0; j < count; j++) top [j] = -top [j];
+            break;
+
+         case opAdd:
+            top -= BlockSize;
+            for (j = 0; j < count; j++) top [j] = top [j] + top [j + BlockSize];
+            break;
+
+         case opSubtract:
+            top -= BlockSize;
+            for (j = 0; j < count; j++) top [j] = top [j] - top [j + BlockSize];
+            break;
+
+         case opMultiply:
+            top -= BlockSize;
+            for (j = 0; j < count; j++) top [j] = top [j] * top [j + BlockSize];
+            break;
+
+         case opDivide:
+            top -= BlockSize;
+            for (j = 0; j < count; j++) top [j] = top [j] / top [j + BlockSize];
+            break;
+
+         case opPower:
+            top -= BlockSize;
+            for (j = 0; j < count; j++) top [j] = pow (top [j], top [j + BlockSize]);
+            break;
+
+         case opFunction: {
+               double (*function) (double) = functionList [instruction.index].function;
+               for (j = 0; j < count; j++) top [j] = function (top [j]);
+            }
+            break;
+      }
+   }
+
+   for (j = 0; j < count; j++) out [j] = top [j];
+}
+
 //---------------------------------------------------------------------------------
 // Looks for and collates single input letters A .. Z and A' .. Z'  and maps
 // these onto A .. L.
@@ -229,4 +455,258 @@ bool QEExpressionEvaluation::buildMaps (const QString& expression, QString& tran
    return true;
 }
 
+//---------------------------------------------------------------------------------
+// Compiles the translated infix expression (i.e. inputs A .. L) into byte code.
+// Only arithmetic operators, parentheses, numbers, PI/D2R/R2D and the functions
+// in functionList are accepted - anything else is left to calcPerform.
+// Precedence follows postfix: unary minus, then ^ (or **), then * /, then + -,
+// all left associative.
+//
+bool QEExpressionEvaluation::compile (const QString& translated)
+{
+   const QByteArray text = translated.toUpper ().toLatin1 ();
+   int pos = 0;
+
+   this->byteCode.clear ();
+   this->stackDepth = 0;
+   this->maxStackDepth = 0;
+
+   if (!this->compileSum (text, pos)) return false;
+
+   while (pos < text.length () && text.at (pos) == ' ') pos++;
+   return (pos == text.length ()) && (this->stackDepth == 1);
+}
+
+//---------------------------------------------------------------------------------
+// Skip spaces and return next character (or 0 at end of text).
+//
+static char peekChar (const QByteArray& text, int& pos)
+{
+   while (pos < text.length () && text.at (pos) == ' ') pos++;
+   return (pos < text.length ()) ? text.at (pos) : 0;
+}
+
+//---------------------------------------------------------------------------------
+//
+bool QEExpressionEvaluation::compileSum (const QByteArray& text, int& pos)
+{
+   if (!this->compileProduct (text, pos)) return false;
+
+   while (true) {
+      const char c = peekChar (text, pos);
+      if (c != '+' && c != '-') return true;
+      pos++;
+      if (!this->compileProduct (text, pos)) return false;
+      this->addInstruction ((c == '+') ? opAdd : opSubtract);
+   }
+}
+
+//---------------------------------------------------------------------------------
+//
+bool QEExpressionEvaluation::compileProduct (const QByteArray& text, int& pos)
+{
+   if (!this->compilePower (text, pos)) return false;
+
+   while (true) {
+      const char c = peekChar (text, pos);
+      if (c != '/' && (c != '*' || text.mid (pos, 2) == "**")) return true;
+      pos++;
+      if (!this->compilePower (text, pos)) return false;
+      this->addInstruction ((c == '*') ? opMultiply : opDivide);
+   }
+}
+
+//---------------------------------------------------------------------------------
+//
+bool QEExpressionEvaluation::compilePower (const QByteArray& text, int& pos)
+{
+   if (!this->compileUnary (text, pos)) return false;
+
+   while (true) {
+      const char c = peekChar (text, pos);
+      if (c == '^') {
+         pos += 1;
+      } else if (text.mid (pos, 2) == "**") {
+         pos += 2;
+      } else {
+         return true;
+      }
+      if (!this->compileUnary (text, pos)) return false;
+      this->addInstruction (opPower);
+   }
+}
+
+//---------------------------------------------------------------------------------
+//
+bool QEExpressionEvaluation::compileUnary (const QByteArray& text, int& pos)
+{
+   if (peekChar (text, pos) == '-') {
+      pos++;
+      if (!this->compileUnary (text, pos)) return false;
+      this->addInstruction (opNegate);
+      return true;
+   }
+   return this->compilePrimary (text, pos);
+}
+
+//---------------------------------------------------------------------------------
+//
+bool QEExpressionEvaluation::compilePrimary (const QByteArray& text, int& pos)
+{
+   const char c = peekChar (text, pos);
+
+   if (c == '(') {
+      pos++;
+      if (!this->compileSum (text, pos)) return false;
+      if (peekChar (text, pos) != ')') return false;
+      pos++;
+      return true;
+   }
+
+   if ((c >= '0' && c <= '9') || c == '.') {
+      // Hexadecimal literals are left to calcPerform.
+      //
+      if (text.mid (pos, 2) == "0X") return false;
+
+      int end = pos;
+      while (end < text.length () && ((text.at (end) >= '0' && text.at (end) <= '9') || text.at (end) == '.')) end++;
+      if (end < text.length () && text.at (end) == 'E') {
+         int e = end + 1;
+         if (e < text.length () && (text.at (e) == '+' || text.at (e) == '-')) e++;
+         if (e < text.length () && text.at (e) >= '0' && text.at (e) <= '9') {
+            end = e;
+            while (end < text.length () && text.at (end) >= '0' && text.at (end) <= '9') end++;
+         }
+      }
+
+      bool okay;
+      const double value = text.mid (pos, end - pos).toDouble (&okay);
+      if (!okay) return false;
+      pos = end;
+      this->addInstruction (opConstant, 0, value);
+      return true;
+   }
+
+   if (c >= 'A' && c <= 'Z') {
+      int end = pos;
+      while (end < text.length () &&
+             ((text.at (end) >= 'A' && text.at (end) <= 'Z') ||
+              (text.at (end) >= '0' && text.at (end) <= '9') || text.at (end) == '_')) end++;
+      const QByteArray name = text.mid (pos, end - pos);
+      pos = end;
+
+      if (name.length () == 1) {
+         // Postfix argument A .. L - map back to the user argument.
+         //
+         const int a = name.at (0) - 'A';
+         if (a >= NumberPostfixArguments || this->argumentSource [a] < 0) return false;
+         this->addInstruction (opArgument, this->argumentSource [a]);
+         return true;
+      }
+
+      // Constants - as calculated by calcPerform.
+      //
+      if (name == "PI")  { this->addInstruction (opConstant, 0, pi);         return true; }
+      if (name == "D2R") { this->addInstruction (opConstant, 0, pi / 180.0); return true; }
+      if (name == "R2D") { this->addInstruction (opConstant, 0, 180.0 / pi); return true; }
+
+      for (int f = 0; f < ARRAY_LENGTH (functionList); f++) {
+         if (name == functionList [f].name) {
+            if (peekChar (text, pos) != '(') return false;
+            if (!this->compilePrimary (text, pos)) return false;
+            this->addInstruction (opFunction, f);
+            return true;
+         }
+      }
+   }
+
+   return false;
+}
+
+//---------------------------------------------------------------------------------
+//
+void QEExpressionEvaluation::addInstruction (const OpCodes op, const int index, const double value)
+{
+   Instruction instruction;
+
+   instruction.op = op;
+   instruction.index = index;
+   instruction.value = value;
+   this->byteCode.append (instruction);
+
+   switch (op) {
+      case opArgument:
+      case opConstant:
+         this->stackDepth++;
+         break;
+
+      case opAdd:
+      case opSubtract:
+      case opMultiply:
+      case opDivide:
+      case opPower:
+         this->stackDepth--;
+         break;
+
+      default:
+         break;
+   }
+   this->maxStackDepth = MAX (this->maxStackDepth, this->stackDepth);
+}
+
+//---------------------------------------------------------------------------------
+// Evaluate a range of argument values using both calcPerform and the byte code.
+// The byte code is only used if the results are bit for bit identical.
+//
+bool QEExpressionEvaluation::verifyByteCode ()
+{
+   const int numberProbes = ARRAY_LENGTH (probeValues);
+   CalculateArguments userArgs;
+   CalculateArrayArguments arrayArgs;
+   QVector<double> columns [2 * NumberUserArguments];
+   QVector<double> result;
+   int i, k, p;
+
+   // Each used argument takes a different sequence of probe values.
+   //
+   clear (userArgs);
+   clear (arrayArgs);
+   for (i = 0; i < NumberPostfixArguments; i++) {
+      const int u = this->argumentSource [i];
+      if (u < 0) continue;
+      for (p = 0; p < 4 * numberProbes; p++) {
+         columns [u].append (probeValues [(p * (2 * i + 1) + p / numberProbes + i) % numberProbes]);
+      }
+      arrayArgs [u / NumberUserArguments][u % NumberUserArguments] = &columns [u];
+   }
+
+   const int number = 4 * numberProbes;
+
+   this->byteCodeIsValid = true;
+   this->evaluateArray (userArgs, arrayArgs, number, result);
+   this->byteCodeIsValid = false;
+
+   for (p = 0; p < number; p++) {
+      CalculateArguments elementArgs;
+      clear (elementArgs);
+      for (k = 0; k < 2 * NumberUserArguments; k++) {
+         if (!columns [k].isEmpty ()) {
+            elementArgs [k / NumberUserArguments][k % NumberUserArguments] = columns [k].at (p);
+         }
+      }
+
+      bool okay;
+      const double expected = this->evaluate (elementArgs, &okay);
+      const double actual = result.at (p);
+
+      if (!okay) return false;   // byte code never fails
+      if (memcmp (&expected, &actual, sizeof (double)) != 0 &&
+          !(expected != expected && actual != actual)) {   // both NaN is okay
+         return false;
+      }
+   }
+
+   return true;
+}
+
 // end
@@ -29,6 +29,7 @@
 
 #include <QHash>
 #include <QString>
+#include <QVector>
 #include <QEPluginLibrary_global.h>
 
 //---------------------------------------------------------------------------------
@@ -60,6 +61,12 @@
 /// of the CALC field, but may use the full 100 characters allowed by the
 /// underlying postfix function.
 ///
+/// Whole arrays may be evaluated using evaluateArray. Expressions that only use
+/// arithmetic operators and simple functions are compiled into a byte code that
+/// is evaluated a block of elements at a time. The byte code is checked against
+/// calcPerform when the expression is initialised, and is only used when the
+/// results are identical; otherwise calcPerform is called for each element.
+///
 /// Acknowledgements:
 /// QEExpressionEvaluation is a direct crib of TCalculate out of the Delphi OPI framework.
 /// The postfix and calcPerform functions were written by Bob Dalesio (12-12-86).
@@ -76,18 +83,88 @@ public:
    enum InputKinds { Normal, Primed };
 
    typedef double CalculateArguments [NumberInputKinds][NumberUserArguments];
+   typedef const QVector<double>* CalculateArrayArguments [NumberInputKinds][NumberUserArguments];
 
    bool initialise (const QString& expression);
    QString getCalcError () { return this-> calcError; }
 
    double evaluate (const CalculateArguments& userArgs, bool* okay = 0);
 
+   // Evaluates the expression for elements 0 to number - 1 into result.
+   // Where arrayArgs specifies an array for an input, element j of the array is
+   // used for element j, or the userArgs value when the array is too short.
+   // Otherwise (NULL) the userArgs value is used for all elements.
+   // The results are identical to calling evaluate for each element.
+   //
+   void evaluateArray (const CalculateArguments& userArgs,
+                       const CalculateArrayArguments& arrayArgs,
+                       const int number, QVector<double>& result,
+                       bool* okay = 0);
+
+   // Returns true if the (successfully) initialised expression uses the given
+   // user argument, e.g. (Primed, 1) for B'. This allows the caller to avoid
+   // calculating argument values that are not required.
+   //
+   bool isArgumentUsed (const InputKinds kind, const int index) const;
+
    static void clear (CalculateArguments& userArgs);
+   static void clear (CalculateArrayArguments& arrayArgs);
    static int indexOf (const char c);
 
 private:
    bool buildMaps (const QString& expression, QString& translated);
 
+   // Byte code compiler and evaluator.
+   //
+   enum OpCodes {
+      opArgument,     // push user argument (index)
+      opConstant,     // push value
+      opNegate,
+      opAdd,
+      opSubtract,
+      opMultiply,
+      opDivide,
+      opPower,
+      opFunction      // apply function (index)
+   };
+
+   struct Instruction {
+      OpCodes op;
+      int index;
+      double value;
+   };
+
+   typedef QVector<Instruction> ByteCode;
+
+   bool compile (const QString& translated);
+   bool compileSum (const QByteArray& text, int& pos);
+   bool compileProduct (const QByteArray& text, int& pos);
+   bool compilePower (const QByteArray& text, int& pos);
+   bool compileUnary (const QByteArray& text, int& pos);
+   bool compilePrimary (const QByteArray& text, int& pos);
+   void addInstruction (const OpCodes op, const int index = 0, const double value = 0.0);
+   bool verifyByteCode ();
+
+   void evaluateBlock (const CalculateArguments& userArgs,
+                       const CalculateArrayArguments& arrayArgs,
+                       const int offset, const int count,
+                       double* stack, double* out) const;
+
+   void postfixArguments (const CalculateArguments& userArgs, double* args) const;
+
+   static const int BlockSize = 256;
+   static const int NumberPostfixArguments = 12;    // i.e. CALCPERFORM_NARGS
+
+   ByteCode byteCode;
+   bool byteCodeIsValid;
+   int stackDepth;
+   int maxStackDepth;
+
+   // Maps postfix argument number to user argument (-1 if unused), as per
+   // argumentMap, but avoids the hash look up for each evaluation.
+   //
+   int argumentSource [NumberPostfixArguments];
+
    static const int MaxInfixSize = 100;
 
    // This is the value from the INFIX_TO_POSTFIX_SIZE macro from postfix.h
@@ -0,0 +1,83 @@
+/*  QEFalseColour.cpp
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+#include <QColor>
+#include <QEFalseColour.h>
+
+//------------------------------------------------------------------------------
+// static
+QRgb QEFalseColour::getColour (const unsigned char value)
+{
+   const int max = 0xFF;
+   const int half = 0x80;
+   const int lightness_slope = 4;
+   const int low_hue = 240;    // blue.
+   const int high_hue = 0;     // red
+
+   int bp1;
+   int bp2;
+   int h, l;
+   QColor c;
+
+   // Range of inputs broken into three bands:
+   // [0 .. bp1], [bp1 .. bp2] and [bp2 .. max]
+   //
+   bp1 = half / lightness_slope;
+   bp2 = max - (max - half) / lightness_slope;
+
+   if (value < bp1) {
+      // Constant hue (blue), lightness ramps up to 128
+      h = low_hue;
+      l = lightness_slope*value;
+   } else if (value > bp2) {
+      // Constant hue (red), lightness ramps up from 128 to 255
+      h = high_hue;
+      l = max - lightness_slope*(max-value);
+   } else {
+      // The bit in the middle.
+      // Contant lightness, hue varies blue to red.
+      h = ((value - bp1)*high_hue + (bp2 - value)*low_hue) / (bp2 - bp1);
+      l = half;
+   }
+
+   c.setHsl (h, max, l);   // Saturation always 100%
+
+   return c.rgb ();          // Alpha always 100%
+}
+
+//------------------------------------------------------------------------------
+// static
+QVector<QRgb> QEFalseColour::getLookupTable ()
+{
+   QVector<QRgb> result (256);
+
+   for (int j = 0; j < 256; j++) {
+      result [j] = QEFalseColour::getColour ((unsigned char) j);
+   }
+   return result;
+}
+
+// end
@@ -0,0 +1,52 @@
+/*  QEFalseColour.h
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+#ifndef QE_FALSE_COLOUR_H
+#define QE_FALSE_COLOUR_H
+
+#include <QRgb>
+#include <QVector>
+#include <QEPluginLibrary_global.h>
+
+/// The false colour scheme used by QEImage, and by the QEPlotter waterfall, so
+/// that both represent intensities with the same colours.
+///
+/// Values 0 to 255 map from black, through blue, to red and then white, i.e.
+/// the lightness ramps up over the lowest and highest values, and the hue varies
+/// from blue to red over the middle values.
+///
+class QEPLUGINLIBRARYSHARED_EXPORT QEFalseColour {
+public:
+   // Return the false colour for a value.
+   //
+   static QRgb getColour (const unsigned char value);
+
+   // Return a 256 entry lookup table, indexed by value.
+   //
+   static QVector<QRgb> getLookupTable ();
+};
+
+#endif  // QE_FALSE_COLOUR_H
@@ -95,6 +95,77 @@ void QEGraphic::OwnPlot::drawCanvas(QPainter* painter)
    }
 }
 
+//==============================================================================
+// QEGraphic::OwnCurve class
+//==============================================================================
+// A curve together with its scaled data. The curve references the data directly
+// (raw samples) so that the data is neither copied nor re-allocated on replot.
+//
+class QEGraphic::OwnCurve : public QwtPlotCurve {
+public:
+   explicit OwnCurve () : QwtPlotCurve () { }
+   ~OwnCurve () { }
+
+   // Scales the data into the curve's own buffers, and references the buffers.
+   //
+   void setScaledData (const QEGraphic::Axis* xAxis, const QEGraphic::Axis* yAxis,
+                       const DoubleVector& xData, const DoubleVector& yData,
+                       const int number);
+
+   // Drops the referenced data - used when the curve is not in use.
+   //
+   void clearScaledData ();
+
+private:
+   DoubleVector xScaled;
+   DoubleVector yScaled;
+};
+
+//------------------------------------------------------------------------------
+//
+void QEGraphic::OwnCurve::setScaledData (const QEGraphic::Axis* xAxis, const QEGraphic::Axis* yAxis,
+                                         const DoubleVector& xData, const DoubleVector& yData,
+                                         const int number)
+{
+   // Re-sizing retains the allocated capacity, so once the curve has been used
+   // the scaling is just one pass over the data.
+   //
+   this->xScaled.resize (number);
+   this->yScaled.resize (number);
+
+   const double* xIn = xData.constData ();
+   const double* yIn = yData.constData ();
+   double* xOut = this->xScaled.data ();
+   double* yOut = this->yScaled.data ();
+
+   for (int j = 0; j < number; j++) {
+      xOut [j] = xAxis->scaleValue (xIn [j]);
+      yOut [j] = yAxis->scaleValue (yIn [j]);
+   }
+
+#if QWT_VERSION >= 0x060000
+   this->setRawSamples (xOut, yOut, number);
+#else
+   this->setRawData (xOut, yOut, number);
+#endif
+}
+
+//------------------------------------------------------------------------------
+//
+void QEGraphic::OwnCurve::clearScaledData ()
+{
+   // Must drop the raw reference before the buffers are released.
+   //
+#if QWT_VERSION >= 0x060000
+   this->setSamples (DoubleVector (), DoubleVector ());
+#else
+   this->setData (DoubleVector (), DoubleVector ());
+#endif
+   this->xScaled.clear ();
+   this->yScaled.clear ();
+}
+
+
 //==============================================================================
 // QEGraphic::Axis class
 //==============================================================================
@@ -419,6 +490,9 @@ void QEGraphic::construct ()
    this->xAxis = new Axis (this->plot, QwtPlot::xBottom);
    this->yAxis = new Axis (this->plot, QwtPlot::yLeft);
 
+   this->userCurvePool.numberUsed = 0;
+   this->markupCurvePool.numberUsed = 0;
+
    // Construct markups and insert into marksup set.
    //
    this->graphicMarkupsSet = new QEGraphicMarkupSets;
@@ -469,6 +543,8 @@ QEGraphic::~QEGraphic ()
    // cause a segmentation fault when the associated QwtPolot object is deleted.
    //
    this->releaseCurves ();
+   this->deleteCurvePool (this->userCurvePool);
+   this->deleteCurvePool (this->markupCurvePool);
 
    if (this->plotGrid) {
       this->plotGrid->detach();
@@ -685,6 +761,51 @@ void QEGraphic::releaseCurveList (CurveLists& list)
    list.clear ();
 }
 
+//------------------------------------------------------------------------------
+// Marks all pool curves as available for re-use. They remain attached (and are
+// still drawn) until re-used or hidden, so there is no flicker.
+//
+void QEGraphic::recycleCurvePool (CurvePools& pool)
+{
+   pool.numberUsed = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEGraphic::hideUnusedCurvePool (CurvePools& pool)
+{
+   for (int j = pool.numberUsed; j < pool.curves.size (); j++) {
+      OwnCurve* curve = pool.curves.value (j);
+      if (curve && curve->isVisible ()) {
+         curve->setVisible (false);
+         curve->clearScaledData ();
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void QEGraphic::deleteCurvePool (CurvePools& pool)
+{
+   for (int j = 0; j < pool.curves.size (); j++) {
+      OwnCurve* curve = pool.curves.value (j);
+      if (curve) {
+         curve->detach ();
+         delete curve;
+      }
+   }
+   pool.curves.clear ();
+   pool.numberUsed = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEGraphic::hideUnusedCurves ()
+{
+   this->hideUnusedCurvePool (this->userCurvePool);
+   this->hideUnusedCurvePool (this->markupCurvePool);
+}
+
 //------------------------------------------------------------------------------
 //
 void QEGraphic::releaseTextItemList (TextItemLists& list)
@@ -698,7 +819,8 @@ void QEGraphic::releaseTextItemList (TextItemLists& list)
 void QEGraphic::releaseCurves ()
 {
    this->releaseCurveList (this->userCurveList);
-   this->releaseCurveList (this->markupCurveList);
+   this->recycleCurvePool (this->userCurvePool);
+   this->recycleCurvePool (this->markupCurvePool);
    this->releaseTextItemList (this->textItemList);
 }
 
@@ -714,18 +836,27 @@ void QEGraphic::attchOwnCurve (QwtPlotCurve* curve)
 
 //------------------------------------------------------------------------------
 //
-QwtPlotCurve* QEGraphic::createCurveData (const DoubleVector& xData, const DoubleVector& yData)
+void QEGraphic::plotPoolCurveData (CurvePools& pool, const double zOffset,
+                                   const DoubleVector& xData, const DoubleVector& yData)
 {
    const int curveLength = MIN (xData.size (), yData.size ());
 
-   if (curveLength <= 1) return NULL;  // sainity check
+   if (curveLength <= 1) return;  // sainity check
 
-   QwtPlotCurve* curve;
-   DoubleVector useXData;
-   DoubleVector useYData;
-   curve = new QwtPlotCurve ();
+   // Re-use the next curve in the pool if we can, otherwise allocate a new curve
+   // and attach it to the plot object.
+   //
+   OwnCurve* curve = pool.curves.value (pool.numberUsed, NULL);
+   if (!curve) {
+      curve = new OwnCurve ();
+      curve->setZ (curve->z () + zOffset);
+      curve->attach (this->plot);
+      pool.curves.append (curve);
+   }
+   pool.numberUsed++;
 
    // Set curve propeties using current curve attributes.
+   // These are no-ops if the attributes are unchanged.
    //
    curve->setPen (this->getCurvePen ());
    curve->setBrush (this->getCurveBrush ());
@@ -735,47 +866,24 @@ QwtPlotCurve* QEGraphic::createCurveData (const DoubleVector& xData, const Doubl
    // Scale data as need be. Underlying Qwr widget does basic transformation,
    // but we need to do any required real world/log scaling.
    //
-   useXData.clear();
-   useYData.clear();
-   for (int j = 0; j < curveLength; j++) {
-      double x, y;
-
-      x = this->xAxis->scaleValue (xData.value (j));
-      useXData.append (x);
-
-      y = this->yAxis->scaleValue (yData.value (j));
-      useYData.append (y);
-   }
-
-#if QWT_VERSION >= 0x060000
-   curve->setSamples (useXData, useYData);
-#else
-   curve->setData (useXData, useYData);
-#endif
-
-   // Attach new curve to the plot object.
-   //
-   curve->attach (this->plot);
-
-   return curve;
+   curve->setScaledData (this->xAxis, this->yAxis, xData, yData, curveLength);
+   curve->setVisible (true);
 }
 
 //------------------------------------------------------------------------------
 //
 void QEGraphic::plotCurveData (const DoubleVector& xData, const DoubleVector& yData)
 {
-   QwtPlotCurve* curve;
-   curve = this->createCurveData (xData, yData);
-   if (curve) this->userCurveList.append (curve);
+   this->plotPoolCurveData (this->userCurvePool, 0.0, xData, yData);
 }
 
 //------------------------------------------------------------------------------
+// Markup curves are drawn above the user curves, independent of the order in
+// which the pool curves were allocated.
 //
 void QEGraphic::plotMarkupCurveData (const DoubleVector& xData, const DoubleVector& yData)
 {
-   QwtPlotCurve* curve;
-   curve = this->createCurveData (xData, yData);
-   if (curve) this->markupCurveList.append (curve);
+   this->plotPoolCurveData (this->markupCurvePool, 1.0, xData, yData);
 }
 
 //------------------------------------------------------------------------------
@@ -795,8 +903,9 @@ void QEGraphic::plotMarkups ()
 //
 void QEGraphic::graphicReplot ()
 {
-   this->releaseCurveList (this->markupCurveList);
+   this->recycleCurvePool (this->markupCurvePool);
    this->plotMarkups ();
+   this->hideUnusedCurvePool (this->markupCurvePool);
    this->plot->replot ();
 }
 
@@ -888,6 +997,13 @@ bool QEGraphic::globalPosIsOverCanvas (const QPoint& golbalPos) const
           (canvasPos.y () >= 0) && (canvasPos.y () < canvasGeo.height ());
 }
 
+//------------------------------------------------------------------------------
+//
+QSize QEGraphic::getCanvasSize () const
+{
+   return this->plot->canvas()->size ();
+}
+
 //------------------------------------------------------------------------------
 //
 QPoint QEGraphic::pixelDistance (const QPointF& from, const QPointF& to) const
@@ -1128,6 +1244,7 @@ void QEGraphic::replot ()
    // User artefacts already plotted - now do markup plots.
    //
    this->plotMarkups ();
+   this->hideUnusedCurves ();
    this->plot->replot ();
 }
 
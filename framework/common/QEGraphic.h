@@ -78,6 +78,8 @@ public:
    ~QEGraphic ();
 
    // Call before any replotting, releases all curves from previous plot.
+   // Note: the curves allocated by plotCurveData are retained and re-used by
+   // subsequent calls to plotCurveData - any not re-used are hidden by replot.
    //
    void releaseCurves ();
 
@@ -109,7 +111,7 @@ public:
    void setCrosshairsVisible (const bool isVisible, const QPointF& position);
    bool getCrosshairsVisible () const;
 
-   // Allocates a curve, sets current curve attibutes and attaches to plot.
+   // Allocates (or re-uses) a curve, sets current curve attibutes and attaches to plot.
    //
    void plotCurveData (const DoubleVector& xData, const DoubleVector& yData);
 
@@ -133,6 +135,8 @@ public:
 
    bool globalPosIsOverCanvas (const QPoint& golbalPos) const;
 
+   QSize getCanvasSize () const;     // size of plot canvas in pixels
+
    bool getSlopeIsDefined (QPointF& slope) const;
 
    // Returns the pixel distance between two real points.
@@ -213,6 +217,7 @@ protected:
 
 private:
    class OwnPlot;   // private and differed.
+   class OwnCurve;  // private and differed.
 
    // Handle each axis in own class.
    //
@@ -287,7 +292,7 @@ private:
    QEGraphicMarkup* mouseIsOverMarkup (); // uses cursor position to find closest, if any markup
    void plotMarkups ();     // calls each markup's plot functions which call plotMarkupCurveData.
    void plotMarkupCurveData (const DoubleVector& xData, const DoubleVector& yData);
-   QwtPlotCurve* createCurveData (const DoubleVector& xData, const DoubleVector& yData);
+   void hideUnusedCurves ();  // hides curves not re-used since call to releaseCurves
    void graphicReplot ();   // relases and replots markups, then calls QwtPlot replot
    void drawTexts (QPainter* painter);    // called from OwnPlot
 
@@ -306,13 +311,28 @@ private:
    QwtPlotGrid* plotGrid;
    QTimer* tickTimer;
 
-   // Keep a list of allocated curves so that we can track and delete them.
+   // Keep a list of user allocated curves so that we can track and delete them.
    //
    typedef QList<QwtPlotCurve*> CurveLists;
    CurveLists userCurveList;
-   CurveLists markupCurveList;
    void releaseCurveList (CurveLists& list);
 
+   // The curves we allocate are kept in pools and re-used from one replot to the
+   // next, together with their scaled data, rather than re-allocated each time.
+   // Only the first numberUsed curves of a pool are part of the current plot.
+   //
+   struct CurvePools {
+      QList<OwnCurve*> curves;
+      int numberUsed;
+   };
+   CurvePools userCurvePool;
+   CurvePools markupCurvePool;
+   void plotPoolCurveData (CurvePools& pool, const double zOffset,
+                           const DoubleVector& xData, const DoubleVector& yData);
+   void recycleCurvePool (CurvePools& pool);
+   void hideUnusedCurvePool (CurvePools& pool);
+   void deleteCurvePool (CurvePools& pool);
+
    // Keep a list of drawn texts.
    //
    struct TextItems {
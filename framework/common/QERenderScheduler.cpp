@@ -0,0 +1,263 @@
+/*  QERenderScheduler.cpp
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+#include <QDebug>
+#include <QMetaObject>
+#include <QMutex>
+
+#include <QECommon.h>
+#include <QEAdaptationParameters.h>
+#include <QERenderScheduler.h>
+
+#define DEBUG qDebug () << "QERenderScheduler" << __FUNCTION__ << __LINE__
+
+#define NOMINAL_FRAME_INTERVAL   50      // mSec, i.e. 20 Hz
+#define MAXIMUM_FRAME_INTERVAL   500     // mSec, i.e. 2 Hz
+#define DEFAULT_FRAME_BUDGET     20      // mSec
+#define SECOND                   1000    // mSec
+
+static QMutex *schedulerMutex = new QMutex ();
+static QERenderScheduler* theScheduler = NULL;
+
+
+//------------------------------------------------------------------------------
+//
+QERenderScheduler::QERenderScheduler (QObject* parent) : QObject (parent)
+{
+   QEAdaptationParameters ap ("QE_");
+
+   this->nextClient = 0;
+   this->numberAttached = 0;
+   this->frameBudget = LIMIT (ap.getInt ("render_budget", DEFAULT_FRAME_BUDGET), 1, SECOND);
+   this->frameInterval = NOMINAL_FRAME_INTERVAL;
+
+   this->clock.start ();
+
+   // Create, connect and configure timer object.
+   //
+   this->timer = new QTimer (this);
+
+   QObject::connect (this->timer, SIGNAL (timeout ()),
+                     this,        SLOT   (timeout ()));
+
+   this->timer->start (this->frameInterval);
+}
+
+//------------------------------------------------------------------------------
+//
+QERenderScheduler::~QERenderScheduler ()
+{
+   // place holder
+}
+
+//------------------------------------------------------------------------------
+// static
+bool QERenderScheduler::isShowing (const QWidget* widget)
+{
+   return widget->isVisible () && !widget->window ()->isMinimized ();
+}
+
+//------------------------------------------------------------------------------
+//
+void QERenderScheduler::timeout ()
+{
+   QElapsedTimer frameTimer;
+   frameTimer.start ();
+
+   // Purge detached/deleted widgets. This is not done in detach itself as
+   // widgets may be detached while we are ticking the widgets.
+   //
+   for (int j = this->clients.count () - 1; j >= 0; j--) {
+      if (this->clients.value (j).widget.isNull ()) {
+         this->clients.removeAt (j);
+         if (j < this->nextClient) this->nextClient--;
+      }
+   }
+
+   // Widgets attached during this frame are not ticked until the next frame.
+   //
+   const int n = this->clients.count ();
+   if (n == 0) return;
+
+   const qint64 now = this->clock.elapsed ();
+   const int start = LIMIT (this->nextClient, 0, n - 1);
+   int numberTicked = 0;
+   bool deferred = false;
+
+   for (int k = 0; k < n; k++) {
+      const int j = (start + k) % n;
+
+      // Note: any attach during a tick may re-allocate the list, so do not
+      // hold a reference to the client over the tick itself.
+      //
+      Clients& client = this->clients [j];
+      QWidget* widget = client.widget;
+
+      if (!widget) continue;    // detached/deleted during this frame
+
+      if (!QERenderScheduler::isShowing (widget)) {
+         client.wasVisible = false;
+         continue;
+      }
+
+      // Always tick at least one widget per frame.
+      //
+      if ((numberTicked > 0) && (frameTimer.elapsed () >= this->frameBudget)) {
+         this->nextClient = j;   // goes first next frame
+         deferred = true;
+         break;
+      }
+
+      // Advance the next second tick in whole seconds so as to retain the
+      // stagger set up by attach.
+      //
+      bool isSecondTick = !client.wasVisible;
+      if (now >= client.nextSecondTick) {
+         isSecondTick = true;
+         client.nextSecondTick += SECOND * ((now - client.nextSecondTick) / SECOND + 1);
+      }
+      client.wasVisible = true;
+
+      const QMetaMethod method = client.method;
+      method.invoke (widget, Qt::DirectConnection, Q_ARG (bool, isSecondTick));
+      numberTicked++;
+   }
+
+   // Rotate which widget goes first so that no one widget is always last.
+   //
+   if (!deferred) {
+      this->nextClient = (start + 1) % n;
+   }
+
+   this->adjustFrameInterval (frameTimer.elapsed (), deferred);
+}
+
+//------------------------------------------------------------------------------
+//
+void QERenderScheduler::adjustFrameInterval (const qint64 frameTime,
+                                             const bool deferred)
+{
+   int interval = this->frameInterval;
+
+   if (deferred || (frameTime > this->frameBudget)) {
+      // Over budget - back off quickly.
+      //
+      interval = MIN (interval + interval / 2, MAXIMUM_FRAME_INTERVAL);
+
+   } else if (frameTime < this->frameBudget / 2) {
+      // Well within budget - recover slowly.
+      //
+      interval = MAX (interval - NOMINAL_FRAME_INTERVAL / 5, NOMINAL_FRAME_INTERVAL);
+   }
+
+   if (this->frameInterval != interval) {
+      this->frameInterval = interval;
+      this->timer->setInterval (interval);
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+void QERenderScheduler::initialise ()
+{
+   QMutexLocker locker (schedulerMutex);
+
+   if (!theScheduler) {
+      theScheduler = new QERenderScheduler (NULL);
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+bool QERenderScheduler::attach (QWidget* target, const char* member)
+{
+   QERenderScheduler::initialise ();      // idempotant
+
+   if (!target || !member) return false;
+
+   // SLOT () prefixes the signature with a method type code.
+   //
+   const QByteArray signature = QMetaObject::normalizedSignature (member + 1);
+   const int index = target->metaObject ()->indexOfMethod (signature.constData ());
+   if (index < 0) {
+      DEBUG << "no such method" << target->metaObject ()->className () << signature;
+      return false;
+   }
+
+   QERenderScheduler::detach (target);    // avoid duplicates
+
+   // Stagger each widget's second ticks by one frame.
+   //
+   Clients client;
+   client.widget = target;
+   client.method = target->metaObject ()->method (index);
+   client.nextSecondTick = theScheduler->clock.elapsed () +
+         (theScheduler->numberAttached * NOMINAL_FRAME_INTERVAL) % SECOND;
+   client.wasVisible = false;
+
+   theScheduler->numberAttached++;
+   theScheduler->clients.append (client);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// static
+void QERenderScheduler::detach (QWidget* target)
+{
+   QERenderScheduler::initialise ();      // idempotant
+
+   for (int j = 0; j < theScheduler->clients.count (); j++) {
+      if (theScheduler->clients [j].widget == target) {
+         theScheduler->clients [j].widget = NULL;    // purged on next timeout
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+void QERenderScheduler::setFrameBudget (const int mSec)
+{
+   QERenderScheduler::initialise ();      // idempotant
+   theScheduler->frameBudget = LIMIT (mSec, 1, SECOND);
+}
+
+//------------------------------------------------------------------------------
+// static
+int QERenderScheduler::getFrameBudget ()
+{
+   QERenderScheduler::initialise ();      // idempotant
+   return theScheduler->frameBudget;
+}
+
+//------------------------------------------------------------------------------
+// static
+int QERenderScheduler::getFrameInterval ()
+{
+   QERenderScheduler::initialise ();      // idempotant
+   return theScheduler->frameInterval;
+}
+
+// end
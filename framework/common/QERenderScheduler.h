@@ -0,0 +1,109 @@
+/*  QERenderScheduler.h
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+#ifndef QE_RENDER_SCHEDULER_H
+#define QE_RENDER_SCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMetaMethod>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+
+#include <QEPluginLibrary_global.h>
+
+/// Provides a single, process wide, frame timer for plotting widgets such as
+/// QEStripChart and QEPlotter, as opposed to each widget running its own timer.
+///
+/// Each frame the attached widgets are ticked in turn, via the specified slot
+/// which takes a single bool parameter, e.g. SLOT (tickTimeout (const bool)).
+/// The parameter is true once per second per widget, when the widget should
+/// do any periodic full replot. These second ticks are staggered across the
+/// widgets so that they do not all replot in the same frame.
+///
+/// Widgets that are not visible (hidden, on a hidden tab or in a minimised
+/// window) are not ticked. The first tick after a widget becomes visible
+/// again is always a second tick.
+///
+/// Once the frame budget has been used, the remaining widgets are deferred to
+/// the next frame (and go first). If frames consistently exceed the budget,
+/// the frame interval is increased (i.e. lower refresh rate), and restored
+/// once the load decreases.
+///
+/// The frame budget (in mSec) may be defined by the QE_RENDER_BUDGET adaptation
+/// parameter, or set programatically using setFrameBudget.
+///
+class QEPLUGINLIBRARYSHARED_EXPORT QERenderScheduler : public QObject {
+   Q_OBJECT
+public:
+   // Attach/detach widget to/from the scheduler.
+   // Example: attach (this, SLOT (tickTimeout (const bool)));
+   //
+   static bool attach (QWidget* target, const char* member);
+   static void detach (QWidget* target);
+
+   // Per frame time budget for all attached widgets.
+   //
+   static void setFrameBudget (const int mSec);
+   static int getFrameBudget ();
+
+   // Current, possibly degraded, frame interval.
+   //
+   static int getFrameInterval ();
+
+private:
+   // The single instance is ONLY created from within this class.
+   //
+   explicit QERenderScheduler (QObject* parent = 0);
+   ~QERenderScheduler ();
+
+   static void initialise ();
+
+   struct Clients {
+      QPointer<QWidget> widget;
+      QMetaMethod method;
+      qint64 nextSecondTick;    // mSec since scheduler start
+      bool wasVisible;
+   };
+
+   static bool isShowing (const QWidget* widget);
+   void adjustFrameInterval (const qint64 frameTime, const bool deferred);
+
+   QTimer* timer;
+   QElapsedTimer clock;
+   QList<Clients> clients;
+   int nextClient;              // client to be ticked first in the next frame
+   int frameBudget;
+   int frameInterval;
+   int numberAttached;          // used to stagger second ticks
+
+private slots:
+   void timeout ();
+};
+
+#endif   // QE_RENDER_SCHEDULER_H
@@ -14,6 +14,7 @@ HEADERS += \
    common/QEDelayedText.h \
    common/QEDisplayRanges.h \
    common/QEExpressionEvaluation.h  \
+   common/QEFalseColour.h \
    common/QEFileMonitor.h  \
    common/QEFixedPointRadix.h \
    common/QEFrameworkVersion.h \
@@ -24,6 +25,7 @@ HEADERS += \
    common/QEGraphicNames.h \
    common/QEOneToOne.h \
    common/QEPlatform.h \
+   common/QERenderScheduler.h \
    common/QEScaling.h \
    common/QEScanTimers.h \
    common/PasswordDialog.h \
@@ -40,6 +42,7 @@ SOURCES += \
    common/QEDelayedText.cpp \
    common/QEDisplayRanges.cpp \
    common/QEExpressionEvaluation.cpp  \
+   common/QEFalseColour.cpp \
    common/QEFileMonitor.cpp  \
    common/QEFixedPointRadix.cpp \
    common/QEFrameworkVersion.cpp \
@@ -48,6 +51,7 @@ SOURCES += \
    common/QEGraphic.cpp \
    common/QEGraphicMarkup.cpp \
    common/QEPlatform.cpp \
+   common/QERenderScheduler.cpp \
    common/QEScaling.cpp \
    common/QEScanTimers.cpp \
    common/PasswordDialog.cpp \
@@ -33,6 +33,7 @@
 #include <QCaObject.h>
 #include <QCaEventUpdate.h>
 #include <CaRecord.h>
+#include <FrameBufferPool.h>
 #include <CaConnection.h>
 
 using namespace qcaobject;
@@ -105,7 +106,6 @@ void QCaObject::initialise( const QString& newRecordName,
     lastValueIsDefined = false;
     lastDataSize = 0;
 
-    lastNewData = NULL;
 
     signalsToSend = signalsToSendIn;
     priority = priorityIn;
@@ -221,10 +221,6 @@ QCaObject::~QCaObject() {
     // however, now safe.
     eventFilter.deleteFilter( eventHandler );
 
-    // Release any 'last data'
-    if( lastNewData )
-        delete (carecord::CaRecord*)lastNewData;
-
     // Release state machines
     delete connectionMachine;
     delete subscriptionMachine;
@@ -1086,58 +1082,56 @@ void QCaObject::processData( void* newDataPtr ) {
     }
 
     // Build and emit a byte array containing the data.
-    // Note, the byte array (and copies of it such as the lastByteArrayValue will
-    // have a pointer directly into the data, so don't delete the data until all
-    // byte arrays referencing it have been deleted.
+    // Note, the byte array shares the reference counted buffer holding the record's
+    // data (the buffer is written once by the CA callback and is not copied here).
+    // The buffer remains valid while any byte array (such as lastByteArrayValue or a
+    // copy held by a widget or its processing thread) references it, regardless of
+    // when the record itself is deleted, so queued connections are safe.
     if( signalsToSend & SIG_BYTEARRAY )
     {
-        char* data;
         unsigned long dataSize = 0;
 
-        // Get a pointer to the data
+        // Get the data element size
         switch( newData->getType() ) {
-            case generic::GENERIC_STRING         : newData->getString       ( (char**)          (&data) ); dataSize = 1; break;
-            case generic::GENERIC_SHORT          : newData->getShort        ( (short**)         (&data) ); dataSize = 2; break;
-            case generic::GENERIC_UNSIGNED_SHORT : newData->getUnsignedShort( (unsigned short**)(&data) ); dataSize = 2; break;
-            case generic::GENERIC_UNSIGNED_CHAR  : newData->getUnsignedChar ( (unsigned char**) (&data) ); dataSize = 1; break;
-            case generic::GENERIC_LONG           : newData->getLong         ( (qint32**)        (&data) ); dataSize = 4; break;
-            case generic::GENERIC_UNSIGNED_LONG  : newData->getUnsignedLong ( (quint32**)       (&data) ); dataSize = 4; break;
-            case generic::GENERIC_FLOAT          : newData->getFloat        ( (float**)         (&data) ); dataSize = 4; break;
-            case generic::GENERIC_DOUBLE         : newData->getDouble       ( (double**)        (&data) ); dataSize = 8; break;
-            case generic::GENERIC_UNKNOWN        : data = NULL;                                            dataSize = 0; break;
+            case generic::GENERIC_STRING         : dataSize = 1; break;
+            case generic::GENERIC_SHORT          : dataSize = 2; break;
+            case generic::GENERIC_UNSIGNED_SHORT : dataSize = 2; break;
+            case generic::GENERIC_UNSIGNED_CHAR  : dataSize = 1; break;
+            case generic::GENERIC_LONG           : dataSize = 4; break;
+            case generic::GENERIC_UNSIGNED_LONG  : dataSize = 4; break;
+            case generic::GENERIC_FLOAT          : dataSize = 4; break;
+            case generic::GENERIC_DOUBLE         : dataSize = 8; break;
+            case generic::GENERIC_UNKNOWN        : dataSize = 0; break;
         }
 
-        // Build a byte array from the data
-        unsigned long arraySize = arrayCount * dataSize;
-        byteArrayValue.resize( arraySize );
-        char* baData = byteArrayValue.data();
-        memcpy( baData, data, arraySize );
+        // Release the previous data.
+        // (If nothing else is still using it, its buffer is returned to the pool)
+        byteArrayValue = QByteArray();
+        FrameBufferPool::releaseBuffer( lastByteArrayValue );
+
+        // Reference the data in a byte array
+        if( newData->getType() == generic::GENERIC_STRING )
+        {
+            // Strings are small and not held in a shared buffer, so just copy it
+            std::string str = newData->getString();
+            byteArrayValue = QByteArray( str.c_str(), (int)(str.size()) );
+        }
+        else
+        {
+            byteArrayValue = newData->getValueBuffer();
+        }
 
         // Save the data just about emited so it can be re-sent if required
         lastByteArrayValue = byteArrayValue;
         lastDataSize = dataSize;
 
         // Send off the new data
-        // NOTE, the signal/slot connections to this signal must be Qt::DirectConnection
-        // as the byte array refernces the data directly which may be deleted before a queued connection is completed
         emit dataChanged( byteArrayValue, dataSize, alarmInfo, timeStamp, variableIndex );
-
-        // Delete any old data now it is no longer referenced by byte arrays
-        if( lastNewData )
-        {
-            delete (carecord::CaRecord*)lastNewData;
-        }
-
-        // Save the current event data for later deletion
-        lastNewData = (void*)newData;
     }
 
-    // If not emiting an array, the data can be deleted (emitted byte arrays have pointers directly into the data)
-    else
-    {
-        // Discard the event data
-        delete newData;
-    }
+    // Discard the event data
+    // (any emitted byte arrays hold their own reference to the data)
+    delete newData;
 }
 
 /*
@@ -1211,8 +1205,6 @@ void QCaObject::resendLastData()
     }
     if( signalsToSend & SIG_BYTEARRAY )
     {
-        // NOTE, the signal/slot connections to this signal must be Qt::DirectConnection as the byte array
-        // refernces the data held in lastNewData directly which may be deleted before a queued connection is completed
         emit dataChanged( lastByteArrayValue, lastDataSize, lastAlarmInfo, lastTimeStamp, variableIndex );
     }
 }
@@ -192,7 +192,6 @@ namespace qcaobject {
       bool         lastValueIsDefined;
       QVariant     lastVariantValue;
       QByteArray   lastByteArrayValue;
-      void*        lastNewData; // Record containing data directly refernced by lastByteArrayValue (actually of type carecord::CaRecord*)
       unsigned long lastDataSize;
 
       // Index to be used to extact scalar value fron an array.
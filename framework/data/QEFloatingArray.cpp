@@ -38,87 +38,275 @@ QEFloatingArray::QEFloatingArray (int size, const double& t) : QVector<double> (
 
 QEFloatingArray::QEFloatingArray (const QVector<double>& other) : QVector<double> (other) { }
 
+// The reduction loops below work on the raw data, and keep several independent
+// partial results, which removes the loop carried dependency and allows the
+// compiler to vectorise the loops (e.g. to SSE/AVX min/max/add instructions).
+//
+#define NUMBER_OF_LANES  4
+
+#define MIN_DELTA_X  (1.0E-20)
+
 //---------------------------------------------------------------------------------
+// Note: this is a simple MIN loop rather than getMinMaxValues, so as to retain
+// the original treatment of NaN values, i.e. a NaN is replaced by the next value.
 //
-double QEFloatingArray::minimumValue (const double& defaultValue)
+double QEFloatingArray::minimumValue (const double& defaultValue) const
 {
-   int n = this->count ();
+   const int n = this->count ();
+   const double* d = this->constData ();
    double r;
 
    if (n == 0) return defaultValue;
-   r = this->value (0);
+   r = d [0];
    for (int j = 1; j < n; j++) {
-      r = MIN (r, this->value (j));
+      r = MIN (r, d [j]);
    }
    return r;
 }
 
 //---------------------------------------------------------------------------------
+// As per minimumValue.
 //
-double QEFloatingArray::maximumValue (const double& defaultValue)
+double QEFloatingArray::maximumValue (const double& defaultValue) const
 {
-   int n = this->count ();
+   const int n = this->count ();
+   const double* d = this->constData ();
    double r;
 
    if (n == 0) return defaultValue;
-   r = this->value (0);
+   r = d [0];
    for (int j = 1; j < n; j++) {
-      r = MAX (r, this->value (j));
+      r = MAX (r, d [j]);
    }
    return r;
 }
 
+//---------------------------------------------------------------------------------
+//
+bool QEFloatingArray::getMinMaxValues (double& minimum, double& maximum) const
+{
+   const int n = this->count ();
+   const double* d = this->constData ();
+   double lo [NUMBER_OF_LANES];
+   double hi [NUMBER_OF_LANES];
+   int j, k;
+
+   if (n == 0) return false;
+
+   for (k = 0; k < NUMBER_OF_LANES; k++) {
+      lo [k] = hi [k] = d [0];
+   }
+
+   for (j = 0; j + NUMBER_OF_LANES <= n; j += NUMBER_OF_LANES) {
+      for (k = 0; k < NUMBER_OF_LANES; k++) {
+         const double v = d [j + k];
+         lo [k] = (v < lo [k]) ? v : lo [k];
+         hi [k] = (v > hi [k]) ? v : hi [k];
+      }
+   }
+   for (; j < n; j++) {
+      lo [0] = MIN (lo [0], d [j]);
+      hi [0] = MAX (hi [0], d [j]);
+   }
+
+   minimum = lo [0];
+   maximum = hi [0];
+   for (k = 1; k < NUMBER_OF_LANES; k++) {
+      minimum = MIN (minimum, lo [k]);
+      maximum = MAX (maximum, hi [k]);
+   }
+   return true;
+}
+
+//---------------------------------------------------------------------------------
+//
+double QEFloatingArray::sum () const
+{
+   const int n = this->count ();
+   const double* d = this->constData ();
+   double s [NUMBER_OF_LANES];
+   int j, k;
+
+   for (k = 0; k < NUMBER_OF_LANES; k++) {
+      s [k] = 0.0;
+   }
+
+   for (j = 0; j + NUMBER_OF_LANES <= n; j += NUMBER_OF_LANES) {
+      for (k = 0; k < NUMBER_OF_LANES; k++) {
+         s [k] += d [j + k];
+      }
+   }
+   for (; j < n; j++) {
+      s [0] += d [j];
+   }
+
+   return (s [0] + s [1]) + (s [2] + s [3]);
+}
+
+//---------------------------------------------------------------------------------
+//
+double QEFloatingArray::mean (const double& defaultValue) const
+{
+   const int n = this->count ();
+
+   if (n == 0) return defaultValue;
+   return this->sum () / double (n);
+}
+
+//---------------------------------------------------------------------------------
+//
+bool QEFloatingArray::getMinMaxValuesIgnoreNaN (double& minimum, double& maximum) const
+{
+   const int n = this->count ();
+   const double* d = this->constData ();
+   int first;
+   int j;
+
+   // Find first non NaN value, if any. Note: NaN != NaN.
+   //
+   for (first = 0; first < n && d [first] != d [first]; first++);
+   if (first >= n) return false;
+
+   // Comparisons with NaN are always false, so NaN values never replace the
+   // current min or max value.
+   //
+   double lo = d [first];
+   double hi = d [first];
+   for (j = first + 1; j < n; j++) {
+      const double v = d [j];
+      lo = (v < lo) ? v : lo;
+      hi = (v > hi) ? v : hi;
+   }
+
+   minimum = lo;
+   maximum = hi;
+   return true;
+}
+
+//---------------------------------------------------------------------------------
+//
+double QEFloatingArray::sumIgnoreNaN (int* count) const
+{
+   const int n = this->count ();
+   const double* d = this->constData ();
+   double s [NUMBER_OF_LANES];
+   int c [NUMBER_OF_LANES];
+   int j, k;
+
+   for (k = 0; k < NUMBER_OF_LANES; k++) {
+      s [k] = 0.0;
+      c [k] = 0;
+   }
+
+   // Select rather than branch, so the loop remains vectorisable.
+   //
+   for (j = 0; j + NUMBER_OF_LANES <= n; j += NUMBER_OF_LANES) {
+      for (k = 0; k < NUMBER_OF_LANES; k++) {
+         const double v = d [j + k];
+         const bool isNumber = (v == v);
+         s [k] += isNumber ? v : 0.0;
+         c [k] += isNumber ? 1 : 0;
+      }
+   }
+   for (; j < n; j++) {
+      const double v = d [j];
+      if (v == v) {
+         s [0] += v;
+         c [0]++;
+      }
+   }
+
+   if (count) {
+      *count = (c [0] + c [1]) + (c [2] + c [3]);
+   }
+   return (s [0] + s [1]) + (s [2] + s [3]);
+}
+
+//---------------------------------------------------------------------------------
+//
+double QEFloatingArray::meanIgnoreNaN (const double& defaultValue) const
+{
+   int count;
+   const double s = this->sumIgnoreNaN (&count);
+
+   if (count == 0) return defaultValue;
+   return s / double (count);
+}
+
+//---------------------------------------------------------------------------------
+//
+void QEFloatingArray::scaleOffset (const double scale, const double offset)
+{
+   const int n = this->count ();
+   double* d = this->data ();
+
+   for (int j = 0; j < n; j++) {
+      d [j] = scale * d [j] + offset;
+   }
+}
+
 //---------------------------------------------------------------------------------
 //
 QEFloatingArray QEFloatingArray::calcDyByDx (const QVector<double>& x)
 {
-   const int size = MIN (this->size(), x.size());
    QEFloatingArray result;
+
+   this->calcDyByDx (x, result);
+   return result;
+}
+
+//---------------------------------------------------------------------------------
+//
+void QEFloatingArray::calcDyByDx (const QVector<double>& x, QVector<double>& result) const
+{
+   const int size = MIN (this->size(), x.size());
+   const double* xp = x.constData ();
+   const double* yp = this->constData ();
+   double* r;
    double s;
    int j;
 
-   result.clear ();
+   result.resize (size);
+   r = result.data ();
 
    if (size == 1) {
-      result.append (0.0);
+      r [0] = 0.0;
 
    } else if (size == 2) {
 
-      s = derivative (x.value (0), this->value (0),
-                      x.value (1), this->value (1));
+      s = derivative (xp [0], yp [0], xp [1], yp [1]);
 
-      result.append (s);
-      result.append (s);
+      r [0] = s;
+      r [1] = s;
 
    } else if (size >= 3) {
 
       // First point.
       //
-      s = derivative (x.value (0), this->value (0),
-                      x.value (1), this->value (1));
-      result.append (s);
+      r [0] = derivative (xp [0], yp [0], xp [1], yp [1]);
 
-      // Middle points.
+      // Middle points. This is the three-point derivative function in line,
+      // with a select rather than a branch to avoid the divide by zero, so that
+      // the compiler may vectorise the loop. The results are identical.
       //
       for (j = 1 ; j < size - 1; j++) {
-         s = derivative (x.value(j - 1), this->value(j - 1),
-                         x.value(j    ), this->value(j    ),
-                         x.value(j + 1), this->value(j + 1));
-         result.append (s);
+         const double x1 = xp [j - 1] - xp [j];
+         const double y1 = yp [j - 1] - yp [j];
+         const double x3 = xp [j + 1] - xp [j];
+         const double y3 = yp [j + 1] - yp [j];
+         const double divisor = x1*x3*(x3 - x1);
+         const bool isOkay = (ABS (divisor) >= MIN_DELTA_X);
+
+         r [j] = isOkay ? (y1*x3*x3 - y3*x1*x1) / (isOkay ? divisor : 1.0) : 0.0;
       }
 
       // Last point.
       //
-      s = derivative (x.value (size - 2), this->value (size - 2),
-                      x.value (size - 1), this->value (size - 1));
-      result.append (s);
+      r [size - 1] = derivative (xp [size - 2], yp [size - 2],
+                                 xp [size - 1], yp [size - 1]);
    }
-
-   return result;
 }
 
-#define MIN_DELTA_X  (1.0E-20)
-
 //---------------------------------------------------------------------------------
 // static
 double QEFloatingArray::derivative (const double xp1, const double yp1,
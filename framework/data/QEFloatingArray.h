@@ -44,14 +44,43 @@ public:
    // Find min/max values of the array. If array has zero elements then
    // the returned value is the defaultValue .
    //
-   double minimumValue (const double& defaultValue = 0.0);
-   double maximumValue (const double& defaultValue = 0.0);
+   double minimumValue (const double& defaultValue = 0.0) const;
+   double maximumValue (const double& defaultValue = 0.0) const;
+
+   // Find both min and max values in one pass. Returns false (and leaves
+   // minimum and maximum unchanged) if the array has zero elements.
+   // Note: this, and the sum/mean functions below, assume that the array does
+   // not contain any NaN values - use the IgnoreNaN variants if it might.
+   //
+   bool getMinMaxValues (double& minimum, double& maximum) const;
+
+   // Sum and mean of the array. The mean of a zero element array is the defaultValue.
+   //
+   double sum () const;
+   double mean (const double& defaultValue = 0.0) const;
+
+   // NaN aware variants - NaN elements are ignored. The count, if specified,
+   // returns the number of non-NaN elements.
+   //
+   bool getMinMaxValuesIgnoreNaN (double& minimum, double& maximum) const;
+   double sumIgnoreNaN (int* count = 0) const;
+   double meanIgnoreNaN (const double& defaultValue = 0.0) const;
+
+   // Applies y = scale.x + offset to each element in place.
+   //
+   void scaleOffset (const double scale, const double offset);
 
    // Calculates dThis/dx for each point using a series of three-point
    // polynomials. First an last point based to a two-point polynomial.
    //
    QEFloatingArray calcDyByDx (const QVector<double>& x);
 
+   // As above, but calculates into the result array in place, so no allocation
+   // is required when the result array is re-used and the size is steady.
+   // The middle points are evaluated by a branch free loop.
+   //
+   void calcDyByDx (const QVector<double>& x, QVector<double>& result) const;
+
 private:
    static double derivative (const double xp1, const double yp1,
                              const double xp2, const double yp2);
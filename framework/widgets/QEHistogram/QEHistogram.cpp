@@ -26,6 +26,7 @@
 
 #include <QDebug>
 #include <QBrush>
+#include <QPaintEvent>
 #include <QPen>
 
 #include <QECommon.h>
@@ -88,6 +89,7 @@ QEHistogram::QEHistogram (QWidget *parent) : QFrame (parent)
    this->mMinimum = 0.0;
    this->mMaximum = 10.0;
    this->mOrientation = Qt::Horizontal;
+   this->mDecimation = NoDecimation;
    this->mTestSize = 0;
 
    // Create internal widgets
@@ -109,6 +111,12 @@ QEHistogram::QEHistogram (QWidget *parent) : QFrame (parent)
    this->dataArray.reserve (100);
    this->numberDisplayed = 0;
    this->firstDisplayed = 0;
+   this->isDecimated = false;
+
+   this->autoRangeIsValid = false;
+   this->autoRangeFound = false;
+   this->autoMinimum = 0.0;
+   this->autoMaximum = 0.0;
 
    // Do this only once, not in paintEvent as it causes another paint event.
    //
@@ -151,6 +159,7 @@ void QEHistogram::clear ()
    this->firstDisplayed = 0;
    this->dataArray.clear ();
    this->colourArray.clear ();
+   this->autoRangeIsValid = false;
    this->update ();
 }
 
@@ -159,6 +168,11 @@ void QEHistogram::clear ()
 void QEHistogram::setColour (const int index, const QColor& value)
 {
    if (index >= 0 && index < MAX_CAPACITY) {     // sanity check
+      // Widgets such as QEWaveformHistogram (re)set every colour on every
+      // update - avoid repainting anything when nothing has changed.
+      //
+      if (this->colourArray.value (index, NO_COLOUR_VALUE) == value) return;
+
       while (this->colourArray.count () < index + 1) {
          this->colourArray.append (NO_COLOUR_VALUE);
       }
@@ -170,7 +184,7 @@ void QEHistogram::setColour (const int index, const QColor& value)
          this->colourArray.remove (this->colourArray.count () - 1);
       }
 
-      this->update ();
+      this->updateDataRange (index, index);
    }
 }
 
@@ -179,6 +193,9 @@ void QEHistogram::setColour (const int index, const QColor& value)
 void QEHistogram::setValue (const int index, const double value)
 {
    if (index >= 0 && index < MAX_CAPACITY) {     // sanity check
+      const int oldCount = this->dataArray.count ();
+      const double oldValue = this->dataArray.value (index, NO_DATA_VALUE);
+
       while (this->dataArray.count () < index + 1) {
          this->dataArray.append (NO_DATA_VALUE);
       }
@@ -190,7 +207,27 @@ void QEHistogram::setValue (const int index, const double value)
          this->dataArray.remove (this->dataArray.count () - 1);
       }
 
-      this->update ();
+      // The auto scale range is unaffected if the old value was neither the
+      // min nor max value and the new value is within the current range.
+      //
+      bool rangeKept = false;
+      if (this->mAutoScale && this->autoRangeIsValid) {
+         const bool oldInside = isNullDataValue (oldValue) ||
+                                (oldValue > this->autoMinimum && oldValue < this->autoMaximum);
+         const bool newInside = isNullDataValue (value) ||
+                                (value >= this->autoMinimum && value <= this->autoMaximum);
+         rangeKept = oldInside && newInside;
+      }
+
+      if (!rangeKept) {
+         this->autoRangeIsValid = false;
+      }
+
+      if (this->dataArray.count () == oldCount && (rangeKept || !this->mAutoScale)) {
+         this->updateDataRange (index, index);
+      } else {
+         this->update ();
+      }
    }
 }
 
@@ -212,8 +249,106 @@ double QEHistogram::value (const int index) const
 //
 void QEHistogram::setValues (const DataArray& values)
 {
+   const DataArray previous = this->dataArray;
+   const int n = values.count ();
+
    this->dataArray = values;
-   this->update ();
+   this->autoRangeIsValid = false;
+
+   if (previous.count () != n) {
+      this->update ();
+      return;
+   }
+
+   // Same number of values - find the range of values that have changed,
+   // and if the scale is unchanged, just repaint that part of the histogram.
+   //
+   const double* oldData = previous.constData ();
+   const double* newData = values.constData ();
+   int first = 0;
+   int last = n - 1;
+
+   while (first < n && oldData [first] == newData [first]) first++;
+   if (first >= n) return;     // nothing has changed
+   while (last > first && oldData [last] == newData [last]) last--;
+
+   if (this->mAutoScale) {
+      const bool oldFound = this->autoRangeFound;
+      const double oldMinimum = this->autoMinimum;
+      const double oldMaximum = this->autoMaximum;
+
+      this->updateAutoRange ();
+      if (this->autoRangeFound != oldFound ||
+          this->autoMinimum != oldMinimum || this->autoMaximum != oldMaximum) {
+         this->update ();
+         return;
+      }
+   }
+
+   this->updateDataRange (first, last);
+}
+
+//------------------------------------------------------------------------------
+//
+void QEHistogram::updateAutoRange ()
+{
+   const double* data = this->dataArray.constData ();
+   const int n = this->dataArray.count ();
+   bool foundValue = false;
+   double searchMinimum = +1.0E25;
+   double searchMaximum = -1.0E25;
+
+   for (int j = 0; j < n; j++) {
+      const double v = data [j];
+      if (isNullDataValue (v)) continue;
+      searchMinimum = MIN (v, searchMinimum);
+      searchMaximum = MAX (v, searchMaximum);
+      foundValue = true;
+   }
+
+   this->autoRangeFound = foundValue;
+   this->autoMinimum = searchMinimum;
+   this->autoMaximum = searchMaximum;
+   this->autoRangeIsValid = true;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEHistogram::updateDataRange (const int first, const int last)
+{
+   const int n = this->dataArray.count ();
+
+   if (!this->paintArea.isValid () || n < 1) {
+      this->update ();    // no layout yet - paint everything
+      return;
+   }
+
+   if (first >= n) return;    // e.g. colour of an item with no value
+
+   QRect dirty;
+
+   if (this->isDecimated) {
+      // Column c displays items c*n/width to (c+1)*n/width - 1 - allow for
+      // rounding by including the neighbouring columns.
+      //
+      const int width = this->paintArea.width ();
+      const int firstColumn = MAX ((int) (((qint64) first * width) / n) - 1, 0);
+      const int lastColumn  = MIN ((int) (((qint64) (last + 1) * width) / n) + 1, width - 1);
+
+      dirty = QRect (QPoint (this->paintArea.left () + firstColumn, this->paintArea.top ()),
+                     QPoint (this->paintArea.left () + lastColumn,  this->paintArea.bottom ()));
+   } else {
+      const int firstPosn = MAX (first - this->firstDisplayed, 0);
+      const int lastPosn  = MIN (last  - this->firstDisplayed, this->numberDisplayed - 1);
+
+      if (firstPosn > lastPosn) return;   // none of the items are displayed
+
+      dirty = this->fullBarRect (firstPosn).united (this->fullBarRect (lastPosn));
+   }
+
+   // Allow for the bar border pen.
+   //
+   this->histogramArea->update (dirty.adjusted (-1, -1, +1, +1));
 }
 
 //------------------------------------------------------------------------------
@@ -240,6 +375,7 @@ QColor QEHistogram::getPaintColour (const int index) const
 //
 int QEHistogram::scrollMaximum () const
 {
+   if (this->isDecimated) return 0;    // all displayed
    return MAX (0, this->dataArray.count () - this->numberDisplayed);
 }
 
@@ -290,6 +426,19 @@ int QEHistogram::indexOfPosition (const int x, const int y) const
    const int hax = x - this->histogramArea->geometry ().left ();
    const int hay = y - this->histogramArea->geometry ().top ();
 
+   if (this->isDecimated) {
+      // Return the first item of the pixel column.
+      //
+      const int column = hax - this->paintArea.left ();
+      const int width = this->paintArea.width ();
+
+      if (column < 0 || column >= width ||
+          hay < this->paintArea.top () || hay > this->paintArea.bottom ()) return -1;
+
+      const int index = (int) (((qint64) column * this->count ()) / width);
+      return (index < this->count ()) ? index : -1;
+   }
+
    const int guess = (hax - this->firstBarLeft ()) /
                      MAX (1, this->useBarWidth + this->useGap + 1);
 
@@ -325,12 +474,26 @@ int QEHistogram::indexOfPosition (const QPoint& p) const
 
 //------------------------------------------------------------------------------
 //
-bool QEHistogram::paintItem (QPainter& painter,
-                             const int position,
-                             const int valueIndex) const
+bool QEHistogram::displayedBarRect (const int position, QRect& bar) const
 {
    const int finishRight = this->paintArea.right ();
-   QRect bar;
+
+   bar = this->fullBarRect (position);
+   if (bar.left () >= finishRight) return false;   // Off to the side
+   if (bar.right () > finishRight) {
+      bar.setRight (finishRight);                  // Truncate
+      if (bar.width () < 5) return false;          // Tooo small!!
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEHistogram::paintItem (QPainter& painter,
+                             const QRect& fullBar,
+                             const int valueIndex) const
+{
+   QRect bar = fullBar;
    double value;
    double base;
    double baseLineFraction;
@@ -342,19 +505,12 @@ bool QEHistogram::paintItem (QPainter& painter,
    QBrush brush;
    QPen pen;
 
-   bar = this->fullBarRect (position);
-   if (bar.left () >= finishRight) return false;   // Off to the side
-   if (bar.right () > finishRight) {
-      bar.setRight (finishRight);                  // Truncate
-      if (bar.width () < 5) return false;          // Tooo small!!
-   }
-
    value = this->dataArray.value (valueIndex, NO_DATA_VALUE);
    base = this->mBaseLine;
 
    // Is value invalid, i.e. un-defined BUT still in paint area?
    //
-   if (isNullDataValue (value)) return true;
+   if (isNullDataValue (value)) return;
 
    if (this->mLogScale) {
       value = LOG10 (value);
@@ -403,7 +559,100 @@ bool QEHistogram::paintItem (QPainter& painter,
    painter.setPen (pen);
 
    painter.drawRect (bar);
-   return true;
+}
+
+//------------------------------------------------------------------------------
+// Same calculation as used in paintItem.
+//
+int QEHistogram::valueToY (const double value) const
+{
+   const double v = this->mLogScale ? LOG10 (value) : value;
+   double fraction = (v                 - this->drawMinimum) /
+                     (this->drawMaximum - this->drawMinimum);
+   fraction = LIMIT (fraction, 0.0, 1.0);
+
+   return this->paintArea.bottom () - (int) (fraction * this->paintArea.height ());
+}
+
+//------------------------------------------------------------------------------
+// Each pixel column of the paint area represents the items c*n/width up to
+// (c+1)*n/width - 1, or the nearest item when there are fewer items than
+// columns. One vertical line is drawn per column, from the base line to the
+// mean value or spanning the min to max values, in the colour of the first
+// item of the column.
+//
+void QEHistogram::paintDecimated (QPainter& painter, const QRect& dirty) const
+{
+   const double* data = this->dataArray.constData ();
+   const int n = this->dataArray.count ();
+   const int left = this->paintArea.left ();
+   const int width = this->paintArea.width ();
+   const int baseY = this->valueToY (this->mBaseLine);
+
+   const int firstColumn = MAX (dirty.left () - left, 0);
+   const int lastColumn  = MIN (dirty.right () - left, width - 1);
+
+   QVector<QLine> lines;
+   QColor lineColour;
+
+   lines.reserve (lastColumn - firstColumn + 1);
+
+   for (int column = firstColumn; column <= lastColumn; column++) {
+      const int from = (int) (((qint64) column * n) / width);
+      const int to = MAX ((int) (((qint64) (column + 1) * n) / width) - 1, from);
+
+      double minimum = 0.0;
+      double maximum = 0.0;
+      double sum = 0.0;
+      int number = 0;
+
+      for (int j = from; j <= to; j++) {
+         const double v = data [j];
+         if (isNullDataValue (v)) continue;
+         if (number == 0) {
+            minimum = maximum = v;
+         } else {
+            minimum = MIN (v, minimum);
+            maximum = MAX (v, maximum);
+         }
+         sum += v;
+         number++;
+      }
+
+      if (number == 0) continue;    // all null - nothing to draw
+
+      int top;
+      int bot;
+      if (this->mDecimation == MeanDecimation) {
+         top = bot = this->valueToY (sum / number);
+      } else {
+         top = this->valueToY (maximum);
+         bot = this->valueToY (minimum);
+      }
+
+      // Like the bars, include the base line.
+      //
+      top = MIN (top, baseY);
+      bot = MAX (bot, baseY);
+
+      // Draw batches of same colour lines.
+      //
+      QColor colour = this->getPaintColour (from);
+      if (colour != lineColour) {
+         if (!lines.isEmpty ()) {
+            painter.drawLines (lines);
+            lines.clear ();
+         }
+         lineColour = colour;
+         painter.setPen (QPen (this->isEnabled () ? colour : QEUtilities::blandColour (colour), 1));
+      }
+
+      lines.append (QLine (left + column, top, left + column, bot));
+   }
+
+   if (!lines.isEmpty ()) {
+      painter.drawLines (lines);
+   }
 }
 
 //------------------------------------------------------------------------------
@@ -521,7 +770,56 @@ void QEHistogram::paintGrid (QPainter& painter) const
 
 //------------------------------------------------------------------------------
 //
-void QEHistogram::paintAllItems ()
+bool QEHistogram::GridLayer::operator== (const GridLayer& other) const
+{
+   return (this->size == other.size) &&
+          (this->paintArea == other.paintArea) &&
+          (this->font == other.font) &&
+          (this->background == other.background) &&
+          (this->drawMinimum == other.drawMinimum) &&
+          (this->drawMaximum == other.drawMaximum) &&
+          (this->drawMajor == other.drawMajor) &&
+          (this->showScale == other.showScale) &&
+          (this->showGrid == other.showGrid) &&
+          (this->logScale == other.logScale) &&
+          (this->enabled == other.enabled);
+}
+
+//------------------------------------------------------------------------------
+//
+void QEHistogram::paintGridLayer (QPainter& painter)
+{
+   GridLayer layer;
+
+   layer.size = this->histogramArea->size ();
+   layer.paintArea = this->paintArea;
+   layer.font = this->histogramArea->font ();
+   layer.background = this->getBackgroundColour ();
+   layer.drawMinimum = this->drawMinimum;
+   layer.drawMaximum = this->drawMaximum;
+   layer.drawMajor = this->drawMajor;
+   layer.showScale = this->mShowScale;
+   layer.showGrid = this->mShowGrid;
+   layer.logScale = this->mLogScale;
+   layer.enabled = this->isEnabled ();
+
+   if (this->gridPixmap.isNull () || !(layer == this->gridLayer)) {
+      this->gridLayer = layer;
+      this->gridPixmap = QPixmap (layer.size);
+      this->gridPixmap.fill (Qt::transparent);
+
+      QPainter gridPainter (&this->gridPixmap);
+      gridPainter.setRenderHint (QPainter::Antialiasing, false);
+      gridPainter.setFont (layer.font);
+      this->paintGrid (gridPainter);
+   }
+
+   painter.drawPixmap (0, 0, this->gridPixmap);
+}
+
+//------------------------------------------------------------------------------
+//
+void QEHistogram::paintAllItems (const QRect& dirty)
 {
    const int numberGrid = 5;   // approx number of y grid lines.
    const int margin = QEScaling::scale (3);
@@ -543,19 +841,12 @@ void QEHistogram::paintAllItems ()
    double useMinimum = this->mMinimum;
    double useMaximum = this->mMaximum;
    if (this->mAutoScale) {
-      bool foundValue = false;
-      double searchMinimum = +1.0E25;
-      double searchMaximum = -1.0E25;
-      for (int j = 0; j < this->dataArray.count (); j++) {
-         double v = this->dataArray.at (j);
-         if (isNullDataValue (v)) continue;
-         searchMinimum  = MIN (v, searchMinimum);
-         searchMaximum  = MAX (v, searchMaximum);
-         foundValue = true;
+      if (!this->autoRangeIsValid) {
+         this->updateAutoRange ();
       }
-      if (foundValue) {
-         useMinimum  = searchMinimum;
-         useMaximum  = searchMaximum;
+      if (this->autoRangeFound) {
+         useMinimum  = this->autoMinimum;
+         useMaximum  = this->autoMaximum;
       }
    }
 
@@ -597,7 +888,7 @@ void QEHistogram::paintAllItems ()
 
    // Do grid and axis - note this might tweak useMinimum/useMaximum.
    //
-   this->paintGrid (painter);
+   this->paintGridLayer (painter);
 
    this->useGap = this->mGap;
    this->useBarWidth = this->mBarWidth;
@@ -620,18 +911,35 @@ void QEHistogram::paintAllItems ()
       }
    }
 
-   // Maximum number of items that could be drawn.
+   // Decimate when there are more items than can be drawn as bars.
    //
-   const int maxDrawable = this->dataArray.count () - this->firstDisplayed;
+   const int n = this->dataArray.count ();
+   const int pitch = (int) (this->useBarWidth + this->useGap + 1);
+   this->isDecimated = (this->mDecimation != NoDecimation) &&
+                       (n > this->paintArea.width () / MAX (1, pitch));
 
-   this->numberDisplayed = 0;
-   for (int posnIndex = 0; posnIndex < maxDrawable; posnIndex++) {
-      int dataIndex = this->firstDisplayed + posnIndex;
-      bool painted = paintItem (painter, posnIndex, dataIndex);
-      if (painted) {
+   if (this->isDecimated) {
+      this->firstDisplayed = 0;
+      this->numberDisplayed = n;
+      this->paintDecimated (painter, dirty);
+
+   } else {
+      // Maximum number of items that could be drawn.
+      //
+      const int maxDrawable = n - this->firstDisplayed;
+
+      this->numberDisplayed = 0;
+      for (int posnIndex = 0; posnIndex < maxDrawable; posnIndex++) {
+         QRect bar;
+         if (!this->displayedBarRect (posnIndex, bar)) break;
          this->numberDisplayed = posnIndex + 1;
-      } else {
-         break;
+
+         // Only paint bars (plus border) within the area being repainted.
+         //
+         if (bar.adjusted (-1, -1, +1, +1).intersects (dirty)) {
+            const int dataIndex = this->firstDisplayed + posnIndex;
+            this->paintItem (painter, bar, dataIndex);
+         }
       }
    }
 
@@ -651,7 +959,8 @@ bool QEHistogram::eventFilter (QObject *obj, QEvent* event)
 
    if (type == QEvent::Paint) {
       if (obj == this->histogramArea) {
-         this->paintAllItems ();
+         QPaintEvent* paintEvent = static_cast<QPaintEvent*> (event);
+         this->paintAllItems (paintEvent->rect ());
          result = true;  // event has been handled
       }
    }
@@ -684,6 +993,7 @@ void QEHistogram::createTestData ()
       this->dataArray << v;
       this->colourArray << c;
    }
+   this->autoRangeIsValid = false;
 }
 
 //==============================================================================
@@ -724,6 +1034,7 @@ PROPERTY_ACCESS (bool,   DrawBorder,       value,
 PROPERTY_ACCESS (QColor, BackgroundColour, value,                                                 NO_EXTRA)
 PROPERTY_ACCESS (QColor, BarColour,        value,                                                 NO_EXTRA)
 PROPERTY_ACCESS (Qt::Orientation,  Orientation,  value,                                           NO_EXTRA)
+PROPERTY_ACCESS (Decimations, Decimation,  value,                                                 NO_EXTRA)
 PROPERTY_ACCESS (int,    TestSize,         LIMIT (value, 0, MAX_CAPACITY),                        this->createTestData ())
 
 #undef PROPERTY_ACCESS
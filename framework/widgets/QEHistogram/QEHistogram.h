@@ -29,8 +29,10 @@
 
 #include <QColor>
 #include <QEvent>
+#include <QFont>
 #include <QFrame>
 #include <QPainter>
+#include <QPixmap>
 #include <QPoint>
 #include <QRect>
 #include <QScrollBar>
@@ -42,10 +44,23 @@
 /// The QEHistogram class is a non-EPICS aware histogram widget.
 /// The value of, i.e. the length of each bar, and colour may be set indepedently.
 ///
+/// When decimation is selected and there are more values than can be drawn as
+/// individual bars, the values are aggregated per pixel column and all values
+/// are displayed without a scroll bar.
+///
 class QEPLUGINLIBRARYSHARED_EXPORT QEHistogram:public QFrame {
    Q_OBJECT
 
 public:
+   /// \enum Decimations
+   enum Decimations {
+      NoDecimation,        ///< Always draw individual bars, scroll if needs be.
+      MinMaxDecimation,    ///< Draw min to max range of values per pixel column.
+      MeanDecimation       ///< Draw mean of values per pixel column.
+   };
+
+   Q_ENUMS (Decimations)
+
    Q_PROPERTY (bool   autoBarGapWidths READ getAutoBarGapWidths WRITE setAutoBarGapWidths)
    Q_PROPERTY (int    barWidth         READ getBarWidth         WRITE setBarWidth)
    Q_PROPERTY (int    gap              READ getGap              WRITE setGap)
@@ -61,6 +76,7 @@ public:
    Q_PROPERTY (QColor barColour        READ getBarColour        WRITE setBarColour)
    Q_PROPERTY (bool   drawBorder       READ getDrawBorder       WRITE setDrawBorder)
    Q_PROPERTY (Qt::Orientation orientation READ getOrientation  WRITE setOrientation)
+   Q_PROPERTY (Decimations decimation  READ getDecimation       WRITE setDecimation)
 
    // Test - used for previewing/testing - may be removed.
    //
@@ -98,6 +114,7 @@ public:
    PROPERTY_ACCESS (QColor, BackgroundColour)
    PROPERTY_ACCESS (QColor, BarColour)
    PROPERTY_ACCESS (Qt::Orientation, Orientation)
+   PROPERTY_ACCESS (Decimations, Decimation)
    //
    PROPERTY_ACCESS (int,    TestSize)
 #undef PROPERTY_ACCESS
@@ -127,16 +144,33 @@ private:
    int   firstBarLeft () const;
    QRect fullBarRect (const int position) const;
 
+   // Returns true if item position is in the paintArea, and the bar rectangle
+   // truncated to the paintArea.
+   bool displayedBarRect (const int position, QRect& bar) const;
+
    QString coordinateText (const double value) const;
    int maxPaintTextWidth (QPainter& painter) const;
    void paintGrid (QPainter& painter) const;
 
-   // Returns true if item position is in the paintArea
-   bool paintItem (QPainter& painter, const int position, const int index) const;
+   // Paints the background grid/scale layer from the cache, regenerating the
+   // cache only when the layer has changed.
+   void paintGridLayer (QPainter& painter);
+
+   void paintItem (QPainter& painter, const QRect& fullBar, const int index) const;
+
+   // Paints the pixel columns that intersect dirty when decimating.
+   void paintDecimated (QPainter& painter, const QRect& dirty) const;
+   int valueToY (const double value) const;
 
-   void paintAllItems ();
+   void paintAllItems (const QRect& dirty);
    bool eventFilter (QObject* obj, QEvent* event);
 
+   // Finds the min/max of all values, ignoring null values.
+   void updateAutoRange ();
+
+   // Schedules a repaint of just the area occupied by items first to last.
+   // The caller ensures the number of items and the scale are unchanged.
+   void updateDataRange (const int first, const int last);
    int scrollMaximum () const;
 
    // Detrmines the color to paint. If slot has a specific colour, that colour
@@ -186,6 +220,7 @@ private:
    bool mShowGrid;
    bool mLogScale;
    Qt::Orientation mOrientation;
+   Decimations mDecimation;
    int mTestSize;
 
    int firstDisplayed;
@@ -195,6 +230,34 @@ private:
    double drawMajor;
    double useGap;
    double useBarWidth;
+   bool isDecimated;          // last paint aggregated values per pixel column
+
+   // Auto scale range of the data - re-evaluated only when the data changes.
+   //
+   bool autoRangeIsValid;
+   bool autoRangeFound;
+   double autoMinimum;
+   double autoMaximum;
+
+   // The grid/scale layer cache and what it was drawn for.
+   //
+   struct GridLayer {
+      QSize size;
+      QRect paintArea;
+      QFont font;
+      QColor background;
+      double drawMinimum;
+      double drawMaximum;
+      double drawMajor;
+      bool showScale;
+      bool showGrid;
+      bool logScale;
+      bool enabled;
+      bool operator== (const GridLayer& other) const;
+   };
+
+   GridLayer gridLayer;
+   QPixmap gridPixmap;
 
 private slots:
    void scrollBarValueChanged (int value);
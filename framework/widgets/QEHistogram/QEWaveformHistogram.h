@@ -88,6 +88,7 @@ public:
    Q_PROPERTY (QColor barColour        READ getBarColour        WRITE setBarColour)
    Q_PROPERTY (bool   drawBorder       READ getDrawBorder       WRITE setDrawBorder)
    Q_PROPERTY (Qt::Orientation orientation READ getOrientation  WRITE setOrientation)
+   Q_PROPERTY (QEHistogram::Decimations decimation READ getDecimation WRITE setDecimation)
 
 public:
    explicit QEWaveformHistogram (QWidget* parent = 0);
@@ -111,6 +112,7 @@ public:
    QE_EXPOSE_INTERNAL_OBJECT_FUNCTIONS (histogram, QColor, getBackgroundColour, setBackgroundColour)
    QE_EXPOSE_INTERNAL_OBJECT_FUNCTIONS (histogram, QColor, getBarColour,  setBarColour)
    QE_EXPOSE_INTERNAL_OBJECT_FUNCTIONS (histogram, Qt::Orientation, getOrientation, setOrientation)
+   QE_EXPOSE_INTERNAL_OBJECT_FUNCTIONS (histogram, QEHistogram::Decimations, getDecimation, setDecimation)
 
 protected:
    qcaobject::QCaObject* createQcaItem (unsigned int variableIndex);
@@ -97,6 +97,22 @@ void QEImage::setup() {
     infoUpdatePaused( paused );
     pauseExternalAction = NULL;
 
+    continuousAutoBrightnessContrast = false;
+    autoLowPercentile = 0.1;
+    autoHighPercentile = 99.9;
+    autoSmoothing = 0.8;
+    haveAutoRange = false;
+    autoLow = 0.0;
+    autoHigh = 0.0;
+
+    displayPerformance = false;
+    framesReceived = 0;
+    lastReceiveLatency = 0.0;
+    lastHistogramTime = 0.0;
+    lastFramesReceived = 0;
+    lastFramesPainted = 0;
+    pipelineStatisticsTimer.start();
+
     vSlice1Thickness = 1;
     vSlice2Thickness = 1;
     vSlice3Thickness = 1;
@@ -254,8 +270,12 @@ void QEImage::setup() {
     recorder = new recording( this );
     QObject::connect(recorder, SIGNAL(destroyed(QObject*)), this, SLOT(recorderDestroyed(QObject*)));
     QObject::connect(recorder, SIGNAL(playingBack(bool)), this, SLOT(playingBack(bool)));
-    QObject::connect( recorder,  SIGNAL( byteArrayChanged( const QByteArray&, unsigned long, QCaAlarmInfo&, QCaDateTime&, const unsigned int& ) ),
-                      this, SLOT( setImage( const QByteArray&, unsigned long, QCaAlarmInfo&, QCaDateTime&, const unsigned int& ) ) );
+    QObject::connect( recorder,  SIGNAL( recordedImageChanged( const QByteArray&, recordedImageInfo& ) ),
+                      this, SLOT( setRecordedImage( const QByteArray&, recordedImageInfo& ) ) );
+    liveWidth = 0;
+    liveHeight = 0;
+    liveFormat = imageDataFormats::MONO;
+    liveBitDepth = 8;
 
     // Create vertical, horizontal, and general profile plots
     vSliceLabel = new QLabel( "Vertical Profile" );
@@ -398,6 +418,8 @@ void QEImage::setup() {
 
     // Connect to the image process to be able to receive images as they are built from image data
     QObject::connect( &iProcessor, SIGNAL( imageBuilt( QImage, QString ) ), this, SLOT( displayBuiltImage( QImage, QString ) ) );
+    QObject::connect( &iProcessor, SIGNAL( beamAnalysed( beamAnalysisResultsList ) ), this, SLOT( useBeamAnalysis( beamAnalysisResultsList ) ) );
+    QObject::connect( &iProcessor, SIGNAL( profilesGenerated( profileResults ) ), this, SLOT( useProfiles( profileResults ) ) );
 
     // !! move this functionality into QEWidget???
     // !! needs one for single variables and one for multiple variables, or just the multiple variable one for all
@@ -662,6 +684,13 @@ qcaobject::QCaObject* QEImage::createQcaItem( unsigned int variableIndex ) {
         case PROFILE_V_ARRAY:
         case PROFILE_LINE_ARRAY:
 
+        case BEAM_CENTROID_X_VARIABLE:
+        case BEAM_CENTROID_Y_VARIABLE:
+        case BEAM_SIGMA_X_VARIABLE:
+        case BEAM_SIGMA_Y_VARIABLE:
+        case BEAM_PEAK_VARIABLE:
+        case BEAM_INTEGRAL_VARIABLE:
+
             return new QEFloating( getSubstitutedVariableName( variableIndex ), this, &floatingFormatting, variableIndex );
 
         default:
@@ -849,6 +878,13 @@ void QEImage::establishConnection( unsigned int variableIndex ) {
         case PROFILE_V_ARRAY:
         case PROFILE_LINE_ARRAY:
 
+        case BEAM_CENTROID_X_VARIABLE:
+        case BEAM_CENTROID_Y_VARIABLE:
+        case BEAM_SIGMA_X_VARIABLE:
+        case BEAM_SIGMA_Y_VARIABLE:
+        case BEAM_PEAK_VARIABLE:
+        case BEAM_INTEGRAL_VARIABLE:
+
             break;
 
         // Connect to ellipse variables
@@ -1423,6 +1459,68 @@ void QEImage::useTargetingData()
     }
 }
 
+// Use the results of a beam analysis performed by the image processor.
+// Results are available for each selected area (or the entire image if no area is selected).
+// The beam markup is moved to the beam found in the first of these (the lowest numbered selected area)
+// (the fitted centre if available, otherwise the centroid) and its results are written to any beam analysis variables.
+// All results are available through getAllBeamAnalysisResults().
+void QEImage::useBeamAnalysis( beamAnalysisResultsList resultsList )
+{
+    // Save the results
+    lastBeamAnalysis = resultsList;
+
+    // Use the first area analysed
+    if( resultsList.isEmpty() )
+    {
+        return;
+    }
+    const beamAnalysisResults& results = resultsList.first();
+
+    // Nothing more to do if no beam was found
+    if( !results.valid )
+    {
+        return;
+    }
+
+    // Update the beam position and present it
+    double x = results.fitValid ? results.fitX : results.centroidX;
+    double y = results.fitValid ? results.fitY : results.centroidY;
+    beamInfo.setPoint( QPoint( qRound( x ), qRound( y ) ) );
+
+    if( videoWidget->hasCurrentImage() )
+    {
+        videoWidget->markupBeamValueChange( iProcessor.rotateFlipToImagePoint( beamInfo.getPoint() ), displayMarkups );
+    }
+    infoUpdateBeam( beamInfo.getPoint().x(), beamInfo.getPoint().y() );
+
+    // Write the beam analysis variables
+    QEFloating *qca;
+    qca = (QEFloating*)getQcaItem( BEAM_CENTROID_X_VARIABLE );
+    if( qca ) qca->writeFloating( results.centroidX );
+
+    qca = (QEFloating*)getQcaItem( BEAM_CENTROID_Y_VARIABLE );
+    if( qca ) qca->writeFloating( results.centroidY );
+
+    qca = (QEFloating*)getQcaItem( BEAM_SIGMA_X_VARIABLE );
+    if( qca ) qca->writeFloating( results.fitValid ? results.fitSigmaX : results.sigmaX );
+
+    qca = (QEFloating*)getQcaItem( BEAM_SIGMA_Y_VARIABLE );
+    if( qca ) qca->writeFloating( results.fitValid ? results.fitSigmaY : results.sigmaY );
+
+    qca = (QEFloating*)getQcaItem( BEAM_PEAK_VARIABLE );
+    if( qca ) qca->writeFloating( (double)(results.peak) );
+
+    qca = (QEFloating*)getQcaItem( BEAM_INTEGRAL_VARIABLE );
+    if( qca ) qca->writeFloating( results.integral );
+}
+
+// Save the slices and profiles generated by the image processor.
+// These arrive just before the image they were generated from and are used when the markups are updated for that image.
+void QEImage::useProfiles( profileResults results )
+{
+    lastProfiles = results;
+}
+
 // Display all markup data
 // Used When the first image update occurs to display any
 // markups for which data has arrived, but could not be presented
@@ -1475,14 +1573,44 @@ void QEImage::playingBack( bool playing )
     {
         deleteQcaItem( IMAGE_VARIABLE, true );
         stopStream();
+
+        // Note the live image attributes (recorded images may have been recorded with different attributes)
+        liveWidth = iProcessor.getImageBuffWidth();
+        liveHeight = iProcessor.getImageBuffHeight();
+        liveFormat = iProcessor.getFormat();
+        liveBitDepth = iProcessor.getBitDepth();
     }
     else
     {
+        // Restore the live image attributes
+        setFormatOption( liveFormat );
+        iProcessor.setBitDepth( liveBitDepth );
+        iProcessor.setImageBuffWidth( liveWidth );
+        iProcessor.setImageBuffHeight( liveHeight );
+        setImageSize();
+
         establishConnection( IMAGE_VARIABLE );
         startStream();
     }
 }
 
+// Slot from recorder control to present a recorded image.
+// The image is presented with the attributes (width, height, format and bit depth) in effect when it was recorded.
+void QEImage::setRecordedImage( const QByteArray& image, recordedImageInfo& info )
+{
+    // Apply the recorded image attributes
+    setFormatOption( info.format );
+    iProcessor.setBitDepth( info.bitDepth );
+    iProcessor.setImageBuffWidth( info.width );
+    iProcessor.setImageBuffHeight( info.height );
+
+    // Update the image buffer according to the recorded size.
+    setImageSize();
+
+    // Present the image as if it had just arrived
+    setImage( image, info.dataSize, info.alarmInfo, info.time, 0 );
+}
+
 //====================================================
 
 // Update image from non CA souce (no associated CA timestamp or alarm info available)
@@ -1542,10 +1670,15 @@ void QEImage::setImage( const QByteArray& imageIn,
         return;
     }
 
+    // Update pipeline statistics
+    framesReceived++;
+    lastReceiveLatency = (double)(time.msecsTo( QDateTime::currentDateTime() ));
+
     // If recording, save image
     if( recorder && recorder->isRecording() )
     {
-        recorder->recordImage( imageIn, dataSize, alarmInfo, time );
+        recorder->recordImage( imageIn, dataSize, alarmInfo, time,
+                               iProcessor.getImageBuffWidth(), iProcessor.getImageBuffHeight(), iProcessor.getFormat(), iProcessor.getBitDepth() );
     }
 
     // Signal a database value change to any Link widgets
@@ -1601,6 +1734,38 @@ void QEImage::displayImage()
         initScrollPosSet = true;
     }
 
+    // Let the image processor know the scale the image is displayed at so it
+    // can build the image directly at the displayed resolution if required
+    if( iProcessor.rotatedImageBuffWidth() )
+    {
+        iProcessor.setDisplayScale( (double)(videoWidget->width()) / (double)(iProcessor.rotatedImageBuffWidth()) );
+    }
+
+    // Let the image processor know the areas to analyse the beam within (each selected area, or the whole image)
+    if( iProcessor.getBeamAnalysis() != imageProperties::BEAM_ANALYSIS_NONE )
+    {
+        QVector<QRect> areas( 4 );
+        if( haveSelectedArea1 ) areas[0] = iProcessor.rotateFlipToDataRectangle( selectedArea1Point1, selectedArea1Point2 );
+        if( haveSelectedArea2 ) areas[1] = iProcessor.rotateFlipToDataRectangle( selectedArea2Point1, selectedArea2Point2 );
+        if( haveSelectedArea3 ) areas[2] = iProcessor.rotateFlipToDataRectangle( selectedArea3Point1, selectedArea3Point2 );
+        if( haveSelectedArea4 ) areas[3] = iProcessor.rotateFlipToDataRectangle( selectedArea4Point1, selectedArea4Point2 );
+        iProcessor.setBeamAnalysisAreas( areas );
+    }
+
+    // Let the image processor know what slices and profiles to generate as it processes the image
+    profileRequests requests;
+    requests.vSliceOn = haveVSlice1X && vSliceDisplay;
+    requests.vSliceX = vSlice1X;
+    requests.vSliceThickness = vSlice1Thickness;
+    requests.hSliceOn = haveHSlice1Y && hSliceDisplay;
+    requests.hSliceY = hSlice1Y;
+    requests.hSliceThickness = hSlice1Thickness;
+    requests.profileOn = haveProfileLine && profileDisplay;
+    requests.profileStart = profileLineStart;
+    requests.profileEnd = profileLineEnd;
+    requests.profileThickness = profileThickness;
+    iProcessor.setProfileRequests( requests );
+
     // Process the image data. Hopefully a presentable QImage will be result.
     iProcessor.buildImage();
 
@@ -1627,13 +1792,157 @@ void QEImage::displayBuiltImage( QImage frameImage, QString messageText )
     }
 
     // Display the new image
-    videoWidget->setNewImage( frameImage, imageTime );
+    // (The image may have been built at a reduced resolution for display, so also supply the full resolution size)
+    videoWidget->setNewImage( frameImage, imageTime, QSize( iProcessor.rotatedImageBuffWidth(), iProcessor.rotatedImageBuffHeight() ) );
 
     // Update markups if required
     updateMarkupData();
 
+    // Any slices and profiles generated with the image have now been used.
+    // (If the markups are moved before the next image, slices and profiles are generated directly)
+    lastProfiles = profileResults();
+
     // Display the image statistics
+    QElapsedTimer histogramTimer;
+    histogramTimer.start();
     imageDisplayProps->showStatistics();
+    lastHistogramTime = (double)(histogramTimer.nsecsElapsed()) / 1000000.0;
+
+    // Set the brightness and contrast to suit the image if required
+    if( continuousAutoBrightnessContrast )
+    {
+        updateAutoBrightnessContrast();
+    }
+
+    // Present the pipeline statistics if due
+    updatePipelineStatistics();
+}
+
+// Present the image pipeline statistics (over the image if required, and as a signal) about once a second
+void QEImage::updatePipelineStatistics()
+{
+    // Do nothing if not due
+    qint64 elapsed = pipelineStatisticsTimer.elapsed();
+    if( elapsed < 1000 )
+    {
+        return;
+    }
+    pipelineStatisticsTimer.restart();
+
+    // Gather the statistics
+    unsigned long framesBuilt;
+    unsigned long framesDropped;
+    double buildTime;
+    iProcessor.getPipelineStatistics( framesBuilt, framesDropped, buildTime );
+
+    unsigned long framesPainted;
+    double paintTime;
+    double latency;
+    videoWidget->getPaintStatistics( framesPainted, paintTime, latency );
+
+    // Determine rates since last presented
+    double receivedRate = (double)(framesReceived - lastFramesReceived) * 1000.0 / (double)elapsed;
+    double paintedRate = (double)(framesPainted - lastFramesPainted) * 1000.0 / (double)elapsed;
+    lastFramesReceived = framesReceived;
+    lastFramesPainted = framesPainted;
+
+    // Build the summary
+    QString summary = QString( "Received: %1 (%2/s)  Built: %3  Dropped: %4  Painted: %5 (%6/s)\n"
+                               "Receive: %7 ms  Build: %8 ms  Histogram: %9 ms  Paint: %10 ms  Latency: %11 ms" )
+                        .arg( framesReceived ).arg( receivedRate, 0, 'f', 1 )
+                        .arg( framesBuilt ).arg( framesDropped )
+                        .arg( framesPainted ).arg( paintedRate, 0, 'f', 1 )
+                        .arg( lastReceiveLatency, 0, 'f', 1 ).arg( buildTime, 0, 'f', 1 ).arg( lastHistogramTime, 0, 'f', 1 )
+                        .arg( paintTime, 0, 'f', 1 ).arg( latency, 0, 'f', 1 );
+
+    // Present the summary over the image if required
+    if( displayPerformance )
+    {
+        videoWidget->setOverlayText( summary );
+    }
+
+    // Let anyone interested know
+    emit pipelineStatistics( summary );
+}
+
+// Reset image pipeline frame counts
+void QEImage::resetPipelineStatistics()
+{
+    framesReceived = 0;
+    lastFramesReceived = 0;
+    lastFramesPainted = 0;
+    iProcessor.resetPipelineStatistics();
+    videoWidget->resetPaintStatistics();
+}
+
+// Image pipeline statistics
+unsigned long QEImage::getFramesReceived()
+{
+    return framesReceived;
+}
+
+unsigned long QEImage::getFramesBuilt()
+{
+    unsigned long framesBuilt;
+    unsigned long framesDropped;
+    double buildTime;
+    iProcessor.getPipelineStatistics( framesBuilt, framesDropped, buildTime );
+    return framesBuilt;
+}
+
+unsigned long QEImage::getFramesDropped()
+{
+    unsigned long framesBuilt;
+    unsigned long framesDropped;
+    double buildTime;
+    iProcessor.getPipelineStatistics( framesBuilt, framesDropped, buildTime );
+    return framesDropped;
+}
+
+unsigned long QEImage::getFramesPainted()
+{
+    unsigned long framesPainted;
+    double paintTime;
+    double latency;
+    videoWidget->getPaintStatistics( framesPainted, paintTime, latency );
+    return framesPainted;
+}
+
+double QEImage::getReceiveLatency()
+{
+    return lastReceiveLatency;
+}
+
+double QEImage::getBuildTime()
+{
+    unsigned long framesBuilt;
+    unsigned long framesDropped;
+    double buildTime;
+    iProcessor.getPipelineStatistics( framesBuilt, framesDropped, buildTime );
+    return buildTime;
+}
+
+double QEImage::getHistogramTime()
+{
+    return lastHistogramTime;
+}
+
+double QEImage::getPaintTime()
+{
+    unsigned long framesPainted;
+    double paintTime;
+    double latency;
+    videoWidget->getPaintStatistics( framesPainted, paintTime, latency );
+    return paintTime;
+}
+
+double QEImage::getLatency()
+{
+    unsigned long framesPainted;
+    double paintTime;
+    double latency;
+    videoWidget->getPaintStatistics( framesPainted, paintTime, latency );
+    return latency;
 }
 
 // Return the size of the widget where the image will be presented
@@ -2736,6 +3045,86 @@ int QEImage::getZoom()
     return zoom;
 }
 
+// Display decimation
+void QEImage::setDisplayDecimation( imageProperties::decimationOptions decimationIn )
+{
+    // Save the decimation option
+    iProcessor.setDecimation( decimationIn );
+
+    // Present the updated image
+    displayImage();
+}
+
+imageProperties::decimationOptions QEImage::getDisplayDecimation()
+{
+    return iProcessor.getDecimation();
+}
+
+// Beam analysis
+void QEImage::setBeamAnalysis( imageProperties::beamAnalysisOptions beamAnalysisIn )
+{
+    // Save the beam analysis option
+    iProcessor.setBeamAnalysis( beamAnalysisIn );
+
+    // Discard any previous results
+    lastBeamAnalysis.clear();
+}
+
+// Return the results of the last beam analysis of the first area analysed (the lowest numbered selected area, or the entire image)
+beamAnalysisResults QEImage::getBeamAnalysisResults()
+{
+    return lastBeamAnalysis.isEmpty() ? beamAnalysisResults() : lastBeamAnalysis.first();
+}
+
+imageProperties::beamAnalysisOptions QEImage::getBeamAnalysis()
+{
+    return iProcessor.getBeamAnalysis();
+}
+
+// Background subtraction
+void QEImage::setBackgroundSubtraction( bool backgroundSubtractionIn )
+{
+    iProcessor.setBackgroundSubtraction( backgroundSubtractionIn );
+}
+
+bool QEImage::getBackgroundSubtraction()
+{
+    return iProcessor.getBackgroundSubtraction();
+}
+
+// Use the last image received as the background (used from the next image)
+void QEImage::captureBackground()
+{
+    iProcessor.captureBackground();
+}
+
+// Discard the background
+void QEImage::clearBackground()
+{
+    iProcessor.clearBackground();
+}
+
+// Frame averaging
+void QEImage::setFrameAveraging( imageFilter::averagingOptions averagingIn )
+{
+    iProcessor.setAveraging( averagingIn );
+}
+
+imageFilter::averagingOptions QEImage::getFrameAveraging()
+{
+    return iProcessor.getAveraging();
+}
+
+void QEImage::setAverageFrames( int averageFramesIn )
+{
+    iProcessor.setAverageFrames( averageFramesIn < 1 ? 1 : averageFramesIn );
+}
+
+int QEImage::getAverageFrames()
+{
+    return iProcessor.getAverageFrames();
+}
+
 // Rotation
 void QEImage::setRotation( imageProperties::rotationOptions rotationIn )
 {
@@ -2805,6 +3194,98 @@ bool QEImage::getAutoBrightnessContrast()
     return imageDisplayProps->getAutoBrightnessContrast();
 }
 
+// Continuous automatic setting of brightness and contrast
+void QEImage::setContinuousAutoBrightnessContrast( bool continuousAutoBrightnessContrastIn )
+{
+    continuousAutoBrightnessContrast = continuousAutoBrightnessContrastIn;
+
+    // Start smoothing afresh
+    haveAutoRange = false;
+}
+
+bool QEImage::getContinuousAutoBrightnessContrast()
+{
+    return continuousAutoBrightnessContrast;
+}
+
+// Percentiles used when setting brightness and contrast automatically
+void QEImage::setAutoBrightnessContrastLowPercentile( double lowPercentileIn )
+{
+    autoLowPercentile = qBound( 0.0, lowPercentileIn, 100.0 );
+}
+
+double QEImage::getAutoBrightnessContrastLowPercentile()
+{
+    return autoLowPercentile;
+}
+
+void QEImage::setAutoBrightnessContrastHighPercentile( double highPercentileIn )
+{
+    autoHighPercentile = qBound( 0.0, highPercentileIn, 100.0 );
+}
+
+double QEImage::getAutoBrightnessContrastHighPercentile()
+{
+    return autoHighPercentile;
+}
+
+// Smoothing applied when setting brightness and contrast continuously
+void QEImage::setAutoBrightnessContrastSmoothing( double smoothingIn )
+{
+    autoSmoothing = qBound( 0.0, smoothingIn, 0.99 );
+}
+
+double QEImage::getAutoBrightnessContrastSmoothing()
+{
+    return autoSmoothing;
+}
+
+// Set brightness and contrast to suit the last image built.
+// The range between the low and high percentiles of the image is determined from the full depth histogram
+// gathered while the image was built, so no pass over the image is required.
+// The range is smoothed over successive images to avoid flicker.
+// The new brightness and contrast is applied from the next image (rather than rebuilding the current image)
+void QEImage::updateAutoBrightnessContrast()
+{
+    if( !imageDisplayProps )
+    {
+        return;
+    }
+
+    // Determine the range for this image
+    unsigned int low, high;
+    if( !imageDisplayProps->getPercentileRange( autoLowPercentile, autoHighPercentile, low, high ) )
+    {
+        return;
+    }
+
+    // Smooth the range
+    if( haveAutoRange )
+    {
+        autoLow  = autoLow  * autoSmoothing + (double)(low)  * (1.0-autoSmoothing);
+        autoHigh = autoHigh * autoSmoothing + (double)(high) * (1.0-autoSmoothing);
+    }
+    else
+    {
+        autoLow = low;
+        autoHigh = high;
+        haveAutoRange = true;
+    }
+
+    // Apply the range if it has changed
+    unsigned int newLow = (unsigned int)(autoLow+0.5);
+    unsigned int newHigh = (unsigned int)(autoHigh+0.5);
+    if( newHigh <= newLow )
+    {
+        newHigh = newLow+1;
+    }
+    if( (int)newLow != imageDisplayProps->getLowPixel() || (int)newHigh != imageDisplayProps->getHighPixel() )
+    {
+        imageDisplayProps->updateBrightnessContrast( newHigh, newLow );
+        iProcessor.invalidatePixelLookup();
+    }
+}
+
 // Resize options
 void QEImage::setResizeOption( resizeOptions resizeOptionIn )
 {
@@ -3082,6 +3563,23 @@ bool QEImage::getDisplayCursorPixelInfo()
     return optionsDialog->optionGet( imageContextMenu::ICM_ENABLE_CURSOR_PIXEL );
 }
 
+// Show image pipeline statistics over the image
+void QEImage::setDisplayPerformance( bool displayPerformanceIn )
+{
+    displayPerformance = displayPerformanceIn;
+
+    // Remove any statistics already presented (statistics will be presented when the next image arrives if required)
+    if( !displayPerformance )
+    {
+        videoWidget->setOverlayText( QString() );
+    }
+}
+
+bool QEImage::getDisplayPerformance()
+{
+    return displayPerformance;
+}
+
 // Show contrast reversal
 void QEImage::setContrastReversal( bool contrastReversal )
 {
@@ -4512,6 +5010,17 @@ void QEImage::imageDisplayPropertiesChanged()
 // A request has been made to set the brightness and contrast to suit the current image
 void QEImage::brightnessContrastAutoImageRequest()
 {
+    // Use the range between the auto brightness and contrast percentiles of the image
+    // (determined from the histogram of the image, so a few hot or dead pixels are ignored)
+    unsigned int low, high;
+    if( imageDisplayProps && imageDisplayProps->getPercentileRange( autoLowPercentile, autoHighPercentile, low, high ) )
+    {
+        imageDisplayProps->setBrightnessContrast( high, low );
+        haveAutoRange = false;
+        return;
+    }
+
+    // No histogram yet, use the full range of pixels in the image
     setRegionAutoBrightnessContrast( QPoint( 0, 0), QPoint( iProcessor.getImageBuffWidth(), iProcessor.getImageBuffHeight() ) );
 }
 
@@ -4538,7 +5047,15 @@ void QEImage::generateVSlice( int x, unsigned int thickness )
     }
 
     // Generate the data through the slice
-    iProcessor.generateVSliceData( vSliceData, x, thickness );
+    // (use the data generated as the image was processed if available)
+    if( lastProfiles.requests.vSliceOn && lastProfiles.requests.vSliceX == x && lastProfiles.requests.vSliceThickness == thickness )
+    {
+        vSliceData = lastProfiles.vSliceData;
+    }
+    else
+    {
+        iProcessor.generateVSliceData( vSliceData, x, thickness );
+    }
 
     // Write the profile data
     QEFloating *qca;
@@ -4591,7 +5108,15 @@ void QEImage::generateHSlice( int y, unsigned int thickness )
     }
 
     // Generate the data through the slice
-    iProcessor.generateHSliceData( hSliceData, y, thickness );
+    // (use the data generated as the image was processed if available)
+    if( lastProfiles.requests.hSliceOn && lastProfiles.requests.hSliceY == y && lastProfiles.requests.hSliceThickness == thickness )
+    {
+        hSliceData = lastProfiles.hSliceData;
+    }
+    else
+    {
+        iProcessor.generateHSliceData( hSliceData, y, thickness );
+    }
 
     // Write the profile data
     QEFloating *qca;
@@ -4707,7 +5232,17 @@ void QEImage::generateProfile( QPoint point1, QPoint point2, unsigned int thickn
     }
 
     // Generate the data through the slice
-    iProcessor.generateProfileData( profileData, point1, point2, thickness );
+    // (use the data generated as the image was processed if available)
+    if( lastProfiles.requests.profileOn &&
+        lastProfiles.requests.profileStart == point1 && lastProfiles.requests.profileEnd == point2 &&
+        lastProfiles.requests.profileThickness == thickness )
+    {
+        profileData = lastProfiles.profileData;
+    }
+    else
+    {
+        iProcessor.generateProfileData( profileData, point1, point2, thickness );
+    }
 
     // Write the profile data
     QEFloating *qca;
@@ -5284,17 +5819,6 @@ void QEImage::actionRequest( QString action, QStringList /*arguments*/, bool ini
 
 }
 
-// Constructor for class used to hold a record of a single image
-// Used when building a list of recorded images
-historicImage::historicImage( QByteArray imageIn, unsigned long dataSizeIn, QCaAlarmInfo& alarmInfoIn, QCaDateTime& timeIn )
-{
-    image = imageIn;
-
-    dataSize = dataSizeIn;
-    alarmInfo = alarmInfoIn;
-    time = timeIn;
-}
-
 // A configuration is being saved. Return any configuration to be saved for this widget
 void QEImage::saveConfiguration( PersistanceManager* pm )
 {
@@ -27,6 +27,7 @@
 #define QEIMAGE_H
 
 #include <QScrollArea>
+#include <QElapsedTimer>
 #include <QEWidget.h>
 #include <QEInteger.h>
 #include <videowidget.h>
@@ -225,6 +226,23 @@ public:
     void setZoom( int zoomIn );                                         ///< Access function for #zoom property - refer to #zoom property for details
     int getZoom();                                                      ///< Access function for #zoom property - refer to #zoom property for details
 
+    void setDisplayDecimation( imageProperties::decimationOptions decimationIn ); ///< Access function for #displayDecimation property - refer to #displayDecimation property for details
+    imageProperties::decimationOptions getDisplayDecimation();                    ///< Access function for #displayDecimation property - refer to #displayDecimation property for details
+
+    void setBeamAnalysis( imageProperties::beamAnalysisOptions beamAnalysisIn );  ///< Access function for #beamAnalysis property - refer to #beamAnalysis property for details
+    imageProperties::beamAnalysisOptions getBeamAnalysis();                       ///< Access function for #beamAnalysis property - refer to #beamAnalysis property for details
+    beamAnalysisResults getBeamAnalysisResults();                                 ///< Return the results of the last beam analysis of the first area analysed (the lowest numbered selected area, or the entire image)
+    beamAnalysisResultsList getAllBeamAnalysisResults(){ return lastBeamAnalysis; } ///< Return the results of the last beam analysis of each area analysed
+
+    void setBackgroundSubtraction( bool backgroundSubtractionIn );              ///< Access function for #backgroundSubtraction property - refer to #backgroundSubtraction property for details
+    bool getBackgroundSubtraction();                                            ///< Access function for #backgroundSubtraction property - refer to #backgroundSubtraction property for details
+
+    void setFrameAveraging( imageFilter::averagingOptions averagingIn );        ///< Access function for #frameAveraging property - refer to #frameAveraging property for details
+    imageFilter::averagingOptions getFrameAveraging();                          ///< Access function for #frameAveraging property - refer to #frameAveraging property for details
+
+    void setAverageFrames( int averageFramesIn );                               ///< Access function for #averageFrames property - refer to #averageFrames property for details
+    int getAverageFrames();                                                     ///< Access function for #averageFrames property - refer to #averageFrames property for details
+
     void setRotation( imageProperties::rotationOptions rotationIn );    ///< Access function for #rotation property - refer to #rotation property for details
     imageProperties::rotationOptions getRotation();                     ///< Access function for #rotation property - refer to #rotation property for details
 
@@ -300,6 +318,20 @@ public:
     void setDisplayCursorPixelInfo( bool displayCursorPixelInfo );      ///< Access function for #displayCursorPixelInfo property - refer to #displayCursorPixelInfo property for details
     bool getDisplayCursorPixelInfo();                                   ///< Access function for #displayCursorPixelInfo property - refer to #displayCursorPixelInfo property for details
 
+    void setDisplayPerformance( bool displayPerformanceIn );            ///< Access function for #displayPerformance property - refer to #displayPerformance property for details
+    bool getDisplayPerformance();                                       ///< Access function for #displayPerformance property - refer to #displayPerformance property for details
+
+    // Image pipeline statistics
+    unsigned long getFramesReceived();                                  ///< Return the number of images received (while not paused)
+    unsigned long getFramesBuilt();                                     ///< Return the number of images built for display
+    unsigned long getFramesDropped();                                   ///< Return the number of images discarded as a newer image arrived before they could be built
+    unsigned long getFramesPainted();                                   ///< Return the number of new images painted
+    double getReceiveLatency();                                         ///< Return the time from the last image timestamp to it being received (mS)
+    double getBuildTime();                                              ///< Return the time taken to build the last image, including building the histogram (mS)
+    double getHistogramTime();                                          ///< Return the time taken to present the last image statistics and histogram (mS)
+    double getPaintTime();                                              ///< Return the time taken to paint the last new image (mS)
+    double getLatency();                                                ///< Return the time from the last image timestamp to it being painted (mS)
+
     void setContrastReversal( bool contrastReversalIn );                ///< Access function for #contrastReversal property - refer to #contrastReversal property for details
     bool getContrastReversal();                                         ///< Access function for #contrastReversal property - refer to #contrastReversal property for details
 
@@ -366,6 +398,18 @@ public:
     void setAutoBrightnessContrast( bool autoBrightnessContrastIn );    ///< Access function for #autoBrightnessContrast property - refer to #autoBrightnessContrast property for details
     bool getAutoBrightnessContrast();                                   ///< Access function for #autoBrightnessContrast property - refer to #autoBrightnessContrast property for details
 
+    void setContinuousAutoBrightnessContrast( bool continuousAutoBrightnessContrastIn );  ///< Access function for #continuousAutoBrightnessContrast property - refer to #continuousAutoBrightnessContrast property for details
+    bool getContinuousAutoBrightnessContrast();                                           ///< Access function for #continuousAutoBrightnessContrast property - refer to #continuousAutoBrightnessContrast property for details
+
+    void setAutoBrightnessContrastLowPercentile( double lowPercentileIn );                ///< Access function for #autoBrightnessContrastLowPercentile property - refer to #autoBrightnessContrastLowPercentile property for details
+    double getAutoBrightnessContrastLowPercentile();                                      ///< Access function for #autoBrightnessContrastLowPercentile property - refer to #autoBrightnessContrastLowPercentile property for details
+
+    void setAutoBrightnessContrastHighPercentile( double highPercentileIn );              ///< Access function for #autoBrightnessContrastHighPercentile property - refer to #autoBrightnessContrastHighPercentile property for details
+    double getAutoBrightnessContrastHighPercentile();                                     ///< Access function for #autoBrightnessContrastHighPercentile property - refer to #autoBrightnessContrastHighPercentile property for details
+
+    void setAutoBrightnessContrastSmoothing( double smoothingIn );                        ///< Access function for #autoBrightnessContrastSmoothing property - refer to #autoBrightnessContrastSmoothing property for details
+    double getAutoBrightnessContrastSmoothing();                                          ///< Access function for #autoBrightnessContrastSmoothing property - refer to #autoBrightnessContrastSmoothing property for details
+
     void setExternalControls( bool externalControlsIn );                ///< Access function for #externalControls property - refer to #externalControls property for details
     bool getExternalControls();                                         ///< Access function for #externalControls property - refer to #externalControls property for details
 
@@ -544,6 +588,7 @@ public:
                           LINE_PROFILE_X1_VARIABLE, LINE_PROFILE_Y1_VARIABLE, LINE_PROFILE_X2_VARIABLE, LINE_PROFILE_Y2_VARIABLE, LINE_PROFILE_THICKNESS_VARIABLE,
                           PROFILE_H_ARRAY, PROFILE_V_ARRAY, PROFILE_LINE_ARRAY,
                           ELLIPSE_X_VARIABLE, ELLIPSE_Y_VARIABLE, ELLIPSE_W_VARIABLE, ELLIPSE_H_VARIABLE,
+                          BEAM_CENTROID_X_VARIABLE, BEAM_CENTROID_Y_VARIABLE, BEAM_SIGMA_X_VARIABLE, BEAM_SIGMA_Y_VARIABLE, BEAM_PEAK_VARIABLE, BEAM_INTEGRAL_VARIABLE,
 
                           QEIMAGE_NUM_VARIABLES /*Must be last*/ };
 
@@ -630,8 +675,11 @@ private slots:
     void resizeFullScreen();        // Resize full screen once it has been managed
 
     void playingBack( bool playing );
+    void setRecordedImage( const QByteArray& image, recordedImageInfo& info );
 
     void displayBuiltImage( QImage image, QString error );
+    void useBeamAnalysis( beamAnalysisResultsList resultsList );
+    void useProfiles( profileResults results );
 
 public slots:
     void setImageFile( QString name );
@@ -683,6 +731,11 @@ public slots:
     void setDisplayMarkupsOn() {setDisplayMarkups(true);} ///< Set markup display to on to show all markups that change either due to user or PV activity, even if their setDisplay????Selection is off - refer to #displayMarkups property for details
     void setDisplayMarkupsOff() {setDisplayMarkups(false);}///< Set markup display to off to stop PV controlled pvs from showing even if they change, unless their setDisplay????Selection is on - refer to #displayMarkups property for details
 
+    void resetPipelineStatistics(); ///< Reset image pipeline frame counts
+
+    void captureBackground();       ///< Use the last image received as the background - refer to #backgroundSubtraction property for details
+    void clearBackground();         ///< Discard the background - refer to #backgroundSubtraction property for details
+
 signals:
     // Note, the following signals are common to many QE widgets,
     // if changing the doxygen comments, ensure relevent changes are migrated to all instances
@@ -695,6 +748,10 @@ signals:
 
     void componentHostRequest( const QEActionRequests& request );
 
+    /// Sent about once a second while images are arriving with a summary of the image pipeline statistics.
+    /// Refer to getFramesReceived(), getFramesBuilt(), getFramesDropped(), getFramesPainted(), getBuildTime(), getPaintTime(), getLatency(), etc, for individual values.
+    void pipelineStatistics( const QString& summary );
+
   private:
     imageUses imageUse;
     void useTargetingData();
@@ -807,8 +864,35 @@ signals:
     // Image and related information
     QCaDateTime imageTime;
 
+    // Continuous auto brightness and contrast
+    void updateAutoBrightnessContrast();    // Set brightness and contrast to suit the last image built
+    bool continuousAutoBrightnessContrast;  // True if brightness and contrast is set to suit each image
+    double autoLowPercentile;               // Percentile of pixel values displayed black
+    double autoHighPercentile;              // Percentile of pixel values displayed white
+    double autoSmoothing;                   // Proportion of the previous range retained as each image arrives
+    bool haveAutoRange;                     // True if autoLow and autoHigh are set
+    double autoLow;                         // Smoothed pixel value displayed black
+    double autoHigh;                        // Smoothed pixel value displayed white
+
+    // Beam analysis
+    beamAnalysisResultsList lastBeamAnalysis; // Results of the last beam analysis performed by the image processor (for each area analysed)
+
+    // Image pipeline statistics
+    void updatePipelineStatistics();        // Present (and signal) pipeline statistics if due
+    bool displayPerformance;                // True if pipeline statistics are presented over the image
+    unsigned long framesReceived;           // Number of images received (while not paused)
+    double lastReceiveLatency;              // Time from the last image timestamp to it being received (mS)
+    double lastHistogramTime;               // Time taken to present the last image statistics and histogram (mS)
+    QElapsedTimer pipelineStatisticsTimer;  // Time since pipeline statistics were last presented
+    unsigned long lastFramesReceived;       // Number of images received when pipeline statistics were last presented (for rate calculation)
+    unsigned long lastFramesPainted;        // Number of images painted when pipeline statistics were last presented (for rate calculation)
+
     // Image history
     recording* recorder;
+    unsigned long liveWidth;                // Image attributes in use before playback started. Recorded images are presented with the
+    unsigned long liveHeight;               // attributes they were recorded with, and these are restored when returning to live images
+    imageDataFormats::formatOptions liveFormat;
+    unsigned int liveBitDepth;
 
     // Region of interest information
     areaInfo roiInfo[4];
@@ -890,6 +974,7 @@ signals:
     QVector<QPointF> vSliceData;
     QVector<QPointF> hSliceData;
     QVector<QPointF> profileData;
+    profileResults lastProfiles;        // Slices and profiles generated by the image processor for the image being presented
 
     // Icons
     QIcon* pauseButtonIcon;
@@ -1289,6 +1374,36 @@ protected:
     /// This variable is used to read an ellipse height
     Q_PROPERTY(QString ellipseHVariable READ getVariableName64Property WRITE setVariableName64Property)
 
+    VARIABLE_PROPERTY_ACCESS(65)
+    /// EPICS variable name (CA PV).
+    /// This variable is used to write the beam centroid X determined by the beam analysis (refer to #beamAnalysis property).
+    Q_PROPERTY(QString beamCentroidXVariable READ getVariableName65Property WRITE setVariableName65Property)
+
+    VARIABLE_PROPERTY_ACCESS(66)
+    /// EPICS variable name (CA PV).
+    /// This variable is used to write the beam centroid Y determined by the beam analysis (refer to #beamAnalysis property).
+    Q_PROPERTY(QString beamCentroidYVariable READ getVariableName66Property WRITE setVariableName66Property)
+
+    VARIABLE_PROPERTY_ACCESS(67)
+    /// EPICS variable name (CA PV).
+    /// This variable is used to write the beam width (sigma X) determined by the beam analysis (refer to #beamAnalysis property).
+    Q_PROPERTY(QString beamSigmaXVariable READ getVariableName67Property WRITE setVariableName67Property)
+
+    VARIABLE_PROPERTY_ACCESS(68)
+    /// EPICS variable name (CA PV).
+    /// This variable is used to write the beam height (sigma Y) determined by the beam analysis (refer to #beamAnalysis property).
+    Q_PROPERTY(QString beamSigmaYVariable READ getVariableName68Property WRITE setVariableName68Property)
+
+    VARIABLE_PROPERTY_ACCESS(69)
+    /// EPICS variable name (CA PV).
+    /// This variable is used to write the beam peak pixel value determined by the beam analysis (refer to #beamAnalysis property).
+    Q_PROPERTY(QString beamPeakVariable READ getVariableName69Property WRITE setVariableName69Property)
+
+    VARIABLE_PROPERTY_ACCESS(70)
+    /// EPICS variable name (CA PV).
+    /// This variable is used to write the beam integrated intensity determined by the beam analysis (refer to #beamAnalysis property).
+    Q_PROPERTY(QString beamIntegralVariable READ getVariableName70Property WRITE setVariableName70Property)
+
 #undef VARIABLE_PROPERTY_ACCESS
 
     /// Macro substitutions. The default is no substitutions. The format is NAME1=VALUE1[,] NAME2=VALUE2... Values may be quoted strings. For example, 'CAM=1, NAME = "Image 1"'
@@ -1757,6 +1872,11 @@ public:
     /// the cursor, and for other selections such as selected areas.
     Q_PROPERTY(bool displayCursorPixelInfo READ getDisplayCursorPixelInfo WRITE setDisplayCursorPixelInfo)
 
+    /// If true, image pipeline statistics (frames received, built, dropped and painted, stage timings, and latency
+    /// from the image timestamp to paint) will be presented over the top left corner of the image.
+    /// The same statistics are available through the pipelineStatistics() signal regardless of this property.
+    Q_PROPERTY(bool displayPerformance READ getDisplayPerformance WRITE setDisplayPerformance)
+
     /// If true, the image will undergo contrast reversal.
     ///
     Q_PROPERTY(bool contrastReversal READ getContrastReversal WRITE setContrastReversal)
@@ -1863,6 +1983,63 @@ public:
     /// Zoom percentage. Used when #resizeOption is #Zoom
     Q_PROPERTY(int zoom READ getZoom WRITE setZoom)
 
+    Q_ENUMS(DisplayDecimationOptions)
+    /// Display decimation option. If not FullResolution, monochrome images displayed at 50% or less are built directly
+    /// at (about) the displayed resolution rather than being built at full resolution and scaled down when painted.
+    /// This reduces image processing to match the screen pixels displayed rather than the detector pixels.
+    /// Binning presents the average of each block of pixels, Maximum presents the maximum of each block (preserving hot pixels).
+    /// Images are built at full resolution again when zoomed in. Images saved or passed to other applications are always full resolution.
+    Q_PROPERTY(DisplayDecimationOptions displayDecimation READ getDisplayDecimationProperty WRITE setDisplayDecimationProperty)
+    /// \enum DisplayDecimationOptions
+    /// User friendly enumerations for #displayDecimation property
+    enum DisplayDecimationOptions { FullResolution = imageProperties::DECIMATION_NONE,     ///< Always build images at full resolution
+                                    Binning        = imageProperties::DECIMATION_BINNING,  ///< Present the average of each block of pixels
+                                    Maximum        = imageProperties::DECIMATION_MAXIMUM   ///< Present the maximum of each block of pixels
+                                  };
+    void setDisplayDecimationProperty( DisplayDecimationOptions displayDecimation ){ setDisplayDecimation( (imageProperties::decimationOptions)displayDecimation ); }  ///< Access function for #displayDecimation property - refer to #displayDecimation property for details
+    DisplayDecimationOptions getDisplayDecimationProperty(){ return (DisplayDecimationOptions)getDisplayDecimation(); }                                             ///< Access function for #displayDecimation property - refer to #displayDecimation property for details
+
+    Q_ENUMS(BeamAnalysisOptions)
+    /// Beam analysis option. If not NoAnalysis, the beam is analysed in each image as it is processed (in the image processing thread).
+    /// The analysis is performed within each selected area (1 to 4) if present, otherwise across the whole image. The lowest pixel value in each area is taken as the background.
+    /// The beam markup and beam variables reflect the lowest numbered selected area. Results for all areas are available from getAllBeamAnalysisResults().
+    /// Moments determines the intensity weighted centroid, second moments, peak and integrated intensity. MomentsAndFit also fits a Gaussian to the beam projections.
+    /// The beam markup follows the centroid (or fitted centre), and results are written to the beam variables if defined (refer to #beamCentroidXVariable, etc).
+    /// Note, monochrome, Bayer and RGB1 formats are analysed (RGB1 with up to 16 bit colours).
+    Q_PROPERTY(BeamAnalysisOptions beamAnalysis READ getBeamAnalysisProperty WRITE setBeamAnalysisProperty)
+    /// \enum BeamAnalysisOptions
+    /// User friendly enumerations for #beamAnalysis property
+    enum BeamAnalysisOptions { NoAnalysis    = imageProperties::BEAM_ANALYSIS_NONE,     ///< No beam analysis
+                               Moments       = imageProperties::BEAM_ANALYSIS_MOMENTS,  ///< Centroid, second moments, peak and integrated intensity
+                               MomentsAndFit = imageProperties::BEAM_ANALYSIS_FIT       ///< Moments, plus a Gaussian fit to the beam projections
+                             };
+    void setBeamAnalysisProperty( BeamAnalysisOptions beamAnalysis ){ setBeamAnalysis( (imageProperties::beamAnalysisOptions)beamAnalysis ); }  ///< Access function for #beamAnalysis property - refer to #beamAnalysis property for details
+    BeamAnalysisOptions getBeamAnalysisProperty(){ return (BeamAnalysisOptions)getBeamAnalysis(); }                                           ///< Access function for #beamAnalysis property - refer to #beamAnalysis property for details
+
+    /// If true, a captured background image is subtracted from each image before it is displayed or analysed.
+    /// The background is captured from the last image received by calling the captureBackground() slot, and discarded by calling the clearBackground() slot.
+    /// Pixel values are limited at zero. Brightness and contrast statistics, the histogram, slices, profiles and beam analysis all use the processed image.
+    Q_PROPERTY(bool backgroundSubtraction READ getBackgroundSubtraction WRITE setBackgroundSubtraction)
+
+    Q_ENUMS(FrameAveragingOptions)
+    /// Frame averaging option. Images may be averaged (after any background subtraction) to reveal faint features.
+    /// RunningAverage presents the average of the last #averageFrames images. ExponentialAverage presents an exponential average with a time constant of #averageFrames images.
+    /// Averaging restarts if the image size or format changes.
+    /// A running average holds each image averaged. If that would require more than 256MB, an exponential average is used instead.
+    Q_PROPERTY(FrameAveragingOptions frameAveraging READ getFrameAveragingProperty WRITE setFrameAveragingProperty)
+    /// \enum FrameAveragingOptions
+    /// User friendly enumerations for #frameAveraging property
+    enum FrameAveragingOptions { NoAveraging        = imageFilter::AVERAGE_NONE,         ///< No averaging
+                                 RunningAverage     = imageFilter::AVERAGE_RUNNING,      ///< Average of the last #averageFrames images
+                                 ExponentialAverage = imageFilter::AVERAGE_EXPONENTIAL   ///< Exponential average with a time constant of #averageFrames images
+                               };
+    void setFrameAveragingProperty( FrameAveragingOptions frameAveraging ){ setFrameAveraging( (imageFilter::averagingOptions)frameAveraging ); }  ///< Access function for #frameAveraging property - refer to #frameAveraging property for details
+    FrameAveragingOptions getFrameAveragingProperty(){ return (FrameAveragingOptions)getFrameAveraging(); }                                     ///< Access function for #frameAveraging property - refer to #frameAveraging property for details
+
+    /// Number of images averaged (or the time constant in images for an exponential average) when #frameAveraging is not NoAveraging.
+    /// Range is 1 to 64.
+    Q_PROPERTY(int averageFrames READ getAverageFrames WRITE setAverageFrames)
+
     Q_ENUMS(RotationOptions)
 
     /// Image rotation option.
@@ -1904,6 +2081,24 @@ public:
     /// The brightness and contrast is set to use the full range of pixels in the selected area.
     Q_PROPERTY(bool autoBrightnessContrast READ getAutoBrightnessContrast WRITE setAutoBrightnessContrast)
 
+    /// If true, continuously set local brightness and contrast to suit each image as it arrives.
+    /// The brightness and contrast is set to span the pixel values between two percentiles of the image
+    /// (refer to #autoBrightnessContrastLowPercentile and #autoBrightnessContrastHighPercentile) so a few hot or dead pixels don't affect it.
+    /// Changes are smoothed over several images (refer to #autoBrightnessContrastSmoothing) and are applied from the next image.
+    Q_PROPERTY(bool continuousAutoBrightnessContrast READ getContinuousAutoBrightnessContrast WRITE setContinuousAutoBrightnessContrast)
+
+    /// Percentile of pixel values displayed black when setting brightness and contrast automatically. Default is 0.1%.
+    /// Used by #continuousAutoBrightnessContrast and when brightness and contrast is set for the entire image ('Auto all').
+    Q_PROPERTY(double autoBrightnessContrastLowPercentile READ getAutoBrightnessContrastLowPercentile WRITE setAutoBrightnessContrastLowPercentile)
+
+    /// Percentile of pixel values displayed white when setting brightness and contrast automatically. Default is 99.9%.
+    /// Used by #continuousAutoBrightnessContrast and when brightness and contrast is set for the entire image ('Auto all').
+    Q_PROPERTY(double autoBrightnessContrastHighPercentile READ getAutoBrightnessContrastHighPercentile WRITE setAutoBrightnessContrastHighPercentile)
+
+    /// Smoothing applied to brightness and contrast changes when #continuousAutoBrightnessContrast is true.
+    /// This is the proportion of the previous range retained as each image arrives. 0.0 is no smoothing, values approaching 1.0 respond more slowly. Default is 0.8
+    Q_PROPERTY(double autoBrightnessContrastSmoothing READ getAutoBrightnessContrastSmoothing WRITE setAutoBrightnessContrastSmoothing)
+
     /// Name of widget for display and identification purpose.
     /// If present is added to the start of dock names provided by a QEImage widget to an application (such as QEGui)
     /// to diferentiate between docks provided by different instances of QEImage.
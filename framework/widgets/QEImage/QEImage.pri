@@ -52,10 +52,12 @@ HEADERS += \
     widgets/QEImage/imageDataFormats.h \
     widgets/QEImage/markupDisplayMenu.h \
     widgets/QEImage/recording.h \
+    widgets/QEImage/recordingStore.h \
     widgets/QEImage/screenSelectDialog.h \
     widgets/QEImage/colourConversion.h \
     widgets/QEImage/imageProcessor.h \
     widgets/QEImage/imageProperties.h \
+    widgets/QEImage/imageFilter.h \
     widgets/QEImage/imageMarkupLegendSetText.h
 
 isEmpty( _QE_FFMPEG ) {
@@ -90,9 +92,11 @@ SOURCES += \
     widgets/QEImage/fullScreenWindow.cpp \
     widgets/QEImage/markupDisplayMenu.cpp \
     widgets/QEImage/recording.cpp \
+    widgets/QEImage/recordingStore.cpp \
     widgets/QEImage/screenSelectDialog.cpp \
     widgets/QEImage/imageProcessor.cpp \
     widgets/QEImage/imageProperties.cpp \
+    widgets/QEImage/imageFilter.cpp \
     widgets/QEImage/imageMarkupLegendSetText.cpp
 
 isEmpty( _QE_FFMPEG ) {
@@ -28,6 +28,7 @@
 
 #include <brightnessContrast.h>
 #include <QPainter>
+#include <QMutexLocker>
 #include <math.h>
 
 #define SCALE_HEIGHT 20
@@ -84,6 +85,7 @@ imageDisplayProperties::imageDisplayProperties()
     }
     maxP = 0;
     minP = UINT_MAX;
+    pixelLookupShift = 0;
 
     setFrameStyle( QFrame::StyledPanel|QFrame::Raised );
 
@@ -353,6 +355,13 @@ void imageDisplayProperties::setBrightnessContrast( const unsigned int max, cons
     emit imageDisplayPropertiesChange();
 }
 
+// Set the brightness and contrast without signaling a change.
+// Used when the caller will apply the change itself (for example, from the next image)
+void imageDisplayProperties::updateBrightnessContrast( const unsigned int max, const unsigned int min )
+{
+    updateZeroValueFullValue( min, max );
+}
+
 // Set the state of the 'Auto brightness and contrast' check box
 void imageDisplayProperties::setAutoBrightnessContrast( bool autoBrightnessContrast )
 {
@@ -730,7 +739,9 @@ void imageDisplayProperties::setStatistics( unsigned int minPIn,
                                             unsigned int maxPIn,                // Maximum pixel value
                                             unsigned int bitDepth,              // Bit depth
                                             unsigned int binsIn[HISTOGRAM_BINS],// Histogram bins
-                                            rgbPixel pixelLookupIn[256] )       // Color translation lookup
+                                            const QVector<unsigned int>& fullBinsIn, // Full depth histogram
+                                            const QVector<rgbPixel>& pixelLookupIn,// Color translation lookup
+                                            unsigned int pixelLookupShiftIn )  // Shift applied to pixel values before lookup
 {
     // Update image statistics
     minP = minPIn;
@@ -740,7 +751,69 @@ void imageDisplayProperties::setStatistics( unsigned int minPIn,
     {
         bins[i] = binsIn[i];
     }
+
+    QMutexLocker locker( &statisticsLock );
+    fullBins = fullBinsIn;
     pixelLookup = pixelLookupIn;
+    pixelLookupShift = pixelLookupShiftIn;
+}
+
+// Determine the pixel values at two percentiles of the current image (for example 0.1% and 99.9%).
+// This uses the full depth histogram gathered while building the image, so no pass over the image is required.
+// Using percentiles rather than the minimum and maximum pixel values means a few hot or dead pixels don't ruin the range.
+// Note, for pixels deeper than the histogram, values are resolved to the histogram bin.
+// Return false if no histogram is available.
+bool imageDisplayProperties::getPercentileRange( double lowPercentile, double highPercentile, unsigned int& low, unsigned int& high )
+{
+    // Get the current histogram
+    QVector<unsigned int> histogram;
+    unsigned int shift;
+    {
+        QMutexLocker locker( &statisticsLock );
+        histogram = fullBins;
+        shift = pixelLookupShift;
+    }
+
+    // Determine the total pixel count
+    int n = histogram.size();
+    const unsigned int* counts = histogram.constData();
+    quint64 total = 0;
+    for( int i = 0; i < n; i++ )
+    {
+        total += counts[i];
+    }
+    if( total == 0 )
+    {
+        return false;
+    }
+
+    // Determine the pixel counts at the percentiles
+    quint64 lowCount = (quint64)( (double)total * lowPercentile / 100.0 );
+    quint64 highCount = (quint64)ceil( (double)total * highPercentile / 100.0 );
+    if( highCount > total ) highCount = total;
+
+    // Walk the cumulative distribution to find the values at the percentiles
+    quint64 cumulative = 0;
+    int lowBin = -1;
+    int highBin = n-1;
+    for( int i = 0; i < n; i++ )
+    {
+        cumulative += counts[i];
+        if( lowBin < 0 && cumulative > lowCount )
+        {
+            lowBin = i;
+        }
+        if( cumulative >= highCount )
+        {
+            highBin = i;
+            break;
+        }
+    }
+    if( lowBin < 0 ) lowBin = highBin;
+
+    low = (unsigned int)lowBin << shift;
+    high = (((unsigned int)highBin+1) << shift) - 1;
+    return true;
 }
 
 // Show the current image statistics.
@@ -916,40 +989,36 @@ void histogram::paintEvent(QPaintEvent* )
     }
 
     // Draw scale bar
-    int minX = idp->zeroValue*w/idp->range;
-    int maxX = idp->fullValue*w/idp->range;
-    imageDisplayProperties::rgbPixel* col;
-
     int scaleTop = h+3;
     int scaleHeight = SCALE_HEIGHT-4;
 
-    // Draw the first colour in the lookup table for the entire area to the left of the minimum value
-    QRect scaleRect = QRect( 0, scaleTop, minX, scaleHeight );
-    col = &(idp->pixelLookup[0] );
-    p.fillRect( scaleRect, QColor( col->p[2], col->p[1], col->p[0] ) );
-
-    // Draw the last colour in the lookup table for the entire area to the right of the maximum value
-    scaleRect = QRect( maxX, scaleTop, w-maxX, scaleHeight );
-    col = &(idp->pixelLookup[255] );
-    p.fillRect( scaleRect, QColor( col->p[2], col->p[1], col->p[0] ) );
-
-    // Display all colors in the lookup table
-    QRectF colourRect;
-
-    colourRect.setTop( scaleTop );
-    colourRect.setBottom( scaleTop + scaleHeight );
-
-    colourRect.setLeft( minX );
-    colourRect.setWidth( (double)(maxX-minX)/255 );
-
-    for( unsigned int i = 0; i < 256; i++ )
+    // Display the colour from the lookup table for the pixel value under each column of the scale.
+    // The lookup table holds an entry for every pixel value and includes the current brightness and
+    // contrast, so the scale shows exactly how each pixel value is presented.
+    QVector<imageDisplayProperties::rgbPixel> pixelLookup;
     {
-        // Draw the color rectangle
-        imageDisplayProperties::rgbPixel* col = &(idp->pixelLookup[i] );
-        p.fillRect( colourRect, QColor( col->p[2], col->p[1], col->p[0] ) );
-
-        // Move on to the next colour
-        colourRect.moveLeft( colourRect.right() );
+        QMutexLocker locker( &idp->statisticsLock );
+        pixelLookup = idp->pixelLookup;
+    }
+    int lookupSize = pixelLookup.size();
+    if( lookupSize )
+    {
+        const imageDisplayProperties::rgbPixel* lookup = pixelLookup.constData();
+        QRect colourRect( 0, scaleTop, 1, scaleHeight );
+        for( int x = 0; x < (int)w; x++ )
+        {
+            // Determine the lookup table entry for the pixel value at this column
+            quint64 index = (quint64)( (double)(x)*idp->range/w ) >> idp->pixelLookupShift;
+            if( index >= (quint64)lookupSize )
+            {
+                index = lookupSize-1;
+            }
+
+            // Draw the color for this column
+            const imageDisplayProperties::rgbPixel* col = &(lookup[index]);
+            colourRect.moveLeft( x );
+            p.fillRect( colourRect, QColor( col->p[2], col->p[1], col->p[0] ) );
+        }
     }
 
     // Prepare to draw the bounds and gradient
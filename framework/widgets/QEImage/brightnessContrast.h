@@ -35,6 +35,8 @@
 #include <QScrollArea>
 #include <QVBoxLayout>
 #include <QPushButton>
+#include <QVector>
+#include <QMutex>
 
 #define HISTOGRAM_BINS 256
 class imageDisplayProperties;
@@ -74,6 +76,7 @@ public:
     ~imageDisplayProperties();
 
     void setBrightnessContrast( const unsigned int max, const unsigned int min );
+    void updateBrightnessContrast( const unsigned int max, const unsigned int min ); // As for setBrightnessContrast(), but without signaling a change (the caller applies the change)
     void setAutoBrightnessContrast( bool autoBrightnessContrast );  // Set 'Auto Brightness' function on or off
     void setContrastReversal( bool contrastReversal );              // Set contrast reversal state on or off
     void setLog( bool log );                                        // Set logarithmic scale on or off
@@ -95,8 +98,11 @@ public:
                         unsigned int maxPIn,
                         unsigned int bitDepth,
                         unsigned int binsIn[HISTOGRAM_BINS],
-                        rgbPixel pixelLookup[256] );
+                        const QVector<unsigned int>& fullBinsIn,
+                        const QVector<rgbPixel>& pixelLookup,
+                        unsigned int pixelLookupShift );
     void showStatistics();                      // Must be called from main thread
+    bool getPercentileRange( double lowPercentile, double highPercentile, unsigned int& low, unsigned int& high ); // Determine the pixel values at two percentiles of the current image
 
 signals:
     void brightnessContrastAutoImage();     // Issue a request to set the brightness and contrast to match the current image
@@ -199,9 +205,12 @@ public:
     unsigned int minP;  // Lowest pixel value in image
     unsigned int depth; // Bit depth
     unsigned int bins[HISTOGRAM_BINS]; // Histogram bins
+    QVector<unsigned int> fullBins; // Full depth histogram (one bin per pixel lookup table entry)
+    QMutex statisticsLock;          // Protects the statistics tables (fullBins and pixelLookup) as they are set from the image processing thread
     bool statisticsSet; // Statistic have been set ( setStatistics() has been called) and things like range are now available
 
-    rgbPixel* pixelLookup; // Pixel lookup table used to present colour scale in histogram
+    QVector<rgbPixel> pixelLookup;  // Pixel lookup table used to present colour scale in histogram (one entry per pixel value)
+    unsigned int pixelLookupShift;  // Shift applied to pixel values before indexing pixelLookup
 
     QLabel* histXLabel;
 
@@ -0,0 +1,312 @@
+/*
+ *  This file is part of the EPICS QT Framework, initially developed at the Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+
+/*
+ This class manages background subtraction and frame averaging of image data
+ for the QEImage widget. It is used by the image processor as each frame arrives,
+ before the frame is displayed or analysed, so the image, brightness and contrast
+ statistics, histogram, slices, profiles and beam analysis all reflect the processed
+ frame. (Any clipping applies to the processed pixel values as clipping is part of
+ translating pixel values for display)
+
+ Background subtraction:
+ The last frame received can be captured as the background. When subtracting, the
+ background is subtracted from each frame element by element, limited at zero.
+ Only the significant bits (according to the bit depth) are used.
+
+ Frame averaging:
+ A running average is the average of the last N frames. The frames in the average are
+ held (shared, not copied) with a sum of them all. As each frame arrives it is added to
+ the sum and the oldest frame is removed. An exponential average uses a weight of 1/N for
+ each new frame and requires no frames to be held. As holding N large frames can take a
+ lot of memory (64 frames of 32MB is 2GB), an exponential average is used instead of a
+ running average if the frames held would exceed MAX_RUNNING_AVERAGE_BYTES.
+
+ Each operation is a simple scalar loop over the frame elements of a fixed type with no
+ branching on format within the loop, so the compiler is free to vectorise it.
+ (There are no hand written SIMD kernels.)
+
+ Frames are processed in the image processing thread (not as the frame arrives in the
+ GUI thread).
+
+ Processing applies to formats where each data element is an intensity (mono, Bayer and RGB).
+ Other formats are passed through unchanged.
+ Processed frames are written to buffers from the frame buffer pool. If no processing is
+ required the frame is passed through without copying.
+*/
+
+#include "imageFilter.h"
+#include <FrameBufferPool.h>
+
+// Construction
+imageFilter::imageFilter()
+{
+    subtract = false;
+    averaging = AVERAGE_NONE;
+    averageFrames = 1;
+    averageSize = 0;
+    averageDataSize = 0;
+    averageBitDepth = 0;
+}
+
+// Use the last frame received as the background
+void imageFilter::captureBackground()
+{
+    background = lastRaw;
+    resetAverage();
+}
+
+// Discard the background
+void imageFilter::clearBackground()
+{
+    background.clear();
+    resetAverage();
+}
+
+// Set how frames are averaged
+void imageFilter::setAveraging( averagingOptions averagingIn )
+{
+    if( averaging != averagingIn )
+    {
+        averaging = averagingIn;
+        resetAverage();
+    }
+}
+
+// Set the number of frames averaged
+void imageFilter::setAverageFrames( unsigned int framesIn )
+{
+    if( framesIn < 1 ) framesIn = 1;
+    if( framesIn > MAX_AVERAGE_FRAMES ) framesIn = MAX_AVERAGE_FRAMES;
+
+    if( averageFrames != framesIn )
+    {
+        averageFrames = framesIn;
+        resetAverage();
+    }
+}
+
+// Restart averaging
+void imageFilter::resetAverage()
+{
+    runningFrames.clear();
+    runningSum.clear();
+    exponentialAverage.clear();
+    averageSize = 0;
+}
+
+//=====================================================
+// Processing kernels.
+// Each is a single loop over the frame elements of type T
+
+// Subtract a background, limited at zero
+template <typename T>
+static void subtractBackground( const T* in, const T* bg, T* out, int n, T mask )
+{
+    for( int i = 0; i < n; i++ )
+    {
+        T v = in[i]&mask;
+        T b = bg[i]&mask;
+        out[i] = ( v > b ) ? v-b : 0;
+    }
+}
+
+// Add a frame to (or remove a frame from) a running sum
+template <typename T>
+static void addToSum( const T* in, quint64* sum, int n, T mask )
+{
+    for( int i = 0; i < n; i++ )
+    {
+        sum[i] += in[i]&mask;
+    }
+}
+
+template <typename T>
+static void removeFromSum( const T* in, quint64* sum, int n, T mask )
+{
+    for( int i = 0; i < n; i++ )
+    {
+        sum[i] -= in[i]&mask;
+    }
+}
+
+// Generate the average from a running sum
+template <typename T>
+static void averageFromSum( const quint64* sum, T* out, int n, unsigned int count )
+{
+    double scale = 1.0 / count;
+    for( int i = 0; i < n; i++ )
+    {
+        out[i] = (T)( sum[i] * scale );
+    }
+}
+
+// Add a frame to an exponential average and generate the current average
+template <typename T>
+static void exponentialStep( const T* in, float* average, T* out, int n, T mask, float weight )
+{
+    for( int i = 0; i < n; i++ )
+    {
+        float a = average[i] + ( (float)(in[i]&mask) - average[i] ) * weight;
+        average[i] = a;
+        out[i] = (T)( a + 0.5f );
+    }
+}
+
+// Initialise an exponential average from a frame
+template <typename T>
+static void exponentialStart( const T* in, float* average, int n, T mask )
+{
+    for( int i = 0; i < n; i++ )
+    {
+        average[i] = in[i]&mask;
+    }
+}
+
+//=====================================================
+
+// Process a frame (background subtraction then averaging).
+// Return the processed frame, or the frame itself if no processing is required
+template <typename T>
+static QByteArray processFrame( const QByteArray& in, const QByteArray& background, bool subtract,
+                                imageFilter::averagingOptions averaging, unsigned int averageFrames,
+                                QList<QByteArray>& runningFrames, QVector<quint64>& runningSum, QVector<float>& exponentialAverage,
+                                unsigned int bitDepth )
+{
+    int n = in.size() / sizeof(T);
+    T mask = ( bitDepth >= sizeof(T)*8 ) ? (T)(~0) : (T)(((quint64)1<<bitDepth)-1);
+    QByteArray frame = in;
+
+    // Subtract the background if required (and if the background matches the frame)
+    if( subtract && background.size() == in.size() )
+    {
+        QByteArray subtracted = FrameBufferPool::getBuffer( in.size() );
+        subtractBackground<T>( (const T*)(in.constData()), (const T*)(background.constData()), (T*)(subtracted.data()), n, mask );
+        frame = subtracted;
+    }
+
+    // A running average holds each frame averaged. If that would take too much memory, use an exponential average instead.
+    if( averaging == imageFilter::AVERAGE_RUNNING && (qint64)(in.size()) * averageFrames > MAX_RUNNING_AVERAGE_BYTES )
+    {
+        averaging = imageFilter::AVERAGE_EXPONENTIAL;
+        runningFrames.clear();
+        runningSum.clear();
+    }
+
+    // Average if required
+    switch( averaging )
+    {
+        case imageFilter::AVERAGE_RUNNING:
+        {
+            // Start a new sum if required
+            if( runningSum.size() != n )
+            {
+                runningSum.fill( 0, n );
+                runningFrames.clear();
+            }
+
+            // Add the new frame, and remove the oldest frames if there are more than required
+            addToSum<T>( (const T*)(frame.constData()), runningSum.data(), n, mask );
+            runningFrames.append( frame );
+            while( (unsigned int)(runningFrames.count()) > averageFrames )
+            {
+                removeFromSum<T>( (const T*)(runningFrames.first().constData()), runningSum.data(), n, mask );
+                runningFrames.removeFirst();
+            }
+
+            // Generate the average
+            QByteArray averaged = FrameBufferPool::getBuffer( in.size() );
+            averageFromSum<T>( runningSum.constData(), (T*)(averaged.data()), n, runningFrames.count() );
+            return averaged;
+        }
+
+        case imageFilter::AVERAGE_EXPONENTIAL:
+        {
+            // Start a new average from this frame if required
+            if( exponentialAverage.size() != n )
+            {
+                exponentialAverage.resize( n );
+                exponentialStart<T>( (const T*)(frame.constData()), exponentialAverage.data(), n, mask );
+                return frame;
+            }
+
+            // Add the new frame
+            QByteArray averaged = FrameBufferPool::getBuffer( in.size() );
+            exponentialStep<T>( (const T*)(frame.constData()), exponentialAverage.data(), (T*)(averaged.data()), n, mask, 1.0f/averageFrames );
+            return averaged;
+        }
+
+        default:
+            return frame;
+    }
+}
+
+// Process a frame
+QByteArray imageFilter::process( const QByteArray& in, unsigned long dataSize, unsigned int bitDepth, imageDataFormats::formatOptions format )
+{
+    // Keep a reference to the raw frame in case it is captured as the background
+    lastRaw = in;
+
+    // Nothing to do if no processing required
+    if( !( subtract && !background.isEmpty() ) && averaging == AVERAGE_NONE )
+    {
+        return in;
+    }
+
+    // Only process formats where each element is an intensity
+    switch( format )
+    {
+        case imageDataFormats::MONO:
+        case imageDataFormats::BAYERGB:
+        case imageDataFormats::BAYERBG:
+        case imageDataFormats::BAYERGR:
+        case imageDataFormats::BAYERRG:
+        case imageDataFormats::RGB1:
+        case imageDataFormats::RGB2:
+        case imageDataFormats::RGB3:
+            break;
+
+        default:
+            return in;
+    }
+
+    // Restart averaging if the frame has changed shape
+    if( in.size() != averageSize || dataSize != averageDataSize || bitDepth != averageBitDepth )
+    {
+        resetAverage();
+        averageSize = in.size();
+        averageDataSize = dataSize;
+        averageBitDepth = bitDepth;
+    }
+
+    // Process the frame according to the element size
+    switch( dataSize )
+    {
+        case 1: return processFrame<quint8>(  in, background, subtract, averaging, averageFrames, runningFrames, runningSum, exponentialAverage, bitDepth );
+        case 2: return processFrame<quint16>( in, background, subtract, averaging, averageFrames, runningFrames, runningSum, exponentialAverage, bitDepth );
+        case 4: return processFrame<quint32>( in, background, subtract, averaging, averageFrames, runningFrames, runningSum, exponentialAverage, bitDepth );
+        default: return in;
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ *  This file is part of the EPICS QT Framework, initially developed at the Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+
+/*
+ This class manages background subtraction and frame averaging of image data before it is displayed or analysed.
+ Refer to imageFilter.cpp for details.
+ */
+
+#ifndef IMAGEFILTER_H
+#define IMAGEFILTER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <imageDataFormats.h>
+
+#define MAX_AVERAGE_FRAMES 64   // Largest number of frames that can be averaged
+#define MAX_RUNNING_AVERAGE_BYTES ((qint64)(256)*1024*1024) // Largest total size of the frames held for a running average. An exponential average is used if a running average would need more
+
+class imageFilter
+{
+public:
+    imageFilter();
+
+    /// \enum averagingOptions
+    /// Frame averaging options
+    enum averagingOptions { AVERAGE_NONE,           ///< No averaging
+                            AVERAGE_RUNNING,        ///< Average of the last N frames
+                            AVERAGE_EXPONENTIAL     ///< Exponential average with a time constant of N frames
+                          };
+
+    void setBackgroundSubtraction( bool subtractIn ){ subtract = subtractIn; }  // Set if the background is subtracted from each frame
+    bool getBackgroundSubtraction(){ return subtract; }
+    void captureBackground();                                                   // Use the last frame received as the background
+    void clearBackground();                                                     // Discard the background
+    bool hasBackground(){ return !background.isEmpty(); }                       // Return true if a background has been captured
+
+    void setAveraging( averagingOptions averagingIn );                          // Set how frames are averaged
+    averagingOptions getAveraging(){ return averaging; }
+    void setAverageFrames( unsigned int framesIn );                             // Set the number of frames averaged (or the time constant in frames for an exponential average)
+    unsigned int getAverageFrames(){ return averageFrames; }
+    void resetAverage();                                                        // Restart averaging
+
+    QByteArray process( const QByteArray& in, unsigned long dataSize, unsigned int bitDepth, imageDataFormats::formatOptions format ); // Process a frame
+
+private:
+    bool subtract;                      // True if the background is subtracted from each frame
+    QByteArray background;              // Background frame (raw data)
+    QByteArray lastRaw;                 // Last frame received (raw data). Held so it can be captured as the background
+
+    averagingOptions averaging;         // Frame averaging option
+    unsigned int averageFrames;         // Frames averaged (or time constant in frames for an exponential average)
+    QList<QByteArray> runningFrames;    // Frames included in the running average (after any background subtraction)
+    QVector<quint64> runningSum;        // Sum of frames included in the running average
+    QVector<float> exponentialAverage;  // Current exponential average
+
+    // Attributes of the frames being averaged. Averaging restarts if any change
+    int averageSize;
+    unsigned long averageDataSize;
+    unsigned int averageBitDepth;
+};
+
+#endif // IMAGEFILTER_H
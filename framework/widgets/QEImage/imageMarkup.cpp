@@ -134,10 +134,15 @@ void imageMarkup::setMarkupTime( QCaDateTime& time )
     if( showTime )
     {
         markupText* timeDate = (markupText*)items[MARKUP_ID_TIMESTAMP];
-        timeDate->setText( time.text().left( 23 ) );
 
-    // No need to notify of a markup change as the time is only ever set
-    // when a new image arrives and all markups will be redrawn if visible
+        // Notify a markup has changed.
+        // The time is only ever set when a new image arrives, but markups are
+        // cached over the image, so both the old and new text areas need redrawing
+        QVector<QRect> changedAreas;
+        changedAreas.append( scaleArea( timeDate->area, timeDate->scalableArea ) );
+        timeDate->setText( time.text().left( 23 ) );
+        changedAreas.append( scaleArea( timeDate->area, timeDate->scalableArea ) );
+        markupChange( changedAreas );
     }
 }
 
@@ -27,9 +27,12 @@
 // The work is performed in a dedicated thread .
 
 #include <QMutexLocker>
+#include <QElapsedTimer>
 #include "imageProcessor.h"
 #include "imageDataFormats.h"
 #include <colourConversion.h>
+#include <FrameBufferPool.h>
+#include <QEFalseColour.h>
 #include <math.h>
 
 // Constructor
@@ -38,6 +41,19 @@ imageProcessor::imageProcessor()
     // Initialise
     next = NULL;
     finishNow = false;
+    lastDecimationFactor = 1;
+    framesBuilt = 0;
+    framesDropped = 0;
+    builtSequence = 0;
+    lastBuildTime = 0.0;
+    imageSequence = 0;
+    imageUnfiltered = false;
+    filteredSequence = 0;
+
+    // Allow beam analysis results, slices and profiles to be passed from the image processing thread
+    qRegisterMetaType<beamAnalysisResults>( "beamAnalysisResults" );
+    qRegisterMetaType<beamAnalysisResultsList>( "beamAnalysisResultsList" );
+    qRegisterMetaType<profileResults>( "profileResults" );
 
     // Manage image processing thread
     imageWait.lockForWrite();
@@ -103,26 +119,74 @@ void imageProcessor::run()
                 QMutexLocker locker( &imageLock );
                 core = next;
                 next = NULL;
+                if( core )
+                {
+                    builtSequence = core->getSequence();
+                }
             }
 
             // If any image data, process it
             if( core )
             {
+                // Apply any background subtraction and averaging to image data as received.
+                // Each image received is filtered once only (the same image may be built again, for example if the brightness changes
+                // before the widget has picked up the filtered version). The filtered data is handed back to the widget through filteredImageData.
+                if( core->imageUnfiltered() )
+                {
+                    bool alreadyFiltered;
+                    QByteArray filtered;
+                    {// set scope of QMutexLocker
+                        QMutexLocker locker( &imageLock );
+                        alreadyFiltered = ( filteredSequence == core->getSequence() );
+                        filtered = filteredImageData;
+                    }
+
+                    if( alreadyFiltered )
+                    {
+                        core->useFilteredData( filtered );
+                    }
+                    else
+                    {
+                        {// set scope of QMutexLocker
+                            QMutexLocker locker( &filterLock );
+                            filtered = core->filterCore( filter );
+                        }
+
+                        QMutexLocker locker( &imageLock );
+                        filteredImageData = filtered;
+                        filteredSequence = core->getSequence();
+                    }
+                }
+
                 // Build the image
+                QElapsedTimer buildTimer;
+                buildTimer.start();
                 image = core->buildImageCore();
 
-                // Deliver the image to the widget
-                emit imageBuilt( image, "" );
+                // Note the build statistics
+                {// set scope of QMutexLocker
+                    QMutexLocker locker( &imageLock );
+                    framesBuilt++;
+                    lastBuildTime = (double)(buildTimer.nsecsElapsed()) / 1000000.0;
+                }
 
-                // Realease the content of any previous buffer that
-                // earlier QImages may have still been referencing.
+                // Analyse the beam if required.
+                // (Results are delivered before the image so any markups reflecting them are current when the image is presented)
+                if( core->analyseBeamRequired() )
+                {
+                    emit beamAnalysed( core->analyseBeamCore() );
+                }
 
-                // !!!!!!!! This is not correct. The slot called by the emit above is
-// unlikely to be complete yet.
-// It is not naturally synchronous when in another thread.
-// Force synchronous? I'd rather not...
+                // Generate any slices and profiles required
+                if( core->generateProfilesRequired() )
+                {
+                    emit profilesGenerated( core->generateProfilesCore() );
+                }
 
-                lastImageBuff.clear();
+                // Deliver the image to the widget
+                // Note, the image holds its own reference to the buffer it was built in,
+                // so the buffer remains valid until the widget has finished with the image.
+                emit imageBuilt( image, "" );
 
                 // Discard the image information
                 delete core;
@@ -148,24 +212,29 @@ void imageProcessor::setImageBuff()
     // Determine buffer size
     unsigned long buffSize = IMAGEBUFF_BYTES_PER_PIXEL * imageBuffWidth * imageBuffHeight;
 
-    // Resize buffer
-    // Note, not efficient to resize to same size - it actually does a reallocation
-    // of memory (on Qt 5.1 on windows at least)
+    // Replace the buffer if the size has changed
+    // Note, any previous QImages still referencing the old buffer hold their own reference to it
     if( (unsigned long)(imageBuff.size()) != buffSize )
     {
-        // Keep the last buffer untill a the next image is
-        // generated to ensure any previous QImages still
-        // referencing the buffer data remain sound
-        lastImageBuff = imageBuff;
-        imageBuff.resize( buffSize );
+        imageBuff = FrameBufferPool::getBuffer( buffSize );
     }
 }
 
-// Save the image data for analysis, processing and display
+// Save the image data for analysis, processing and display.
+// This is called from the widget's data update slot, so does no processing.
+// Any background subtraction and averaging is applied in the image processing thread. Until the filtered image data is
+// available (see useFilteredImage()) analysis performed in this thread (such as pixel information) uses the image data as received.
 void imageProcessor::setImage( const QByteArray& imageIn, unsigned long dataSize )
 {
     // Save the current image
+    // (The previous image is returned to the pool if nothing else is still using it)
+    FrameBufferPool::releaseBuffer( imageData );
     imageData = imageIn;
+    {// set scope of QMutexLocker
+        QMutexLocker locker( &imageLock );
+        imageSequence++;
+        imageUnfiltered = true;
+    }
     receivedImageSize = (unsigned long) imageData.size ();
     imageDataSize = dataSize;
 
@@ -177,6 +246,18 @@ void imageProcessor::setImage( const QByteArray& imageIn, unsigned long dataSize
     bytesPerPixel = imageDataSize * elementsPerPixel;
 }
 
+// Replace the current image data with its filtered version (background subtraction and averaging applied)
+// once the image processing thread has filtered it.
+void imageProcessor::useFilteredImage()
+{
+    QMutexLocker locker( &imageLock );
+    if( imageUnfiltered && filteredSequence == imageSequence )
+    {
+        imageData = filteredImageData;
+        imageUnfiltered = false;
+    }
+}
+
 // Generate a new image.
 // This is the first part of generating an image from new data.
 // most of the processing will occur in a seperate thread in imagePropertiesCore::buildImageCore()
@@ -185,6 +266,9 @@ void imageProcessor::buildImage()
     // Initially no errors
     QString errorText;
 
+    // Use the filtered version of the current image data if it is available
+    useFilteredImage();
+
     // Do nothing if there is no image, or are no image dimensions yet
     if( imageData.isEmpty() || !imageBuffWidth || !imageBuffHeight )
     {
@@ -252,28 +336,31 @@ void imageProcessor::buildImage()
         QMutexLocker locker( &imageLock );
 
         // If there is earlier image data that is yet to be processed, discard it.
+        // This only drops a frame if that image data is not the current image data (about to be packaged up
+        // again) and has not already been built, as it will be when rebuilding the current image following
+        // a brightness, zoom or markup change.
         if( next )
         {
+            if( next->getSequence() != imageSequence && next->getSequence() != builtSequence )
+            {
+                framesDropped++;
+            }
             delete next;
             next = NULL;
         }
 
-        // Package up the current image data and all related information
-        next = new imagePropertiesCore( imageData,
-                                        imageBuff,
-                                        imageBuffWidth,
-                                        imageBuffHeight,
-                                        getScanOption(),
-                                        bytesPerPixel,
-                                        pixelLow,
-                                        pixelHigh,
-                                        bitDepth,
-                                        pixelLookup,
-                                        formatOption,
-                                        imageDataSize,
-                                        imageDisplayProps,
-                                        rotatedImageBuffWidth(),
-                                        rotatedImageBuffHeight() );
+        // Get a buffer to build the image in.
+        // The buffer used for the previous image may still be referenced by the QImage built in it,
+        // so use an idle buffer from the pool (which will usually be one used for an earlier image)
+        // rather than overwrite an image that may be being displayed.
+        unsigned long buffSize = imageBuff.size();
+        FrameBufferPool::releaseBuffer( imageBuff );
+        imageBuff = FrameBufferPool::getBuffer( buffSize );
+
+        // Package up the current image data and all related information.
+        // If the image is displayed at a reduced size, build it directly at (about) the displayed resolution
+        lastDecimationFactor = getDecimationFactor();
+        next = newCore( imageBuff, lastDecimationFactor );
     }
 
 // Include the following two lines to skip processing in seperate thread.
@@ -285,6 +372,33 @@ void imageProcessor::buildImage()
     imageSync.wakeOne();
 }
 
+// Package up the current image data and all related information ready for processing.
+// The processed image will be generated in the buffer provided, decimated by the factor provided.
+imagePropertiesCore* imageProcessor::newCore( QByteArray& buff, unsigned int factor )
+{
+    return new imagePropertiesCore( imageData,
+                                    buff,
+                                    imageBuffWidth,
+                                    imageBuffHeight,
+                                    getScanOption(),
+                                    bytesPerPixel,
+                                    bitDepth,
+                                    pixelLookup,
+                                    pixelLookupShift,
+                                    formatOption,
+                                    imageDataSize,
+                                    imageDisplayProps,
+                                    (rotatedImageBuffWidth()+factor-1)/factor,
+                                    (rotatedImageBuffHeight()+factor-1)/factor,
+                                    factor,
+                                    decimation,
+                                    beamAnalysis,
+                                    beamAnalysisAreas,
+                                    profiles,
+                                    imageUnfiltered,
+                                    imageSequence );
+}
+
 // Package up image data along with all the information
 // needed to process it and generate a QImage.
 imagePropertiesCore::imagePropertiesCore( QByteArray imageDataIn,
@@ -293,15 +407,21 @@ imagePropertiesCore::imagePropertiesCore( QByteArray imageDataIn,
                                           unsigned long imageBuffHeightIn,
                                           int scanOptionIn,
                                           unsigned long bytesPerPixelIn,
-                                          int pixelLowIn,
-                                          int pixelHighIn,
                                           unsigned int bitDepthIn,
-                                          imageDisplayProperties::rgbPixel* pixelLookupIn,
+                                          QVector<imageDisplayProperties::rgbPixel> pixelLookupIn,
+                                          unsigned int pixelLookupShiftIn,
                                           imageDataFormats::formatOptions formatOptionIn,
                                           unsigned long imageDataSizeIn,
                                           imageDisplayProperties* imageDisplayPropsIn,
                                           unsigned int rotatedImageBuffWidthIn,
-                                          unsigned int rotatedImageBuffHeightIn )
+                                          unsigned int rotatedImageBuffHeightIn,
+                                          unsigned int decimationFactorIn,
+                                          int decimationIn,
+                                          int beamAnalysisIn,
+                                          QVector<QRect> beamAnalysisAreasIn,
+                                          profileRequests profilesIn,
+                                          bool unfilteredIn,
+                                          unsigned long sequenceIn )
 {
     imageData = imageDataIn;
     imageBuff = imageBuffIn;
@@ -309,15 +429,30 @@ imagePropertiesCore::imagePropertiesCore( QByteArray imageDataIn,
     imageBuffHeight = imageBuffHeightIn;
     scanOption = scanOptionIn;
     bytesPerPixel = bytesPerPixelIn;
-    pixelLow = pixelLowIn;
-    pixelHigh = pixelHighIn;
     bitDepth = bitDepthIn;
     pixelLookup = pixelLookupIn;
+    pixelLookupShift = pixelLookupShiftIn;
     formatOption = formatOptionIn;
     imageDataSize = imageDataSizeIn;
     imageDisplayProps = imageDisplayPropsIn;
     rotatedImageBuffWidth = rotatedImageBuffWidthIn;
     rotatedImageBuffHeight = rotatedImageBuffHeightIn;
+    decimationFactor = decimationFactorIn ? decimationFactorIn : 1;
+    decimation = decimationIn;
+    beamAnalysis = beamAnalysisIn;
+    beamAnalysisAreas = beamAnalysisAreasIn;
+    profiles = profilesIn;
+    unfiltered = unfilteredIn;
+    sequence = sequenceIn;
+}
+
+// Apply background subtraction and averaging to the image data.
+// This is performed by the image processing thread before building the image.
+QByteArray imagePropertiesCore::filterCore( imageFilter& filter )
+{
+    imageData = filter.process( imageData, imageDataSize, bitDepth, formatOption );
+    unfiltered = false;
+    return imageData;
 }
 
 // Generate a new image.
@@ -387,8 +522,12 @@ QImage imagePropertiesCore::buildImageCore()
     int start;      // Output buffer start pixel (one of the four corners)
     int outInc;     // Outer loop increment to output buffer
     int inInc;      // Inner loop increment to output buffer
-    int h = imageBuffHeight;
-    int w = imageBuffWidth;
+
+    // Image dimensions to scan.
+    // If decimating, each pixel scanned represents a block of original pixels
+    // (with partial blocks on the right and bottom edges if the image is not an exact multiple of the block size)
+    int h = (imageBuffHeight+decimationFactor-1)/decimationFactor;
+    int w = (imageBuffWidth+decimationFactor-1)/decimationFactor;
 
     // Set the loop parameters according to the scan option
     switch( scanOption )
@@ -414,27 +553,25 @@ QImage imagePropertiesCore::buildImageCore()
     // loops to where ever that next pixel is according to the rotation and flipping.
     dataIndex = start;
 
-    unsigned int pixelRange = pixelHigh-pixelLow;
-    if( !pixelRange )
-    {
-        pixelRange = 1;
-    }
+    // The pixel lookup table holds an entry for every possible pixel value and already
+    // includes local brightness and contrast, so each pixel only requires a single lookup.
+    // Note, must be constData() - not data() - to avoid a copy of the shared table
+    const imageDisplayProperties::rgbPixel* lookup = pixelLookup.constData();
 
     unsigned int mask = (1<<bitDepth)-1;
 
-    // Prepare for building image stats while processing image data
+    // Prepare for building image stats while processing image data.
+    // A full depth histogram is gathered with one bin for each pixel lookup table entry.
+    // (The coarse histogram used for display is derived from it after the image is built)
     unsigned int maxP = 0;
     unsigned int minP = UINT_MAX;
     unsigned int valP;
-    unsigned int binShift = (bitDepth<8)?0:bitDepth-8;
-    unsigned int bin;
-    for( int i = 0; i < HISTOGRAM_BINS; i++ )
-    {
-        bins[i]=0;
-    }
+    int histogramSize = pixelLookup.size() ? pixelLookup.size() : HISTOGRAM_BINS;
+    unsigned int histogramMask = histogramSize-1;
+    QVector<unsigned int> fullBins( histogramSize, 0 );
+    unsigned int* histogram = fullBins.data();
 #define BUILD_STATS \
-    bin = valP>>binShift; \
-    bins[bin] = bins[bin]+1; \
+    histogram[(valP>>pixelLookupShift)&histogramMask]++; \
     if( valP < minP ) minP = valP; \
     else if( valP > maxP ) maxP = valP;
 
@@ -459,6 +596,47 @@ QImage imagePropertiesCore::buildImageCore()
     {
         case imageDataFormats::MONO:
         {
+            // If decimating, generate each pixel from the block of original pixels it represents
+            if( decimationFactor > 1 )
+            {
+                bool useMaximum = ( decimation == imageProperties::DECIMATION_MAXIMUM );
+                unsigned long rowStep = imageBuffWidth*bytesPerPixel;
+
+                LOOP_START
+                    // Determine the block of original pixels represented by this pixel
+                    unsigned long blockX = ( dataIndex % w ) * decimationFactor;
+                    unsigned long blockY = ( dataIndex / w ) * decimationFactor;
+                    unsigned long blockW = ( blockX+decimationFactor > imageBuffWidth )  ? imageBuffWidth-blockX  : decimationFactor;
+                    unsigned long blockH = ( blockY+decimationFactor > imageBuffHeight ) ? imageBuffHeight-blockY : decimationFactor;
+
+                    // Combine the block of original pixels (maximum or average)
+                    const unsigned char* rowPtr = &dataIn[(blockY*imageBuffWidth+blockX)*bytesPerPixel];
+                    quint64 total = 0;
+                    unsigned int maximum = 0;
+                    for( unsigned long y = 0; y < blockH; y++ )
+                    {
+                        const unsigned char* pixelPtr = rowPtr;
+                        for( unsigned long x = 0; x < blockW; x++ )
+                        {
+                            unsigned int blockPixel = (*(unsigned int*)(pixelPtr))&mask;
+                            total += blockPixel;
+                            if( blockPixel > maximum ) maximum = blockPixel;
+                            pixelPtr += bytesPerPixel;
+                        }
+                        rowPtr += rowStep;
+                    }
+                    unsigned int inPixel = useMaximum ? maximum : (unsigned int)( total / ( blockW*blockH ));
+
+                    // Accumulate pixel statistics
+                    valP = inPixel;
+                    BUILD_STATS
+
+                    // Select displayed pixel
+                    dataOut[buffIndex] = lookup[inPixel>>pixelLookupShift];
+                LOOP_END
+                break;
+            }
+
             LOOP_START
                 unsigned int inPixel;
 
@@ -469,11 +647,8 @@ QImage imagePropertiesCore::buildImageCore()
                 valP = inPixel;
                 BUILD_STATS
 
-                // Scale pixel for local brightness and contrast
-                ( (int)inPixel < pixelLow ) ? inPixel = 0 : ( (int)inPixel > pixelHigh ) ? inPixel = 255 : inPixel = ((int)inPixel-pixelLow)*255/pixelRange;
-
                 // Select displayed pixel
-                dataOut[buffIndex] = pixelLookup[inPixel];
+                dataOut[buffIndex] = lookup[inPixel>>pixelLookupShift];
             LOOP_END
             break;
         }
@@ -583,8 +758,7 @@ QImage imagePropertiesCore::buildImageCore()
             // Processing region (corners, edges, or central)
             regions region;
 
-            // Pre-calculate data shift and mask nessesary to obtain most significant 8 bits
-            int shift = (bitDepth<=8)?0:bitDepth-8;
+            // Pre-calculate data mask nessesary to obtain the significant bits
             quint32 mask = (1<<bitDepth)-1;
 
             // Loop through the input data
@@ -775,22 +949,22 @@ QImage imagePropertiesCore::buildImageCore()
                         }
 
                         // Calculate the diagonal sum (red or blue depending on the pattern)
-                        d = (d1+d2+d3+d4)>>(shift+2);
+                        d = (d1+d2+d3+d4)>>2;
 
                         // Calculate the Green value from the green cells
-                        g = (g1+g2+g3+g4)>>(shift+2);
+                        g = (g1+g2+g3+g4)>>2;
 
                         // Take the red and blue from the current cell and the diagonals, or the other way round depending on the pattern
                         switch( cellColour )
                         {
                             default:    // Should never hit the default case. Include to avoid compilation errors
                             case CC_R: // red
-                                r = rb>>shift;
+                                r = rb;
                                 b = d;
                                 break;
                             case CC_B: // blue
                                 r = d;
-                                b = rb>>shift;
+                                b = rb;
                                 break;
                         }
 
@@ -873,11 +1047,11 @@ QImage imagePropertiesCore::buildImageCore()
                         }
 
                         // Calculate the vertical and horizontal sums (one is red, the other is blue depending on the pattern)
-                        h = (h1+h2)>>(shift+1);
-                        v = (v1+v2)>>(shift+1);
+                        h = (h1+h2)>>1;
+                        v = (v1+v2)>>1;
 
                         // Calculate the Green value from the green cell
-                        g = g12>>shift;
+                        g = g12;
 
                         // Take the red and blue from the vertical or horizontal sums depending on the pattern
                         switch( cellColour )
@@ -910,16 +1084,11 @@ QImage imagePropertiesCore::buildImageCore()
                 valP = g; // use all three colors!!!
                 BUILD_STATS
 
-                // Scale pixel for local brightness and contrast
+                // Select displayed pixel (lookup includes local brightness and contrast)
                 // !!! This will introduce some hue issues. Should convert to HSV to manipulate brightness and contrast????
-                ( (int)r < pixelLow ) ? r = 0 : ( (int)r > pixelHigh ) ? r = 255 : r = (r-pixelLow)*255/pixelRange;
-                ( (int)g < pixelLow ) ? g = 0 : ( (int)g > pixelHigh ) ? g = 255 : g = (g-pixelLow)*255/pixelRange;
-                ( (int)b < pixelLow ) ? b = 0 : ( (int)b > pixelHigh ) ? b = 255 : b = (b-pixelLow)*255/pixelRange;
-
-                // Select displayed pixel
-                dataOut[buffIndex].p[0] = pixelLookup[b].p[0];
-                dataOut[buffIndex].p[1] = pixelLookup[g].p[0];
-                dataOut[buffIndex].p[2] = pixelLookup[r].p[0];
+                dataOut[buffIndex].p[0] = lookup[b>>pixelLookupShift].p[0];
+                dataOut[buffIndex].p[1] = lookup[g>>pixelLookupShift].p[0];
+                dataOut[buffIndex].p[2] = lookup[r>>pixelLookupShift].p[0];
                 dataOut[buffIndex].p[3] = 0xff;
 
             LOOP_END
@@ -945,16 +1114,11 @@ QImage imagePropertiesCore::buildImageCore()
                 valP = g; // use all three colors!!!
                 BUILD_STATS
 
-                // Scale pixel for local brightness and contrast
+                // Select displayed pixel (lookup includes local brightness and contrast)
                 // !!! This will introduce some hue issues. Should convert to HSV to manipulate brightness and contrast????
-                ( (int)r < pixelLow ) ? r = 0 : ( (int)r > pixelHigh ) ? r = 255 : r = (r-pixelLow)*255/pixelRange;
-                ( (int)g < pixelLow ) ? g = 0 : ( (int)g > pixelHigh ) ? g = 255 : g = (g-pixelLow)*255/pixelRange;
-                ( (int)b < pixelLow ) ? b = 0 : ( (int)b > pixelHigh ) ? b = 255 : b = (b-pixelLow)*255/pixelRange;
-
-                // Select displayed pixel
-                dataOut[buffIndex].p[0] = pixelLookup[b].p[0];
-                dataOut[buffIndex].p[1] = pixelLookup[g].p[0];
-                dataOut[buffIndex].p[2] = pixelLookup[r].p[0];
+                dataOut[buffIndex].p[0] = lookup[b>>pixelLookupShift].p[0];
+                dataOut[buffIndex].p[1] = lookup[g>>pixelLookupShift].p[0];
+                dataOut[buffIndex].p[2] = lookup[r>>pixelLookupShift].p[0];
                 dataOut[buffIndex].p[3] = 0xff;
 
             LOOP_END
@@ -1008,16 +1172,11 @@ QImage imagePropertiesCore::buildImageCore()
                     valP = g; // use all three colors!!!
                     BUILD_STATS
 
-                    // Scale pixel for local brightness and contrast
+                    // Select displayed pixel (lookup includes local brightness and contrast)
                     // !!! This will introduce some hue issues. Should convert to HSV to manipulate brightness and contrast????
-                    ( (int)r < pixelLow ) ? r = 0 : ( (int)r > pixelHigh ) ? r = 255 : r = (r-pixelLow)*255/pixelRange;
-                    ( (int)g < pixelLow ) ? g = 0 : ( (int)g > pixelHigh ) ? g = 255 : g = (g-pixelLow)*255/pixelRange;
-                    ( (int)b < pixelLow ) ? b = 0 : ( (int)b > pixelHigh ) ? b = 255 : b = (b-pixelLow)*255/pixelRange;
-
-                    // Select displayed pixel
-                    dataOut[buffIndex].p[0] = pixelLookup[b].p[0];
-                    dataOut[buffIndex].p[1] = pixelLookup[g].p[0];
-                    dataOut[buffIndex].p[2] = pixelLookup[r].p[0];
+                    dataOut[buffIndex].p[0] = lookup[b>>pixelLookupShift].p[0];
+                    dataOut[buffIndex].p[1] = lookup[g>>pixelLookupShift].p[0];
+                    dataOut[buffIndex].p[2] = lookup[r>>pixelLookupShift].p[0];
                     dataOut[buffIndex].p[3] = 0xff;
 
             LOOP_END
@@ -1025,791 +1184,763 @@ QImage imagePropertiesCore::buildImageCore()
         }
     }
 
+    // Derive the coarse histogram (HISTOGRAM_BINS bins of the most significant bits) from the full depth histogram
+    for( int i = 0; i < HISTOGRAM_BINS; i++ )
+    {
+        bins[i]=0;
+    }
+    unsigned int binShift = (bitDepth<8)?0:bitDepth-8;
+    for( int i = 0; i < histogramSize; i++ )
+    {
+        unsigned int bin = ( (quint64)(i) << pixelLookupShift ) >> binShift;
+        if( bin >= HISTOGRAM_BINS ) bin = HISTOGRAM_BINS-1;
+        bins[bin] += histogram[i];
+    }
+
     // Update the image display properties controls if present
     if( imageDisplayProps )
     {
-        imageDisplayProps->setStatistics( minP, maxP, bitDepth, bins, pixelLookup );
+        imageDisplayProps->setStatistics( minP, maxP, bitDepth, bins, fullBins, pixelLookup, pixelLookupShift );
     }
 
     // Generate a frame from the data
-    QImage frameImage( (uchar*)(imageBuff.constData()), rotatedImageBuffWidth, rotatedImageBuffHeight, QImage::Format_RGB32 );
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    // The image holds a reference to the buffer so the buffer is released (returned to the pool)
+    // only when the image (and all copies of it) are deleted
+    QImage frameImage( (uchar*)(imageBuff.constData()), rotatedImageBuffWidth, rotatedImageBuffHeight, QImage::Format_RGB32,
+                       releaseImageBuff, new QByteArray( imageBuff ) );
     return frameImage;
+#else
+    // Images can't hold a reference to the buffer, so return a copy
+    QImage frameImage( (uchar*)(imageBuff.constData()), rotatedImageBuffWidth, rotatedImageBuffHeight, QImage::Format_RGB32 );
+    return frameImage.copy();
+#endif
 }
 
-// Set the image width
-// Return true of the width changes as a result.
-bool imageProcessor::setWidth( unsigned long uValue )
+// Release the reference to an image buffer held by a QImage when the QImage is deleted.
+// This is usually the last reference, so the buffer is returned to the pool for the next image.
+void imagePropertiesCore::releaseImageBuff( void* info )
 {
-    if( imageBuffWidth != uValue )
-    {
-        imageBuffWidth = uValue;
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    QByteArray* buffer = (QByteArray*)info;
+    FrameBufferPool::releaseBuffer( *buffer );
+    delete buffer;
 }
 
-// Set the image height
-// Return true of the height changes as a result.
-bool imageProcessor::setHeight( unsigned long uValue )
+// Return a number representing a pixel intensity given a pointer into an image data buffer
+// and the format information required to interpret it.
+// Used by both the image processor and the image processing thread.
+static int pixelValueFromData( const unsigned char* ptr, imageDataFormats::formatOptions formatOption, unsigned int bitDepth, unsigned long imageDataSize )
 {
-    if( imageBuffHeight != uValue )
-    {
-        imageBuffHeight = uValue;
-        return true;
-    }
-    else
+    // Sanity check
+    if( !ptr )
+        return 0;
+
+    // Case the data to the correct size, then return the data as a floating point number.
+    switch( formatOption )
     {
-        return false;
+        case imageDataFormats::BAYERGB:
+        case imageDataFormats::BAYERBG:
+        case imageDataFormats::BAYERGR:
+        case imageDataFormats::BAYERRG:
+        case imageDataFormats::MONO:
+            {
+                unsigned int usableDepth = bitDepth;
+                if( bitDepth > (imageDataSize*8) )
+                {
+                    usableDepth = imageDataSize*8;
+                }
+
+                quint32 mask = (1<<usableDepth)-1;
+
+                return (*((quint32*)ptr))&mask;
+            }
+
+        case imageDataFormats::RGB1:
+            {
+                // for RGB, average all colors
+                unsigned int pixel = *(unsigned int*)ptr;
+                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
+            }
+
+        case imageDataFormats::RGB2:
+            //!!! not done - copy of RGB1
+            {
+                // for RGB, average all colors
+                unsigned int pixel = *(unsigned int*)ptr;
+                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
+            }
+
+        case imageDataFormats::RGB3:
+            //!!! not done - copy of RGB1
+            {
+                // for RGB, average all colors
+                unsigned int pixel = *(unsigned int*)ptr;
+                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
+            }
+
+        case imageDataFormats::YUV444:
+            //!!! not done - copy of RGB1
+            {
+                // for RGB, average all colors
+                unsigned int pixel = *(unsigned int*)ptr;
+                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
+            }
+
+        case imageDataFormats::YUV422:
+            //!!! not done - copy of RGB1
+            {
+                // for RGB, average all colors
+                unsigned int pixel = *(unsigned int*)ptr;
+                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
+            }
+
+        case imageDataFormats::YUV421:
+            //!!! not done - copy of RGB1
+            {
+                // for RGB, average all colors
+                unsigned int pixel = *(unsigned int*)ptr;
+                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
+            }
     }
+
+    // Avoid compilation warning (not sure why this is required as all cases are handled in switch statements.
+    return *ptr;
 }
 
-// Set the number of dimensions.
-// This is an area detector concept and is used to determine how to treat dimenstions 0, 1, and 2
-bool imageProcessor::setNumDimensions( unsigned long uValue )
-{
-    if( numDimensions != uValue )
-    {
-        switch( uValue )
-        {
-            case 0:
-                numDimensions = uValue;
-                break;
 
-            case 2:
-            case 3:
-                numDimensions = uValue;
-                setWidthHeightFromDimensions();
-                break;
-        }
-        return true;
-    }
-    else
+// Return the mask required to obtain the significant bits of single element pixel data
+static quint32 pixelDataMask( unsigned int bitDepth, unsigned long imageDataSize )
+{
+    unsigned int usableDepth = bitDepth;
+    if( usableDepth > imageDataSize*8 )
     {
-        return false;
+        usableDepth = imageDataSize*8;
     }
+    return (quint32)(((quint64)1<<usableDepth)-1);
 }
 
-// Set the first dimension (width if two dimenstions, bytes per element if three dimensions)
-bool imageProcessor::setDimension0( unsigned long uValue )
+// Beam analysis results. Initially invalid
+beamAnalysisResults::beamAnalysisResults()
 {
-    if( imageDimension0 != uValue )
-    {
-        imageDimension0 = uValue;
-        setWidthHeightFromDimensions();
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    valid = false;
+    areaNumber = 0;
+    centroidX = 0.0;
+    centroidY = 0.0;
+    sigmaX = 0.0;
+    sigmaY = 0.0;
+    sigmaXY = 0.0;
+    peak = 0;
+    integral = 0.0;
+    background = 0;
+
+    fitValid = false;
+    fitX = 0.0;
+    fitY = 0.0;
+    fitSigmaX = 0.0;
+    fitSigmaY = 0.0;
 }
 
-// Set the second dimension (height if two dimensions, width if three dimensions)
-bool imageProcessor::setDimension1( unsigned long uValue )
+// Function used to accumulate the beam analysis sums for one row of image data.
+// Pixel values are added to the X projection, and the row total, the row total weighted by
+// X, the lowest and highest pixel value and the position of the highest pixel value are returned.
+typedef void (*beamRowFunction)( const unsigned char* rowPtr, unsigned long step, int w, quint32 mask, unsigned long elementStep,
+                                 quint64* projX, quint64& rowSum, quint64& rowSumX,
+                                 unsigned int& rowMin, unsigned int& rowMax, int& rowMaxX );
+
+// Accumulate the beam analysis sums for one row of single element pixels (mono and Bayer formats).
+// The element type is fixed for the whole row so the inner loop has no per pixel format handling.
+template <typename T>
+static void beamRowSingleElement( const unsigned char* rowPtr, unsigned long step, int w, quint32 mask, unsigned long,
+                                  quint64* projX, quint64& rowSum, quint64& rowSumX,
+                                  unsigned int& rowMin, unsigned int& rowMax, int& rowMaxX )
 {
-    if( imageDimension1 != uValue )
+    quint64 sum = 0;
+    quint64 sumX = 0;
+    unsigned int minV = UINT_MAX;
+    unsigned int maxV = 0;
+    int maxX = 0;
+    for( int x = 0; x < w; x++ )
     {
-        imageDimension1 = uValue;
-        setWidthHeightFromDimensions();
-        return true;
-    }
-    else
-    {
-        return false;
+        unsigned int v = (*(const T*)(rowPtr))&mask;
+        rowPtr += step;
+
+        projX[x] += v;
+        sum += v;
+        sumX += (quint64)v * x;
+        if( v < minV ) minV = v;
+        if( v > maxV ) { maxV = v; maxX = x; }
     }
+    rowSum = sum;
+    rowSumX = sumX;
+    rowMin = minV;
+    rowMax = maxV;
+    rowMaxX = maxX;
 }
 
-// Set the third dimension (unused if two dimensions, height if three dimensions)
-bool imageProcessor::setDimension2( unsigned long uValue )
+// Accumulate the beam analysis sums for one row of RGB pixels.
+// The intensity of each pixel is the sum of the three colours. As for single element pixels, the
+// element type is fixed for the whole row, so each colour is read at its full size, not just its first byte.
+template <typename T>
+static void beamRowRGB( const unsigned char* rowPtr, unsigned long step, int w, quint32 mask, unsigned long elementStep,
+                        quint64* projX, quint64& rowSum, quint64& rowSumX,
+                        unsigned int& rowMin, unsigned int& rowMax, int& rowMaxX )
 {
-    if( imageDimension2 != uValue )
-    {
-        imageDimension2 = uValue;
-        setWidthHeightFromDimensions();
-        return true;
-    }
-    else
+    quint64 sum = 0;
+    quint64 sumX = 0;
+    unsigned int minV = UINT_MAX;
+    unsigned int maxV = 0;
+    int maxX = 0;
+    for( int x = 0; x < w; x++ )
     {
-        return false;
+        unsigned int v = ((*(const T*)(rowPtr))&mask) +
+                         ((*(const T*)(rowPtr+elementStep))&mask) +
+                         ((*(const T*)(rowPtr+2*elementStep))&mask);
+        rowPtr += step;
+
+        projX[x] += v;
+        sum += v;
+        sumX += (quint64)v * x;
+        if( v < minV ) minV = v;
+        if( v > maxV ) { maxV = v; maxX = x; }
     }
+    rowSum = sum;
+    rowSumX = sumX;
+    rowMin = minV;
+    rowMax = maxV;
+    rowMaxX = maxX;
 }
 
-// Set clipping flag. If true, setClippingLow() and setClippingHigh() are used to set clipping values
-void imageProcessor::setClippingOn( bool clippingOnIn )
+// Analyse the beam in the image data.
+// This is performed by the image processing thread after building the image.
+// Each selected analysis area is analysed independently. If no area is selected, the entire image is analysed.
+// Results are returned in area number order.
+beamAnalysisResultsList imagePropertiesCore::analyseBeamCore()
 {
-    if( clippingOn != clippingOnIn )
+    beamAnalysisResultsList resultsList;
+
+    for( int i = 0; i < beamAnalysisAreas.count(); i++ )
     {
-        clippingOn = clippingOnIn;
-        pixelLookupValid = false;
+        if( !beamAnalysisAreas[i].isEmpty() )
+        {
+            beamAnalysisResults results = analyseBeamArea( beamAnalysisAreas[i] );
+            results.areaNumber = i+1;
+            resultsList.append( results );
+        }
     }
-}
 
-// Set pixel value below which low clip colour is displayed
-void imageProcessor::setClippingLow( unsigned int value )
-{
-    if( clippingLow != (unsigned int)value )
+    if( resultsList.isEmpty() )
     {
-        clippingLow = value;
-        pixelLookupValid = false;
+        resultsList.append( analyseBeamArea( QRect() ) );
     }
+
+    return resultsList;
 }
 
-// Set pixel value above which high clip colour is displayed
-void imageProcessor::setClippingHigh( unsigned int value )
+// Analyse the beam in an area of the image data (the entire image if the area is empty).
+// Centroid, second moments, peak and integrated intensity are determined in a single pass
+// over the analysis area. The pass accumulates the X and Y projections of the area and the
+// row sums weighted by X. All moments are then derived from these. The lowest pixel value in
+// the area is taken as the background and is removed from the sums afterwards.
+beamAnalysisResults imagePropertiesCore::analyseBeamArea( const QRect& analysisArea )
 {
-    if( clippingHigh != (unsigned int)value )
+    beamAnalysisResults results;
+
+    // Determine the area to analyse (the entire image if no area is specified)
+    QRect imageArea( 0, 0, imageBuffWidth, imageBuffHeight );
+    QRect area = analysisArea.isEmpty() ? imageArea : analysisArea.normalized().intersected( imageArea );
+    if( area.isEmpty() || (unsigned long)(imageData.size()) < imageBuffWidth*imageBuffHeight*bytesPerPixel )
     {
-        clippingHigh = value;
-        pixelLookupValid = false;
+        return results;
     }
-}
+    results.area = area;
 
-// Determine the way the input pixel data must be scanned to accommodate the required
-// rotate and flip options. This is used when generating the image data, and also when
-// transforming points in the image back to references in the original pixel data.
-int imageProcessor::getScanOption()
-{
-    // Depending on the flipping and rotating options pixel drawing can start in any of
-    // the four corners and start scanning either vertically or horizontally.
-    // The 8 scanning options are shown numbered here:
-    //
-    //    o----->1         2<-----o
-    //    |                       |
-    //    |                       |
-    //    |                       |
-    //    v                       v
-    //    5                       6
-    //
-    //
-    //
-    //    7                       8
-    //    ^                       ^
-    //    |                       |
-    //    |                       |
-    //    |                       |
-    //    o----->3         4<-----o
-    //
-    //
-    // The rotation and flip properties can be set in 16 combinations, but these 16
-    // options can only specify the 8 possible scan options as follows:
-    // (for example rotating 180 degrees, then flipping both vertically and horizontally
-    // is the same as doing no rotation or flipping at all - scan option 1)
-    //
-    //  rot vflip hflip scan_option
-    //    0   0     0      1
-    //    0   0     1      2
-    //    0   1     0      3
-    //    0   1     1      4
-    //  R90   0     0      7
-    //  R90   0     1      5
-    //  R90   1     0      8
-    //  R90   1     1      6
-    //  L90   0     0      6
-    //  L90   0     1      8
-    //  L90   1     0      5
-    //  L90   1     1      7
-    //  180   0     0      4
-    //  180   0     1      3
-    //  180   1     0      2
-    //  180   1     1      1
-    //
-    // Determine the scan option as shown in the above diagram
-    switch( rotation )
-    {                                               // vh v!h     !vh !v!h
-        case ROTATION_0:        return flipVert?flipHoz?4:3:flipHoz?2:1;
-        case ROTATION_90_RIGHT: return flipVert?flipHoz?6:8:flipHoz?5:7;
-        case ROTATION_90_LEFT:  return flipVert?flipHoz?7:5:flipHoz?8:6;
-        case ROTATION_180:      return flipVert?flipHoz?1:2:flipHoz?3:4;
-        default:                return 1; // Sanity check
-    }
-}
+    // Select the row function for the format
+    quint32 mask = pixelDataMask( bitDepth, imageDataSize );
 
-// Generate a lookup table to convert raw pixel values to display pixel values taking into
-// account, clipping, and contrast reversal.
-// Note, the table will be used to translate each colour in an RGB format.
-//
-void imageProcessor::getPixelTranslation()
-{
-    // Maximum pixel value for 8 bit
-    #define MAX_VALUE 255
+    beamRowFunction rowFunction = NULL;
+    switch( formatOption )
+    {
+        case imageDataFormats::MONO:
+        case imageDataFormats::BAYERGB:
+        case imageDataFormats::BAYERBG:
+        case imageDataFormats::BAYERGR:
+        case imageDataFormats::BAYERRG:
+            switch( imageDataSize )
+            {
+                case 1: rowFunction = beamRowSingleElement<quint8>;  break;
+                case 2: rowFunction = beamRowSingleElement<quint16>; break;
+                case 4: rowFunction = beamRowSingleElement<quint32>; break;
+                default: break;
+            }
+            break;
 
-    // If there is an image options control, get the relevent options
-    bool contrastReversal;
-    bool logBrightness;
+        case imageDataFormats::RGB1:
+            // (Only up to 16 bit colours, so the sum of the three colours fits the pixel value)
+            if( bytesPerPixel < 3*imageDataSize )
+            {
+                break;
+            }
+            switch( imageDataSize )
+            {
+                case 1: rowFunction = beamRowRGB<quint8>;  break;
+                case 2: rowFunction = beamRowRGB<quint16>; break;
+                default: break;
+            }
+            break;
 
-    if( imageDisplayProps )
-    {
-        contrastReversal = imageDisplayProps->getContrastReversal();
-        logBrightness = imageDisplayProps->getLog();
+        default:
+            break;
     }
-    else
+
+    // Can't analyse this format
+    if( !rowFunction )
     {
-        contrastReversal = false;
-        logBrightness = false;
+        return results;
     }
 
-    // If there is an image options control, and we have retrieved high and low pixels from an image, get the relevent options
-    if( imageDisplayProps && imageDisplayProps->statisticsValid() )
+    // Accumulate the projections and row sums in a single pass over the area
+    int w = area.width();
+    int h = area.height();
+    QVector<quint64> projX( w, 0 );
+    QVector<quint64> projY( h, 0 );
+    QVector<quint64> rowSumX( h, 0 );
+
+    unsigned int minV = UINT_MAX;
+    unsigned int maxV = 0;
+
+    const unsigned char* dataIn = (const unsigned char*)imageData.constData();
+    unsigned long rowStep = imageBuffWidth*bytesPerPixel;
+    const unsigned char* rowPtr = &dataIn[(area.top()*imageBuffWidth+area.left())*bytesPerPixel];
+    quint64* projXPtr = projX.data();
+
+    for( int y = 0; y < h; y++ )
     {
-        pixelLow = imageDisplayProps->getLowPixel();
-        pixelHigh = imageDisplayProps->getHighPixel();
+        unsigned int rowMin;
+        unsigned int rowMax;
+        int rowMaxX;
+        rowFunction( rowPtr, bytesPerPixel, w, mask, imageDataSize, projXPtr, projY[y], rowSumX[y], rowMin, rowMax, rowMaxX );
+
+        if( rowMin < minV ) minV = rowMin;
+        if( y == 0 || rowMax > maxV )
+        {
+            maxV = rowMax;
+            results.peakPos = QPoint( area.left()+rowMaxX, area.top()+y );
+        }
+
+        rowPtr += rowStep;
     }
-    else
+
+    results.peak = maxV;
+    results.background = minV;
+
+    // Derive the moments from the projections with the background removed.
+    // Coordinates are relative to the area origin until the results are saved.
+    double b = minV;
+    double sumW = 0.0;
+    double sumWX = 0.0;
+    double sumWXX = 0.0;
+    for( int x = 0; x < w; x++ )
     {
-        pixelLow = 0;
-        pixelHigh = maxPixelValue();
+        double v = (double)(projX[x]) - b*h;
+        sumW += v;
+        sumWX += v*x;
+        sumWXX += v*x*x;
     }
 
-    // Loop populating table with pixel translations for every pixel value
-    unsigned int value = 0;
-    for( value = 0; value <= MAX_VALUE; value++ )
+    double sumWY = 0.0;
+    double sumWYY = 0.0;
+    double sumWXY = 0.0;
+    double sumXCoords = (double)w*(w-1)/2.0;
+    for( int y = 0; y < h; y++ )
     {
-        // Alpha always 100%
-        pixelLookup[value].p[3] = 0xff;
+        double v = (double)(projY[y]) - b*w;
+        sumWY += v*y;
+        sumWYY += v*y*y;
+        sumWXY += ((double)(rowSumX[y]) - b*sumXCoords)*y;
+    }
 
-        // Assume no clipping
-        bool clipped = false;
-        if( clippingOn && (clippingHigh > 0 || clippingLow > 0 ))
-        {
-            // If clipping high, set pixel to solid 'clip high' color
-            if( clippingHigh > 0 && value >= clippingHigh )
-            {
-                pixelLookup[value].p[0] = 0x80;
-                pixelLookup[value].p[1] = 0x80;
-                pixelLookup[value].p[2] = 0xff;
-                clipped = true;
-            }
-            // If clipping low, set pixel to solid 'clip low' color
-            else if( clippingLow > 0 && value <= clippingLow )
-            {
-                pixelLookup[value].p[0] = 0xff;
-                pixelLookup[value].p[1] = 0x80;
-                pixelLookup[value].p[2] = 0x80;
-                clipped = true;
-            }
-        }
+    results.integral = sumW;
 
-        // Translate pixel value if not clipped
-        if( !clipped )
-        {
-            // Start with original value
-            int translatedValue = value;
+    // No signal above background. Only the peak and integral are available
+    if( sumW <= 0.0 )
+    {
+        return results;
+    }
 
-            // Logarithmic brightness if required
-            if( logBrightness )
-            {
-                translatedValue = int( log10( value+1 ) * 105.8864 );
-            }
+    double cx = sumWX/sumW;
+    double cy = sumWY/sumW;
+    double varX = sumWXX/sumW - cx*cx;
+    double varY = sumWYY/sumW - cy*cy;
 
-            // Reverse contrast if required
-            if( contrastReversal )
-            {
-                translatedValue = MAX_VALUE - translatedValue;
-            }
+    results.centroidX = area.left() + cx;
+    results.centroidY = area.top() + cy;
+    results.sigmaX = ( varX > 0.0 ) ? sqrt( varX ) : 0.0;
+    results.sigmaY = ( varY > 0.0 ) ? sqrt( varY ) : 0.0;
+    results.sigmaXY = sumWXY/sumW - cx*cy;
+    results.valid = true;
 
-            // Save translated pixel
-            if( imageDisplayProps->getFalseColour() )
-            {
-                pixelLookup[value] = getFalseColor ((unsigned char)translatedValue);
-            }
-            else
-            {
-                pixelLookup[value].p[0] = (unsigned char)translatedValue;
-                pixelLookup[value].p[1] = (unsigned char)translatedValue;
-                pixelLookup[value].p[2] = (unsigned char)translatedValue;
-            }
+    // Fit a Gaussian to each projection if required
+    if( beamAnalysis == imageProperties::BEAM_ANALYSIS_FIT )
+    {
+        QVector<double> fitProjX( w );
+        for( int x = 0; x < w; x++ )
+        {
+            fitProjX[x] = (double)(projX[x]) - b*h;
+        }
+        QVector<double> fitProjY( h );
+        for( int y = 0; y < h; y++ )
+        {
+            fitProjY[y] = (double)(projY[y]) - b*w;
         }
 
+        double fx, fy, fsx, fsy;
+        if( fitGaussian( fitProjX, cx, fx, fsx ) && fitGaussian( fitProjY, cy, fy, fsy ) )
+        {
+            results.fitX = area.left() + fx;
+            results.fitY = area.top() + fy;
+            results.fitSigmaX = fsx;
+            results.fitSigmaY = fsy;
+            results.fitValid = true;
+        }
     }
 
-    return;
+    return results;
 }
 
-// Determine the maximum pixel value for the current format
-unsigned int imageProcessor::maxPixelValue()
+// Fit a Gaussian to a beam projection.
+// The log of a Gaussian is a parabola, so a weighted least squares parabola is fitted to the log
+// of the projection (Caruana's method). Only points above 10% of the maximum are used, weighted by
+// the square of their value to reduce the influence of the noisy tails.
+// The fit is made relative to the given centre (normally the centroid) to keep the sums well conditioned.
+// Return true if the fit succeeded.
+bool imagePropertiesCore::fitGaussian( const QVector<double>& projection, double centre, double& fitCentre, double& fitSigma )
 {
-    double result = 0;
+    // Determine the threshold for points to use in the fit
+    double maxV = 0.0;
+    for( int i = 0; i < projection.size(); i++ )
+    {
+        if( projection[i] > maxV ) maxV = projection[i];
+    }
+    if( maxV <= 0.0 )
+    {
+        return false;
+    }
+    double threshold = maxV * 0.1;
 
-    switch( formatOption )
+    // Accumulate the sums for the normal equations (values normalised to the maximum)
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0;
+    double l0 = 0.0, l1 = 0.0, l2 = 0.0;
+    int points = 0;
+    for( int i = 0; i < projection.size(); i++ )
     {
-        case imageDataFormats::BAYERGB:
-        case imageDataFormats::BAYERBG:
-        case imageDataFormats::BAYERGR:
-        case imageDataFormats::BAYERRG:
-        case imageDataFormats::MONO:
-            result = (1<<bitDepth)-1;
-            break;
+        if( projection[i] <= threshold )
+        {
+            continue;
+        }
 
-        case imageDataFormats::RGB1:
-        case imageDataFormats::RGB2:
-        case imageDataFormats::RGB3:
-            result = (1<<8)-1; //???!!! not done yet probably correct
-            break;
+        double v = projection[i] / maxV;
+        double wt = v*v;
+        double l = log( v );
+        double u = i - centre;
+        double u2 = u*u;
+
+        s0 += wt;
+        s1 += wt*u;
+        s2 += wt*u2;
+        s3 += wt*u2*u;
+        s4 += wt*u2*u2;
+        l0 += wt*l;
+        l1 += wt*l*u;
+        l2 += wt*l*u2;
+        points++;
+    }
 
-        case imageDataFormats::YUV444:
-        case imageDataFormats::YUV422:
-        case imageDataFormats::YUV421:
-            result = (1<<8)-1; //???!!! not done yet probably correct
-            break;
+    if( points < 3 )
+    {
+        return false;
     }
 
-    if( result == 0 )
+    // Solve for the parabola a + b.u + c.u^2 (Cramer's rule)
+    double det = s0*(s2*s4-s3*s3) - s1*(s1*s4-s2*s3) + s2*(s1*s3-s2*s2);
+    if( det == 0.0 )
     {
-        result = 255;
+        return false;
     }
+    double b = ( s0*(l1*s4-s3*l2) - l0*(s1*s4-s2*s3) + s2*(s1*l2-l1*s2) ) / det;
+    double c = ( s0*(s2*l2-l1*s3) - s1*(s1*l2-l1*s2) + l0*(s1*s3-s2*s2) ) / det;
 
-    return result;
+    // Not a peak
+    if( c >= 0.0 )
+    {
+        return false;
+    }
+
+    fitCentre = centre - b/(2.0*c);
+    fitSigma = sqrt( -1.0/(2.0*c) );
+    return true;
 }
 
-// Return the image width following any rotation
-unsigned int imageProcessor::rotatedImageBuffWidth()
+// Slice and profile requests. Initially nothing requested
+profileRequests::profileRequests()
 {
-    switch( rotation)
-    {
-        default:
-        case ROTATION_0:
-        case ROTATION_180:
-            return imageBuffWidth;
+    vSliceOn = false;
+    vSliceX = 0;
+    vSliceThickness = 1;
 
-        case ROTATION_90_RIGHT:
-        case ROTATION_90_LEFT:
-            return imageBuffHeight;
-    }
+    hSliceOn = false;
+    hSliceY = 0;
+    hSliceThickness = 1;
+
+    profileOn = false;
+    profileThickness = 1;
 }
 
-// Return the image height following any rotation
-unsigned int imageProcessor::rotatedImageBuffHeight()
+// Full resolution image width following any rotation
+unsigned int imagePropertiesCore::fullImageWidth()
 {
-    switch( rotation)
+    return ( scanOption >= 5 ) ? imageBuffHeight : imageBuffWidth;
+}
+
+// Full resolution image height following any rotation
+unsigned int imagePropertiesCore::fullImageHeight()
+{
+    return ( scanOption >= 5 ) ? imageBuffWidth : imageBuffHeight;
+}
+
+// Transform a point from the image to the original data according to the scan option.
+// This matches imageProcessor::rotateFlipToDataPoint(), but uses the scan option captured for this image.
+QPoint imagePropertiesCore::imageToDataPoint( const QPoint& pos )
+{
+    int w = (int)imageBuffWidth-1;
+    int h = (int)imageBuffHeight-1;
+    switch( scanOption )
     {
         default:
-        case ROTATION_0:
-        case ROTATION_180:
-            return imageBuffHeight;
-
-        case ROTATION_90_RIGHT:
-        case ROTATION_90_LEFT:
-            return imageBuffWidth;
+        case 1: return pos;
+        case 2: return QPoint( w-pos.x(), pos.y() );
+        case 3: return QPoint( pos.x(),   h-pos.y() );
+        case 4: return QPoint( w-pos.x(), h-pos.y() );
+        case 5: return QPoint( pos.y(),   pos.x() );
+        case 6: return QPoint( w-pos.y(), pos.x() );
+        case 7: return QPoint( pos.y(),   h-pos.x() );
+        case 8: return QPoint( w-pos.y(), h-pos.x() );
     }
 }
 
-// Get a false color representation for an entry from the color lookup table
-imageDisplayProperties::rgbPixel imageProcessor::getFalseColor (const unsigned char value) {
-
-    const int max = 0xFF;
-    const int half = 0x80;
-    const int lightness_slope = 4;
-    const int low_hue = 240;    // blue.
-    const int high_hue = 0;     // red
+// Return a pointer to the data for a pixel in the image.
+// Return NULL if the pixel is outside the image, or beyond the end of the image data
+const unsigned char* imagePropertiesCore::imageDataPtr( const QPoint& pos )
+{
+    QPoint posTr = imageToDataPoint( pos );
+    if( posTr.x() < 0 || posTr.x() >= (int)imageBuffWidth || posTr.y() < 0 || posTr.y() >= (int)imageBuffHeight )
+    {
+        return NULL;
+    }
 
-    int bp1;
-    int bp2;
-    imageDisplayProperties::rgbPixel result;
-    int h, l;
-    QColor c;
+    int index = (posTr.x()+posTr.y()*imageBuffWidth)*bytesPerPixel;
+    if( index+(int)bytesPerPixel > imageData.size() )
+    {
+        return NULL;
+    }
+    return &(((const unsigned char*)imageData.constData())[index]);
+}
 
-    // Range of inputs broken into three bands:
-    // [0 .. bp1], [bp1 .. bp2] and [bp2 .. max]
-    //
-    bp1 = half / lightness_slope;
-    bp2 = max - (max - half) / lightness_slope;
-
-    if( value < bp1 ){
-        // Constant hue (blue), lightness ramps up to 128
-        h = low_hue;
-        l = lightness_slope*value;
-    } else if( value > bp2 ){
-        // Constant hue (red), lightness ramps up from 128 to 255
-        h = high_hue;
-        l = max - lightness_slope*(max-value);
-    } else {
-        // The bit in the middle.
-        // Contant lightness, hue varies blue to red.
-        h = ((value - bp1)*high_hue + (bp2 - value)*low_hue) / (bp2 - bp1);
-        l = half;
-    }
-
-    c.setHsl( h, max, l );   // Saturation always 100%
-
-    result.p[0] = (unsigned char) c.blue();
-    result.p[1] = (unsigned char) c.green();
-    result.p[2] = (unsigned char) c.red();
-    result.p[3] = (unsigned char) max; // Alpha always 100%
+// Sum one row of single element pixels (mono and Bayer formats) into a slice.
+// Each pixel is added to the slice entry the output pointer is stepped to. (If the step is zero, the whole row is added to one entry)
+template <typename T>
+static void accumulateSliceRow( const unsigned char* rowPtr, unsigned long step, int w, quint32 mask, double* out, int outStep )
+{
+    if( outStep == 0 )
+    {
+        quint64 sum = 0;
+        for( int x = 0; x < w; x++ )
+        {
+            sum += (*(const T*)(rowPtr))&mask;
+            rowPtr += step;
+        }
+        *out += sum;
+        return;
+    }
 
-    return result;
+    for( int x = 0; x < w; x++ )
+    {
+        *out += (*(const T*)(rowPtr))&mask;
+        rowPtr += step;
+        out += outStep;
+    }
 }
 
-
-// Determine the element count expected based on the available dimensions
-int imageProcessor::getElementCount()
+// Sum the pixels in an area of the image into a slice.
+// If alongX is true each slice entry is the sum of a column of the area (a horizontal slice),
+// otherwise each slice entry is the sum of a row of the area (a vertical slice).
+// The area is walked in the order the original data is held, whatever the rotation and flip
+// options, so a vertical slice through unrotated data sums a short run of pixels in each row
+// rather than stepping down the image a row at a time for each pixel in the thickness.
+void imagePropertiesCore::accumulateSlice( const QRect& area, bool alongX, QVector<double>& sums )
 {
-    // If we already have the image dimensions (and the elements per pixel if required), update the image
-    // size we need here before the subscription.
-    // (we should have image dimensions as a connection is only established once these have been read)
-    if( imageBuffWidth && imageBuffHeight && ( numDimensions !=3 || imageDimension0))
+    // Do nothing if the data is not complete
+    if( area.isEmpty() || (unsigned long)(imageData.size()) < imageBuffWidth*imageBuffHeight*bytesPerPixel )
     {
-        // element count is at least width x height
-        unsigned int elementCount = imageBuffWidth * imageBuffHeight;
+        return;
+    }
 
-        // Regardless of the souce of the width and height (either from width and height variables or from
-        // the appropriate area detector dimension variables), if the number of area detector dimensions
-        // is 3, then the first dimension is the number or elements per pixel so the element count needs to
-        // be multiplied by the first area detector dimension.
-
-        // It is possible for the image dimensions to change dynamically. For example to change from
-        // 3 dimensions to 2. In this example, the first dimension may change from being the data elements
-        // per pixel to being the image width before the 'number of dimensions' variable changes. This results
-        // in a window where the first dimension is assumed to be the data elements per pixel (num dimensions is 3)
-        // but it is actually the image width (much larger) this can result in crashes where a huge number of bytes
-        // per pixel is assumed and data arrays are overrun. If the dimensions appear odd, 32 was chosen as being large enough to cater for the
-        // largest number of elements per pixel. It is reasonable for image widths to be less than 32, so code must
-        // still handle invalid bytes per pixel calculations.
-        if( numDimensions == 3 && imageDimension0 && imageDimension0 <= 32 )
-        {
-            elementCount = elementCount * elementsPerPixel;
-        }
-
-        return elementCount;
-    }
-
-    // We can't determine the element count yet.
-    else
-    {
-        return 0;
-    }
-}
-
-
-// Determine if the image dimensional information is valid.
-// A side effect of this method is to set elementsPerPixel.
-// If an image dimensions change dynamically we may pass through a period where a set of dimensions that are nonsense. For example,
-// if the number of dimensions is changing from 3 to 2, this means the first dimension will change from being the data elements
-// per pixel to the image width. If the update for the first dimension arrives first, the number of dimensions will still be 3 (implying the
-// first dimension is the number of data elements per pixel, but the the first dimension will be the image width.
-// If the dimensions appear nonsense, then don't force an image update. Note, this won't stop an image update from occuring, so
-// the image update must cope with odd dimensions, but just no point forcing it here.
-// The test for good dimensions is to check if a width and height is present, and (if the first dimension is expected to be the number
-// of data elements per pixel, then is is less than 32. 32 was chosen as being large enough for any pixel format (for example 32 bits
-// per color for 4 Bayer RGBG colours) but less than most image widths. This test doesn't have to be perfect since the image update must
-// be able to cope with an invalid set of dimensions as mentioned above.
-bool imageProcessor::validateDimensions()
-{
-    unsigned long pixelCount = imageBuffWidth * imageBuffHeight;
-    if( pixelCount && (( numDimensions != 3 ) || ( imageDimension0 < 32 ) ) )
-    {
-        if( numDimensions == 3 )
-        {
-            elementsPerPixel = imageDimension0;
-        }
-        else
-        {
-            elementsPerPixel = 1;
-        }
-
-        return true;
-    }
-    else
-    {
-        return false;
-    }
-}
-
-// Determine the range of pixel values an area of the image
-void imageProcessor::getPixelRange( const QRect& area, unsigned int* min, unsigned int* max )
-{
-    // If the area selected was the the entire image, and the image was not presented at 100%, rounding areas while scaling
-    // may result in area dimensions outside than the actual image by a pixel or so, so limit the area to within the image.
-    unsigned int areaX = (area.topLeft().x()>=0)?area.topLeft().x():0;
-    unsigned int areaY = (area.topLeft().y()>=0)?area.topLeft().y():0;
-    unsigned int areaW = (area.width() <=(int)rotatedImageBuffWidth() )?area.width() :rotatedImageBuffWidth();
-    unsigned int areaH = (area.height()<=(int)rotatedImageBuffHeight())?area.height():rotatedImageBuffHeight();
-
-    // Set up to step pixel by pixel through the area
-    const unsigned char* data = (unsigned char*)imageData.constData();
-    unsigned int index = (areaY*rotatedImageBuffWidth()+areaX)*bytesPerPixel;
-
-    // This function is called as the user drags region handles around the
-    // screen. Recalculating min and max pixels for large areas
-    // for each mouse movement event needs to be efficient so speed loop by
-    // extracting width and height. (Compiler can't assume QRect width
-    // and height stays constant so it is evaluated each iteration of for
-    // loop if it was in the form   'for( int i = 0; i < area.height(); i++ )'
-    unsigned int stepW = bytesPerPixel;
-
-    // Calculate the step to the start of the next row in the area selected.
-    unsigned int stepH = (rotatedImageBuffWidth()-areaW)*bytesPerPixel;
-
-    unsigned int maxP = 0;
-    unsigned int minP = UINT_MAX;
-
-    // Determine the maximum and minimum pixel values in the area
-    for( unsigned int i = 0; i < areaH; i++ )
+    // Determine the area in the original data
+    QPoint origin = imageToDataPoint( QPoint( 0, 0 ) );
+    QRect dataArea = QRect( imageToDataPoint( area.topLeft() ), imageToDataPoint( area.bottomRight() ) ).normalized();
+
+    // Determine how the slice entry changes for each step across and down the original data.
+    // As only flips and 90 degree rotations are applied each step is -1, 0 or 1
+    QPoint step = imageToDataPoint( alongX ? QPoint( 1, 0 ) : QPoint( 0, 1 ) ) - origin;
+    int outStepX = step.x();
+    int outStepY = step.y();
+    int out = outStepX*( dataArea.left()-origin.x() ) + outStepY*( dataArea.top()-origin.y() );
+
+    // Walk the area in the original data row by row
+    const unsigned char* dataIn = (const unsigned char*)imageData.constData();
+    unsigned long rowStep = imageBuffWidth*bytesPerPixel;
+    const unsigned char* rowPtr = &dataIn[(dataArea.top()*imageBuffWidth+dataArea.left())*bytesPerPixel];
+    int w = dataArea.width();
+    double* sumsPtr = sums.data();
+    quint32 mask = pixelDataMask( bitDepth, imageDataSize );
+
+    for( int y = 0; y < dataArea.height(); y++ )
     {
-        for( unsigned int j = 0; j < areaW; j++ )
+        // Sum the row. For speed, the switch on format is outside the loop over the row
+        switch( formatOption )
         {
-            unsigned int p = getPixelValueFromData( &(data[index]) );
-            if( p < minP ) minP = p;
-            if( p > maxP ) maxP = p;
+            case imageDataFormats::MONO:
+            case imageDataFormats::BAYERGB:
+            case imageDataFormats::BAYERBG:
+            case imageDataFormats::BAYERGR:
+            case imageDataFormats::BAYERRG:
+                if( imageDataSize == 1 )
+                {
+                    accumulateSliceRow<quint8>( rowPtr, bytesPerPixel, w, mask, &sumsPtr[out], outStepX );
+                    break;
+                }
+                if( imageDataSize == 2 )
+                {
+                    accumulateSliceRow<quint16>( rowPtr, bytesPerPixel, w, mask, &sumsPtr[out], outStepX );
+                    break;
+                }
+                if( imageDataSize == 4 )
+                {
+                    accumulateSliceRow<quint32>( rowPtr, bytesPerPixel, w, mask, &sumsPtr[out], outStepX );
+                    break;
+                }
+                // Fall through for other data sizes
 
-            index += stepW;
+            default:
+                {
+                    const unsigned char* pixelPtr = rowPtr;
+                    double* outPtr = &sumsPtr[out];
+                    for( int x = 0; x < w; x++ )
+                    {
+                        *outPtr += pixelValueFromData( pixelPtr, formatOption, bitDepth, imageDataSize );
+                        pixelPtr += bytesPerPixel;
+                        outPtr += outStepX;
+                    }
+                }
+                break;
         }
-        index += stepH;
-    }
 
-    // Return results
-    *min = minP;
-    *max = maxP;
+        rowPtr += rowStep;
+        out += outStepY;
+    }
 }
 
-// Return a pointer to pixel data in the original image data.
-// The position parameter is scaled to the original image size but reflects
-// the displayed rotation and flip options, so it must be transformed first.
-// Return NULL, if there is no image data, or point is beyond end of image data
-const unsigned char* imageProcessor::getImageDataPtr( QPoint& pos )
+// Generate all slices and profiles required.
+// This is performed by the image processing thread after building the image
+profileResults imagePropertiesCore::generateProfilesCore()
 {
-    QPoint posTr;
-
-    // Transform the position to reflect the original unrotated or flipped data
-    posTr = rotateFlipToDataPoint( pos );
-
-    // Set up reference to start of the data, and the index to the required pixel
-    const unsigned char* data = (unsigned char*)imageData.constData();
-    int index = (posTr.x()+posTr.y()*imageBuffWidth)*bytesPerPixel;
+    profileResults results;
+    results.requests = profiles;
 
-    // Return a pointer to the pixel data if possible
-    if( !imageData.isEmpty() && index < imageData.size() )
+    if( profiles.vSliceOn )
     {
-        return &(data[index]);
+        generateVSliceCore( results.vSliceData, profiles.vSliceX, profiles.vSliceThickness );
     }
-    else
+    if( profiles.hSliceOn )
     {
-        return NULL;
+        generateHSliceCore( results.hSliceData, profiles.hSliceY, profiles.hSliceThickness );
     }
-}
-
-// Return a number representing a pixel intensity given a pointer into an image data buffer.
-// Note, the pointer is indexed according to the pixel data size which will be at least
-// big enough for the data format.
-int imageProcessor::getPixelValueFromData( const unsigned char* ptr )
-{
-    // Sanity check
-    if( !ptr )
-        return 0;
-
-    // Case the data to the correct size, then return the data as a floating point number.
-    switch( formatOption )
+    if( profiles.profileOn && profiles.profileStart != profiles.profileEnd )
     {
-        case imageDataFormats::BAYERGB:
-        case imageDataFormats::BAYERBG:
-        case imageDataFormats::BAYERGR:
-        case imageDataFormats::BAYERRG:
-        case imageDataFormats::MONO:
-            {
-                unsigned int usableDepth = bitDepth;
-                if( bitDepth > (imageDataSize*8) )
-                {
-                    usableDepth = imageDataSize*8;
-                }
-
-                quint32 mask = (1<<usableDepth)-1;
-
-                return (*((quint32*)ptr))&mask;
-            }
-
-        case imageDataFormats::RGB1:
-            {
-                // for RGB, average all colors
-                unsigned int pixel = *(unsigned int*)ptr;
-                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
-            }
-
-        case imageDataFormats::RGB2:
-            //!!! not done - copy of RGB1
-            {
-                // for RGB, average all colors
-                unsigned int pixel = *(unsigned int*)ptr;
-                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
-            }
-
-        case imageDataFormats::RGB3:
-            //!!! not done - copy of RGB1
-            {
-                // for RGB, average all colors
-                unsigned int pixel = *(unsigned int*)ptr;
-                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
-            }
-
-        case imageDataFormats::YUV444:
-            //!!! not done - copy of RGB1
-            {
-                // for RGB, average all colors
-                unsigned int pixel = *(unsigned int*)ptr;
-                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
-            }
-
-        case imageDataFormats::YUV422:
-            //!!! not done - copy of RGB1
-            {
-                // for RGB, average all colors
-                unsigned int pixel = *(unsigned int*)ptr;
-                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
-            }
-
-        case imageDataFormats::YUV421:
-            //!!! not done - copy of RGB1
-            {
-                // for RGB, average all colors
-                unsigned int pixel = *(unsigned int*)ptr;
-                return ((pixel&0xff0000>>16) + (pixel&0x00ff00>>8) + (pixel&0x0000ff)) / 3;
-            }
+        generateProfileCore( results.profileData, profiles.profileStart, profiles.profileEnd, profiles.profileThickness );
     }
 
-    // Avoid compilation warning (not sure why this is required as all cases are handled in switch statements.
-    return *ptr;
-}
-
-// Return a floating point number representing a pixel intensity given a pointer into an image data buffer.
-double imageProcessor::getFloatingPixelValueFromData( const unsigned char* ptr )
-{
-    return getPixelValueFromData( ptr );
-}
-
-// Return a QImage based on the current image
-QImage imageProcessor::copyImage()
-{
-    return image;
+    return results;
 }
 
 // Generate a profile along a line down an image at a given X position
 // Input ordinates are scaled to the source image data.
 // The profile contains values for each pixel intersected by the line.
-void imageProcessor::generateVSliceData( QVector<QPointF>& vSliceData, int x, unsigned int thickness )
+void imagePropertiesCore::generateVSliceCore( QVector<QPointF>& vSliceData, int x, unsigned int thickness )
 {
-    // Ensure the buffer is the correct size
-    if( vSliceData.size() != (int)rotatedImageBuffHeight() )
-        vSliceData.resize( rotatedImageBuffHeight() );
+    int w = fullImageWidth();
+    int h = fullImageHeight();
 
-    // Set up to step pixel by pixel through the image data along the line
-    const unsigned char* data = (unsigned char*)imageData.constData();
-    const unsigned char* dataPtr = &(data[x*bytesPerPixel]);
-    int dataPtrStep = rotatedImageBuffWidth()*bytesPerPixel;
+    // Ensure the buffer is the correct size
+    if( vSliceData.size() != h )
+        vSliceData.resize( h );
 
     // Set up to step through the line thickness
     unsigned int halfThickness = thickness/2;
     int xMin = x-halfThickness;
     if( xMin < 0 ) xMin = 0;
     int xMax =  xMin+thickness;
-    if( xMax >= (int)rotatedImageBuffWidth() ) xMax = rotatedImageBuffWidth();
+    if( xMax >= w ) xMax = w;
 
-    // Accumulate data for each pixel in the thickness
-    bool firstPass = true;
-    for( int nextX = xMin; nextX < xMax; nextX++ )
+    // Sum the pixels across the line thickness
+    QVector<double> sums( h, 0.0 );
+    if( xMax > xMin )
     {
-        // Accumulate the image data value at each pixel.
-        // The buffer is filled backwards so the plot, which sits on its side beside the image is drawn correctly
-        QPoint pos;
-        pos.setX( nextX );
-        for( int i = rotatedImageBuffHeight()-1; i >= 0; i-- )
-        {
-            pos.setY( i );
-            QPointF* dataPoint = &vSliceData[i];
-            double value = getFloatingPixelValueFromData( getImageDataPtr( pos ) );
-
-            // On first pass, set up X and Y
-            if( firstPass )
-            {
-                dataPoint->setY( i );
-                dataPoint->setX( value );
-            }
-
-            // On subsequent passes (when thickness is greater than 1), accumulate X
-            else
-            {
-                dataPoint->setX( dataPoint->x() + value );
-            }
-
-            dataPtr += dataPtrStep;
-        }
-
-        firstPass = false;
+        accumulateSlice( QRect( xMin, 0, xMax-xMin, h ), false, sums );
     }
 
     // Calculate average pixel values if more than one pixel thick
-    if( thickness > 1 )
+    double divisor = ( thickness > 1 ) ? thickness : 1.0;
+    for( int i = 0; i < h; i++ )
     {
-        for( int i = rotatedImageBuffHeight()-1; i >= 0; i-- )
-        {
-            QPointF* dataPoint = &vSliceData[i];
-            dataPoint->setX( dataPoint->x()/thickness );
-        }
+        QPointF* dataPoint = &vSliceData[i];
+        dataPoint->setY( i );
+        dataPoint->setX( sums[i]/divisor );
     }
 }
 
 // Generate a profile along a line across an image at a given Y position
 // Input ordinates are at the resolution of the source image data
 // The profile contains values for each pixel intersected by the line.
-void imageProcessor::generateHSliceData( QVector<QPointF>& hSliceData, int y, unsigned int thickness )
+void imagePropertiesCore::generateHSliceCore( QVector<QPointF>& hSliceData, int y, unsigned int thickness )
 {
-    // Ensure the buffer is the correct size
-    if( hSliceData.size() != (int)rotatedImageBuffWidth() )
-        hSliceData.resize( rotatedImageBuffWidth() );
+    int w = fullImageWidth();
+    int h = fullImageHeight();
 
-    // Set up to step pixel by pixel through the image data along the line
-    const unsigned char* data = (unsigned char*)imageData.constData();
-    const unsigned char* dataPtr = &(data[y*rotatedImageBuffWidth()*bytesPerPixel]);
-    int dataPtrStep = bytesPerPixel;
+    // Ensure the buffer is the correct size
+    if( hSliceData.size() != w )
+        hSliceData.resize( w );
 
     // Set up to step through the line thickness
     unsigned int halfThickness = thickness/2;
     int yMin = y-halfThickness;
     if( yMin < 0 ) yMin = 0;
     int yMax =  yMin+thickness;
-    if( yMax >= (int)rotatedImageBuffHeight() ) yMax = rotatedImageBuffHeight();
+    if( yMax >= h ) yMax = h;
 
-    // Accumulate data for each pixel in the thickness
-    bool firstPass = true;
-    for( int nextY = yMin; nextY < yMax; nextY++ )
+    // Sum the pixels across the line thickness
+    QVector<double> sums( w, 0.0 );
+    if( yMax > yMin )
     {
-        // Accumulate the image data value at each pixel.
-        QPoint pos;
-        pos.setY( nextY );
-        for( unsigned int i = 0; i < rotatedImageBuffWidth(); i++ )
-        {
-            pos.setX( i );
-            QPointF* dataPoint = &hSliceData[i];
-            double value = getFloatingPixelValueFromData( getImageDataPtr( pos ) );
-
-            // On first pass, set up X and Y
-            if( firstPass )
-            {
-                dataPoint->setX( i );
-                dataPoint->setY( value );
-            }
-
-            // On subsequent passes (when thickness is greater than 1), accumulate X
-            else
-            {
-                dataPoint->setY( dataPoint->y() + value );
-            }
-
-            dataPtr += dataPtrStep;
-        }
-
-        firstPass = false;
-    }
-
+        accumulateSlice( QRect( 0, yMin, w, yMax-yMin ), true, sums );
+    }
 
     // Calculate average pixel values if more than one pixel thick
-    if( thickness > 1 )
+    double divisor = ( thickness > 1 ) ? thickness : 1.0;
+    for( int i = 0; i < w; i++ )
     {
-        for( unsigned int i = 0; i < rotatedImageBuffWidth(); i++ )
-        {
-            QPointF* dataPoint = &hSliceData[i];
-            dataPoint->setY( dataPoint->y()/thickness );
-        }
+        QPointF* dataPoint = &hSliceData[i];
+        dataPoint->setX( i );
+        dataPoint->setY( sums[i]/divisor );
     }
 }
 
@@ -1875,8 +2006,11 @@ void imageProcessor::generateHSliceData( QVector<QPointF>& hSliceData, int y, un
 // angles to the line by a 'pixel' distance up to the line thickness.
 // The results are then averaged.
 //
-void imageProcessor::generateProfileData( QVector<QPointF>& profileData, QPoint point1, QPoint point2, unsigned int thickness )
+void imagePropertiesCore::generateProfileCore( QVector<QPointF>& profileData, QPoint point1, QPoint point2, unsigned int thickness )
 {
+    unsigned int w = fullImageWidth();
+    unsigned int h = fullImageHeight();
+
     // X and Y components of line drawn
     double dX = point2.x()-point1.x();
     double dY = point2.y()-point1.y();
@@ -1920,7 +2054,7 @@ void imageProcessor::generateProfileData( QVector<QPointF>& profileData, QPoint
         {
             // Calculate the value if the point is within the image (user can drag outside the image)
             double value;
-            if( x >= 0 && x < rotatedImageBuffWidth() && y >= 0 && y < rotatedImageBuffHeight() )
+            if( x >= 0 && x < w && y >= 0 && y < h )
             {
 
                 // Determine the top left of the notional pixel that will be measured
@@ -1953,10 +2087,10 @@ void imageProcessor::generateProfileData( QVector<QPointF>& profileData, QPoint
                 QPoint posBL( actualXTL,   actualYTL+1 );
                 QPoint posBR( actualXTL+1, actualYTL+1 );
 
-                const unsigned char* dataPtrTL = getImageDataPtr( posTL );
-                const unsigned char* dataPtrTR = getImageDataPtr( posTR );
-                const unsigned char* dataPtrBL = getImageDataPtr( posBL );
-                const unsigned char* dataPtrBR = getImageDataPtr( posBR );
+                const unsigned char* dataPtrTL = imageDataPtr( posTL );
+                const unsigned char* dataPtrTR = imageDataPtr( posTR );
+                const unsigned char* dataPtrBL = imageDataPtr( posBL );
+                const unsigned char* dataPtrBR = imageDataPtr( posBR );
 
                 // Determine the value of the notional pixel from a weighted average of the four real pixels it overlays.
                 // The larger the proportion of the real pixel overlayed, the greated the weight.
@@ -1965,25 +2099,25 @@ void imageProcessor::generateProfileData( QVector<QPointF>& profileData, QPoint
                 value = 0;
                 if( xTLi >= 0 && yTLi >= 0 )
                 {
-                    value += propTL * getFloatingPixelValueFromData( dataPtrTL );
+                    value += propTL * pixelValueFromData( dataPtrTL, formatOption, bitDepth, imageDataSize );
                     pixelsInValue++;
                 }
 
-                if( xTLi+1 < rotatedImageBuffWidth() && yTLi >= 0 )
+                if( xTLi+1 < w && yTLi >= 0 )
                 {
-                    value += propTR * getFloatingPixelValueFromData( dataPtrTR );
+                    value += propTR * pixelValueFromData( dataPtrTR, formatOption, bitDepth, imageDataSize );
                     pixelsInValue++;
                 }
 
-                if( xTLi >= 0 && yTLi+1 < rotatedImageBuffHeight() )
+                if( xTLi >= 0 && yTLi+1 < h )
                 {
 
-                    value += propBL * getFloatingPixelValueFromData( dataPtrBL );
+                    value += propBL * pixelValueFromData( dataPtrBL, formatOption, bitDepth, imageDataSize );
                     pixelsInValue++;
                 }
-                if( xTLi+1 < rotatedImageBuffWidth() && yTLi+1 < rotatedImageBuffHeight() )
+                if( xTLi+1 < w && yTLi+1 < h )
                 {
-                    value += propBR * getFloatingPixelValueFromData( dataPtrBR );
+                    value += propBR * pixelValueFromData( dataPtrBR, formatOption, bitDepth, imageDataSize );
                     pixelsInValue++;
                 }
 
@@ -2034,6 +2168,711 @@ void imageProcessor::generateProfileData( QVector<QPointF>& profileData, QPoint
     }
 }
 
+// Set the image width
+// Return true of the width changes as a result.
+bool imageProcessor::setWidth( unsigned long uValue )
+{
+    if( imageBuffWidth != uValue )
+    {
+        imageBuffWidth = uValue;
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Set the image height
+// Return true of the height changes as a result.
+bool imageProcessor::setHeight( unsigned long uValue )
+{
+    if( imageBuffHeight != uValue )
+    {
+        imageBuffHeight = uValue;
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Set the number of dimensions.
+// This is an area detector concept and is used to determine how to treat dimenstions 0, 1, and 2
+bool imageProcessor::setNumDimensions( unsigned long uValue )
+{
+    if( numDimensions != uValue )
+    {
+        switch( uValue )
+        {
+            case 0:
+                numDimensions = uValue;
+                break;
+
+            case 2:
+            case 3:
+                numDimensions = uValue;
+                setWidthHeightFromDimensions();
+                break;
+        }
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Set the first dimension (width if two dimenstions, bytes per element if three dimensions)
+bool imageProcessor::setDimension0( unsigned long uValue )
+{
+    if( imageDimension0 != uValue )
+    {
+        imageDimension0 = uValue;
+        setWidthHeightFromDimensions();
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Set the second dimension (height if two dimensions, width if three dimensions)
+bool imageProcessor::setDimension1( unsigned long uValue )
+{
+    if( imageDimension1 != uValue )
+    {
+        imageDimension1 = uValue;
+        setWidthHeightFromDimensions();
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Set the third dimension (unused if two dimensions, height if three dimensions)
+bool imageProcessor::setDimension2( unsigned long uValue )
+{
+    if( imageDimension2 != uValue )
+    {
+        imageDimension2 = uValue;
+        setWidthHeightFromDimensions();
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Set clipping flag. If true, setClippingLow() and setClippingHigh() are used to set clipping values
+void imageProcessor::setClippingOn( bool clippingOnIn )
+{
+    if( clippingOn != clippingOnIn )
+    {
+        clippingOn = clippingOnIn;
+        pixelLookupValid = false;
+    }
+}
+
+// Set pixel value below which low clip colour is displayed
+void imageProcessor::setClippingLow( unsigned int value )
+{
+    if( clippingLow != (unsigned int)value )
+    {
+        clippingLow = value;
+        pixelLookupValid = false;
+    }
+}
+
+// Set pixel value above which high clip colour is displayed
+void imageProcessor::setClippingHigh( unsigned int value )
+{
+    if( clippingHigh != (unsigned int)value )
+    {
+        clippingHigh = value;
+        pixelLookupValid = false;
+    }
+}
+
+// Determine the way the input pixel data must be scanned to accommodate the required
+// rotate and flip options. This is used when generating the image data, and also when
+// transforming points in the image back to references in the original pixel data.
+int imageProcessor::getScanOption()
+{
+    // Depending on the flipping and rotating options pixel drawing can start in any of
+    // the four corners and start scanning either vertically or horizontally.
+    // The 8 scanning options are shown numbered here:
+    //
+    //    o----->1         2<-----o
+    //    |                       |
+    //    |                       |
+    //    |                       |
+    //    v                       v
+    //    5                       6
+    //
+    //
+    //
+    //    7                       8
+    //    ^                       ^
+    //    |                       |
+    //    |                       |
+    //    |                       |
+    //    o----->3         4<-----o
+    //
+    //
+    // The rotation and flip properties can be set in 16 combinations, but these 16
+    // options can only specify the 8 possible scan options as follows:
+    // (for example rotating 180 degrees, then flipping both vertically and horizontally
+    // is the same as doing no rotation or flipping at all - scan option 1)
+    //
+    //  rot vflip hflip scan_option
+    //    0   0     0      1
+    //    0   0     1      2
+    //    0   1     0      3
+    //    0   1     1      4
+    //  R90   0     0      7
+    //  R90   0     1      5
+    //  R90   1     0      8
+    //  R90   1     1      6
+    //  L90   0     0      6
+    //  L90   0     1      8
+    //  L90   1     0      5
+    //  L90   1     1      7
+    //  180   0     0      4
+    //  180   0     1      3
+    //  180   1     0      2
+    //  180   1     1      1
+    //
+    // Determine the scan option as shown in the above diagram
+    switch( rotation )
+    {                                               // vh v!h     !vh !v!h
+        case ROTATION_0:        return flipVert?flipHoz?4:3:flipHoz?2:1;
+        case ROTATION_90_RIGHT: return flipVert?flipHoz?6:8:flipHoz?5:7;
+        case ROTATION_90_LEFT:  return flipVert?flipHoz?7:5:flipHoz?8:6;
+        case ROTATION_180:      return flipVert?flipHoz?1:2:flipHoz?3:4;
+        default:                return 1; // Sanity check
+    }
+}
+
+// Generate a lookup table to convert raw pixel values to display pixel values taking into
+// account local brightness and contrast, clipping, logarithmic scale, false colour, and contrast reversal.
+// The table holds an entry for every possible pixel value (up to MAX_LOOKUP_BITS bits), so no
+// precision is lost by reducing high bit depth pixels to 8 bits before the lookup, and the
+// image processing only requires a single table lookup per pixel.
+// The table is only regenerated when something that affects it changes (see pixelLookupValid)
+// Note, the table will be used to translate each colour in an RGB format.
+//
+void imageProcessor::getPixelTranslation()
+{
+    // Maximum display value
+    #define MAX_VALUE 255
+
+    // If there is an image options control, get the relevent options
+    bool contrastReversal;
+    bool logBrightness;
+    bool falseColour;
+
+    if( imageDisplayProps )
+    {
+        contrastReversal = imageDisplayProps->getContrastReversal();
+        logBrightness = imageDisplayProps->getLog();
+        falseColour = imageDisplayProps->getFalseColour();
+    }
+    else
+    {
+        contrastReversal = false;
+        logBrightness = false;
+        falseColour = false;
+    }
+
+    // If there is an image options control, and we have retrieved high and low pixels from an image, get the relevent options
+    if( imageDisplayProps && imageDisplayProps->statisticsValid() )
+    {
+        pixelLow = imageDisplayProps->getLowPixel();
+        pixelHigh = imageDisplayProps->getHighPixel();
+    }
+    else
+    {
+        pixelLow = 0;
+        pixelHigh = maxPixelValue();
+    }
+
+    // Size the table for every possible pixel value.
+    // If pixels are deeper than the table allows, the pixel values will be shifted down before lookup.
+    unsigned int valueBits = pixelValueBits();
+    pixelLookupShift = ( valueBits > MAX_LOOKUP_BITS ) ? valueBits-MAX_LOOKUP_BITS : 0;
+    int lookupSize = 1<<( valueBits-pixelLookupShift );
+    if( pixelLookup.size() != lookupSize )
+    {
+        pixelLookup.resize( lookupSize );
+    }
+
+    // Get a reference to the table.
+    // If any image currently being processed still holds the previous table this will generate a
+    // new copy, leaving the table in use unchanged.
+    imageDisplayProperties::rgbPixel* lookup = pixelLookup.data();
+
+    // Prepare for scaling for local brightness and contrast
+    double pixelRange = pixelHigh-pixelLow;
+    if( pixelRange <= 0.0 )
+    {
+        pixelRange = 1.0;
+    }
+
+    // Prepare for logarithmic brightness across the full pixel range
+    // (For an 8 bit range this is the same as log10( value+1 ) * 105.8864)
+    double logScale = MAX_VALUE / log10( pixelRange+1.0 );
+
+    // Loop populating table with pixel translations for every pixel value
+    for( int i = 0; i < lookupSize; i++ )
+    {
+        // Pixel value represented by this entry
+        double value = (double)((quint64)(i)<<pixelLookupShift);
+
+        // Alpha always 100%
+        lookup[i].p[3] = 0xff;
+
+        // Assume no clipping
+        bool clipped = false;
+        if( clippingOn && (clippingHigh > 0 || clippingLow > 0 ))
+        {
+            // If clipping high, set pixel to solid 'clip high' color
+            if( clippingHigh > 0 && value >= clippingHigh )
+            {
+                lookup[i].p[0] = 0x80;
+                lookup[i].p[1] = 0x80;
+                lookup[i].p[2] = 0xff;
+                clipped = true;
+            }
+            // If clipping low, set pixel to solid 'clip low' color
+            else if( clippingLow > 0 && value <= clippingLow )
+            {
+                lookup[i].p[0] = 0xff;
+                lookup[i].p[1] = 0x80;
+                lookup[i].p[2] = 0x80;
+                clipped = true;
+            }
+        }
+
+        // Translate pixel value if not clipped
+        if( !clipped )
+        {
+            // Scale pixel for local brightness and contrast
+            double scaledValue;
+            if( value <= pixelLow )
+            {
+                scaledValue = 0.0;
+            }
+            else if( value >= pixelHigh )
+            {
+                scaledValue = pixelRange;
+            }
+            else
+            {
+                scaledValue = value-pixelLow;
+            }
+
+            // Logarithmic brightness if required
+            int translatedValue;
+            if( logBrightness )
+            {
+                translatedValue = int( log10( scaledValue+1.0 ) * logScale );
+            }
+            else
+            {
+                translatedValue = int( scaledValue * MAX_VALUE / pixelRange );
+            }
+
+            // Sanity check
+            if( translatedValue > MAX_VALUE )
+            {
+                translatedValue = MAX_VALUE;
+            }
+
+            // Reverse contrast if required
+            if( contrastReversal )
+            {
+                translatedValue = MAX_VALUE - translatedValue;
+            }
+
+            // Save translated pixel
+            if( falseColour )
+            {
+                lookup[i] = getFalseColor ((unsigned char)translatedValue);
+            }
+            else
+            {
+                lookup[i].p[0] = (unsigned char)translatedValue;
+                lookup[i].p[1] = (unsigned char)translatedValue;
+                lookup[i].p[2] = (unsigned char)translatedValue;
+            }
+        }
+
+    }
+
+    return;
+}
+
+// Determine the number of significant bits in each pixel value for the current format
+unsigned int imageProcessor::pixelValueBits()
+{
+    switch( formatOption )
+    {
+        case imageDataFormats::BAYERGB:
+        case imageDataFormats::BAYERBG:
+        case imageDataFormats::BAYERGR:
+        case imageDataFormats::BAYERRG:
+        case imageDataFormats::MONO:
+            return ( bitDepth > 0 ) ? bitDepth : 8;
+
+        // Colour formats are taken as 8 bits per component, as in maxPixelValue().
+        // Deeper colour components are not yet supported.
+        case imageDataFormats::RGB1:
+        case imageDataFormats::RGB2:
+        case imageDataFormats::RGB3:
+        case imageDataFormats::YUV444:
+        case imageDataFormats::YUV422:
+        case imageDataFormats::YUV421:
+        default:
+            return 8;
+    }
+}
+
+// Determine the maximum pixel value for the current format
+unsigned int imageProcessor::maxPixelValue()
+{
+    double result = 0;
+
+    switch( formatOption )
+    {
+        case imageDataFormats::BAYERGB:
+        case imageDataFormats::BAYERBG:
+        case imageDataFormats::BAYERGR:
+        case imageDataFormats::BAYERRG:
+        case imageDataFormats::MONO:
+            result = (1<<bitDepth)-1;
+            break;
+
+        case imageDataFormats::RGB1:
+        case imageDataFormats::RGB2:
+        case imageDataFormats::RGB3:
+            result = (1<<8)-1; //???!!! not done yet probably correct
+            break;
+
+        case imageDataFormats::YUV444:
+        case imageDataFormats::YUV422:
+        case imageDataFormats::YUV421:
+            result = (1<<8)-1; //???!!! not done yet probably correct
+            break;
+    }
+
+    if( result == 0 )
+    {
+        result = 255;
+    }
+
+    return result;
+}
+
+// Return the image width following any rotation
+unsigned int imageProcessor::rotatedImageBuffWidth()
+{
+    switch( rotation)
+    {
+        default:
+        case ROTATION_0:
+        case ROTATION_180:
+            return imageBuffWidth;
+
+        case ROTATION_90_RIGHT:
+        case ROTATION_90_LEFT:
+            return imageBuffHeight;
+    }
+}
+
+// Return the image height following any rotation
+unsigned int imageProcessor::rotatedImageBuffHeight()
+{
+    switch( rotation)
+    {
+        default:
+        case ROTATION_0:
+        case ROTATION_180:
+            return imageBuffHeight;
+
+        case ROTATION_90_RIGHT:
+        case ROTATION_90_LEFT:
+            return imageBuffWidth;
+    }
+}
+
+// Get a false color representation for an entry from the color lookup table
+imageDisplayProperties::rgbPixel imageProcessor::getFalseColor (const unsigned char value) {
+
+    // The false colour scheme is shared with other widgets, e.g. the QEPlotter waterfall.
+    const QRgb c = QEFalseColour::getColour( value );
+    imageDisplayProperties::rgbPixel result;
+
+    result.p[0] = (unsigned char) qBlue( c );
+    result.p[1] = (unsigned char) qGreen( c );
+    result.p[2] = (unsigned char) qRed( c );
+    result.p[3] = (unsigned char) qAlpha( c ); // Alpha always 100%
+
+    return result;
+}
+
+
+// Determine the element count expected based on the available dimensions
+int imageProcessor::getElementCount()
+{
+    // If we already have the image dimensions (and the elements per pixel if required), update the image
+    // size we need here before the subscription.
+    // (we should have image dimensions as a connection is only established once these have been read)
+    if( imageBuffWidth && imageBuffHeight && ( numDimensions !=3 || imageDimension0))
+    {
+        // element count is at least width x height
+        unsigned int elementCount = imageBuffWidth * imageBuffHeight;
+
+        // Regardless of the souce of the width and height (either from width and height variables or from
+        // the appropriate area detector dimension variables), if the number of area detector dimensions
+        // is 3, then the first dimension is the number or elements per pixel so the element count needs to
+        // be multiplied by the first area detector dimension.
+
+        // It is possible for the image dimensions to change dynamically. For example to change from
+        // 3 dimensions to 2. In this example, the first dimension may change from being the data elements
+        // per pixel to being the image width before the 'number of dimensions' variable changes. This results
+        // in a window where the first dimension is assumed to be the data elements per pixel (num dimensions is 3)
+        // but it is actually the image width (much larger) this can result in crashes where a huge number of bytes
+        // per pixel is assumed and data arrays are overrun. If the dimensions appear odd, 32 was chosen as being large enough to cater for the
+        // largest number of elements per pixel. It is reasonable for image widths to be less than 32, so code must
+        // still handle invalid bytes per pixel calculations.
+        if( numDimensions == 3 && imageDimension0 && imageDimension0 <= 32 )
+        {
+            elementCount = elementCount * elementsPerPixel;
+        }
+
+        return elementCount;
+    }
+
+    // We can't determine the element count yet.
+    else
+    {
+        return 0;
+    }
+}
+
+
+// Determine if the image dimensional information is valid.
+// A side effect of this method is to set elementsPerPixel.
+// If an image dimensions change dynamically we may pass through a period where a set of dimensions that are nonsense. For example,
+// if the number of dimensions is changing from 3 to 2, this means the first dimension will change from being the data elements
+// per pixel to the image width. If the update for the first dimension arrives first, the number of dimensions will still be 3 (implying the
+// first dimension is the number of data elements per pixel, but the the first dimension will be the image width.
+// If the dimensions appear nonsense, then don't force an image update. Note, this won't stop an image update from occuring, so
+// the image update must cope with odd dimensions, but just no point forcing it here.
+// The test for good dimensions is to check if a width and height is present, and (if the first dimension is expected to be the number
+// of data elements per pixel, then is is less than 32. 32 was chosen as being large enough for any pixel format (for example 32 bits
+// per color for 4 Bayer RGBG colours) but less than most image widths. This test doesn't have to be perfect since the image update must
+// be able to cope with an invalid set of dimensions as mentioned above.
+bool imageProcessor::validateDimensions()
+{
+    unsigned long pixelCount = imageBuffWidth * imageBuffHeight;
+    if( pixelCount && (( numDimensions != 3 ) || ( imageDimension0 < 32 ) ) )
+    {
+        if( numDimensions == 3 )
+        {
+            elementsPerPixel = imageDimension0;
+        }
+        else
+        {
+            elementsPerPixel = 1;
+        }
+
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Determine the range of pixel values an area of the image
+void imageProcessor::getPixelRange( const QRect& area, unsigned int* min, unsigned int* max )
+{
+    // If the area selected was the the entire image, and the image was not presented at 100%, rounding areas while scaling
+    // may result in area dimensions outside than the actual image by a pixel or so, so limit the area to within the image.
+    unsigned int areaX = (area.topLeft().x()>=0)?area.topLeft().x():0;
+    unsigned int areaY = (area.topLeft().y()>=0)?area.topLeft().y():0;
+    unsigned int areaW = (area.width() <=(int)rotatedImageBuffWidth() )?area.width() :rotatedImageBuffWidth();
+    unsigned int areaH = (area.height()<=(int)rotatedImageBuffHeight())?area.height():rotatedImageBuffHeight();
+
+    // Set up to step pixel by pixel through the area
+    const unsigned char* data = (unsigned char*)imageData.constData();
+    unsigned int index = (areaY*rotatedImageBuffWidth()+areaX)*bytesPerPixel;
+
+    // This function is called as the user drags region handles around the
+    // screen. Recalculating min and max pixels for large areas
+    // for each mouse movement event needs to be efficient so speed loop by
+    // extracting width and height. (Compiler can't assume QRect width
+    // and height stays constant so it is evaluated each iteration of for
+    // loop if it was in the form   'for( int i = 0; i < area.height(); i++ )'
+    unsigned int stepW = bytesPerPixel;
+
+    // Calculate the step to the start of the next row in the area selected.
+    unsigned int stepH = (rotatedImageBuffWidth()-areaW)*bytesPerPixel;
+
+    unsigned int maxP = 0;
+    unsigned int minP = UINT_MAX;
+
+    // Determine the maximum and minimum pixel values in the area
+    for( unsigned int i = 0; i < areaH; i++ )
+    {
+        for( unsigned int j = 0; j < areaW; j++ )
+        {
+            unsigned int p = getPixelValueFromData( &(data[index]) );
+            if( p < minP ) minP = p;
+            if( p > maxP ) maxP = p;
+
+            index += stepW;
+        }
+        index += stepH;
+    }
+
+    // Return results
+    *min = minP;
+    *max = maxP;
+}
+
+// Return a pointer to pixel data in the original image data.
+// The position parameter is scaled to the original image size but reflects
+// the displayed rotation and flip options, so it must be transformed first.
+// Return NULL, if there is no image data, or point is beyond end of image data
+const unsigned char* imageProcessor::getImageDataPtr( QPoint& pos )
+{
+    QPoint posTr;
+
+    // Transform the position to reflect the original unrotated or flipped data
+    posTr = rotateFlipToDataPoint( pos );
+
+    // Set up reference to start of the data, and the index to the required pixel
+    const unsigned char* data = (unsigned char*)imageData.constData();
+    int index = (posTr.x()+posTr.y()*imageBuffWidth)*bytesPerPixel;
+
+    // Return a pointer to the pixel data if possible
+    if( !imageData.isEmpty() && index < imageData.size() )
+    {
+        return &(data[index]);
+    }
+    else
+    {
+        return NULL;
+    }
+}
+
+// Return a number representing a pixel intensity given a pointer into an image data buffer.
+// Note, the pointer is indexed according to the pixel data size which will be at least
+// big enough for the data format.
+int imageProcessor::getPixelValueFromData( const unsigned char* ptr )
+{
+    return pixelValueFromData( ptr, formatOption, bitDepth, imageDataSize );
+}
+
+// Return a floating point number representing a pixel intensity given a pointer into an image data buffer.
+double imageProcessor::getFloatingPixelValueFromData( const unsigned char* ptr )
+{
+    return getPixelValueFromData( ptr );
+}
+
+// Return a QImage based on the current image
+// If the current image was built at a reduced resolution for display, a full
+// resolution image is built here (in a buffer of its own) for the caller.
+QImage imageProcessor::copyImage()
+{
+    // Use the filtered version of the current image data if it is available
+    useFilteredImage();
+
+    if( lastDecimationFactor > 1 && !imageData.isEmpty() && pixelLookupValid )
+    {
+        QByteArray fullBuff = FrameBufferPool::getBuffer( IMAGEBUFF_BYTES_PER_PIXEL * imageBuffWidth * imageBuffHeight );
+        imagePropertiesCore* core = newCore( fullBuff, 1 );
+        QImage fullImage = core->buildImageCore();
+        delete core;
+        return fullImage;
+    }
+    return image;
+}
+
+// Return the number of images built and dropped, and the time taken to build the last image (mS)
+void imageProcessor::getPipelineStatistics( unsigned long& framesBuiltOut, unsigned long& framesDroppedOut, double& buildTimeOut )
+{
+    QMutexLocker locker( &imageLock );
+    framesBuiltOut = framesBuilt;
+    framesDroppedOut = framesDropped;
+    buildTimeOut = lastBuildTime;
+}
+
+// Reset image counts
+void imageProcessor::resetPipelineStatistics()
+{
+    QMutexLocker locker( &imageLock );
+    framesBuilt = 0;
+    framesDropped = 0;
+}
+
+// Determine the number of original pixels (in each direction) represented by each pixel in the next image built.
+// Decimation is only used if requested, if the image is displayed at 50% or less, and for monochrome images
+// (other formats such as Bayer are interpreted using neighbouring pixels so are always built at full resolution).
+// When the image is zoomed back in the image is rebuilt at full resolution.
+unsigned int imageProcessor::getDecimationFactor()
+{
+    if( decimation == DECIMATION_NONE ||
+        formatOption != imageDataFormats::MONO ||
+        displayScale <= 0.0 || displayScale > 0.5 )
+    {
+        return 1;
+    }
+
+    return (unsigned int)( 1.0 / displayScale );
+}
+
+// Generate a profile along a line down an image at a given X position
+// This is normally generated as the image is processed, but may be required
+// immediately when the slice is moved (refer to imagePropertiesCore::generateVSliceCore())
+void imageProcessor::generateVSliceData( QVector<QPointF>& vSliceData, int x, unsigned int thickness )
+{
+    QByteArray noBuff;
+    imagePropertiesCore* core = newCore( noBuff, 1 );
+    core->generateVSliceCore( vSliceData, x, thickness );
+    delete core;
+}
+
+// Generate a profile along a line across an image at a given Y position
+// This is normally generated as the image is processed, but may be required
+// immediately when the slice is moved (refer to imagePropertiesCore::generateHSliceCore())
+void imageProcessor::generateHSliceData( QVector<QPointF>& hSliceData, int y, unsigned int thickness )
+{
+    QByteArray noBuff;
+    imagePropertiesCore* core = newCore( noBuff, 1 );
+    core->generateHSliceCore( hSliceData, y, thickness );
+    delete core;
+}
+
+// Generate a profile along an arbitrary line through an image.
+// This is normally generated as the image is processed, but may be required
+// immediately when the line is moved (refer to imagePropertiesCore::generateProfileCore())
+void imageProcessor::generateProfileData( QVector<QPointF>& profileData, QPoint point1, QPoint point2, unsigned int thickness )
+{
+    QByteArray noBuff;
+    imagePropertiesCore* core = newCore( noBuff, 1 );
+    core->generateProfileCore( profileData, point1, point2, thickness );
+    delete core;
+}
+
 // Transform a rectangle in the displayed image to a rectangle in the
 // original data according to current rotation and flip options.
 QRect imageProcessor::rotateFlipToDataRectangle( const QRect& rect )
@@ -32,6 +32,7 @@
 #include <QWaitCondition>
 #include <QReadWriteLock>
 #include <imageProperties.h>
+#include <imageFilter.h>
 
 /*!
  This class generates images for presentation from raw image data and formatting
@@ -66,10 +67,12 @@ public:
 
     // Image information
     int getScanOption();                            ///< Determine the way the input pixel data must be scanned to accommodate the required rotate and flip options.
-    void getPixelTranslation();                     ///< Generate a lookup table to convert raw pixel values to display pixel values
+    void getPixelTranslation();                     ///< Generate a lookup table to convert every possible raw pixel value to a display pixel value
     unsigned int maxPixelValue();                   ///< Determine the maximum pixel value for the current format
+    unsigned int pixelValueBits();                  ///< Determine the number of significant bits in each pixel value for the current format
     unsigned int rotatedImageBuffWidth();           ///< Return the image width following any rotation
     unsigned int rotatedImageBuffHeight();          ///< Return the image height following any rotation
+    unsigned int getDecimationFactor();             ///< Determine the number of original pixels (in each direction) represented by each pixel in the next image built
     imageDisplayProperties::rgbPixel getFalseColor (const unsigned char value);    ///< Get a false color representation for an entry fro the color lookup table
     int getElementCount();                                                         ///< Determine the element count expected based on the available dimensions
     bool validateDimensions();                                                     ///< Determine if the image dimensional information is valid.
@@ -82,6 +85,20 @@ public:
 
     QImage copyImage();         ///< Return a QImage based on the current image
 
+    // Background subtraction and frame averaging
+    // (Performed in the image processing thread, so access to the filter is locked)
+    void setBackgroundSubtraction( bool subtract ){ QMutexLocker locker( &filterLock ); filter.setBackgroundSubtraction( subtract ); }     ///< Set if a captured background is subtracted from each image
+    bool getBackgroundSubtraction(){ QMutexLocker locker( &filterLock ); return filter.getBackgroundSubtraction(); }                       ///< Return true if a captured background is subtracted from each image
+    void captureBackground(){ QMutexLocker locker( &filterLock ); filter.captureBackground(); }                                            ///< Use the last image received as the background
+    void clearBackground(){ QMutexLocker locker( &filterLock ); filter.clearBackground(); }                                                ///< Discard the background
+    void setAveraging( imageFilter::averagingOptions averaging ){ QMutexLocker locker( &filterLock ); filter.setAveraging( averaging ); }   ///< Set how images are averaged
+    imageFilter::averagingOptions getAveraging(){ QMutexLocker locker( &filterLock ); return filter.getAveraging(); }                      ///< Return how images are averaged
+    void setAverageFrames( unsigned int frames ){ QMutexLocker locker( &filterLock ); filter.setAverageFrames( frames ); }                 ///< Set the number of images averaged
+    unsigned int getAverageFrames(){ QMutexLocker locker( &filterLock ); return filter.getAverageFrames(); }                               ///< Return the number of images averaged
+
+    void getPipelineStatistics( unsigned long& framesBuiltOut, unsigned long& framesDroppedOut, double& buildTimeOut ); ///< Return the number of images built and dropped, and the time taken to build the last image (mS)
+    void resetPipelineStatistics();                                                                                    ///< Reset image counts
+
     void generateVSliceData( QVector<QPointF>& vSliceData, int x, unsigned int thickness );                          ///< Generate a series of pixel values from a vertical slice through the current image.
     void generateHSliceData( QVector<QPointF>& hSliceData, int y, unsigned int thickness );                          ///< Generate a series of pixel values from a horizontal slice through the current image.
     void generateProfileData( QVector<QPointF>& profileData, QPoint point1, QPoint point2, unsigned int thickness ); ///< Generate a series of pseudo pixel values from an arbitrary line between two pixels.
@@ -105,8 +122,30 @@ public:
 
 signals:
     void imageBuilt( QImage imageData, QString error );                         ///< An image has been generated from image data and in now ready for presentation
+    void beamAnalysed( beamAnalysisResultsList results );                       ///< A beam analysis has been performed on each analysis area of the image data (only if a beam analysis has been requested)
+    void profilesGenerated( profileResults results );                           ///< Slices and profiles have been generated from image data (only if slices or profiles have been requested)
 
 private:
+    imageFilter filter;                                                     // Background subtraction and frame averaging applied to each image as it arrives (in the image processing thread)
+    QMutex filterLock;                                                      // Protects the filter
+    void useFilteredImage();                                                // Replace the current image data with its filtered version once the image processing thread has filtered it
+
+    // Image data filtering state.
+    // Image data is saved as received. It is filtered in the image processing thread, which returns the filtered data through
+    // filteredImageData (protected by imageLock). Each image received is numbered so a received image is only filtered once.
+    unsigned long imageSequence;                                            // Number of the current image data
+    bool imageUnfiltered;                                                   // True if the current image data has not been replaced by its filtered version yet
+    QByteArray filteredImageData;                                           // Filtered version of the last image filtered by the image processing thread
+    unsigned long filteredSequence;                                         // Number of the image in filteredImageData
+
+    imagePropertiesCore* newCore( QByteArray& buff, unsigned int factor ); // Package up the current image data and all related information for processing
+    unsigned int lastDecimationFactor;                                      // Decimation factor used when building the last image
+
+    // Pipeline statistics (protected by imageLock as the images are built in the image processing thread)
+    unsigned long framesBuilt;      // Number of images built
+    unsigned long framesDropped;    // Number of images discarded as a newer image arrived before the image processing thread could build them
+    unsigned long builtSequence;    // Number of the image data most recently taken by the image processing thread to build
+    double lastBuildTime;           // Time taken to build the last image (mS). This includes building the histogram which is done in the same pass
 };
 
 #endif // IMAGEPROCESSOR_H
@@ -38,6 +38,11 @@ imageProperties::imageProperties()
     flipVert = false;
     flipHoz = false;
 
+    decimation = DECIMATION_NONE;
+    displayScale = 1.0;
+
+    beamAnalysis = BEAM_ANALYSIS_NONE;
+
     formatOption = imageDataFormats::MONO;
     bitDepth = 8;
 
@@ -50,6 +55,7 @@ imageProperties::imageProperties()
     clippingHigh = 0;
 
     pixelLookupValid = false;
+    pixelLookupShift = 0;
 
     receivedImageSize = 0;
 
@@ -222,6 +228,11 @@ bool imageProperties::setFormat( const QString& text )
     }
 
     // Format text recognozed, use it
+    // (Invalidate any pixel lookup information held as the size of the lookup table depends on the format)
+    if( formatOption != newFormatOption )
+    {
+        pixelLookupValid = false;
+    }
     formatOption = newFormatOption;
     return true;
 }
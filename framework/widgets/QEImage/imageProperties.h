@@ -26,11 +26,84 @@
 #ifndef IMAGEPROPERTIES_H
 #define IMAGEPROPERTIES_H
 
+#include <QVector>
+#include <QList>
+#include <QRect>
+#include <QPointF>
+#include <QMetaType>
 #include "QCaDateTime.h"
 #include "imageDataFormats.h"
+#include <imageFilter.h>
 #include <brightnessContrast.h> // Remove this, or extract the general definitions used (eg rgbPixel) into another include file
 
 
+// Results of a beam analysis of an image.
+// All positions and sizes are in original image data pixels (before any rotation or flipping).
+// Intensities are raw pixel values.
+class beamAnalysisResults
+{
+public:
+    beamAnalysisResults();
+
+    bool valid;             // True if the analysis produced results (there was signal above background within the analysis area)
+    int areaNumber;         // Selected area analysed (1 to 4), or 0 if the entire image was analysed
+    QRect area;             // Area analysed
+    double centroidX;       // Intensity weighted centroid
+    double centroidY;
+    double sigmaX;          // Square root of the second central moments
+    double sigmaY;
+    double sigmaXY;         // Second central cross moment (covariance)
+    unsigned int peak;      // Highest pixel value and its position
+    QPoint peakPos;
+    double integral;        // Integrated intensity above background
+    unsigned int background;// Background subtracted (lowest pixel value in the analysis area)
+
+    bool fitValid;          // True if a Gaussian fit was requested and succeeded
+    double fitX;            // Gaussian fit centre
+    double fitY;
+    double fitSigmaX;       // Gaussian fit standard deviation
+    double fitSigmaY;
+};
+
+Q_DECLARE_METATYPE( beamAnalysisResults )
+
+// Results of a beam analysis of each area analysed in an image, in area number order
+typedef QList<beamAnalysisResults> beamAnalysisResultsList;
+Q_DECLARE_METATYPE( beamAnalysisResultsList )
+
+// Slices and profiles to generate for each image as it is processed.
+// All positions are in image pixels (after any rotation or flipping).
+class profileRequests
+{
+public:
+    profileRequests();
+
+    bool vSliceOn;                      // Generate a vertical slice
+    int vSliceX;
+    unsigned int vSliceThickness;
+
+    bool hSliceOn;                      // Generate a horizontal slice
+    int hSliceY;
+    unsigned int hSliceThickness;
+
+    bool profileOn;                     // Generate an arbitrary line profile
+    QPoint profileStart;
+    QPoint profileEnd;
+    unsigned int profileThickness;
+};
+
+// Slices and profiles generated for an image
+class profileResults
+{
+public:
+    profileRequests requests;           // What was requested (the data is only present for those slices and profiles requested)
+    QVector<QPointF> vSliceData;
+    QVector<QPointF> hSliceData;
+    QVector<QPointF> profileData;
+};
+
+Q_DECLARE_METATYPE( profileResults )
+
 // Class to manage core image processing by a seperate thread.
 //
 // Much of the information required for processing an image can me
@@ -56,34 +129,71 @@ public:
                          unsigned long imageBuffHeightIn,
                          int scanOptionIn,
                          unsigned long bytesPerPixelIn,
-                         int pixelLowIn,
-                         int pixelHighIn,
                          unsigned int bitDepthIn,
-                         imageDisplayProperties::rgbPixel* pixelLookupIn,
+                         QVector<imageDisplayProperties::rgbPixel> pixelLookupIn,
+                         unsigned int pixelLookupShiftIn,
                          imageDataFormats::formatOptions formatOptionIn,
                          unsigned long imageDataSizeIn,
                          imageDisplayProperties* imageDisplayPropsIn,
                          unsigned int rotatedImageBuffWidthIn,
-                         unsigned int rotatedImageBuffHeightIn );
+                         unsigned int rotatedImageBuffHeightIn,
+                         unsigned int decimationFactorIn,
+                         int decimationIn,
+                         int beamAnalysisIn,
+                         QVector<QRect> beamAnalysisAreasIn,
+                         profileRequests profilesIn,
+                         bool unfilteredIn,
+                         unsigned long sequenceIn );
+
+    // Background subtraction and averaging (performed in the image processing thread before building the image)
+    bool imageUnfiltered(){ return unfiltered; }                // Return true if the image data has not been filtered yet
+    unsigned long getSequence(){ return sequence; }             // Return the number of the image data received
+    QByteArray filterCore( imageFilter& filter );               // Filter the image data. Returns the filtered data
+    void useFilteredData( const QByteArray& data ){ imageData = data; unfiltered = false; } // Use image data already filtered
 
     QImage buildImageCore();
+    bool analyseBeamRequired(){ return beamAnalysis != 0; }   // Return true if a beam analysis is required as well as building the image
+    beamAnalysisResultsList analyseBeamCore();                 // Analyse the beam in each analysis area of the image data
+
+    bool generateProfilesRequired(){ return profiles.vSliceOn || profiles.hSliceOn || profiles.profileOn; } // Return true if any slices or profiles are required as well as building the image
+    profileResults generateProfilesCore();                                                                   // Generate all slices and profiles required
+
+    void generateVSliceCore( QVector<QPointF>& vSliceData, int x, unsigned int thickness );                          // Generate a series of pixel values from a vertical slice through the image.
+    void generateHSliceCore( QVector<QPointF>& hSliceData, int y, unsigned int thickness );                          // Generate a series of pixel values from a horizontal slice through the image.
+    void generateProfileCore( QVector<QPointF>& profileData, QPoint point1, QPoint point2, unsigned int thickness ); // Generate a series of pseudo pixel values from an arbitrary line between two pixels.
 private:
+    static void releaseImageBuff( void* info ); // Release the image buffer reference held by a QImage built by buildImageCore()
+    beamAnalysisResults analyseBeamArea( const QRect& analysisArea ); // Analyse the beam in an area of the image data (the entire image if the area is empty)
+    static bool fitGaussian( const QVector<double>& projection, double centre, double& fitCentre, double& fitSigma ); // Fit a Gaussian to a beam projection
+
+    unsigned int fullImageWidth();                      // Full resolution image width following any rotation
+    unsigned int fullImageHeight();                     // Full resolution image height following any rotation
+    QPoint imageToDataPoint( const QPoint& pos );       // Transform a point from the image to the original data according to the scan option
+    const unsigned char* imageDataPtr( const QPoint& pos ); // Return a pointer to the data for a pixel in the image (NULL if outside the image)
+    void accumulateSlice( const QRect& area, bool alongX, QVector<double>& sums ); // Sum the pixels in an area of the image across or down the image
+
     QByteArray imageData;             // Buffer to hold original image data.
     QByteArray imageBuff;             // Buffer to hold data converted to format for generating QImage.
     unsigned long imageBuffWidth;     // Original image width (may be generated directly from a width variable, or selected from the relevent dimension variable)
     unsigned long imageBuffHeight;    // Original image height (may be generated directly from a width variable, or selected from the relevent dimension variable)
     int scanOption;
     unsigned long bytesPerPixel;      // Bytes in input data per pixel (imageDataSize * elementsPerPixel)
-    int pixelLow;
-    int pixelHigh;
     unsigned int bitDepth;
     unsigned int bins[HISTOGRAM_BINS]; // Bins used for generating a pixel histogram
-    imageDisplayProperties::rgbPixel* pixelLookup;
+    QVector<imageDisplayProperties::rgbPixel> pixelLookup; // Shared copy of the pixel lookup table (a copy so the table can be regenerated while this image is processed)
+    unsigned int pixelLookupShift;    // Shift applied to pixel values before indexing the pixel lookup table (only non zero for pixels deeper than MAX_LOOKUP_BITS)
     imageDataFormats::formatOptions formatOption;
     unsigned long imageDataSize;      // Size of elements in image data (originating from CA data type)
     imageDisplayProperties* imageDisplayProps;
     unsigned int rotatedImageBuffWidth;
     unsigned int rotatedImageBuffHeight;
+    unsigned int decimationFactor;    // Number of original pixels in each direction represented by each pixel in the image built (1 for full resolution)
+    int decimation;                   // How blocks of original pixels are combined when decimating (imageProperties::decimationOptions)
+    int beamAnalysis;                 // Beam analysis required (imageProperties::beamAnalysisOptions)
+    QVector<QRect> beamAnalysisAreas; // Areas of the original image data to analyse, indexed by area number-1. Empty for areas not selected
+    profileRequests profiles;         // Slices and profiles to generate
+    bool unfiltered;                  // True if the image data is as received (background subtraction and averaging have not been applied yet)
+    unsigned long sequence;           // Number of the image data received
 };
 
 /*!
@@ -106,6 +216,22 @@ public:
                            ROTATION_180         ///< Rotate image 180 degrees
                          };
 
+    // Display decimation
+    /// \enum decimationOptions
+    /// Options for building images directly at the displayed resolution when the image is displayed at less than 100%
+    enum decimationOptions { DECIMATION_NONE,      ///< Always build images at full resolution
+                             DECIMATION_BINNING,   ///< Each displayed pixel is the average of the original pixels it represents
+                             DECIMATION_MAXIMUM    ///< Each displayed pixel is the maximum of the original pixels it represents (preserves hot pixels)
+                           };
+
+    // Beam analysis
+    /// \enum beamAnalysisOptions
+    /// Options for analysing the beam in each image as it is processed
+    enum beamAnalysisOptions { BEAM_ANALYSIS_NONE,     ///< No beam analysis
+                               BEAM_ANALYSIS_MOMENTS,  ///< Centroid, second moments, peak and integrated intensity
+                               BEAM_ANALYSIS_FIT       ///< As for BEAM_ANALYSIS_MOMENTS, plus a Gaussian fit to the beam projections
+                             };
+
     // Image attribut set and get functions
     void setRotation( rotationOptions rotationIn ){ rotation = rotationIn; }
     rotationOptions getRotation(){ return rotation; }
@@ -139,6 +265,18 @@ public:
 
     void setElementsPerPixel( unsigned long elementsPerPixelIn ){ elementsPerPixel = elementsPerPixelIn; }//LOCK ACCESS???
 
+    void setDecimation( decimationOptions decimationIn ){ decimation = decimationIn; }
+    decimationOptions getDecimation(){ return decimation; }
+
+    void setDisplayScale( double displayScaleIn ){ displayScale = displayScaleIn; } ///< Set the scale the image is currently displayed at (1.0 = 100%). Used to determine decimation
+
+    void setBeamAnalysis( beamAnalysisOptions beamAnalysisIn ){ beamAnalysis = beamAnalysisIn; }
+    beamAnalysisOptions getBeamAnalysis(){ return beamAnalysis; }
+
+    void setBeamAnalysisAreas( const QVector<QRect>& areasIn ){ beamAnalysisAreas = areasIn; } ///< Set the areas of the original image data to analyse (indexed by area number-1, empty if an area is not selected). If all are empty, the entire image is analysed
+
+    void setProfileRequests( const profileRequests& profilesIn ){ profiles = profilesIn; } ///< Set the slices and profiles to generate as each image is processed
+
     void setImageDisplayProperties( imageDisplayProperties* imageDisplayPropsIn ){ imageDisplayProps = imageDisplayPropsIn; }
 
     // Methods to force reprocessing
@@ -161,8 +299,7 @@ protected:
     QByteArray imageData;                 // Buffer to hold original image data.
     unsigned long receivedImageSize;  // Size as received on last CA update.
     QString previousMessageText;      // Previous message text - avoid repeats.
-    QByteArray imageBuff;             // Buffer to hold data converted to format for generating QImage. This is only used within the imagePropertiesCore class, but it is coppied from here each time a class is created so the same buffer is reused and to keep the buffer until QImages created from it no longer need it
-    QByteArray lastImageBuff;         // Previous imageBuff (before a resize) kept untill all QImages generated from it ( and still referencing its data) are gone
+    QByteArray imageBuff;             // Buffer to hold data converted to format for generating QImage. This is only used within the imagePropertiesCore class. A new (or idle) buffer is taken from the frame buffer pool for each image. QImages built in a buffer hold their own reference to it
     QImage image;                     // Last image generated. Kept as the widget may aask for it again. For example, if the user is saving it.
 #define IMAGEBUFF_BYTES_PER_PIXEL 4   // 4 bytes for Format_RGB32
     unsigned long imageBuffWidth;     // Original image width (may be generated directly from a width variable, or selected from the relevent dimension variable)
@@ -176,7 +313,9 @@ protected:
 
     // Pixel information
     bool pixelLookupValid;            // pixelLookup is valid. It is invalid if anything that affects the translation changes, such as pixel format, local brigHtness, etc
-    imageDisplayProperties::rgbPixel pixelLookup[256];
+#define MAX_LOOKUP_BITS 16            // Largest pixel depth catered for by the pixel lookup table. Deeper pixels are shifted down to this depth before lookup
+    QVector<imageDisplayProperties::rgbPixel> pixelLookup; // Pixel lookup table. One entry for every possible pixel value (up to MAX_LOOKUP_BITS bits). Includes local brightness and contrast
+    unsigned int pixelLookupShift;    // Shift applied to pixel values before indexing pixelLookup
     int pixelLow;
     int pixelHigh;
 
@@ -185,6 +324,17 @@ protected:
     unsigned int clippingLow;
     unsigned int clippingHigh;
 
+    // Display decimation options
+    decimationOptions decimation;   // How (or if) to build images at the displayed resolution when displayed at less than 100%
+    double displayScale;            // Scale the image is currently displayed at (1.0 = 100%)
+
+    // Beam analysis options
+    beamAnalysisOptions beamAnalysis;   // Beam analysis performed on each image as it is built
+    QVector<QRect> beamAnalysisAreas;   // Areas of the original image data to analyse (all empty for the entire image)
+
+    // Slices and profiles generated as each image is processed
+    profileRequests profiles;
+
     // Flip rotate options
     rotationOptions rotation;   // Rotation option
     bool flipVert;              // True if vertical flip option set
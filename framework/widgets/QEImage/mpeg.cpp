@@ -38,6 +38,7 @@
 #include "mpeg.h"
 
 #include <colourConversion.h>
+#include <FrameBufferPool.h>
 
 /* global switch for fallback mode */
 int fallback = 0;
@@ -48,79 +49,34 @@ static int ffinit=0;
 /* need this to protect certain ffmpeg functions */
 static QMutex *ffmutex;
 
-// An FFBuffer contains an AVFrame, a mutex for access and some data
-FFBuffer::FFBuffer() {
-    this->mutex = new QMutex();
-    this->refs = 0;
-    this->pFrame = avcodec_alloc_frame();
-    this->mem = (unsigned char *) calloc(MAXWIDTH*MAXHEIGHT*3, sizeof(unsigned char));
-}
-
-FFBuffer::~FFBuffer() {
-    av_free(this->pFrame);
-    free(this->mem);
-}
-
-bool FFBuffer::grabFree() {
-    if (this->mutex->tryLock()) {
-        if (this->refs == 0) {
-            this->refs += 1;
-            this->mutex->unlock();    
-            return true;
-        } else {
-            this->mutex->unlock();    
-            return false;
-        }
-    } else {
-        return false;
-    }
-}
-
-void FFBuffer::reserve() {
-    this->mutex->lock();
-    this->refs += 1;
-    this->mutex->unlock();
-}
-
-void FFBuffer::release() {
-    this->mutex->lock();
-    this->refs -= 1;
-    this->mutex->unlock();
-}
-
-// List of FFBuffers to use for raw frames
-static FFBuffer rawbuffers[NBUFFERS];
-
-// List of FFBuffers to use for uncompressed frames
-static FFBuffer outbuffers[NBUFFERS];
-
-// find a free FFBuffer
-FFBuffer * findFreeBuffer(FFBuffer* source) {
-    for (int i = 0; i < NBUFFERS; i++) {
-        // if we can lock it and it has a 0 refcount, we can use it!
-        if (source[i].mutex->tryLock()) {
-            if (source[i].refs == 0) {
-                source[i].refs += 1;
-                source[i].mutex->unlock();
-                return &source[i];
-            } else {
-                source[i].mutex->unlock();    
-            }
-        }
-    }
-    return NULL;
+// A decoded frame formatted like a CA image update
+FFFrame::FFFrame()
+{
+    dataSize = 1;
+    elements = 1;
+    width = 0;
+    height = 0;
+    format = imageDataFormats::MONO;
+    depth = 8;
+    generation = 0;
 }
 
 /* thread that decodes frames from video stream and emits updateSignal when
  * each new frame is available
  */
-FFThread::FFThread (const QString &url, QObject* parent)
+FFThread::FFThread (const QString &url, unsigned long generationIn, QObject* parent)
     : QThread (parent)
 {
     // this is the url to read the stream from
     strcpy(this->url, url.toLatin1().data());
     // set this to 1 to finish
     this->stopping = 0;
+    // no frames waiting to be consumed yet
+    this->pending = 0;
+    // frames emitted are tagged with the stream generation
+    this->generation = generationIn;
+    // allow decoded frames to be queued to the GUI thread
+    qRegisterMetaType<FFFrame>( "FFFrame" );
     // initialise the ffmpeg library once only
     if (ffinit==0) {
         ffinit = 1;
@@ -145,6 +101,7 @@ void FFThread::run()
     AVCodecContext      *pCodecCtx;
     AVCodec             *pCodec;
     AVPacket            packet;
+    AVFrame             *pFrame;
     int                 frameFinished, len;
 
     // Open video file
@@ -180,6 +137,12 @@ void FFThread::run()
         return;
     }
 
+    // Decode using multiple threads where the codec supports it
+    pCodecCtx->thread_count = QThread::idealThreadCount();
+#ifdef FF_THREAD_FRAME
+    pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+#endif
+
     // Open codec
     ffmutex->lock();
 #if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(53, 2, 0)
@@ -187,11 +150,17 @@ void FFThread::run()
 #else
     if(avcodec_open2(pCodecCtx, pCodec, NULL)<0) {
 #endif
+        ffmutex->unlock();
         qDebug() << QString( "Could not open codec for '%1'" ).arg( url );
         return;
     }
     ffmutex->unlock();
 
+    // Frame to decode into.
+    // (The decoder manages the frame data, which is only valid until the next frame is decoded,
+    //  so each frame is formatted into a pooled buffer in this thread before being passed on)
+    pFrame = avcodec_alloc_frame();
+
     // read frames into the packets
     while (stopping !=1 && av_read_frame(pFormatCtx, &packet) >= 0) {
 
@@ -203,34 +172,36 @@ void FFThread::run()
             continue;
         }
 
-        // grab a buffer to decode into
-        FFBuffer *raw = findFreeBuffer(rawbuffers);        
-        if (raw == NULL) {
-            qDebug() << "Couldn't get a free buffer, skipping packet";
-            av_free_packet(&packet);
-            continue;
-        }
-        
         // Decode video frame
-        len = avcodec_decode_video2(pCodecCtx, raw->pFrame, &frameFinished,
+        // (When decoding with frame threads, the first few packets will not complete a frame)
+        len = avcodec_decode_video2(pCodecCtx, pFrame, &frameFinished,
             &packet);
+        av_free_packet(&packet);
         if (!frameFinished) {
-            qDebug() << "Frame not finished. Shouldn't see this...";
-            av_free_packet(&packet);
-            raw->release();
             continue;
         }
-        
-        // Fill in the output buffer
-        raw->pix_fmt = pCodecCtx->pix_fmt;         
-        raw->height = pCodecCtx->height;
-        raw->width = pCodecCtx->width;
-
-        // Emit and free
-        emit updateSignal(raw);
-        av_free_packet(&packet);
+
+        // If the consumer is falling behind, skip this frame
+        {
+            QMutexLocker locker( &pendingMutex );
+            if( pending >= MAXPENDING ) {
+                continue;
+            }
+        }
+
+        // Format the frame and emit it
+        FFFrame frame;
+        frame.generation = generation;
+        if( formatFrame( pFrame, pCodecCtx->pix_fmt, pCodecCtx->width, pCodecCtx->height, frame ) ) {
+            {
+                QMutexLocker locker( &pendingMutex );
+                pending++;
+            }
+            emit updateSignal( frame );
+        }
     }
     // tidy up
+    av_free(pFrame);
     ffmutex->lock();
     avcodec_close(pCodecCtx);
     av_close_input_file(pFormatCtx);
@@ -245,6 +216,125 @@ void FFThread::run()
 
 
 
+// A frame emitted by updateSignal() has been consumed
+void FFThread::frameDone()
+{
+    QMutexLocker locker( &pendingMutex );
+    if( pending > 0 )
+    {
+        pending--;
+    }
+}
+
+// Format a decoded frame like a CA image update.
+// The frame is formatted into a buffer from the frame buffer pool sized for the frame,
+// which is passed on to the image processor without further copying.
+bool FFThread::formatFrame( AVFrame* pFrame, PixelFormat pix_fmt, int width, int height, FFFrame& frame )
+{
+    if( width <= 0 || height <= 0 )
+    {
+        return false;
+    }
+
+    // Get a buffer to hold the image data with no line gaps, sized for the frame's pixel format
+    int buffSize = width * height * ( pix_fmt == PIX_FMT_YUVJ420P ? 3 : 1 );
+    frame.image = FrameBufferPool::getBuffer( buffSize );
+
+    // Populate buffer with no line gaps
+    // (Each horizontal line of pixels in in a larger horizontal line of storage.
+    //  Observed example: each line was 1624 pixels stored in 1664 bytes with
+    //  trailing 40 bytes of value 128 before start of pixel on next line)
+    // Note, the pool does not reference buffers it has handed out, so this does not detach (copy) the buffer
+    char* buffPtr = frame.image.data();
+
+    frame.width = width;
+    frame.height = height;
+
+    // Format the data in a CA like QByteArray
+    switch( pix_fmt )
+    {
+    case PIX_FMT_YUVJ420P:
+        {
+            //!!! Since the QEImage widget handles (or should handle) CA image data in all the formats that are expected in this mpeg stream
+            //!!! perhaps this formatting here should be simply packaging the data in a QbyteArray and delivering it, rather than perform any conversion.
+
+            // Set up the image information
+            frame.dataSize = 1;
+            frame.depth = 8;
+            frame.elements = 3;
+            frame.format = imageDataFormats::RGB1;
+
+            const unsigned char* linePtrY = (const unsigned char*)(pFrame->data[0]);
+            const unsigned char* linePtrU = (const unsigned char*)(pFrame->data[1]);
+            const unsigned char* linePtrV = (const unsigned char*)(pFrame->data[2]);
+
+            // For each row...
+//            qint64 start = QDateTime::currentMSecsSinceEpoch();
+            for( int i = 0; i < height; i++ )
+            {
+                // For each pixel...
+                for( int j = 0; j < width; j++ )
+                {
+                    unsigned char y,u,v;
+                    unsigned char r,g,b;
+
+                    // Use U and V values for every pair of pixels
+                    int uv = j/2;
+
+                    // Get YUV values
+                    y = linePtrY[j];
+                    u = linePtrU[uv];
+                    v = linePtrV[uv];
+
+                    // Convert to RGB
+                    r = YUVJ2R(y, u, v);
+                    g = YUVJ2G(y, u, v);
+                    b = YUVJ2B(y, u, v);
+
+                    // Save RGB result
+                    *buffPtr++ = r;
+                    *buffPtr++ = g;
+                    *buffPtr++ = b;
+                }
+
+                // Step on to new Y data for every line
+                linePtrY += pFrame->linesize[0];
+
+                // Step onto new U and V data every two lines
+                if( i & 1 )
+                {
+                    linePtrU += pFrame->linesize[1];
+                    linePtrV += pFrame->linesize[2];
+                }
+            }
+//            qint64 end = QDateTime::currentMSecsSinceEpoch();
+//            qDebug() <<"decode mS:" << end-start;
+        }
+        break;
+
+    default:
+        {
+            // Set up the image information
+            frame.dataSize = 1;
+            frame.depth = 8;
+            frame.elements = 1;
+            frame.format = imageDataFormats::MONO;
+
+            // Package the data in a CA like QByteArray
+            const char* linePtr = (const char*)(pFrame->data[0]);
+            for( int i = 0; i < height; i++ )
+            {
+                memcpy( buffPtr, linePtr, width );
+                buffPtr += width;
+                linePtr += pFrame->linesize[0];
+            }
+        }
+        break;
+    }
+
+    return true;
+}
+
 mpegSourceObject::mpegSourceObject( mpegSource* msIn )
 {
     ms = msIn;
@@ -265,6 +355,7 @@ void mpegSourceObject::sentAboutToQuit()
 mpegSource::mpegSource()
 {
     ff = NULL;
+    streamGeneration = 0;
     mso = new mpegSourceObject( this );
 }
 
@@ -298,10 +389,11 @@ void mpegSource::startStream()
     stopStream();
 
     /* create the ffmpeg thread */
-    ff = new FFThread( url, mso );
+    streamGeneration++;
+    ff = new FFThread( url, streamGeneration, mso );
 
-    QObject::connect( ff, SIGNAL(updateSignal(FFBuffer *)),
-                      mso, SLOT(updateImage(FFBuffer *)) );
+    QObject::connect( ff, SIGNAL(updateSignal(FFFrame)),
+                      mso, SLOT(updateImage(FFFrame)) );
     QObject::connect( mso, SIGNAL(aboutToQuit()),
                       ff, SLOT(stopGracefully()) );
 
@@ -322,122 +414,23 @@ void mpegSource::stopStream()
     ff = NULL;
 }
 
-void mpegSourceObject::updateImage(FFBuffer *newbuf)
+void mpegSourceObject::updateImage( FFFrame frame )
 {
-    ms->updateImage( newbuf );
-    newbuf->release();
+    ms->updateImage( frame );
 }
 
-void mpegSource::updateImage(FFBuffer *newbuf) {
-
-    newbuf->reserve();
-
-    // Ensure an adequate buffer to hold the image data with no line gaps is allocated.
-    // (re)allocate if not present of not the right size
-    int buffSize = newbuf->width * newbuf->height * 3;   //!!!??? * 3 for color only
-    ba.resize( buffSize );
-
-    // Populate buffer with no line gaps
-    // (Each horizontal line of pixels in in a larger horizontal line of storage.
-    //  Observed example: each line was 1624 pixels stored in 1664 bytes with
-    //  trailing 40 bytes of value 128 before start of pixel on next line)
-    char* buffPtr = (char*)ba.data();
-
-    // Set up default image information
-    unsigned long dataSize = 1;
-    unsigned long depth = 8;
-    unsigned long elementsPerPixel = 1;
-    imageDataFormats::formatOptions format = imageDataFormats::MONO;
-
-// older version does not have 'format'
-//widgets/QEImage/mpeg.cpp: In member function 'void mpegSource::updateImage(FFBuffer*)':
-//widgets/QEImage/mpeg.cpp:387: error: 'struct AVFrame' has no member named 'format'
-
-    // Format the data in a CA like QByteArray
-    switch( newbuf->pix_fmt )
+void mpegSource::updateImage( FFFrame& frame )
+{
+    // Ignore frames still queued from a stream that has since been stopped or replaced.
+    // (They were emitted by an earlier decoding thread, so must not be counted as consumed by the current one)
+    if( !ff || frame.generation != streamGeneration )
     {
-    case PIX_FMT_YUVJ420P:
-        {
-            //!!! Since the QEImage widget handles (or should handle) CA image data in all the formats that are expected in this mpeg stream
-            //!!! perhaps this formatting here should be simply packaging the data in a QbyteArray and delivering it, rather than perform any conversion.
-
-            // Set up the image information
-            dataSize = 1;
-            depth = 8;
-            elementsPerPixel = 3;
-            format = imageDataFormats::RGB1;
-
-            const unsigned char* linePtrY = (const unsigned char*)(newbuf->pFrame->data[0]);
-            const unsigned char* linePtrU = (const unsigned char*)(newbuf->pFrame->data[1]);
-            const unsigned char* linePtrV = (const unsigned char*)(newbuf->pFrame->data[2]);
-
-            // For each row...
-//            qint64 start = QDateTime::currentMSecsSinceEpoch();
-            for( int i = 0; i < newbuf->height; i++ )
-            {
-                // For each pixel...
-                for( int j = 0; j < newbuf->width; j++ )
-                {
-                    unsigned char y,u,v;
-                    unsigned char r,g,b;
-
-                    // Use U and V values for every pair of pixels
-                    int uv = j/2;
-
-                    // Get YUV values
-                    y = linePtrY[j];
-                    u = linePtrU[uv];
-                    v = linePtrV[uv];
-
-                    // Convert to RGB
-                    r = YUVJ2R(y, u, v);
-                    g = YUVJ2G(y, u, v);
-                    b = YUVJ2B(y, u, v);
-
-                    // Save RGB result
-                    *buffPtr++ = r;
-                    *buffPtr++ = g;
-                    *buffPtr++ = b;
-                }
-
-                // Step on to new Y data for every line
-                linePtrY += newbuf->pFrame->linesize[0];
-
-                // Step onto new U and V data every two lines
-                if( i & 1 )
-                {
-                    linePtrU += newbuf->pFrame->linesize[1];
-                    linePtrV += newbuf->pFrame->linesize[2];
-                }
-            }
-//            qint64 end = QDateTime::currentMSecsSinceEpoch();
-//            qDebug() <<"decode mS:" << end-start;
-        }
-        break;
-
-    default:
-        {
-            // Set up the image information
-            dataSize = 1;
-            depth = 8;
-            elementsPerPixel = 1;
-            format = imageDataFormats::MONO;
-
-            // Package the data in a CA like QByteArray
-            const char* linePtr = (const char*)(newbuf->pFrame->data[0]);
-            for( int i = 0; i < newbuf->height; i++ )
-            {
-                memcpy( buffPtr, linePtr, newbuf->width );
-                buffPtr += newbuf->width;
-                linePtr += newbuf->pFrame->linesize[0];
-            }
-        }
-        break;
+        return;
     }
 
-    // Deliver image update
-    setImage( ba, dataSize, elementsPerPixel, newbuf->width, newbuf->height, format, depth );
+    // Let the decoding thread know the frame has been consumed
+    ff->frameDone();
 
-    // Unlock buffer
-    newbuf->release();
+    // Deliver image update
+    setImage( frame.image, frame.dataSize, frame.elements, frame.width, frame.height, frame.format, frame.depth );
 }
@@ -30,6 +30,8 @@
 #include <QThread>
 #include <QWidget>
 #include <QMutex>
+#include <QByteArray>
+#include <QMetaType>
 
 /* ffmpeg includes */
 extern "C"{
@@ -47,52 +49,55 @@ extern "C"{
 
 #include "imageDataFormats.h"
 
-// max width of any input image
-#define MAXWIDTH 4000
-// max height of any input image
-#define MAXHEIGHT 3000
-// number of MAXWIDTH*MAXHEIGHT*3 buffers to create
-#define NBUFFERS 20
+// maximum number of decoded frames waiting to be consumed (further frames are skipped)
+#define MAXPENDING 2
 // number of frames to calc fps from
 #define MAXTICKS 10
 // size of URL string
 #define MAXSTRING 1024
 
-class FFBuffer
+// A decoded frame, formatted like a CA image update.
+// The image data is held in a buffer from the frame buffer pool sized for the actual stream
+// dimensions and pixel format, and is passed on to the image processor without copying.
+class FFFrame
 {
 public:
-    FFBuffer ();
-    ~FFBuffer ();
-	void reserve();
-	void release();
-	bool grabFree();
-    QMutex *mutex;
-    unsigned char *mem;
-    AVFrame *pFrame;
-    PixelFormat pix_fmt;
-    int width;
-    int height;
-    int refs;
+    FFFrame();
+    QByteArray image;
+    unsigned long dataSize;
+    unsigned long elements;
+    unsigned long width;
+    unsigned long height;
+    imageDataFormats::formatOptions format;
+    unsigned int depth;
+    unsigned long generation;   // Generation of the stream (decoding thread) that produced the frame
 };
 
+Q_DECLARE_METATYPE( FFFrame )
+
 class FFThread : public QThread
 {
     Q_OBJECT
 
 public:
-    FFThread (const QString &url, QObject* parent);
+    FFThread (const QString &url, unsigned long generationIn, QObject* parent);
     ~FFThread ();
     void run();
+    void frameDone();   // A frame emitted by updateSignal() has been consumed
 
 public slots:
     void stopGracefully() { stopping = 1; }
 
 signals:
-    void updateSignal(FFBuffer * buf);
+    void updateSignal( FFFrame frame );
 
 private:
+    bool formatFrame( AVFrame* pFrame, PixelFormat pix_fmt, int width, int height, FFFrame& frame ); // Format a decoded frame like a CA image update
     char url[MAXSTRING];
     int stopping;
+    QMutex pendingMutex;    // Protects pending
+    int pending;            // Number of frames emitted but not yet consumed
+    unsigned long generation; // Generation of the stream, used to tag each frame emitted
 };
 
 class mpegSource;
@@ -107,7 +112,7 @@ public:
     void sentAboutToQuit();
 
 public slots:
-    void updateImage(FFBuffer *buf);
+    void updateImage( FFFrame frame );
 
 signals:
     void aboutToQuit();
@@ -122,7 +127,7 @@ public:
     mpegSource();
     ~mpegSource();
 
-    void updateImage(FFBuffer *buf);
+    void updateImage( FFFrame& frame );
 
 protected:
     QString getURL();
@@ -134,6 +139,7 @@ private:
     mpegSourceObject* mso;
     QString url;
     FFThread* ff;
+    unsigned long streamGeneration; // Incremented each time a stream is started, so frames still queued from an earlier stream can be recognised
     virtual void setImage( const QByteArray& imageIn,
                            unsigned long dataSize,
                            unsigned long elements,
@@ -141,9 +147,6 @@ private:
                            unsigned long height,
                            imageDataFormats::formatOptions format,
                            unsigned int depth ) = 0;    // Function to consume image formatted like a CA update
-
-    QByteArray ba;  // Byte array used to deliver images
-
 };
 
 #endif // MPEG_H
@@ -25,10 +25,11 @@
 /*
  This class manages image recording and playback for the QEImage widget.
 
- This class emits a signal 'byteArrayChanged' to stream saved image history
+ This class emits a signal 'recordedImageChanged' to stream saved image history
  back to the QEImage class. Saved images from this signal are presented
  exactly the same way immages are processed from the QEImage's QCa image
- source or MPEG source.
+ source or MPEG source, using the image attributes (width, height, format and
+ bit depth) in effect when the image was recorded.
 
  This class emits a signal 'playingBack to indicate when this class in in
  playback mode. When in playback mode the QEImage widget ensures it is not
@@ -37,6 +38,9 @@
  QEImage class can determine if this class is currently recording images by calling isRecording()
  When recording, the QEImage class can deliver new images to record by calling recordImage()
 
+ Recorded images are held by a recordingStore in a temporary ring file, not in memory,
+ so the number of images recorded is not limited by available memory.
+
 */
 
 #include "recording.h"
@@ -53,6 +57,11 @@ recording::recording( QWidget* parent ) :
     // Prepare playback timer
     timer = new playbackTimer( this );
 
+    // Show a frame requested before it was stored once it has been stored
+    awaitedFrame = -1;
+    QObject::connect( &store, SIGNAL( imageStored() ),
+                      this,   SLOT( imageStored() ) );
+
     // Create icons
     pauseIcon = new QIcon( ":/qe/image/pause.png" );
     playIcon = new QIcon( ":/qe/image/play.png" );
@@ -94,28 +103,36 @@ bool recording::isRecording()
 
 // Record an image.
 // Used by QEImage to record a new image.
-void recording::recordImage( QByteArray image, unsigned long dataSize, QCaAlarmInfo& alarmInfo, QCaDateTime& time )
+void recording::recordImage( QByteArray image, unsigned long dataSize, QCaAlarmInfo& alarmInfo, QCaDateTime& time,
+                             unsigned long width, unsigned long height, imageDataFormats::formatOptions format, unsigned int bitDepth )
 {
     // Determine behaviour
     bool stopAtLimit = ui->radioButtonStopAtLimit->isChecked();
     int limit = ui->spinBoxMaxImages->value();
 
-    // Discard images if limit has been reached and not stopping when limit is reached
-    if( history.count() >= limit && !stopAtLimit )
-    {
-        history.removeFirst();
-    }
-
-    // If not at limit, add new image
-    if( history.count() < limit )
+    // Add the new image if not at the limit, or if discarding the oldest image when at the limit
+    // (The store discards the oldest image when full)
+    if( store.count() < limit || !stopAtLimit )
     {
-        history.append( historicImage( image, dataSize, alarmInfo, time ) );
-
-        ui->labelImageCountRecord->setText( QString( "%1" ).arg( history.count() ) );
+        recordedImageInfo info;
+        info.dataSize = dataSize;
+        info.alarmInfo = alarmInfo;
+        info.time = time;
+        info.width = width;
+        info.height = height;
+        info.format = format;
+        info.bitDepth = bitDepth;
+        store.addImage( image, info );
+
+        ui->labelImageCountRecord->setText( QString( "%1" ).arg( store.count() ) );
+
+        unsigned long dropped = store.getDroppedCount();
+        ui->labelImageCountRecord->setToolTip( dropped ? QString( "Number of images recorded (%1 images dropped as they arrived faster than they could be saved)" ).arg( dropped ) :
+                                                         QString( "Number of images recorded" ) );
     }
 
     // If limit has been reached, and stopping when limit is reached, then stop recording
-    if( history.count() >= limit && stopAtLimit )
+    if( store.count() >= limit && stopAtLimit )
     {
         ui->pushButtonRecord->setChecked( false );
     }
@@ -149,11 +166,30 @@ void recording::showRecordedFrame( int currentFrame )
     if( currentFrame<0) //check for currentFrame <0 because it could be set to -1 by invalid slider position.
         return;
     // Get and display the frame
-    if( currentFrame < history.count() )
+    // (Only this frame is read back from the recording)
+    QByteArray image;
+    recordedImageInfo info;
+    if( store.getImage( currentFrame, image, info ) )
     {
+        awaitedFrame = -1;
         ui->labelImageCountPlayback->setText( QString( "%1/%2" ).arg( currentFrame+1 ).arg( ui->horizontalSliderPosition->maximum()+1 ) );
-        historicImage frame = history.at( currentFrame );
-        emit byteArrayChanged( frame.image, frame.dataSize, frame.alarmInfo, frame.time, 0 );
+        emit recordedImageChanged( image, info );
+    }
+
+    // If the frame is still waiting to be stored, show it when it has been
+    else if( currentFrame < store.count() )
+    {
+        awaitedFrame = currentFrame;
+    }
+}
+
+// An image has been stored by the recording store.
+// If waiting to show the image, show it now.
+void recording::imageStored()
+{
+    if( awaitedFrame >= 0 && !ui->radioButtonLive->isChecked() )
+    {
+        showRecordedFrame( awaitedFrame );
     }
 }
 
@@ -190,7 +226,7 @@ void recording::on_pushButtonPlay_toggled(bool checked)
 
 void recording::on_pushButtonClear_clicked()
 {
-    history.clear();
+    store.clear();
     ui->labelImageCountRecord->setText( "0" );
     ui->radioButtonPlayback->setEnabled( false );
 }
@@ -254,9 +290,7 @@ void recording::on_radioButtonLive_toggled( bool checked )
         {
             ui->pushButtonRecord->setChecked( false );
         }
-        ui->horizontalSliderPosition->setMaximum( history.count()-1 );
-
-        on_pushButtonFirstImage_clicked();
+        ui->horizontalSliderPosition->setMaximum( store.count()-1 );
     }
 
     // Enable appropriate controls (playback or record)
@@ -265,9 +299,30 @@ void recording::on_radioButtonLive_toggled( bool checked )
 
     // Signal to the QEImage that recorder is in playback or record mode
     emit playingBack( !checked );
+
+    // If going to playback mode, show the first image.
+    // (Only after the QEImage has noted it is playing back, and has noted the live image attributes)
+    if( !checked )
+    {
+        on_pushButtonFirstImage_clicked();
+    }
+    else
+    {
+        awaitedFrame = -1;
+    }
 }
 
 
+void recording::on_spinBoxMaxImages_valueChanged( int value )
+{
+    store.setLimit( value );
+}
+
+void recording::on_checkBoxCompress_toggled( bool checked )
+{
+    store.setCompression( checked );
+}
+
 // ================================================
 // Playback timer class
 void playbackTimer::timerEvent( QTimerEvent* )
@@ -36,20 +36,7 @@
 #include <QByteArray>
 #include <QCaAlarmInfo.h>
 #include <QCaDateTime.h>
-
-// Class used to hold a record of a single image
-// Used when building a list of recorded images
-class historicImage
-{
-public:
-    historicImage( QByteArray image, unsigned long dataSize, QCaAlarmInfo& alarmInfo, QCaDateTime& time );
-    ~historicImage(){}
-
-    QByteArray image;
-    unsigned long dataSize;
-    QCaAlarmInfo alarmInfo;
-    QCaDateTime time;
-};
+#include <recordingStore.h>
 
 namespace Ui {
     class recording;
@@ -77,7 +64,8 @@ public:
     ~recording();
 
     bool isRecording();             // Determine if in playback or record mode
-    void recordImage( QByteArray image, unsigned long dataSize, QCaAlarmInfo& alarmInfo, QCaDateTime& time );  // Save a new image
+    void recordImage( QByteArray image, unsigned long dataSize, QCaAlarmInfo& alarmInfo, QCaDateTime& time,
+                      unsigned long width, unsigned long height, imageDataFormats::formatOptions format, unsigned int bitDepth );  // Save a new image
 
     void nextFrameDue();             // Present the next frame due when playing back (public so accessible by playback timer class)
 
@@ -89,7 +77,8 @@ private:
 
     playbackTimer* timer;           // Playback timer
     Ui::recording *ui;              // Recording and playback controls
-    QList<historicImage> history;   // Saved images
+    recordingStore store;           // Saved images (held in a ring file, not in memory)
+    int awaitedFrame;               // Frame to show once it has been stored (-1 if none)
 
     // Icons
     QIcon* pauseIcon;
@@ -99,10 +88,12 @@ private:
 
 
 signals:
-  void byteArrayChanged( const QByteArray& value, unsigned long dataSize, QCaAlarmInfo& alarmInfo, QCaDateTime& timeStamp, const unsigned int& variableIndex );
+  void recordedImageChanged( const QByteArray& image, recordedImageInfo& info );
   void playingBack( bool playing );
 
 private slots:
+    void imageStored();
+
     void on_pushButtonPlay_toggled(bool checked);
     void on_pushButtonRecord_toggled(bool checked);
     void on_pushButtonClear_clicked();
@@ -113,6 +104,8 @@ private slots:
     void on_pushButtonPreviousImage_clicked();
     void on_horizontalSliderPosition_valueChanged(int value);
     void on_radioButtonLive_toggled(bool checked);
+    void on_spinBoxMaxImages_valueChanged(int value);
+    void on_checkBoxCompress_toggled(bool checked);
 };
 
 #endif // RECORDING_H
@@ -0,0 +1,464 @@
+/*
+ *  This file is part of the EPICS QT Framework, initially developed at the Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+
+/*
+ This class manages storage of recorded images for the QEImage widget's recorder.
+
+ Images used to be held in memory, so a few hundred large images could consume
+ gigabytes. Images are now written to a temporary file used as a ring buffer.
+ Only a small index of the images (location and metadata) is held in memory.
+
+ The file is created (and memory mapped if possible) when the first image is
+ stored and is sized to hold the maximum number of images allowed. When full,
+ new images overwrite the oldest. If the limit is raised, or a larger image
+ arrives, the file is grown. Images already recorded are kept.
+
+ Images are queued by addImage() and are written by a dedicated thread so the
+ GUI thread does not wait for the disk. If images arrive faster than they
+ can be written, the excess is dropped rather than allowed to accumulate in memory.
+ Queued images share the received image data (no copy is made).
+ The storing thread reserves space for an image in the ring file, then writes it
+ without holding the lock used by addImage() and count(), then adds it to the index.
+
+ Images may optionally be compressed. Each data element is replaced by its
+ difference from the previous element (byte by byte, so the encoding is lossless
+ for any element size) then compressed with Qt's zlib compression at its fastest
+ level. Smooth images such as camera images typically compress well this way.
+
+ Images are read back by index (random access) for playback. Only images already
+ stored can be read back. imageStored() is emitted as each image is stored.
+*/
+
+#include "recordingStore.h"
+#include <QDir>
+#include <QDebug>
+
+// Maximum size of the ring file
+#define MAX_RECORDING_FILE_SIZE ((qint64)(4)*1024*1024*1024)
+
+// Maximum number of images waiting to be written to the ring file
+#define MAX_PENDING_IMAGES 16
+
+// Construct index entry
+recordedImageInfo::recordedImageInfo()
+{
+    offset = 0;
+    length = 0;
+    compressed = false;
+    rawSize = 0;
+    dataSize = 1;
+    width = 0;
+    height = 0;
+    format = imageDataFormats::MONO;
+    bitDepth = 8;
+}
+
+// Construction
+recordingStore::recordingStore()
+{
+    finishNow = false;
+    generation = 0;
+    limit = 20;
+    compress = false;
+    dropped = 0;
+    map = NULL;
+    capacity = 0;
+    maxCapacity = MAX_RECORDING_FILE_SIZE;
+    writePos = 0;
+    writing = false;
+
+    file.setFileTemplate( QDir::tempPath().append( "/QEImageRecording_XXXXXX" ) );
+
+    // Start the thread that writes images to the ring file
+    start();
+}
+
+// Destruction
+recordingStore::~recordingStore()
+{
+    // Ask the storing thread to exit and wait for it
+    {
+        QMutexLocker locker( &lock );
+        finishNow = true;
+        pending.clear();
+        imageQueued.wakeOne();
+    }
+    wait();
+
+    // Release the ring file (it is removed when closed)
+    releaseFile();
+}
+
+// Set the maximum number of images held
+void recordingStore::setLimit( int limitIn )
+{
+    QMutexLocker locker( &lock );
+
+    // Nothing to do if no change
+    if( limit == limitIn )
+    {
+        return;
+    }
+    limit = limitIn;
+
+    // Discard the oldest images if now over the limit
+    while( index.count() > limit )
+    {
+        index.removeFirst();
+    }
+
+    // If there are no images in the ring file, release it so it is recreated when next needed, sized for the new limit.
+    // (If there are images, the file is grown as required when the next image is stored)
+    if( index.isEmpty() && capacity && !writing )
+    {
+        releaseFile();
+    }
+}
+
+// Set if images are compressed when stored
+void recordingStore::setCompression( bool compressIn )
+{
+    QMutexLocker locker( &lock );
+    compress = compressIn;
+}
+
+// Queue an image to be stored
+void recordingStore::addImage( QByteArray image, recordedImageInfo& info )
+{
+    QMutexLocker locker( &lock );
+
+    // If the storing thread is falling behind, drop the image
+    if( pending.count() >= MAX_PENDING_IMAGES )
+    {
+        dropped++;
+        return;
+    }
+
+    // Queue the image and wake the storing thread
+    pending.append( pendingImage( image, info ) );
+    imageQueued.wakeOne();
+}
+
+// Return the number of images held (including those queued for storing)
+int recordingStore::count()
+{
+    QMutexLocker locker( &lock );
+    return qMin( index.count() + pending.count(), limit );
+}
+
+// Return the number of images discarded as they arrived faster than they could be stored
+unsigned long recordingStore::getDroppedCount()
+{
+    QMutexLocker locker( &lock );
+    return dropped;
+}
+
+// Discard all images
+void recordingStore::clear()
+{
+    QMutexLocker locker( &lock );
+    pending.clear();
+    index.clear();
+    writePos = 0;
+    dropped = 0;
+    generation++;
+}
+
+// Read back a stored image.
+// Images still queued for storing are not available yet (imageStored() is emitted as each image is stored).
+// This does not wait for queued images to be stored. At most it waits for an image
+// currently being written to the ring file.
+// Return true if the image was available.
+bool recordingStore::getImage( int i, QByteArray& image, recordedImageInfo& info )
+{
+    QMutexLocker locker( &lock );
+
+    // Do nothing if no such image (or if not stored yet)
+    if( i < 0 || i >= index.count() )
+    {
+        return false;
+    }
+    info = index.at( i );
+
+    // Take the file lock before releasing the main lock so the space holding the image
+    // can't be reserved for a new image (and overwritten) while it is being read.
+    QMutexLocker fileLocker( &fileLock );
+    locker.unlock();
+
+    // Read the stored image
+    QByteArray stored( (int)(info.length), '\0' );
+    if( map )
+    {
+        memcpy( stored.data(), map + info.offset, info.length );
+    }
+    else
+    {
+        file.seek( info.offset );
+        file.read( stored.data(), info.length );
+    }
+    fileLocker.unlock();
+
+    // Decode the image if required
+    if( info.compressed )
+    {
+        image = decode( stored, info.dataSize, info.rawSize );
+    }
+    else
+    {
+        image = stored;
+    }
+    return !image.isEmpty() || info.rawSize == 0;
+}
+
+// Storing thread.
+// Encode and store images as they are queued.
+void recordingStore::run()
+{
+    while( true )
+    {
+        // Wait for an image
+        QMutexLocker locker( &lock );
+        while( pending.isEmpty() && !finishNow )
+        {
+            imageQueued.wait( &lock );
+        }
+        if( finishNow )
+        {
+            return;
+        }
+        pendingImage next = pending.first();
+        bool compressing = compress;
+        unsigned long startGeneration = generation;
+        locker.unlock();
+
+        // Encode the image (without holding the lock)
+        QByteArray stored;
+        next.info.rawSize = next.image.size();
+        next.info.compressed = false;
+        if( compressing )
+        {
+            stored = encode( next.image, next.info.dataSize, next.info.compressed );
+        }
+        else
+        {
+            stored = next.image;
+        }
+
+        // Store the image (unless the images were cleared while encoding)
+        locker.relock();
+        if( generation == startGeneration && !pending.isEmpty() )
+        {
+            pending.removeFirst();
+            storeImage( stored, next.info, locker );
+        }
+    }
+}
+
+// Ensure the ring file exists and can hold the maximum number of images of the given length (within a limit).
+// If the file is present but too small (the limit has been raised, or the image is larger than
+// earlier images) the file is grown. Images already in the file are kept.
+// Must be called with the lock held.
+bool recordingStore::prepareFile( qint64 imageLength )
+{
+    // Determine the file size required
+    qint64 size = qMin( imageLength * limit, maxCapacity );
+    size = qMax( size, imageLength );
+
+    // Nothing to do if ring file is present and large enough
+    if( capacity >= size )
+    {
+        return true;
+    }
+
+    // Create the ring file, or grow it.
+    // (Resizing a file keeps its content, so images already stored remain where they are.
+    //  The extra space is used before the ring wraps to the start again)
+    QMutexLocker fileLocker( &fileLock );
+    if( map )
+    {
+        file.unmap( map );
+        map = NULL;
+    }
+    if( ( file.isOpen() || file.open() ) && file.resize( size ) )
+    {
+        capacity = size;
+    }
+    else
+    {
+        // Keep any existing file, and don't try to grow it again
+        qDebug() << "Error, recordingStore::prepareFile() could not size the recording file to" << size << "bytes. Recording file size is" << capacity << "bytes";
+        maxCapacity = capacity;
+    }
+
+    // Map the file if possible
+    if( capacity )
+    {
+        map = file.map( 0, capacity );
+    }
+
+    return imageLength <= capacity;
+}
+
+// Release the ring file (it is removed when closed).
+// Must not be called while an image is being written.
+void recordingStore::releaseFile()
+{
+    QMutexLocker fileLocker( &fileLock );
+    if( map )
+    {
+        file.unmap( map );
+        map = NULL;
+    }
+    file.close();
+    capacity = 0;
+    maxCapacity = MAX_RECORDING_FILE_SIZE;
+    writePos = 0;
+}
+
+// Write an encoded image into the ring file and add it to the index.
+// Must be called with the lock held (through the locker provided).
+// The lock is released while the image is written, so the GUI thread can continue
+// to queue images and count them.
+void recordingStore::storeImage( QByteArray& stored, recordedImageInfo& info, QMutexLocker& locker )
+{
+    // Ensure the ring file is present and large enough.
+    // (Size it for uncompressed images so it is not grown if later images compress less well)
+    qint64 length = stored.size();
+    if( !prepareFile( qMax( length, (qint64)(info.rawSize) ) ) )
+    {
+        dropped++;
+        return;
+    }
+
+    // Wrap to the start of the ring file if the image will not fit at the end
+    if( writePos + length > capacity )
+    {
+        writePos = 0;
+    }
+
+    // Discard any images that will be overwritten, and the oldest images if at the limit
+    for( int i = index.count()-1; i >= 0; i-- )
+    {
+        const recordedImageInfo& old = index.at( i );
+        if( old.offset < writePos + length && old.offset + old.length > writePos )
+        {
+            index.removeAt( i );
+        }
+    }
+    while( index.count() >= limit && !index.isEmpty() )
+    {
+        index.removeFirst();
+    }
+
+    // Reserve the space for the image
+    info.offset = writePos;
+    info.length = length;
+    writePos += length;
+    writing = true;
+    unsigned long startGeneration = generation;
+
+    // Write the image without holding the lock
+    locker.unlock();
+    {
+        QMutexLocker fileLocker( &fileLock );
+        if( map )
+        {
+            memcpy( map + info.offset, stored.constData(), length );
+        }
+        else
+        {
+            file.seek( info.offset );
+            file.write( stored.constData(), length );
+        }
+    }
+    locker.relock();
+    writing = false;
+
+    // Add the image to the index (unless the images were cleared while writing).
+    // Also ensure the limit is still respected in case it was lowered while writing.
+    if( generation == startGeneration )
+    {
+        index.append( info );
+        while( index.count() > limit )
+        {
+            index.removeFirst();
+        }
+    }
+
+    // Let the recorder know the image can be read back
+    emit imageStored();
+}
+
+// Delta encode and compress an image.
+// If compression does not reduce the size, the image is returned unchanged and 'compressed' is set false.
+QByteArray recordingStore::encode( const QByteArray& image, unsigned long dataSize, bool& compressed )
+{
+    // Replace each byte with its difference from the same byte of the previous element
+    int stride = (int)( dataSize ? dataSize : 1 );
+    int size = image.size();
+    QByteArray delta( size, '\0' );
+    const unsigned char* in = (const unsigned char*)(image.constData());
+    unsigned char* out = (unsigned char*)(delta.data());
+    for( int i = 0; i < size && i < stride; i++ )
+    {
+        out[i] = in[i];
+    }
+    for( int i = stride; i < size; i++ )
+    {
+        out[i] = (unsigned char)(in[i] - in[i-stride]);
+    }
+
+    // Compress at the fastest level
+    QByteArray packed = qCompress( delta, 1 );
+
+    // Use the compressed image only if smaller
+    if( packed.size() < size )
+    {
+        compressed = true;
+        return packed;
+    }
+    compressed = false;
+    return image;
+}
+
+// Reverse encode()
+QByteArray recordingStore::decode( const QByteArray& stored, unsigned long dataSize, unsigned long rawSize )
+{
+    QByteArray image = qUncompress( stored );
+    if( (unsigned long)(image.size()) != rawSize )
+    {
+        return QByteArray();
+    }
+
+    // Restore each byte by adding the same byte of the previous (restored) element
+    int stride = (int)( dataSize ? dataSize : 1 );
+    int size = image.size();
+    unsigned char* data = (unsigned char*)(image.data());
+    for( int i = stride; i < size; i++ )
+    {
+        data[i] = (unsigned char)(data[i] + data[i-stride]);
+    }
+    return image;
+}
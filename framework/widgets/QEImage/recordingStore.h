@@ -0,0 +1,125 @@
+/*
+ *  This file is part of the EPICS QT Framework, initially developed at the Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+
+/*
+ This class manages storage of recorded images for the QEImage widget's recorder.
+ Refer to recordingStore.cpp for details.
+ */
+
+#ifndef RECORDINGSTORE_H
+#define RECORDINGSTORE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include <QByteArray>
+#include <QTemporaryFile>
+#include <QCaAlarmInfo.h>
+#include <QCaDateTime.h>
+#include <imageDataFormats.h>
+
+// Class used to hold the index entry (location and metadata) of a single recorded image
+class recordedImageInfo
+{
+public:
+    recordedImageInfo();
+    ~recordedImageInfo(){}
+
+    // Location in the recording file
+    qint64 offset;                              // Offset of the stored image in the recording file
+    qint64 length;                              // Length of the stored image in the recording file
+    bool compressed;                            // True if the stored image is compressed
+    unsigned long rawSize;                      // Size of the image before compression
+
+    // Metadata
+    unsigned long dataSize;                     // Size of each data element
+    QCaAlarmInfo alarmInfo;                     // Alarm state of the image
+    QCaDateTime time;                           // Timestamp of the image
+    unsigned long width;                        // Image width when recorded
+    unsigned long height;                       // Image height when recorded
+    imageDataFormats::formatOptions format;     // Image format when recorded
+    unsigned int bitDepth;                      // Image bit depth when recorded
+};
+
+// Class used to store recorded images in a ring file
+class recordingStore : public QThread
+{
+    Q_OBJECT
+public:
+    recordingStore();
+    ~recordingStore();
+
+    void setLimit( int limitIn );               // Set the maximum number of images held
+    void setCompression( bool compressIn );     // Set if images are compressed when stored
+    void addImage( QByteArray image, recordedImageInfo& info ); // Queue an image to be stored
+    int count();                                // Return the number of images held (including those queued for storing)
+    bool getImage( int index, QByteArray& image, recordedImageInfo& info ); // Read back a stored image. Returns false if not stored (yet)
+    void clear();                               // Discard all images
+    unsigned long getDroppedCount();            // Return the number of images discarded as they arrived faster than they could be stored
+
+signals:
+    void imageStored();                         // An image has been stored (and can be read back). Emitted from the storing thread
+
+protected:
+    void run();
+
+private:
+    // Image waiting to be stored
+    class pendingImage
+    {
+    public:
+        pendingImage( QByteArray imageIn, recordedImageInfo& infoIn ){ image = imageIn; info = infoIn; }
+        QByteArray image;
+        recordedImageInfo info;
+    };
+
+    bool prepareFile( qint64 imageLength );             // Ensure the ring file exists and can hold the maximum number of images of the given length
+    void releaseFile();                                 // Release the ring file
+    void storeImage( QByteArray& stored, recordedImageInfo& info, QMutexLocker& locker ); // Write an encoded image into the ring file and add it to the index
+    static QByteArray encode( const QByteArray& image, unsigned long dataSize, bool& compressed ); // Delta encode and compress an image
+    static QByteArray decode( const QByteArray& stored, unsigned long dataSize, unsigned long rawSize ); // Reverse encode()
+
+    QMutex lock;                        // Protects everything below. Not held while the ring file is written
+    QMutex fileLock;                    // Held while reading or writing the ring file, or while changing its size or mapping. (If both locks are required, take 'lock' first)
+    QWaitCondition imageQueued;         // Signaled when an image is queued, or when finishing
+    bool finishNow;                     // Set to ask the storing thread to exit
+    unsigned long generation;           // Incremented when images are cleared (so an image being encoded while clearing is not stored)
+
+    QList<pendingImage> pending;        // Images waiting to be stored
+    QList<recordedImageInfo> index;     // Stored images, oldest first
+    int limit;                          // Maximum number of images held
+    bool compress;                      // True if images are compressed when stored
+    unsigned long dropped;              // Number of images discarded as they arrived faster than they could be stored
+
+    QTemporaryFile file;                // Ring file
+    uchar* map;                         // Memory mapping of the ring file (NULL if mapping is not available, in which case the file is read and written directly)
+    qint64 capacity;                    // Size of the ring file
+    qint64 maxCapacity;                 // Largest ring file allowed (reduced if the file could not be grown)
+    qint64 writePos;                    // Offset in the ring file where the next image will be written
+    bool writing;                       // True while an image is being written (the ring file must not be released)
+};
+
+#endif // RECORDINGSTORE_H
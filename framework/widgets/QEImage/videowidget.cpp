@@ -25,18 +25,44 @@
 /*
  This class manages the low level presentation of images in a display widget and user interact with the image.
  The image is delivered as a QImage ready for display. There is no need to flip, rotate, clip, etc.
- This class manages zooming the image simply by setting the widget size as required and drawing into it. Qt then performs the scaling required.
+ This class manages zooming the image simply by setting the widget size as required and drawing into it.
+ Refer to videowidget.h for how painting is limited to the damaged region of the widget.
  */
 
 #include "videowidget.h"
 #include <QPainter>
+#include <QElapsedTimer>
+#include <math.h>
 
 #define PANNING_CURSOR Qt::CrossCursor
 
+// Return the rectangles making up a region
+static QVector<QRect> regionRects( const QRegion& region )
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    QVector<QRect> rects;
+    for( QRegion::const_iterator it = region.begin(); it != region.end(); ++it )
+    {
+        rects.append( *it );
+    }
+    return rects;
+#else
+    return region.rects();
+#endif
+}
+
 VideoWidget::VideoWidget(QWidget *parent) : QWidget(parent)
 {
     panning = false;
 
+    refImageValid = false;
+    mipKey = 0;
+
+    newImagePending = false;
+    framesPainted = 0;
+    lastPaintTime = 0.0;
+    lastLatency = 0.0;
+
     setAutoFillBackground(false);
 
     QPalette palette = this->palette();
@@ -61,24 +87,164 @@ void VideoWidget::markupSetCursor( QCursor cursor )
     setCursor( cursor );
 }
 
-// Ensure we have a reference image and it is the same size as the display
-// Returns true if a new reference image was created
-// Returns false if no new image was required.
-bool VideoWidget::createRefImage()
+// Return true if the latest camera image is larger than the display.
+// When zoomed out the image is drawn from a reference image at display resolution,
+// otherwise it is drawn directly from the latest camera image.
+bool VideoWidget::isZoomedOut()
 {
-    if( refImage.isNull() || refImage.size() != size() )
+    return !currentImage.isNull() &&
+           ( currentImage.width() > width() || currentImage.height() > height() );
+}
+
+// Return the smallest mip level of the latest camera image that is at least the size given.
+// Mip levels are built on demand and kept until a new image arrives, so zooming between
+// levels does not rescale the full image again.
+const QImage& VideoWidget::getMipLevel( const QSize& minSize )
+{
+    // Discard the mip levels if they were built from a previous image
+    if( mipKey != currentImage.cacheKey() )
     {
-        refImage = QImage( size(), QImage::Format_RGB32 );
-        return true;
+        mipLevels.clear();
+        mipKey = currentImage.cacheKey();
+    }
+
+    // Step down through the levels, building any not built yet, until the next level would be too small
+    const QImage* level = &currentImage;
+    for( int i = 0; ; i++ )
+    {
+        QSize halfSize( level->width() / 2, level->height() / 2 );
+        if( halfSize.width() < minSize.width() || halfSize.height() < minSize.height() || halfSize.isEmpty() )
+        {
+            return *level;
+        }
+
+        if( i == mipLevels.count() )
+        {
+            mipLevels.append( level->scaled( halfSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation ) );
+        }
+        level = &mipLevels[i];
+    }
+}
+
+// Build the reference image at display resolution from the most suitable mip level.
+// Only the final (less than 2:1) reduction is done here, so this costs at most a few
+// times the display size, no matter how large the camera image.
+void VideoWidget::buildRefImage()
+{
+    const QImage& level = getMipLevel( size() );
+    if( level.size() == size() )
+    {
+        // (cheap - creates a shallow copy)
+        refImage = level;
     }
     else
     {
-        return false;
+        refImage = level.scaled( size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+    }
+    refImageValid = true;
+}
+
+// Return the latest image at the same resolution as the display
+QImage VideoWidget::getImage()
+{
+    if( currentImage.isNull() )
+    {
+        return QImage();
+    }
+
+    if( isZoomedOut() )
+    {
+        if( !refImageValid || refImage.size() != size() )
+        {
+            buildRefImage();
+        }
+        return refImage;
+    }
+
+    if( currentImage.size() == size() )
+    {
+        return currentImage;
+    }
+    return currentImage.scaled( size() );
+}
+
+// Draw part of the latest camera image at the current zoom.
+// When zoomed in the part of the image under the area is scaled directly, so the cost depends only on the area drawn.
+// The whole source pixels covering the area are drawn, so each source pixel always lands on the same
+// display pixels no matter how the damaged region is divided up. The painter clips to the damaged region.
+void VideoWidget::drawImageRegion( QPainter& painter, const QRect& r )
+{
+    // When zoomed out, draw from the reference image which is already at display resolution
+    if( isZoomedOut() )
+    {
+        painter.drawImage( r, refImage, r );
+        return;
+    }
+
+    // When the display is the same size as the image, there is no scaling to do
+    if( currentImage.size() == size() )
+    {
+        painter.drawImage( r, currentImage, r );
+        return;
+    }
+
+    // Determine the source pixels covering the area
+    double sx = (double)currentImage.width() / (double)width();
+    double sy = (double)currentImage.height() / (double)height();
+
+    int left   = (int)floor( r.left() * sx );
+    int top    = (int)floor( r.top() * sy );
+    int right  = (int)ceil( (r.right() + 1) * sx );
+    int bottom = (int)ceil( (r.bottom() + 1) * sy );
+    QRect source = QRect( left, top, right - left, bottom - top ).intersected( currentImage.rect() );
+
+    // Draw the source pixels at the display position they map to
+    QRectF target( source.left() / sx, source.top() / sy, source.width() / sx, source.height() / sy );
+    painter.drawImage( target, currentImage, source );
+}
+
+// Ensure the markup layer covers an area (usually the visible part of the widget)
+// and redraw any parts of it that markups have changed since it was last used.
+void VideoWidget::updateMarkupLayer( const QRect& area )
+{
+    // If the layer does not cover the area, recreate it to cover the visible part of the widget.
+    // (If zoomed in, this only happens when panning exposes part of the image not drawn recently)
+    if( markupLayer.isNull() || !QRect( markupLayerOrigin, markupLayer.size() ).contains( area ) )
+    {
+        QRect layerRect = visibleRegion().boundingRect().united( area );
+        markupLayer = QImage( layerRect.size(), QImage::Format_ARGB32_Premultiplied );
+        markupLayerOrigin = layerRect.topLeft();
+        markupLayerDirty = QRegion( layerRect );
+    }
+
+    // Do nothing if the layer is up to date
+    QRect layerRect( markupLayerOrigin, markupLayer.size() );
+    QRegion dirty = markupLayerDirty.intersected( layerRect );
+    markupLayerDirty = QRegion();
+    if( dirty.isEmpty() )
+    {
+        return;
+    }
+
+    // Redraw the markups in each changed part of the layer
+    QPainter layerPainter( &markupLayer );
+    layerPainter.translate( -markupLayerOrigin );
+    QVector<QRect> rects = regionRects( dirty );
+    for( int i = 0; i < rects.count(); i++ )
+    {
+        layerPainter.setClipRect( rects[i] );
+        layerPainter.setCompositionMode( QPainter::CompositionMode_Source );
+        layerPainter.fillRect( rects[i], Qt::transparent );
+        layerPainter.setCompositionMode( QPainter::CompositionMode_SourceOver );
+        drawMarkups( layerPainter, rects[i] );
     }
 }
 
 // The displayed image has changed, redraw it
-void VideoWidget::setNewImage( QImage image, QCaDateTime& time )
+// If the image was built at a reduced resolution for display, the full resolution
+// image size is also supplied. All markup and pixel positions refer to the full
+// resolution image.
+void VideoWidget::setNewImage( QImage image, QCaDateTime& time, QSize fullImageSize )
 {
     // Note if this is the first image update
     bool firstImage = currentImage.isNull();
@@ -86,31 +252,19 @@ void VideoWidget::setNewImage( QImage image, QCaDateTime& time )
     // Take a copy of the current image
     // (cheap - creates a shallow copy)
     currentImage = image;
+    currentImageSize = fullImageSize.isValid() ? fullImageSize : image.size();
 
-    // Create a reference image the same as the display
-    // This is cheap if the display is the same size as the image - a shallow copy is done.
-    // It is more expensive if different sizes as a scaled version is created.
-    if( image.size() == size() )
-    {
-        // Use the input image as the reference image
-        // (cheap - creates a shallow copy)
-        refImage = image;
-    }
-    else
-    {
-        // Ensure we have a reference image and it is the correct size
-        createRefImage();
-
-        // Draw the scaled image into the reference image
-        QPainter refPainter( &refImage );
-        refPainter.drawImage( refImage.rect(), image, image.rect() );
-    }
+    // The reference image (if used) is now out of date.
+    // It is rebuilt when next painted, so images that arrive faster than they can be painted are never scaled.
+    refImageValid = false;
 
-    // Note the time for markups
+    // Note the time for markups, and for latency statistics when the image is painted
     setMarkupTime( time );
+    currentImageTime = time;
+    newImagePending = true;
 
     // Ensure the markup system is aware of the image size
-    setImageSize( currentImage.size() );
+    setImageSize( currentImageSize );
 
     // Ensure the markup scaling is correct.
     // The scaling is set up on the first image (here), and each resize (in the resize event)
@@ -126,6 +280,7 @@ void VideoWidget::setNewImage( QImage image, QCaDateTime& time )
 // The markups have changed redraw them all
 void VideoWidget::markupChange()
 {
+    markupLayer = QImage();
     QVector<QRect> areas;
     areas.append( QRect( 0, 0, width(), height() ));
     markupChange( areas );
@@ -134,6 +289,12 @@ void VideoWidget::markupChange()
 // The markups have changed redraw the required parts
 void VideoWidget::markupChange( QVector<QRect>& changedAreas )
 {
+    // Note the parts of the cached markup layer that must be redrawn
+    for( int i = 0; i < changedAreas.count(); i++ )
+    {
+        markupLayerDirty += changedAreas[i];
+    }
+
     // Start accumulating the changed areas
     QRect nextRect = changedAreas[0];
 
@@ -171,33 +332,105 @@ void VideoWidget::markupChange( QVector<QRect>& changedAreas )
 // Manage a paint event in the video widget
 void VideoWidget::paintEvent(QPaintEvent* event )
 {
-    // Ensure there is a reference image.
-    // If this creates one then there has never been an update yet, fill it with black. This is likely
+    // Time the paint for pipeline statistics
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+
+    // Build a painter and only bother about the changed region
+    QPainter painter(this);
+    painter.setClipRegion( event->region() );
+    QVector<QRect> rects = regionRects( event->region() );
+
+    // If there has never been an update yet, fill with black. This is likely
     // to be the first paint event occuring at creation before an image update has arrived.
-    if( createRefImage() )
+    if( currentImage.isNull() )
     {
-        QPainter refPainter( &refImage );
         QColor bg(0, 0, 0, 255);
-        refPainter.fillRect(rect(), bg);
+        for( int i = 0; i < rects.count(); i++ )
+        {
+            painter.fillRect( rects[i], bg );
+        }
     }
+    else
+    {
+        // If zoomed out, ensure the reference image is up to date
+        if( isZoomedOut() && ( !refImageValid || refImage.size() != size() ) )
+        {
+            buildRefImage();
+        }
 
-    // Build a painter and only bother about the changed area
-    QPainter painter(this);
-    painter.setClipRect( event->rect() );
+        // Update the display with the image
+        for( int i = 0; i < rects.count(); i++ )
+        {
+            drawImageRegion( painter, rects[i] );
+        }
 
-    // Update the display with the reference image.
-    painter.drawImage( event->rect(), refImage, event->rect() );
+        // Composite any markups from the cached markup layer
+        if( anyVisibleMarkups() )
+        {
+            updateMarkupLayer( event->rect() );
+            for( int i = 0; i < rects.count(); i++ )
+            {
+                painter.drawImage( rects[i], markupLayer, rects[i].translated( -markupLayerOrigin ) );
+            }
+        }
+    }
 
-    // Update any markups
-    if( !currentImage.isNull() )
+    // Add the performance overlay if required
+    if( !overlayText.isEmpty() )
+    {
+        QRect textRect = painter.boundingRect( QRect( 0, 0, width(), height() ), Qt::AlignLeft | Qt::AlignTop, overlayText );
+        textRect.adjust( -2, -2, 2, 2 );
+        textRect.moveTo( 0, 0 );
+        painter.fillRect( textRect, QColor( 0, 0, 0, 160 ) );
+        painter.setPen( Qt::yellow );
+        painter.drawText( textRect.adjusted( 2, 2, -2, -2 ), Qt::AlignLeft | Qt::AlignTop, overlayText );
+    }
+
+    // Update pipeline statistics if this paint presented a new image
+    if( newImagePending && !currentImage.isNull() )
     {
-        drawMarkups( painter, event->rect() );
+        newImagePending = false;
+        framesPainted++;
+        lastPaintTime = (double)(paintTimer.nsecsElapsed()) / 1000000.0;
+        lastLatency = (double)(currentImageTime.msecsTo( QDateTime::currentDateTime() ));
     }
 
     // Report position for pixel info logging
     emit currentPixelInfo( pixelInfoPos );
 }
 
+// Set the text presented over the top left corner of the image (or clear it if the text is empty)
+void VideoWidget::setOverlayText( const QString& text )
+{
+    if( text == overlayText )
+    {
+        return;
+    }
+
+    // Redraw both the area of the old text and the area of the new text
+    QFontMetrics fm( font() );
+    QRect oldRect = fm.boundingRect( QRect( 0, 0, width(), height() ), Qt::AlignLeft | Qt::AlignTop, overlayText ).adjusted( -2, -2, 4, 4 );
+    overlayText = text;
+    QRect newRect = fm.boundingRect( QRect( 0, 0, width(), height() ), Qt::AlignLeft | Qt::AlignTop, overlayText ).adjusted( -2, -2, 4, 4 );
+    update( oldRect.united( newRect ) );
+}
+
+// Return the number of new images painted, the time taken to paint the last new image (mS),
+// and the latency from the last image timestamp to it being painted (mS)
+void VideoWidget::getPaintStatistics( unsigned long& framesPaintedOut, double& paintTimeOut, double& latencyOut )
+{
+    framesPaintedOut = framesPainted;
+    paintTimeOut = lastPaintTime;
+    latencyOut = lastLatency;
+}
+
+// Reset the number of new images painted
+void VideoWidget::resetPaintStatistics()
+{
+    framesPainted = 0;
+}
+
 // Manage a resize event
 void VideoWidget::resizeEvent( QResizeEvent *event )
 {
@@ -207,7 +440,12 @@ void VideoWidget::resizeEvent( QResizeEvent *event )
         return;
     }
 
+    // The reference image and markup layer no longer match the display
+    refImageValid = false;
+    markupLayer = QImage();
+
     // If there is a current image, redraw it and recalculate the markup dimensions
+    // (Until the image is rebuilt at the new size, the latest image is painted at the new zoom from the mip level cache)
     if( !currentImage.isNull() )
     {
         emit redraw();
@@ -272,21 +510,21 @@ int VideoWidget::scaleImageOrdinate( int ord )
     return (int)((double)ord * getScale());
 }
 
-// Return the displayed size of the current image
+// Return the full resolution size of the current image
 QSize VideoWidget::getImageSize()
 {
-    return currentImage.size();
+    return currentImageSize;
 }
 
 // Return the scale of the displayed image
 double VideoWidget::getScale()
 {
     // If for any reason a scale can't be determined, return scale of 1.0
-    if( currentImage.isNull() || currentImage.width() == 0 || width() == 0)
+    if( currentImage.isNull() || currentImageSize.width() == 0 || width() == 0)
         return 1.0;
 
-    // Return the horizontal scale of the displayed image
-    return (double)width() / (double)currentImage.width();
+    // Return the horizontal scale of the displayed image (relative to the full resolution image)
+    return (double)width() / (double)currentImageSize.width();
 }
 
 // The mouse has been pressed over the image
@@ -25,13 +25,22 @@
 /*
  This class manages the low level presentation of images in a display widget and user interact with the image.
  The image is delivered as a QImage ready for display. There is no need to flip, rotate, clip, etc.
- This class manages zooming the image simply by setting the widget size as required and drawing into it. Qt then performs the scaling required.
+ This class manages zooming the image simply by setting the widget size as required and drawing into it.
+
+ Painting is limited to the damaged region of the widget:
+    - When zoomed in (or at 100%) only the part of the latest image under the damaged region is scaled and drawn.
+      A large zoomed image is never rasterised in full, so panning only draws the newly exposed strips.
+    - When zoomed out the image is drawn from a reference image at display resolution. This is built from a cache of
+      successively halved versions of the latest image (mip levels), so changing the zoom does not rescale the full image.
+    - Markups are drawn into a cached transparent layer covering the visible part of the widget. The layer is only redrawn
+      where markups change, and is composited over each new image.
  */
 
 #ifndef VIDEOWIDGET_H
 #define VIDEOWIDGET_H
 
 #include <QWidget>
+#include <QRegion>
 #include <imageMarkup.h>
 
 class VideoWidget : public QWidget, public imageMarkup
@@ -41,7 +50,7 @@ public:
     VideoWidget(QWidget *parent = 0);
     ~VideoWidget();
 
-    void setNewImage( QImage image, QCaDateTime& time );
+    void setNewImage( QImage image, QCaDateTime& time, QSize fullImageSize = QSize() );
     void setPanning( bool panningIn );
     bool getPanning();
     QPoint scalePoint( QPoint pnt );
@@ -52,12 +61,16 @@ public:
 
     int scaleImageOrdinate( int ord );
 
-    QImage getImage(){ return refImage; }
+    QImage getImage();                                      // Return the latest image at the same resolution as the display
     QSize getImageSize();
     bool hasCurrentImage(){ return !currentImage.isNull(); }                 // Return true if displaying an image
 
     void markupChange();                                    // The markup overlay has changed, redraw them all
 
+    void setOverlayText( const QString& text );             // Set text to be presented over the top left corner of the image (empty for none)
+    void getPaintStatistics( unsigned long& framesPaintedOut, double& paintTimeOut, double& latencyOut ); // Return the number of new images painted, the last paint time and the last image latency (mS)
+    void resetPaintStatistics();                            // Reset the number of new images painted
+
 protected:
     void paintEvent(QPaintEvent*);
 
@@ -86,8 +99,22 @@ private:
     void addMarkups( QPainter& screenPainter, QVector<QRect>& changedAreas );
 
     QImage currentImage;              // Latest camera image
-    QImage refImage;                  // Latest camera image at the same resolution as the display - used for erasing markups when they are moved
-    bool createRefImage();
+    QSize currentImageSize;           // Full resolution size of the latest camera image (the image itself may have been built at a lower resolution for display)
+    QImage refImage;                  // Latest camera image at the same resolution as the display (only used when zoomed out)
+    bool refImageValid;               // True if the reference image matches the latest camera image and the display size
+    bool isZoomedOut();               // Return true if the latest camera image is larger than the display
+    void buildRefImage();             // Build the reference image from the most suitable mip level
+
+    QVector<QImage> mipLevels;        // Latest camera image successively halved. Built on demand when zoomed out
+    qint64 mipKey;                    // Cache key of the camera image the mip levels were built from
+    const QImage& getMipLevel( const QSize& minSize ); // Return the smallest mip level at least the size given
+
+    void drawImageRegion( QPainter& painter, const QRect& r ); // Draw part of the latest camera image at the current zoom
+
+    QImage markupLayer;               // Markups drawn over a transparent background, covering the visible part of the widget
+    QPoint markupLayerOrigin;         // Position of the markup layer in the widget
+    QRegion markupLayerDirty;         // Parts of the markup layer to be redrawn before it is next used
+    void updateMarkupLayer( const QRect& area ); // Ensure the markup layer covers an area and is up to date
 
     double getScale();
 
@@ -95,6 +122,14 @@ private:
     QPoint panStart;
 
     QPoint pixelInfoPos;    // Current pixel under pointer
+
+    // Pipeline statistics and overlay
+    QString overlayText;            // Text presented over the top left corner of the image (empty for none)
+    QCaDateTime currentImageTime;   // Timestamp of the latest camera image
+    bool newImagePending;           // True if the latest camera image has not been painted yet
+    unsigned long framesPainted;    // Number of new images painted
+    double lastPaintTime;           // Time taken to paint the last new image (mS)
+    double lastLatency;             // Time from the last new image timestamp to it being painted (mS)
 };
 
 #endif // VIDEOWIDGET_H
@@ -23,6 +23,8 @@
  *    andrew.starritt@synchrotron.org.au
  */
 
+#include <math.h>
+
 #include <QApplication>
 #include <QClipboard>
 #include <QDebug>
@@ -37,6 +39,7 @@
 #include <QEGraphic.h>
 
 #include <QECommon.h>
+#include <QERenderScheduler.h>
 #include <QEFloating.h>
 #include <QEInteger.h>
 #include <QEScaling.h>
@@ -233,6 +236,12 @@ void QEPlotter::createInternalWidgets ()
 
    this->plotLayout->addWidget (this->plotArea);
 
+   this->waterfall = new QEPlotterWaterfall (this->plotFrame);
+   this->waterfall->setVisible (false);
+   this->waterfallIsVisible = false;
+   this->waterfallSlot = 0;
+   this->plotLayout->addWidget (this->waterfall);
+
    QObject::connect (this->plotArea, SIGNAL (mouseMove     (const QPointF&)),
                      this,           SLOT   (plotMouseMove (const QPointF&)));
 
@@ -355,6 +364,9 @@ QEPlotter::DataSets::DataSets ()
    // this->colour = item_colours [slot];
    this->fixedSize = 0;
    this->dbSize = 0;
+   this->dataGeneration = 0;
+   this->plottedMin = 0.0;
+   this->plottedMax = 1.0;
    this->pvName = "";
    this->aliasName = "";
    this->expression = "";
@@ -476,6 +488,15 @@ int QEPlotter::DataSets::effectiveSize () const
    return result;
 }
 
+//------------------------------------------------------------------------------
+//
+void QEPlotter::DataSets::updatePyramid ()
+{
+   if (this->pyramid.getGeneration () != this->dataGeneration) {
+      this->pyramid.build (this->data, this->dataGeneration);
+   }
+}
+
 //------------------------------------------------------------------------------
 //
 QString QEPlotter::DataSets::getDataData () const
@@ -602,14 +623,11 @@ QEPlotter::QEPlotter (QWidget* parent) : QEFrame (parent)
    this->currentMinY = this->fixedMinY = 0.0;
    this->currentMaxY = this->fixedMaxY = 10.0;
 
-   // Refresh plot check at ~10Hz.
+   // Refresh plot check at the render scheduler's frame rate.
    //
-   this->tickTimer = new QTimer (this);
-   this->tickTimerCount = 0;
    this->replotIsRequired = true; // ensure process on first tick.
 
-   connect (this->tickTimer, SIGNAL (timeout ()), this, SLOT (tickTimeout ()));
-   this->tickTimer->start (50);  // mSec == 0.05 s
+   QERenderScheduler::attach (this, SLOT (tickTimeout (const bool)));
 
    this->setToolTipSummary ();
    this->pushState ();  // baseline state - there is always at least one.
@@ -619,7 +637,7 @@ QEPlotter::QEPlotter (QWidget* parent) : QEFrame (parent)
 //
 QEPlotter::~QEPlotter ()
 {
-   this->tickTimer->stop ();
+   QERenderScheduler::detach (this);
 }
 
 //------------------------------------------------------------------------------
@@ -713,6 +731,8 @@ void QEPlotter::setNewVariableName (QString variableName,
    if (this->isDataIndex (variableIndex)) {
       this->xy [slot].dataKind = NotInUse;
       this->xy [slot].dataIsConnected = false;
+      this->xy [slot].data.clear ();
+      this->xy [slot].dataGeneration++;
    } else if (this->isSizeIndex (variableIndex)) {
       this->xy [slot].sizeKind = NotSpecified;
       this->xy [slot].sizeIsConnected = false;
@@ -979,6 +999,8 @@ void QEPlotter::generalContextMenuRequested (const QPoint& pos)
                                                this->getPvItemsVisible ());
    this->generalContextMenu->setActionChecked (QEPlotterNames::PLOTTER_SHOW_HIDE_STATUS,
                                                this->getStatusVisible ());
+   this->generalContextMenu->setActionChecked (QEPlotterNames::PLOTTER_SHOW_HIDE_WATERFALL,
+                                               this->getWaterfallVisible ());
 
    // Set dragging variable/data check boxes as appropriate.
    //
@@ -1113,6 +1135,10 @@ void QEPlotter::menuSelected (const QEPlotterNames::MenuActions action, const in
          this->setStatusVisible (! this->getStatusVisible ());
          break;
 
+      case QEPlotterNames::PLOTTER_SHOW_HIDE_WATERFALL:
+         this->setWaterfallVisible (! this->getWaterfallVisible ());
+         break;
+
       case QEPlotterNames::PLOTTER_EMIT_COORDINATES:
          emit this->coordinateSelected  (this->contextMenuRequestPosition);
          emit this->xCoordinateSelected (this->contextMenuRequestPosition.x ());
@@ -2185,6 +2211,8 @@ void QEPlotter::dataArrayChanged (const QVector<double>& values,
    SLOT_CHECK (slot,);
    if (this->isPaused) return;
    this->xy [slot].data = QEFloatingArray (values);
+   this->xy [slot].dataGeneration++;
+   this->appendWaterfallRow (slot);
    this->replotIsRequired = true;
    this->processAlarmInfo (alarmInfo, variableIndex);
    this->setToolTipSummary ();
@@ -2234,11 +2262,12 @@ void QEPlotter::plot ()
    int slot;
    DataSets* xs;
    DataSets* ys;
-   QEFloatingArray xdata;
-   QEFloatingArray ydata;
+   QEFloatingArray& xdata = this->plotXData;
+   QEFloatingArray& ydata = this->plotYData;
    int effectiveXSize;
    int effectiveYSize;
    int number;
+   double xLow = 0.0, xHigh = 0.0;
    double xMin, xMax;
    double yMin, yMax;
    bool xMinMaxDefined;
@@ -2279,6 +2308,7 @@ void QEPlotter::plot ()
 
    xs = &this->xy [0];
    effectiveXSize = xs->effectiveSize ();
+   xs->updatePyramid ();
 
    for (slot = 1; slot < ARRAY_LENGTH (this->xy); slot++) {
       ys = &this->xy [slot];
@@ -2298,34 +2328,32 @@ void QEPlotter::plot ()
 
       effectiveYSize = ys->effectiveSize ();
 
-      // Calculate actual number of points to plot.
-      // Skip if none or only a single point.
+      // Calculate actual number of points to plot, i.e. truncate both data sets
+      // to the same length. Skip if none or only a single point.
       //
       number = MIN (effectiveXSize, effectiveYSize);
+      number = MIN (number, MIN (xs->data.count (), ys->data.count ()));
 
       if (number < 2)  {
          continue;
       }
 
-      // Truncate both data sets to the same length.
-      //
-      xdata = QEFloatingArray (xs->data.mid (0, number));
-      ydata = QEFloatingArray (ys->data.mid (0, number));
+      ys->updatePyramid ();
 
       // Gather, save  and aggregate minima and maxima
       //
+      xs->pyramid.getMinMax (xs->data, 0, number - 1, xLow, xHigh);
       if (xMinMaxDefined) {
          // merge
-         xMin = MIN (xMin, xdata.minimumValue ());
-         xMax = MAX (xMax, xdata.maximumValue ());
+         xMin = MIN (xMin, xLow);
+         xMax = MAX (xMax, xHigh);
       } else {
-         xMin = xdata.minimumValue ();
-         xMax = xdata.maximumValue ();
+         xMin = xLow;
+         xMax = xHigh;
          xMinMaxDefined = true;
       }
 
-      ys->plottedMin = ydata.minimumValue ();
-      ys->plottedMax = ydata.maximumValue ();
+      ys->pyramid.getMinMax (ys->data, 0, number - 1, ys->plottedMin, ys->plottedMax);
 
       if (yMinMaxDefined) {
          // merge
@@ -2340,9 +2368,14 @@ void QEPlotter::plot ()
       // This this item is the selected item, then calculate and display item attributes.
       //
       if (slot == this->selectedDataSet) {
-         processSelectedItem (xdata, ydata, ys->plottedMin, ys->plottedMax);
+         processSelectedItem (xs->data, ys->data, number,
+                              ys->plottedMin, ys->plottedMax);
       }
 
+      // Select the points to be plotted - large data sets are decimated.
+      //
+      this->selectPlotPoints (xs, ys, number, xdata, ydata);
+
       // Scale the y data as required.
       //
       if ((this->yScaleMode == QEPlotterNames::smNormalised) ||
@@ -2358,10 +2391,7 @@ void QEPlotter::plot ()
             c = 0.0;
          }
 
-         for (int j = 0; j < number; j++) {
-            double t = ydata [j];
-            ydata [j] = m*t + c;
-         }
+         ydata.scaleOffset (m, c);
       }
 
       // Lastly plot the data.
@@ -2413,6 +2443,144 @@ void QEPlotter::plot ()
    this->replotIsRequired = false;
 }
 
+//------------------------------------------------------------------------------
+// Selects the points of the first number points of the x and y data sets to be
+// plotted. Large data sets are decimated to the plot's pixel resolution using the
+// y data set's min/max pyramid. This requires the x data to be in order, so that
+// each pixel column maps to a contiguous range of points. When zoomed in, such
+// that there are only a few points per pixel column, all points are plotted, so
+// that exact sample values are still displayed.
+//
+void QEPlotter::selectPlotPoints (const DataSets* xs, const DataSets* ys, const int number,
+                                  QEFloatingArray& xdata, QEFloatingArray& ydata)
+{
+   const int columns = MAX (this->plotArea->getCanvasSize ().width (), 100);
+   const int pointsPerColumn = 4;
+   int first = 0;
+   int last = number - 1;
+
+   if (xs->pyramid.isNonDecreasing () && (number > pointsPerColumn * columns)) {
+      double xLow = xs->data.value (0);
+      double xHigh = xs->data.value (number - 1);
+
+      if (this->xScaleMode != QEPlotterNames::smDynamic) {
+         xLow = MAX (xLow, this->fixedMinX);
+         xHigh = MIN (xHigh, this->fixedMaxX);
+      }
+
+      // Include the points either side of the visible range, so that the plotted
+      // line extends to the edges of the plot.
+      //
+      first = QEPlotterDataPyramid::lowerBound (xs->data, number, xLow) - 1;
+      last = QEPlotterDataPyramid::lowerBound (xs->data, number, xHigh);
+      first = LIMIT (first, 0, number - 1);
+      last = LIMIT (last, first, number - 1);
+
+      if (last - first + 1 > pointsPerColumn * columns) {
+         const bool isLog = this->plotArea->getXLogarithmic () && (xLow > 0.0);
+         QVector<int> columnStarts (columns);
+         QVector<int> indices;
+
+         columnStarts [0] = first;
+         for (int c = 1; c < columns; c++) {
+            const double f = double (c) / double (columns);
+            double x;
+
+            if (isLog) {
+               x = xLow * pow (xHigh / xLow, f);
+            } else {
+               x = xLow + f * (xHigh - xLow);
+            }
+            columnStarts [c] = MAX (QEPlotterDataPyramid::lowerBound (xs->data, number, x), first);
+         }
+
+         indices.reserve (pointsPerColumn * columns);
+         ys->pyramid.decimate (ys->data, columnStarts, last, indices);
+
+         const int n = indices.count ();
+         xdata.resize (n);
+         ydata.resize (n);
+         for (int j = 0; j < n; j++) {
+            xdata [j] = xs->data [indices [j]];
+            ydata [j] = ys->data [indices [j]];
+         }
+         return;
+      }
+   }
+
+   const int n = last - first + 1;
+   xdata.resize (n);
+   ydata.resize (n);
+   for (int j = 0; j < n; j++) {
+      xdata [j] = xs->data [first + j];
+      ydata [j] = ys->data [first + j];
+   }
+}
+
+//------------------------------------------------------------------------------
+// The waterfall displays the selected data set if it is a data PV, otherwise the
+// first displayed data PV, if any. Calculations are not updated by PV updates
+// and so are not available as waterfall data sets.
+//
+int QEPlotter::waterfallDataSet () const
+{
+   const int selected = this->selectedDataSet;
+
+   if ((selected > 0) && (this->xy [selected].dataKind == DataPVPlot)) {
+      return selected;
+   }
+
+   for (int slot = 1; slot < ARRAY_LENGTH (this->xy); slot++) {
+      if ((this->xy [slot].dataKind == DataPVPlot) && this->xy [slot].isDisplayed) {
+         return slot;
+      }
+   }
+   return 0;   // none
+}
+
+//------------------------------------------------------------------------------
+// Appends the new data for the slot to the waterfall if the waterfall is visible
+// and displaying this slot. Only the new row is processed.
+//
+void QEPlotter::appendWaterfallRow (const int slot)
+{
+   if (!this->waterfallIsVisible) return;
+   if (slot != this->waterfallDataSet ()) return;
+
+   // Start afresh when the displayed data set changes.
+   //
+   if (slot != this->waterfallSlot) {
+      this->waterfall->clear ();
+      this->waterfallSlot = slot;
+   }
+
+   DataSets* ys = &this->xy [slot];
+   double minimum;
+   double maximum;
+
+   // Use the fixed y range if defined, otherwise the data set's range as last
+   // plotted. The waterfall latches the range given with its first row, so the
+   // colours of all rows are comparable even when the y scale is dynamic. If the
+   // fixed range is changed, the history (coloured using the old range) is cleared.
+   //
+   if (this->yScaleMode == QEPlotterNames::smFixed) {
+      minimum = this->fixedMinY;
+      maximum = this->fixedMaxY;
+
+      double latchedMinimum;
+      double latchedMaximum;
+      if (this->waterfall->getColourRange (latchedMinimum, latchedMaximum) &&
+          ((latchedMinimum != minimum) || (latchedMaximum != maximum))) {
+         this->waterfall->clear ();
+      }
+   } else {
+      minimum = ys->plottedMin;
+      maximum = ys->plottedMax;
+   }
+
+   this->waterfall->appendRow (ys->data, ys->effectiveSize (), minimum, maximum);
+}
+
 //------------------------------------------------------------------------------
 //
 int QEPlotter::maxActualYSizes () const
@@ -2434,6 +2602,9 @@ void QEPlotter::doAnyCalculations ()
    const int s = QEExpressionEvaluation::indexOf ('S');
 
    QEExpressionEvaluation::CalculateArguments userArguments;
+   QEExpressionEvaluation::CalculateArrayArguments arrayArguments;
+   QEFloatingArray& indices = this->indexArray;
+   bool dyByDxIsRequired [ARRAY_LENGTH (this->xy)];
    DataSets* xs;
    DataSets* ys;
    int effectiveXSize;
@@ -2442,22 +2613,46 @@ void QEPlotter::doAnyCalculations ()
    int j;
    int slot;
    int tols;
-   double value;
    bool okay;
-   bool dataIsAvailable;
 
    xs = &this->xy [0];  // use a alias pointer for brevity
    effectiveXSize = xs->effectiveSize ();
 
+   // The S argument is the element index - only re-calculated when the size changes.
+   //
+   if (indices.count () != effectiveXSize) {
+      indices.resize (effectiveXSize);
+      for (j = 0; j < effectiveXSize; j++) {
+         indices [j] = (double) j;
+      }
+   }
+
+   // Determine which slopes, i.e. primed arguments, are used by any calculation.
+   //
+   for (slot = 0; slot < ARRAY_LENGTH (this->xy); slot++) {
+      dyByDxIsRequired [slot] = false;
+   }
+   for (slot = 1; slot < ARRAY_LENGTH (this->xy); slot++) {
+      ys = &this->xy [slot];
+      if ((ys->dataKind == CalculationPlot) && ys->expressionIsValid) {
+         for (tols = 1; tols < slot; tols++) {
+            if (ys->calculator->isArgumentUsed (Primed, tols - 1)) {
+               dyByDxIsRequired [tols] = true;
+            }
+         }
+      }
+   }
+
    switch (xs->dataKind) {
 
       case NotInUse:
-         xs->data.clear ();
-
          // Use default calculation which is just x = index position 0 .. (n-1)
+         // Only re-calculated when the size changes - data is cleared when the
+         // data kind is set to NotInUse.
          //
-         for (j = 0; j < effectiveXSize; j++) {
-            xs->data.append ((double) j);
+         if (xs->data.count () != effectiveXSize) {
+            xs->data = indices;
+            xs->dataGeneration++;
          }
          break;
 
@@ -2466,23 +2661,26 @@ void QEPlotter::doAnyCalculations ()
          break;
 
       case CalculationPlot:
-         xs->data.clear ();
+         xs->dataGeneration++;
          if (xs->expressionIsValid) {
-            for (j = 0; j < effectiveXSize; j++) {
-               QEExpressionEvaluation::clear (userArguments);
-               userArguments [Normal][s] = (double) j;
-               value = xs->calculator->evaluate (userArguments, &okay);
-               xs->data.append (value);
-            }
+            // Evaluate the whole array in one go, in place.
+            //
+            QEExpressionEvaluation::clear (userArguments);
+            QEExpressionEvaluation::clear (arrayArguments);
+            arrayArguments [Normal][s] = &indices;
+            xs->calculator->evaluateArray (userArguments, arrayArguments,
+                                           effectiveXSize, xs->data, &okay);
+         } else {
+            xs->data.clear ();
          }
    }
 
-   // Next calc slope of actual y fdta values.
+   // Next calc slope of actual y data values, if required.
    //
    for (slot = 1; slot < ARRAY_LENGTH (this->xy); slot++) {
       ys = &this->xy [slot];
-      if (ys->dataKind == DataPVPlot) {
-         ys->dyByDx = ys->data.calcDyByDx (xs->data);
+      if ((ys->dataKind == DataPVPlot) && dyByDxIsRequired [slot]) {
+         ys->data.calcDyByDx (xs->data, ys->dyByDx);
       }
    }
 
@@ -2490,38 +2688,40 @@ void QEPlotter::doAnyCalculations ()
       ys = &this->xy [slot];
       if (ys->dataKind == CalculationPlot) {
 
-         ys->data.clear ();
+         ys->dataGeneration++;
          effectiveYSize = ys->effectiveSize ();
 
          n = MIN (effectiveXSize, effectiveYSize);
 
-         dataIsAvailable = true;
-         for (j = 0; j < n; j++) {
-            QEExpressionEvaluation::clear (userArguments);
-
-            // Pre-defined values: S and X
-            //
-            userArguments [Normal][s] = (double) j;
-            userArguments [Normal][x] = xs->data.value (j);
-            userArguments [Primed][x] = 1.0;    // by defitions.
-
-            for (tols = 1; tols < slot; tols++) {
-               DataSets* ts = &this->xy [tols];
+         // Evaluate the whole array in one go, in place. Arrays shorter than n
+         // use the default (scalar) argument value of 0.0 for missing elements.
+         //
+         QEExpressionEvaluation::clear (userArguments);
+         QEExpressionEvaluation::clear (arrayArguments);
 
-               // TODO: determine if this arg used?
-               userArguments [Normal] [tols - 1] = ts->data.value (j, 0.0);
-               userArguments [Primed] [tols - 1] = ts->dyByDx.value (j, 0.0);
-            }
+         // Pre-defined values: S and X
+         //
+         arrayArguments [Normal][s] = &indices;
+         arrayArguments [Normal][x] = &xs->data;
+         userArguments [Primed][x] = 1.0;    // by defitions.
 
-            if (!dataIsAvailable) break;
+         for (tols = 1; tols < slot; tols++) {
+            DataSets* ts = &this->xy [tols];
 
-            value = ys->calculator->evaluate (userArguments, &okay);
-            ys->data.append (value);
+            // Only arguments used by the expression are accessed.
+            //
+            arrayArguments [Normal] [tols - 1] = &ts->data;
+            arrayArguments [Primed] [tols - 1] = &ts->dyByDx;
          }
 
-         // Calculate slope of calculated plot.
+         ys->calculator->evaluateArray (userArguments, arrayArguments,
+                                        n, ys->data, &okay);
+
+         // Calculate slope of calculated plot, if required by a later calculation.
          //
-         ys->dyByDx = ys->data.calcDyByDx (xs->data);
+         if (dyByDxIsRequired [slot]) {
+            ys->data.calcDyByDx (xs->data, ys->dyByDx);
+         }
       }
    }
 }
@@ -2530,9 +2730,10 @@ void QEPlotter::doAnyCalculations ()
 //
 void QEPlotter::processSelectedItem (const QEFloatingArray& xdata,
                                      const QEFloatingArray& ydata,
+                                     const int numberIn,
                                      const double yMin, const double yMax)
 {
-   const int number = ydata.count ();
+   const int number = MIN (numberIn, MIN (xdata.count (), ydata.count ()));
    QString image;
    double value;
    int jAtMax;
@@ -2585,12 +2786,10 @@ void QEPlotter::processSelectedItem (const QEFloatingArray& xdata,
 
 //------------------------------------------------------------------------------
 //
-void QEPlotter::tickTimeout ()
+void QEPlotter::tickTimeout (const bool isSecondTick)
 {
-   this->tickTimerCount = (this->tickTimerCount + 1) % 20;
-
-   if ((this->tickTimerCount % 20) == 0) {
-      // 20th update, i.e. 1 second has passed - must replot.
+   if (isSecondTick) {
+      // 1 second has passed - must replot.
       this->replotIsRequired = true;
    }
 
@@ -2763,6 +2962,38 @@ bool QEPlotter::getStatusVisible () const
    return this->statusFrame->isVisible ();
 }
 
+//------------------------------------------------------------------------------
+//
+void QEPlotter::setWaterfallVisible (bool visible)
+{
+   this->waterfallIsVisible = visible;
+   this->plotArea->setVisible (!visible);
+   this->waterfall->setVisible (visible);
+   if (!visible) {
+      // Release the history, and start afresh when next shown.
+      //
+      this->waterfall->clear ();
+      this->replotIsRequired = true;
+   }
+}
+
+bool QEPlotter::getWaterfallVisible () const
+{
+   return this->waterfallIsVisible;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotter::setWaterfallRows (int rows)
+{
+   this->waterfall->setNumberOfRows (rows);
+}
+
+int QEPlotter::getWaterfallRows () const
+{
+   return this->waterfall->getNumberOfRows ();
+}
+
 //------------------------------------------------------------------------------
 //
 void QEPlotter::setXLogarithmic (bool isLog)
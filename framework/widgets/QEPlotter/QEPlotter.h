@@ -54,6 +54,8 @@
 
 #include <QEStripChartRangeDialog.h>
 #include "QEPlotterNames.h"
+#include "QEPlotterDataPyramid.h"
+#include "QEPlotterWaterfall.h"
 #include "QEPlotterItemDialog.h"
 #include "QEPlotterMenu.h"
 #include "QEPlotterState.h"
@@ -79,6 +81,8 @@ class QEPLUGINLIBRARYSHARED_EXPORT QEPlotter : public QEFrame {
    Q_PROPERTY (bool toolBarVisible     READ getToolBarVisible    WRITE setToolBarVisible)
    Q_PROPERTY (bool pvItemsVisible     READ getPvItemsVisible    WRITE setPvItemsVisible)
    Q_PROPERTY (bool statusVisible      READ getStatusVisible     WRITE setStatusVisible)
+   Q_PROPERTY (bool waterfallVisible   READ getWaterfallVisible  WRITE setWaterfallVisible)
+   Q_PROPERTY (int  waterfallRows      READ getWaterfallRows     WRITE setWaterfallRows)
    Q_PROPERTY (bool xLogarithmic       READ getXLogarithmic      WRITE setXLogarithmic)
    Q_PROPERTY (bool yLogarithmic       READ getYLogarithmic      WRITE setYLogarithmic)
    Q_PROPERTY (QString contextMenuEmitText    READ getMenuEmitText      WRITE setMenuEmitText)
@@ -203,6 +207,15 @@ public:
    void setStatusVisible (bool visible);
    bool getStatusVisible () const;
 
+   // The waterfall displays the history of the selected data set (or if none
+   // selected, the first data PV) in place of the plot, one row per update.
+   //
+   void setWaterfallVisible (bool visible);
+   bool getWaterfallVisible () const;
+
+   void setWaterfallRows (int rows);
+   int getWaterfallRows () const;
+
    void setXLogarithmic (bool visible);
    bool getXLogarithmic () const;
 
@@ -291,6 +304,9 @@ private:
 
    QFrame* plotFrame;
    QEGraphic* plotArea;
+   QEPlotterWaterfall* waterfall;
+   bool waterfallIsVisible;
+   int waterfallSlot;            // data set currently displayed by the waterfall
 
    QEResizeableFrame* itemResize;
    QScrollArea* itemScrollArea;
@@ -329,8 +345,6 @@ private:
 
    bool enableConextMenu;
    int selectedDataSet;
-   QTimer* tickTimer;
-   int tickTimerCount;
    int  crosshairIndex;
    bool crosshairsAreRequired;  // controls both plotting and signal emmisions
    bool replotIsRequired;
@@ -339,6 +353,13 @@ private:
    QEIntegerFormatting  integerFormatting;
    QEFloatingFormatting floatingFormatting;
 
+   // Work arrays - retained so that, once the array sizes are steady, plotting
+   // and calculations do not allocate.
+   //
+   QEFloatingArray indexArray;         // 0, 1, 2 ... i.e. the S argument
+   QEFloatingArray plotXData;
+   QEFloatingArray plotYData;
+
    bool    contextMenuIsOverGraphic;
    QPointF contextMenuRequestPosition;   // only meaninful when contextMenuIsOverGraphic is true.
    QString contextMenuEmitText;
@@ -389,6 +410,14 @@ private:
       QEFloatingArray data;
       QEFloatingArray dyByDx;
 
+      // Incremented whenever data is modified, so that the pyramid is only
+      // rebuilt when required. The data and dyByDx arrays are updated in place.
+      // Note: dyByDx is only calculated when used by a calculation.
+      //
+      int dataGeneration;
+      QEPlotterDataPyramid pyramid;
+      void updatePyramid ();
+
       // Min max values used when last plotted.
       //
       double plottedMin;
@@ -432,12 +461,17 @@ private:
    void calcCrosshairIndex (const double x);
 
    void plot ();
+   int waterfallDataSet () const;
+   void appendWaterfallRow (const int slot);
+   void selectPlotPoints (const DataSets* xs, const DataSets* ys, const int number,
+                          QEFloatingArray& xdata, QEFloatingArray& ydata);
    int maxActualYSizes () const;
    void doAnyCalculations ();
 
    // Calculate stats
    void processSelectedItem (const QEFloatingArray& xdata,
                              const QEFloatingArray& ydata,
+                             const int number,
                              const double yMin, const double yMax);
 
    void addPvName (const QString& pvName);
@@ -543,7 +577,7 @@ private slots:
 
    void letterButtonClicked (bool checked);
    void checkBoxStateChanged (int state);
-   void tickTimeout ();
+   void tickTimeout (const bool isSecondTick);
 
    void generalContextMenuRequested (const QPoint& pos);
    void itemContextMenuRequested (const QPoint& pos);
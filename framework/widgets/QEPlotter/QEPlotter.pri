@@ -12,6 +12,8 @@ RESOURCES += \
 HEADERS += \
     widgets/QEPlotter/QEPlotter.h \
     widgets/QEPlotter/QEPlotterNames.h \
+    widgets/QEPlotter/QEPlotterDataPyramid.h \
+    widgets/QEPlotter/QEPlotterWaterfall.h \
     widgets/QEPlotter/QEPlotterItemDialog.h \
     widgets/QEPlotter/QEPlotterMenu.h \
     widgets/QEPlotter/QEPlotterState.h \
@@ -20,6 +22,8 @@ HEADERS += \
 
 SOURCES += \
     widgets/QEPlotter/QEPlotter.cpp \
+    widgets/QEPlotter/QEPlotterDataPyramid.cpp \
+    widgets/QEPlotter/QEPlotterWaterfall.cpp \
     widgets/QEPlotter/QEPlotterItemDialog.cpp \
     widgets/QEPlotter/QEPlotterMenu.cpp \
     widgets/QEPlotter/QEPlotterState.cpp \
@@ -0,0 +1,275 @@
+/*  QEPlotterDataPyramid.cpp
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+#include <QDebug>
+
+#include <QECommon.h>
+#include "QEPlotterDataPyramid.h"
+
+#define DEBUG qDebug () << "QEPlotterDataPyramid::" << __FUNCTION__ << ":" << __LINE__
+
+//==============================================================================
+//
+QEPlotterDataPyramid::QEPlotterDataPyramid ()
+{
+   this->generation = -1;
+   this->clear ();
+}
+
+//------------------------------------------------------------------------------
+//
+QEPlotterDataPyramid::~QEPlotterDataPyramid () { }
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterDataPyramid::clear ()
+{
+   this->tree.clear ();
+   this->treeBase = 1;
+   this->number = 0;
+   this->nonDecreasing = true;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterDataPyramid::build (const QVector<double>& data, const int generationIn)
+{
+   const int n = data.count ();
+   const double* values = data.constData ();
+   const int numberOfBlocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+   int j;
+
+   this->generation = generationIn;
+   this->number = n;
+
+   this->treeBase = 1;
+   while (this->treeBase < numberOfBlocks) {
+      this->treeBase *= 2;
+   }
+
+   // Re-sizing retains the allocated capacity when the data size is steady.
+   //
+   this->tree.resize (2 * this->treeBase);
+   Node* nodes = this->tree.data ();
+
+   this->nonDecreasing = true;
+   for (j = 1; j < n; j++) {
+      if (!(values [j] >= values [j - 1])) {   // also catches NaN
+         this->nonDecreasing = false;
+         break;
+      }
+   }
+
+   // Leaves first, then work up to the root.
+   //
+   for (j = 0; j < this->treeBase; j++) {
+      Node& leaf = nodes [this->treeBase + j];
+      QEPlotterDataPyramid::clearNode (leaf);
+      if (j < numberOfBlocks) {
+         const int from = j * BLOCK_SIZE;
+         const int to = MIN (from + BLOCK_SIZE, n) - 1;
+         this->scanNode (data, from, to, leaf);
+      }
+   }
+
+   for (j = this->treeBase - 1; j >= 1; j--) {
+      nodes [j] = nodes [2*j];
+      QEPlotterDataPyramid::mergeNode (nodes [j], nodes [2*j + 1]);
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+bool QEPlotterDataPyramid::getMinMax (const QVector<double>& data,
+                                      const int first, const int last,
+                                      double& minimum, double& maximum) const
+{
+   Node node;
+
+   this->queryNode (data, first, last, node);
+   if (node.minIndex < 0) return false;
+
+   minimum = node.minimum;
+   maximum = node.maximum;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterDataPyramid::decimate (const QVector<double>& data,
+                                     const QVector<int>& columnStarts,
+                                     const int last, QVector<int>& indices) const
+{
+   const int numberOfColumns = columnStarts.count ();
+   const int lastIndex = MIN (last, this->number - 1);
+   int previous = -1;
+
+   for (int c = 0; c < numberOfColumns; c++) {
+      const int from = MAX (columnStarts.value (c), previous + 1);
+      const int to = MIN ((c + 1 < numberOfColumns) ? columnStarts.value (c + 1) - 1 : lastIndex,
+                          lastIndex);
+
+      if (from > to) continue;
+
+      Node node;
+      this->queryNode (data, from, to, node);
+
+      int select [4];
+      select [0] = from;
+      select [1] = MIN (node.minIndex, node.maxIndex);
+      select [2] = MAX (node.minIndex, node.maxIndex);
+      select [3] = to;
+
+      for (int s = 0; s < 4; s++) {
+         // Empty column nodes (from/to only) have min/max index of -1.
+         //
+         if (select [s] > previous) {
+            indices.append (select [s]);
+            previous = select [s];
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+int QEPlotterDataPyramid::lowerBound (const QVector<double>& data, const int number,
+                                      const double x)
+{
+   const double* values = data.constData ();
+   int lower = 0;
+   int upper = MIN (number, data.count ());
+
+   while (lower < upper) {
+      const int mid = lower + (upper - lower) / 2;
+      if (values [mid] < x) {
+         lower = mid + 1;
+      } else {
+         upper = mid;
+      }
+   }
+   return lower;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterDataPyramid::scanNode (const QVector<double>& data,
+                                     const int from, const int to,
+                                     Node& node) const
+{
+   const double* values = data.constData ();
+
+   for (int j = from; j <= to; j++) {
+      const double v = values [j];
+      if (node.minIndex < 0) {
+         node.minimum = node.maximum = v;
+         node.minIndex = node.maxIndex = j;
+      } else if (v < node.minimum) {
+         node.minimum = v;
+         node.minIndex = j;
+      } else if (v > node.maximum) {
+         node.maximum = v;
+         node.maxIndex = j;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterDataPyramid::queryNode (const QVector<double>& data,
+                                      const int firstIn, const int lastIn,
+                                      Node& node) const
+{
+   const int first = MAX (firstIn, 0);
+   const int last = MIN (MIN (lastIn, this->number - 1), data.count () - 1);
+
+   QEPlotterDataPyramid::clearNode (node);
+   if (first > last) return;
+
+   int firstBlock = first / BLOCK_SIZE;
+   int lastBlock = last / BLOCK_SIZE;
+
+   if (firstBlock == lastBlock) {
+      this->scanNode (data, first, last, node);
+      return;
+   }
+
+   // Scan the partial blocks at each end, and use the tree for the whole blocks.
+   //
+   if (first % BLOCK_SIZE != 0) {
+      this->scanNode (data, first, (firstBlock + 1) * BLOCK_SIZE - 1, node);
+      firstBlock++;
+   }
+
+   if ((last + 1) % BLOCK_SIZE != 0 && last != this->number - 1) {
+      this->scanNode (data, lastBlock * BLOCK_SIZE, last, node);
+      lastBlock--;
+   }
+
+   const Node* nodes = this->tree.constData ();
+   int lower = this->treeBase + firstBlock;
+   int upper = this->treeBase + lastBlock + 1;
+   while (lower < upper) {
+      if (lower & 1) QEPlotterDataPyramid::mergeNode (node, nodes [lower++]);
+      if (upper & 1) QEPlotterDataPyramid::mergeNode (node, nodes [--upper]);
+      lower /= 2;
+      upper /= 2;
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+void QEPlotterDataPyramid::clearNode (Node& node)
+{
+   node.minimum = 0.0;
+   node.maximum = 0.0;
+   node.minIndex = -1;
+   node.maxIndex = -1;
+}
+
+//------------------------------------------------------------------------------
+// static
+void QEPlotterDataPyramid::mergeNode (Node& node, const Node& other)
+{
+   if (other.minIndex < 0) return;
+
+   if (node.minIndex < 0) {
+      node = other;
+      return;
+   }
+
+   if (other.minimum < node.minimum) {
+      node.minimum = other.minimum;
+      node.minIndex = other.minIndex;
+   }
+
+   if (other.maximum > node.maximum) {
+      node.maximum = other.maximum;
+      node.maxIndex = other.maxIndex;
+   }
+}
+
+// end
@@ -0,0 +1,104 @@
+/*  QEPlotterDataPyramid.h
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+#ifndef QEPLOTTERDATAPYRAMID_H
+#define QEPLOTTERDATAPYRAMID_H
+
+#include <QVector>
+
+//==============================================================================
+// Min/max pyramid of a plotter data set.
+//
+// The data is grouped into fixed size blocks, and a segment tree holds the
+// minimum and maximum values (and where they occur) of each block and of each
+// group of blocks. This allows the min/max over any index range to be found in
+// O(log n), and hence a large waveform to be decimated to the plot's pixel
+// resolution in O(pixels log n) rather than O(n).
+//
+// The pyramid does not hold the data itself - the data passed to the query
+// functions must be the data the pyramid was last built from. The generation
+// is a user supplied value that allows the user to determine if the pyramid
+// needs to be rebuilt.
+//
+class QEPlotterDataPyramid {
+public:
+   explicit QEPlotterDataPyramid ();
+   ~QEPlotterDataPyramid ();
+
+   void clear ();
+   void build (const QVector<double>& data, const int generation);
+
+   int getGeneration () const { return this->generation; }
+   int count () const { return this->number; }
+
+   // True when the data values are in non-decreasing order, e.g. for x data,
+   // which allows an x range to be mapped to an index range.
+   //
+   bool isNonDecreasing () const { return this->nonDecreasing; }
+
+   // Find min/max values of data [first .. last]. Returns false if the range is empty.
+   //
+   bool getMinMax (const QVector<double>& data, const int first, const int last,
+                   double& minimum, double& maximum) const;
+
+   // Selects the points to plot for columns of data. Column c spans indices
+   // columnStarts [c] to columnStarts [c + 1] - 1, the last column ending at last.
+   // Within each column the first, minimum, maximum and last points are selected,
+   // so that no peak is lost and the line joins up with the adjacent columns.
+   // The selected indices are appended in order to indices.
+   //
+   void decimate (const QVector<double>& data, const QVector<int>& columnStarts,
+                  const int last, QVector<int>& indices) const;
+
+   // Return the index of the first element of data [0 .. number - 1] >= x,
+   // or number if there is no such element. Data must be non-decreasing.
+   //
+   static int lowerBound (const QVector<double>& data, const int number, const double x);
+
+private:
+   enum { BLOCK_SIZE = 32 };      // points per segment tree leaf
+
+   struct Node {
+      double minimum;
+      double maximum;
+      int minIndex;               // -1 when the node is empty
+      int maxIndex;
+   };
+
+   void scanNode (const QVector<double>& data, const int from, const int to, Node& node) const;
+   void queryNode (const QVector<double>& data, const int first, const int last, Node& node) const;
+
+   static void clearNode (Node& node);
+   static void mergeNode (Node& node, const Node& other);
+
+   QVector<Node> tree;            // leaves are at treeBase + block, the root is at 1.
+   int treeBase;
+   int number;
+   int generation;
+   bool nonDecreasing;
+};
+
+#endif  // QEPLOTTERDATAPYRAMID_H
@@ -83,6 +83,7 @@ QEPlotterMenu::QEPlotterMenu (QWidget* parent) : QMenu (parent)
    this->make (menu, "Show/Hide Tool Bar",      true,  QEPlotterNames::PLOTTER_SHOW_HIDE_TOOLBAR);
    this->make (menu, "Show/Hide PV Items",      true,  QEPlotterNames::PLOTTER_SHOW_HIDE_PV_ITEMS);
    this->make (menu, "Show/Hide Status",        true,  QEPlotterNames::PLOTTER_SHOW_HIDE_STATUS);
+   this->make (menu, "Show/Hide Waterfall",     true,  QEPlotterNames::PLOTTER_SHOW_HIDE_WATERFALL);
 
    this->make (this, "Emit Coordinates",        false, QEPlotterNames::PLOTTER_EMIT_COORDINATES );
 
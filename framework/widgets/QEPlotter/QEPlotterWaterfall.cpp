@@ -0,0 +1,277 @@
+/*  QEPlotterWaterfall.cpp
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+#include <QDebug>
+#include <QPainter>
+#include <QPaintEvent>
+
+#include <QECommon.h>
+#include <QEFalseColour.h>
+#include "QEPlotterWaterfall.h"
+
+#define DEBUG qDebug () << "QEPlotterWaterfall::" << __FUNCTION__ << ":" << __LINE__
+
+#define DEFAULT_NUMBER_OF_ROWS   1000
+#define MINIMUM_NUMBER_OF_ROWS   10
+#define MAXIMUM_NUMBER_OF_ROWS   10000
+#define MAXIMUM_NUMBER_OF_COLUMNS  65536
+
+//==============================================================================
+//
+QEPlotterWaterfall::QEPlotterWaterfall (QWidget* parent) : QWidget (parent)
+{
+   this->numberOfRows = DEFAULT_NUMBER_OF_ROWS;
+   this->newestRow = 0;
+   this->rowsDisplayed = 0;
+   this->falseColour = true;
+   this->rangeIsLatched = false;
+   this->rangeMinimum = 0.0;
+   this->rangeMaximum = 0.0;
+   this->buildColourLookup ();
+
+   // We paint the whole widget.
+   //
+   this->setAttribute (Qt::WA_OpaquePaintEvent);
+}
+
+//------------------------------------------------------------------------------
+//
+QEPlotterWaterfall::~QEPlotterWaterfall () { }
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterWaterfall::setNumberOfRows (const int rows)
+{
+   const int temp = LIMIT (rows, MINIMUM_NUMBER_OF_ROWS, MAXIMUM_NUMBER_OF_ROWS);
+
+   if (this->numberOfRows != temp) {
+      this->numberOfRows = temp;
+      this->clear ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+int QEPlotterWaterfall::getNumberOfRows () const
+{
+   return this->numberOfRows;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterWaterfall::setFalseColour (const bool falseColourIn)
+{
+   if (this->falseColour != falseColourIn) {
+      this->falseColour = falseColourIn;
+      this->buildColourLookup ();
+      this->clear ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+bool QEPlotterWaterfall::getFalseColour () const
+{
+   return this->falseColour;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterWaterfall::clear ()
+{
+   this->image = QImage ();
+   this->display = QPixmap ();
+   this->newestRow = 0;
+   this->rangeIsLatched = false;
+   this->update ();
+}
+
+//------------------------------------------------------------------------------
+//
+bool QEPlotterWaterfall::getColourRange (double& minimum, double& maximum) const
+{
+   minimum = this->rangeMinimum;
+   maximum = this->rangeMaximum;
+   return this->rangeIsLatched;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterWaterfall::appendRow (const QVector<double>& data, const int numberIn,
+                                    const double minimumIn, const double maximumIn)
+{
+   const int number = MIN (MIN (numberIn, data.count ()), MAXIMUM_NUMBER_OF_COLUMNS);
+
+   if (number < 1) return;
+
+   // (Re)allocate the ring image if needs be.
+   //
+   if (this->image.isNull () || this->image.width () != number ||
+       this->image.height () != this->numberOfRows) {
+      this->image = QImage (number, this->numberOfRows, QImage::Format_RGB32);
+      this->image.fill (this->colourLookup.value (0));
+      this->newestRow = 0;
+      this->display = QPixmap ();
+   }
+
+   // Latch the colour range so that all rows in the history are comparable.
+   //
+   if (!this->rangeIsLatched && (maximumIn > minimumIn)) {
+      this->rangeIsLatched = true;
+      this->rangeMinimum = minimumIn;
+      this->rangeMaximum = maximumIn;
+   }
+   const double minimum = this->rangeIsLatched ? this->rangeMinimum : minimumIn;
+   const double maximum = this->rangeIsLatched ? this->rangeMaximum : maximumIn;
+
+   // Rows are added going up the image so that, reading down from the newest
+   // row and wrapping at the bottom, the rows are in newest to oldest order.
+   //
+   this->newestRow = (this->newestRow + this->numberOfRows - 1) % this->numberOfRows;
+
+   const double* values = data.constData ();
+   const QRgb* lookup = this->colourLookup.constData ();
+   QRgb* row = (QRgb*) this->image.scanLine (this->newestRow);
+   const double span = maximum - minimum;
+   const double scale = (span > 0.0) ? 255.0 / span : 0.0;
+
+   for (int j = 0; j < number; j++) {
+      const double s = (values [j] - minimum) * scale;
+      int index;
+
+      if (s >= 255.0) {
+         index = 255;
+      } else if (s > 0.0) {
+         index = int (s);
+      } else {
+         index = 0;    // includes NaN
+      }
+      row [j] = lookup [index];
+   }
+
+   if (this->display.isNull () || (this->display.size () != this->size ())) {
+      this->update ();    // the whole display is rendered when painted
+   } else {
+      this->addDisplayRow ();
+   }
+}
+
+//------------------------------------------------------------------------------
+// Rows are (generally) not a whole number of pixels high, so the display is
+// scrolled by the change in the rounded position of the rows since the display
+// was rendered. When there are more rows than pixels, the scroll is often zero,
+// and the newest row just replaces the top pixel row.
+//
+void QEPlotterWaterfall::addDisplayRow ()
+{
+   const int width = this->display.width ();
+   const double rowHeight = double (this->display.height ()) / double (this->numberOfRows);
+
+   this->rowsDisplayed++;
+   const int shift = int (this->rowsDisplayed * rowHeight + 0.5) -
+                     int ((this->rowsDisplayed - 1) * rowHeight + 0.5);
+   const int height = MAX (shift, 1);
+
+   if (shift > 0) {
+      this->display.scroll (0, shift, this->display.rect ());
+   }
+
+   {
+      QPainter painter (&this->display);
+      painter.drawImage (QRectF (0.0, 0.0, width, height), this->image,
+                         QRectF (0.0, this->newestRow, this->image.width (), 1.0));
+   }
+
+   // Scroll the widget's on screen content too - this generates a paint event
+   // for the exposed new row only.
+   //
+   if (shift > 0) {
+      this->scroll (0, shift);
+   } else {
+      this->update (0, 0, width, height);
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterWaterfall::renderDisplay ()
+{
+   this->display = QPixmap (this->size ());
+   this->rowsDisplayed = 0;
+
+   QPainter painter (&this->display);
+   const QRectF all = this->display.rect ();
+
+   if (this->image.isNull ()) {
+      painter.fillRect (all, QColor (this->colourLookup.value (0)));
+      return;
+   }
+
+   const int width = this->image.width ();
+   const int upper = this->numberOfRows - this->newestRow;   // newest rows
+   const double rowHeight = all.height () / double (this->numberOfRows);
+
+   // Newest row to bottom of the image, then top of the image to the oldest row.
+   //
+   QRectF target (0.0, 0.0, all.width (), upper * rowHeight);
+   painter.drawImage (target, this->image,
+                      QRectF (0.0, this->newestRow, width, upper));
+
+   if (this->newestRow > 0) {
+      target = QRectF (0.0, upper * rowHeight, all.width (), this->newestRow * rowHeight);
+      painter.drawImage (target, this->image,
+                         QRectF (0.0, 0.0, width, this->newestRow));
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterWaterfall::paintEvent (QPaintEvent* event)
+{
+   if (this->display.isNull () || (this->display.size () != this->size ())) {
+      this->renderDisplay ();
+   }
+
+   QPainter painter (this);
+   const QRect dirty = event->rect ();
+   painter.drawPixmap (dirty, this->display, dirty);
+}
+
+//------------------------------------------------------------------------------
+//
+void QEPlotterWaterfall::buildColourLookup ()
+{
+   if (this->falseColour) {
+      this->colourLookup = QEFalseColour::getLookupTable ();
+   } else {
+      this->colourLookup.resize (256);
+      for (int j = 0; j < 256; j++) {
+         this->colourLookup [j] = qRgb (j, j, j);
+      }
+   }
+}
+
+// end
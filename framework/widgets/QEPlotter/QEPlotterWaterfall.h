@@ -0,0 +1,104 @@
+/*  QEPlotterWaterfall.h
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+#ifndef QEPLOTTERWATERFALL_H
+#define QEPLOTTERWATERFALL_H
+
+#include <QImage>
+#include <QPixmap>
+#include <QRgb>
+#include <QVector>
+#include <QWidget>
+
+//==============================================================================
+// Displays the history of a waveform as an image, one row per update, newest
+// row at the top.
+//
+// The rows are held in a fixed size ring image. Each new row is converted to
+// colour using a 256 entry lookup table (the same false colour scheme as used
+// by QEImage, see QEFalseColour), so only the new row is processed per update.
+//
+// The ring image is rendered, scaled to the widget size, into a display pixmap.
+// When a row is added, the display pixmap and widget are scrolled down, and only
+// the new row is drawn and repainted. The whole ring image is only re-rendered
+// when the widget is resized or the history is cleared.
+//
+// All rows use the same colour range, i.e. the range given with the first row
+// after the history is cleared is latched.
+//
+class QEPlotterWaterfall : public QWidget {
+   Q_OBJECT
+public:
+   explicit QEPlotterWaterfall (QWidget* parent = 0);
+   ~QEPlotterWaterfall ();
+
+   // Number of rows of history. Changing the number of rows clears the history.
+   //
+   void setNumberOfRows (const int rows);
+   int getNumberOfRows () const;
+
+   void setFalseColour (const bool falseColour);
+   bool getFalseColour () const;
+
+   // Clears the history, and releases the latched colour range.
+   //
+   void clear ();
+
+   // Adds the first number values of data as the newest row. Values are mapped
+   // to colours over the latched range, where the first and last colour lookup
+   // table entries are the range's minimum and maximum. If no range is latched,
+   // minimum to maximum becomes the latched range (provided maximum > minimum).
+   // The history is cleared if the number of values changes.
+   //
+   void appendRow (const QVector<double>& data, const int number,
+                   const double minimum, const double maximum);
+
+   // Returns true, and the latched colour range, if a range is latched.
+   //
+   bool getColourRange (double& minimum, double& maximum) const;
+
+protected:
+   void paintEvent (QPaintEvent* event);
+
+private:
+   void buildColourLookup ();
+   void renderDisplay ();                 // (re)render the whole display pixmap
+   void addDisplayRow ();                 // scroll display pixmap and draw newest row
+
+   QImage image;               // ring image - one row per update
+   QPixmap display;            // the ring image as displayed, scaled to the widget size
+   QVector<QRgb> colourLookup;
+   bool falseColour;
+   int numberOfRows;
+   int newestRow;              // row index of the newest row within the image
+   int rowsDisplayed;          // rows added to the display since it was rendered
+
+   bool rangeIsLatched;
+   double rangeMinimum;
+   double rangeMaximum;
+};
+
+#endif  // QEPLOTTERWATERFALL_H
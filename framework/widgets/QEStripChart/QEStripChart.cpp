@@ -53,6 +53,7 @@
 #include <alarm.h>
 
 #include <QECommon.h>
+#include <QERenderScheduler.h>
 #include <QCaObject.h>
 #include <QELabel.h>
 #include <QCaVariableNamePropertyManager.h>
@@ -410,6 +411,16 @@ void QEStripChart::calcDisplayMinMax ()
 //
 void QEStripChart::recalculateData ()
 {
+   // Calculations only use earlier slots as inputs, so calculating in slot
+   // order ensures calculations based on other calculations are up to date.
+   //
+   for (unsigned int slot = 0; slot < NUMBER_OF_PVS; slot++) {
+      QEStripChartItem* item = this->getItem (slot);
+      if (item && item->isCalculation ()) {
+         item->calculateData ();
+      }
+   }
+
    // Last - clear flag.
    //
    this->recalcIsRequired = false;
@@ -417,7 +428,7 @@ void QEStripChart::recalculateData ()
 
 //------------------------------------------------------------------------------
 //
-void QEStripChart::plotData ()
+void QEStripChart::plotData (const bool isIncremental)
 {
    unsigned int slot;
    double d;
@@ -457,7 +468,7 @@ void QEStripChart::plotData ()
    //
    for (slot = 0; slot < NUMBER_OF_PVS; slot++) {
       if (this->getItem (slot)->isInUse ()) {
-          this->getItem (slot)->plotData ();
+          this->getItem (slot)->plotData (isIncremental);
       }
    }
 
@@ -502,9 +513,11 @@ void QEStripChart::plotData ()
    yRangeStatus.append (" scale");
    this->toolBar->setYRangeStatus (yRangeStatus);
 
-   // Last - clear flag.
+   // Last - clear flags.
    //
    this->replotIsRequired = false;
+   this->plotIsPending = false;
+   this->lastPlotTime.restart ();
 }
 
 //------------------------------------------------------------------------------
@@ -765,15 +778,16 @@ QEStripChart::QEStripChart (QWidget * parent) : QEFrame (parent)
    this->timeDialog = new QEStripChartTimeDialog (this);
    this->yRangeDialog = new QEStripChartRangeDialog (this);
 
-   // Refresh the strip chart at 1Hz.
+   // Refresh the strip chart at up to the update rate (limited by the render
+   // scheduler's frame rate), and replot at least once per second.
    //
-   this->tickTimer = new QTimer (this);
-   this->tickTimerCount = 0;
    this->replotIsRequired = true; // ensure process on first tick.
    this->recalcIsRequired = false;
+   this->updateRate = 1;
+   this->plotIsPending = false;
+   this->lastPlotTime.start ();
 
-   connect (this->tickTimer, SIGNAL (timeout ()), this, SLOT (tickTimeout ()));
-   this->tickTimer->start (50);  // mSec = 0.05 s
+   QERenderScheduler::attach (this, SLOT (tickTimeout (const bool)));
 
    // Enable drag drop onto this widget.
    //
@@ -787,7 +801,7 @@ QEStripChart::QEStripChart (QWidget * parent) : QEFrame (parent)
 //
 QEStripChart::~QEStripChart ()
 {
-   this->tickTimer->stop ();
+   QERenderScheduler::detach (this);
 }
 
 //------------------------------------------------------------------------------
@@ -920,24 +934,43 @@ int QEStripChart::addPvName (const QString& pvName)
 
 //------------------------------------------------------------------------------
 //
-void QEStripChart::tickTimeout ()
+void QEStripChart::tickTimeout (const bool isSecondTick)
 {
-   this->tickTimerCount = (this->tickTimerCount + 1) % 20;
+   // isSecondTick - 1 second has passed - must replot.
+   //
+   const bool isNewData = this->recalcIsRequired;
 
    if (this->recalcIsRequired) {
       this->recalculateData ();
    }
 
-   if ((this->tickTimerCount % 20) == 0) {
-      // 20th update, i.e. 1 second has passed - must replot.
-      this->replotIsRequired = true;
-   }
-
    if (this->replotIsRequired) {
+      // Zoom, pan, scale change etc. - rebuild all curves.
+      //
       if (this->chartTimeMode == QEStripChartNames::tmRealTime) {
          this->setEndDateTime (QDateTime::currentDateTime ());
       }
-      this->plotData ();  // clears replotIsRequired
+      this->plotData (false);  // clears replotIsRequired
+
+   } else if (this->chartTimeMode == QEStripChartNames::tmRealTime) {
+      // Real time - just add any new points to the existing curves and
+      // shift the time axis. New data is plotted no more often than the
+      // update rate, and the chart always scrolls on the second tick.
+      //
+      if (isNewData) {
+         this->plotIsPending = true;
+      }
+
+      const bool isDue = this->plotIsPending && (this->updateRate > 1) &&
+                         (this->lastPlotTime.elapsed () >= 1000 / this->updateRate);
+
+      if (isSecondTick || isDue) {
+         this->setEndDateTime (QDateTime::currentDateTime ());
+         this->plotData (true);  // clears replotIsRequired
+      }
+
+   } else if (isSecondTick) {
+      this->plotData (false);
    }
 }
 
@@ -1227,6 +1260,20 @@ void QEStripChart::setDuration (int durationIn)
    }
 }
 
+//------------------------------------------------------------------------------
+//
+int QEStripChart::getUpdateRate () const
+{
+   return this->updateRate;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChart::setUpdateRate (int updateRateIn)
+{
+   this->updateRate = LIMIT (updateRateIn, 1, 20);
+}
+
 //----------------------------------------------------------------------------
 //
 double QEStripChart::getYMinimum () const
@@ -37,6 +37,7 @@
 #include <QObject>
 #include <QPointF>
 #include <QSize>
+#include <QElapsedTimer>
 #include <QTimer>
 #include <QVariant>
 #include <QScrollArea>
@@ -76,6 +77,12 @@ class QEPLUGINLIBRARYSHARED_EXPORT QEStripChart : public QEFrame {
    Q_PROPERTY (double  yMinimum   READ getYMinimum               WRITE setYMinimum)
    Q_PROPERTY (double  yMaximum   READ getYMaximum               WRITE setYMaximum)
 
+   // Real time mode refresh rate (Hz), 1 to 20, default 1. The chart is replotted
+   // once per second regardless. Higher rates add incremental replots as new data
+   // arrives, limited to this rate and to the render scheduler's frame rate.
+   //
+   Q_PROPERTY (int     updateRate READ getUpdateRate             WRITE setUpdateRate)
+
    // Note, a property macro in the form 'Q_PROPERTY(QString variableName READ ...' doesn't work.
    // A property name ending with 'Name' results in some sort of string a variable being displayed,
    // but will only accept alphanumeric and won't generate callbacks on change.
@@ -140,6 +147,9 @@ public:
    int getDuration () const;
    void setDuration (int durationIn);
 
+   int getUpdateRate () const;
+   void setUpdateRate (int updateRateIn);
+
    double getYMinimum () const;
    void setYMinimum (const double yMinimumIn);
 
@@ -195,7 +205,7 @@ private:
    // Recalculates plots chart data
    //
    void recalculateData ();
-   void plotData ();
+   void plotData (const bool isIncremental = false);
 
    // Internal widgets and state data.
    //
@@ -230,13 +240,17 @@ private:
 
    QEStripChartStateList chartStateList;
 
-   // Timer to keep strip chart scrolling
+   // The strip chart is kept scrolling by the shared render scheduler.
    //
-   QTimer* tickTimer;
-   int tickTimerCount;
    bool replotIsRequired;
    bool recalcIsRequired;
 
+   // Real time incremental replots are limited to updateRate per second.
+   //
+   int updateRate;
+   bool plotIsPending;          // new data not yet plotted
+   QElapsedTimer lastPlotTime;
+
    // Chart time range in seconds.
    //
    int duration;
@@ -313,7 +327,7 @@ private:
    void menuSetYScale (QEStripChartNames::ChartYRanges ys);
 
 private slots:
-   void tickTimeout ();
+   void tickTimeout (const bool isSecondTick);
 
    // From tool bar
    //
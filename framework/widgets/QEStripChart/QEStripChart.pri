@@ -28,7 +28,9 @@ HEADERS += \
     widgets/QEStripChart/QEStripChart.h \
     widgets/QEStripChart/QEStripChartState.h \
     widgets/QEStripChart/QEStripChartAdjustPVDialog.h \
+    widgets/QEStripChart/QEStripChartArchiveCache.h \
     widgets/QEStripChart/QEStripChartContextMenu.h \
+    widgets/QEStripChart/QEStripChartDataBuffer.h \
     widgets/QEStripChart/QEStripChartDurationDialog.h \
     widgets/QEStripChart/QEStripChartItem.h \
     widgets/QEStripChart/QEStripChartNames.h \
@@ -43,7 +45,9 @@ SOURCES += \
     widgets/QEStripChart/QEStripChart.cpp \
     widgets/QEStripChart/QEStripChartState.cpp \
     widgets/QEStripChart/QEStripChartAdjustPVDialog.cpp \
+    widgets/QEStripChart/QEStripChartArchiveCache.cpp \
     widgets/QEStripChart/QEStripChartContextMenu.cpp \
+    widgets/QEStripChart/QEStripChartDataBuffer.cpp \
     widgets/QEStripChart/QEStripChartDurationDialog.cpp \
     widgets/QEStripChart/QEStripChartItem.cpp \
     widgets/QEStripChart/QEStripChartRangeDialog.cpp \
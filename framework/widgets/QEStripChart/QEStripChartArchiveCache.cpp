@@ -0,0 +1,396 @@
+/*  QEStripChartArchiveCache.cpp
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ *
+ */
+
+
+#include <math.h>
+#include <alarm.h>
+#include <QDebug>
+#include <QList>
+
+#include "QEStripChartDataBuffer.h"
+#include "QEStripChartArchiveCache.h"
+
+#define DEBUG  qDebug () << "QEStripChartArchiveCache::" << __FUNCTION__ << ":" << __LINE__
+
+static const double levelZeroSpan = 15.0;    // seconds
+static const int maximumLevel = 32;          // 15 s * 2^32 - way more than enough
+static const int tilesPerWindow = 4;         // minimum, so 4 to 6 in practice
+static const int pointsPerTile = 1000;
+static const int maximumTiles = 240;         // per PV
+
+// A tile that ends more than this before it was read is deemed complete.
+// Otherwise it is re-read if more than refreshInterval has elapsed.
+//
+static const double archiveLatency = 300.0;  // seconds
+static const double refreshInterval = 30.0;  // seconds
+
+//==============================================================================
+//
+QEStripChartArchiveCache::QEStripChartArchiveCache (QObject* parent) : QObject (parent)
+{
+   this->how = QEArchiveInterface::Linear;
+   this->usage = 0;
+   this->clear ();
+
+   QObject::connect (&this->archiveAccess, SIGNAL (setArchiveData (const QObject *, const bool, const QCaDataPointList &)),
+                     this,                 SLOT   (setArchiveData (const QObject *, const bool, const QCaDataPointList &)));
+}
+
+//------------------------------------------------------------------------------
+//
+QEStripChartArchiveCache::~QEStripChartArchiveCache ()
+{
+   // Request tokens are children of this object - no explicit delete required.
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartArchiveCache::setMessageSourceId (unsigned int messageSourceId)
+{
+   this->archiveAccess.setMessageSourceId (messageSourceId);
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartArchiveCache::setPvName (const QString& pvNameIn)
+{
+   if (this->pvName != pvNameIn) {
+      this->pvName = pvNameIn;
+      this->clear ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartArchiveCache::setHow (const QEArchiveInterface::How howIn)
+{
+   if (this->how != howIn) {
+      this->how = howIn;
+      this->clear ();
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartArchiveCache::clear ()
+{
+   // Note: outstanding request tokens are left in the pending hash table. They
+   // are deleted when/if the response arrives, and the response discarded.
+   // This ensures a token address is not re-used while a request is outstanding.
+   //
+   this->tiles.clear ();
+   this->windowIsDefined = false;
+   this->windowLevel = 0;
+   this->windowFirst = 0;
+   this->windowLast = -1;
+}
+
+//------------------------------------------------------------------------------
+//
+bool QEStripChartArchiveCache::setWindow (const QCaDateTime& startDateTime,
+                                          const QCaDateTime& endDateTime,
+                                          const bool reload)
+{
+   const double startTime = QEStripChartDataBuffer::toSeconds (startDateTime);
+   const double endTime = QEStripChartDataBuffer::toSeconds (endDateTime);
+   const double duration = endTime - startTime;
+   int level;
+   qint64 first;
+   qint64 last;
+   bool result;
+
+   // Choose the level such that the window covers a few tiles.
+   //
+   level = 0;
+   while ((level < maximumLevel) && (tilesPerWindow * tileSpan (level) < duration)) {
+      level++;
+   }
+
+   const double span = tileSpan (level);
+   first = (qint64) floor (startTime / span);
+   last = (qint64) ceil (endTime / span) - 1;
+   if (last < first) last = first;
+
+   result = !this->windowIsDefined || reload ||
+            (level != this->windowLevel) ||
+            (first != this->windowFirst) || (last != this->windowLast);
+
+   this->windowIsDefined = true;
+   this->windowLevel = level;
+   this->windowFirst = first;
+   this->windowLast = last;
+
+   // Request the window tiles first, then those either side, so that the
+   // requests for tiles that are to be displayed now are queued first.
+   //
+   this->usage++;
+   for (qint64 index = first; index <= last; index++) {
+      this->requestTile (TileKey (level, index), reload);
+   }
+   this->requestTile (TileKey (level, first - 1), false);
+   if (tileStart (TileKey (level, last + 1)) < now ()) {
+      this->requestTile (TileKey (level, last + 1), false);
+   }
+
+   this->discardTiles ();
+
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+QCaDataPointList QEStripChartArchiveCache::getData () const
+{
+   QCaDataPointList result;
+   QCaDataPoint previous;
+   bool previousIsDefined;
+   bool gapIsRequired;
+
+   if (!this->windowIsDefined) return result;
+
+   // Find the last point before the window's first tile, from either the tile
+   // before (if held) or any points before the tile start returned with the
+   // first tile, so that the value at the start of the window is known.
+   //
+   previousIsDefined = false;
+   for (int k = -1; k <= 0; k++) {
+      const TileKey key (this->windowLevel, this->windowFirst + k);
+      const Tile tile = this->tiles.value (key);
+      const double start = tileStart (TileKey (this->windowLevel, this->windowFirst));
+
+      if (!tile.isReady) continue;
+      for (int j = 0; j < tile.points.count (); j++) {
+         const QCaDataPoint point = tile.points.value (j);
+         if (QEStripChartDataBuffer::toSeconds (point.datetime) >= start) break;
+         previous = point;
+         previousIsDefined = true;
+      }
+   }
+
+   if (previousIsDefined) {
+      result.append (previous);
+   }
+
+   gapIsRequired = false;
+   for (qint64 index = this->windowFirst; index <= this->windowLast; index++) {
+      const TileKey key (this->windowLevel, index);
+      const Tile tile = this->tiles.value (key);
+      const double start = tileStart (key);
+      const double end = tileEnd (key);
+
+      if (!tile.isReady) {
+         // Tile not (yet) available - insert an invalid point so that the
+         // value is not drawn across the gap.
+         //
+         if (!gapIsRequired && result.count () > 0) {
+            QCaDataPoint gap;
+            gap.value = 0.0;
+            gap.datetime = toDateTime (start);
+            gap.alarm = QCaAlarmInfo (NO_ALARM, INVALID_ALARM);
+            result.append (gap);
+         }
+         gapIsRequired = true;
+         continue;
+      }
+      gapIsRequired = false;
+
+      // Each tile contributes its own time span only. Points after the end of
+      // the last tile are kept as they may be used as the following point.
+      //
+      for (int j = 0; j < tile.points.count (); j++) {
+         const QCaDataPoint point = tile.points.value (j);
+         const double t = QEStripChartDataBuffer::toSeconds (point.datetime);
+         if (t < start) continue;
+         if ((t >= end) && (index < this->windowLast)) break;
+         result.append (point);
+      }
+   }
+
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartArchiveCache::setArchiveData (const QObject* userData, const bool okay,
+                                               const QCaDataPointList& archiveData)
+{
+   if (!this->pending.contains (userData)) {
+      return;   // not one of ours.
+   }
+
+   const TileKey key = this->pending.take (userData);
+   QMap<TileKey, Tile>::iterator it = this->tiles.find (key);
+   const bool isCurrent = (it != this->tiles.end ()) && (it.value ().token == userData);
+
+   delete userData;
+
+   if (!isCurrent) {
+      // The tile has since been discarded or re-requested.
+      //
+      return;
+   }
+
+   Tile& tile = it.value ();
+   tile.token = NULL;
+
+   if (okay) {
+      tile.points = archiveData;
+      tile.isReady = true;
+      tile.isFailed = false;
+      tile.isComplete = (tileEnd (key) + archiveLatency) < tile.fetchTime;
+
+      if (this->isInWindow (key)) {
+         emit this->dataChanged ();
+      }
+   } else if (!tile.isReady) {
+      // Retain any old data, otherwise mark as failed so that we don't keep
+      // asking. An explicit reload will re-request the tile.
+      //
+      tile.isFailed = true;
+      DEBUG << "archive read failed" << this->pvName << key.first << key.second;
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartArchiveCache::requestTile (const TileKey& key, const bool reload)
+{
+   if (this->pvName.isEmpty ()) return;
+
+   const double timeNow = now ();
+   Tile& tile = this->tiles [key];   // creates a new tile if needs be
+   bool doRequest;
+
+   if (tile.token) {
+      // Outstanding request - only re-request if asked to.
+      //
+      doRequest = reload;
+   } else if (tile.isReady) {
+      doRequest = !tile.isComplete &&
+                  (reload || (timeNow - tile.fetchTime) >= refreshInterval);
+   } else if (tile.isFailed) {
+      doRequest = reload;
+   } else {
+      doRequest = true;   // new tile
+   }
+
+   tile.lastUsed = this->usage;
+
+   if (!doRequest) return;
+
+   // Any previous token remains in the pending table until its response arrives.
+   //
+   QObject* token = new QObject (this);
+   tile.token = token;
+   tile.fetchTime = timeNow;
+   this->pending.insert (token, key);
+
+   this->archiveAccess.readArchive (token, this->pvName,
+                                    toDateTime (tileStart (key)),
+                                    toDateTime (tileEnd (key)),
+                                    pointsPerTile, this->how, 0);
+}
+
+//------------------------------------------------------------------------------
+//
+bool QEStripChartArchiveCache::isInWindow (const TileKey& key) const
+{
+   // Include the tile before the window as it may provide the initial value.
+   //
+   return this->windowIsDefined &&
+          (key.first == this->windowLevel) &&
+          (key.second >= this->windowFirst - 1) &&
+          (key.second <= this->windowLast);
+}
+
+//------------------------------------------------------------------------------
+// Discard least recently used tiles once more than the maximum are held.
+//
+void QEStripChartArchiveCache::discardTiles ()
+{
+   const int excess = this->tiles.count () - maximumTiles;
+   if (excess <= 0) return;
+
+   // Find candidate tiles - those without outstanding requests, and not part of
+   // the current window or its neighbours.
+   //
+   QList<QPair<qint64, TileKey> > candidates;
+   QMap<TileKey, Tile>::const_iterator it;
+   for (it = this->tiles.constBegin (); it != this->tiles.constEnd (); ++it) {
+      const TileKey key = it.key ();
+      if (it.value ().token) continue;
+      if ((key.first == this->windowLevel) &&
+          (key.second >= this->windowFirst - 1) &&
+          (key.second <= this->windowLast + 1)) continue;
+      candidates.append (QPair<qint64, TileKey> (it.value ().lastUsed, key));
+   }
+
+   qSort (candidates);   // oldest first
+
+   for (int j = 0; j < excess && j < candidates.count (); j++) {
+      this->tiles.remove (candidates.value (j).second);
+   }
+}
+
+//------------------------------------------------------------------------------
+// static
+double QEStripChartArchiveCache::tileSpan (const int level)
+{
+   return ldexp (levelZeroSpan, level);
+}
+
+//------------------------------------------------------------------------------
+// static
+double QEStripChartArchiveCache::tileStart (const TileKey& key)
+{
+   return double (key.second) * tileSpan (key.first);
+}
+
+//------------------------------------------------------------------------------
+// static
+double QEStripChartArchiveCache::tileEnd (const TileKey& key)
+{
+   return double (key.second + 1) * tileSpan (key.first);
+}
+
+//------------------------------------------------------------------------------
+// static
+QCaDateTime QEStripChartArchiveCache::toDateTime (const double seconds)
+{
+   const double s = (seconds > 0.0) ? seconds : 0.0;
+   const double whole = floor (s);
+   return QCaDateTime ((unsigned long) whole, (unsigned long) ((s - whole) * 1.0E9));
+}
+
+//------------------------------------------------------------------------------
+// static
+double QEStripChartArchiveCache::now ()
+{
+   return QEStripChartDataBuffer::toSeconds (QCaDateTime (QDateTime::currentDateTime ()));
+}
+
+// end
@@ -0,0 +1,139 @@
+/*  QEStripChartArchiveCache.h
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ *
+ */
+
+
+#ifndef QSTRIPCHARTARCHIVECACHE_H
+#define QSTRIPCHARTARCHIVECACHE_H
+
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QPair>
+#include <QString>
+
+#include <QCaDataPoint.h>
+#include <QCaDateTime.h>
+#include <QEArchiveManager.h>
+
+//==============================================================================
+// Per PV cache of archive data, used by strip chart items so that panning and
+// zooming through history does not refetch data already read.
+//
+// Time is divided into tiles. There are a number of resolution levels, the tile
+// span doubling from one level to the next, and each tile is read from the
+// archive as a separate request of a fixed number of points. The level used is
+// chosen from the window duration such that a window covers a few tiles, so the
+// resolution of the data read matches what can be displayed.
+//
+// Setting the window requests only those tiles not already held, together with
+// the tiles either side of the window (prefetch), and the data returned for the
+// window is spliced together from the held tiles. Tiles that end close to the
+// time they were read may be incomplete (the archiver may not have the data yet)
+// and are refreshed from time to time.
+//
+class QEStripChartArchiveCache : public QObject {
+   Q_OBJECT
+public:
+   explicit QEStripChartArchiveCache (QObject* parent = 0);
+   ~QEStripChartArchiveCache ();
+
+   void setMessageSourceId (unsigned int messageSourceId);
+
+   // Changing either of these discards all held tiles.
+   //
+   void setPvName (const QString& pvName);
+   void setHow (const QEArchiveInterface::How how);
+
+   void clear ();
+
+   // True once a window has been set, i.e. archive data has been asked for.
+   //
+   bool isActive () const { return this->windowIsDefined; }
+
+   // Sets the time window, and requests missing tiles. When reload is true, tiles
+   // not known to be complete, failed and outstanding requests are all re-requested.
+   // Returns true if the tiles that make up the window have changed, i.e. getData
+   // may now return different data.
+   //
+   bool setWindow (const QCaDateTime& startTime, const QCaDateTime& endTime,
+                   const bool reload);
+
+   // Splice together the held tiles for the current window. Tiles not yet held
+   // appear as a gap, i.e. an invalid point at the start of the tile.
+   //
+   QCaDataPointList getData () const;
+
+signals:
+   // Emitted when a tile within the current window has been read.
+   //
+   void dataChanged ();
+
+private:
+   typedef QPair<int, qint64> TileKey;      // level, index
+
+   struct Tile {
+      Tile () : token (NULL), fetchTime (0.0), lastUsed (0),
+                isReady (false), isComplete (false), isFailed (false) {}
+
+      QCaDataPointList points;
+      const QObject* token;    // identifies outstanding request, else NULL
+      double fetchTime;        // time of last request
+      qint64 lastUsed;         // used to determine which tiles to discard
+      bool isReady;            // points available
+      bool isComplete;         // no need to re-read
+      bool isFailed;
+   };
+
+   static double tileSpan (const int level);
+   static double tileStart (const TileKey& key);
+   static double tileEnd (const TileKey& key);
+   static QCaDateTime toDateTime (const double seconds);
+   static double now ();
+
+   void requestTile (const TileKey& key, const bool reload);
+   bool isInWindow (const TileKey& key) const;
+   void discardTiles ();
+
+   QEArchiveAccess archiveAccess;
+   QString pvName;
+   QEArchiveInterface::How how;
+
+   QMap<TileKey, Tile> tiles;
+   QHash<const QObject*, TileKey> pending;    // outstanding requests
+   qint64 usage;
+
+   bool windowIsDefined;
+   int windowLevel;
+   qint64 windowFirst;
+   qint64 windowLast;
+
+private slots:
+   void setArchiveData (const QObject* userData, const bool okay,
+                        const QCaDataPointList& archiveData);
+};
+
+#endif  // QSTRIPCHARTARCHIVECACHE_H
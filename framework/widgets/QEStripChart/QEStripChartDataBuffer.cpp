@@ -0,0 +1,1039 @@
+/*  QEStripChartDataBuffer.cpp
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ *
+ */
+
+#include <math.h>
+#include <QDebug>
+#include <QECommon.h>
+
+#include "QEStripChartDataBuffer.h"
+
+#define DEBUG  qDebug () << "QEStripChartDataBuffer::" << __FUNCTION__ << ":" << __LINE__
+
+//==============================================================================
+//
+QEStripChartDataBuffer::QEStripChartDataBuffer (const int capacityIn)
+{
+   this->capacity = (capacityIn >= 1) ? capacityIn : 1;
+   this->treeBase = 0;        // the tree is allocated as points are added
+   this->head = 0;
+   this->number = 0;
+   this->generation = 0;
+   this->appendCount = 0;
+   this->truncations = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+QEStripChartDataBuffer::~QEStripChartDataBuffer ()
+{
+}
+
+//------------------------------------------------------------------------------
+// Storage is released, and only allocated again as points are added.
+//
+void QEStripChartDataBuffer::clear ()
+{
+   this->seconds.clear ();
+   this->nanoSeconds.clear ();
+   this->values.clear ();
+   this->status.clear ();
+   this->severity.clear ();
+   this->displayable.clear ();
+   this->tree.clear ();
+   this->treeBase = 0;
+
+   this->head = 0;
+   this->number = 0;
+   this->generation++;
+   this->appendCount = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartDataBuffer::append (const QCaDataPoint& point)
+{
+   int p;
+
+   if (this->number < this->capacity) {
+      p = this->physical (this->number);
+      if (p == this->values.count ()) {
+         // Not full yet - the columns grow as required.
+         //
+         this->seconds.append (point.datetime.getSeconds ());
+         this->nanoSeconds.append (point.datetime.getNanoSeconds ());
+         this->values.append (point.value);
+         this->status.append (point.alarm.status);
+         this->severity.append (point.alarm.severity);
+         this->displayable.append (point.isDisplayable ());
+      } else {
+         // Not full, but has been truncated since it was full.
+         //
+         this->seconds [p] = point.datetime.getSeconds ();
+         this->nanoSeconds [p] = point.datetime.getNanoSeconds ();
+         this->values [p] = point.value;
+         this->status [p] = point.alarm.status;
+         this->severity [p] = point.alarm.severity;
+         this->displayable [p] = point.isDisplayable ();
+      }
+      this->number++;
+   } else {
+      // Full - overwrite the oldest point.
+      //
+      p = this->head;
+      this->seconds [p] = point.datetime.getSeconds ();
+      this->nanoSeconds [p] = point.datetime.getNanoSeconds ();
+      this->values [p] = point.value;
+      this->status [p] = point.alarm.status;
+      this->severity [p] = point.alarm.severity;
+      this->displayable [p] = point.isDisplayable ();
+      this->head = (this->head + 1) % this->capacity;
+   }
+
+   // The segment tree grows with the data, so a buffer with a large capacity
+   // only uses memory for the points actually held.
+   //
+   if (p / BUCKET_SIZE >= this->treeBase) {
+      this->growTree (p / BUCKET_SIZE + 1);
+   }
+
+   this->updateBucket (p / BUCKET_SIZE);
+
+   // The previous point's weight is the time until this point, so its bucket
+   // also needs to be updated if it is a different bucket.
+   //
+   if (this->number >= 2) {
+      const int q = this->physical (this->number - 2);
+      if ((q / BUCKET_SIZE) != (p / BUCKET_SIZE)) {
+         this->updateBucket (q / BUCKET_SIZE);
+      }
+   }
+
+   this->appendCount++;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartDataBuffer::truncate (const int newCount)
+{
+   if ((newCount < 0) || (newCount >= this->number)) return;
+
+   const int removed = this->number - newCount;
+
+   if (newCount == 0) {
+      // Nothing left - release storage, as per clear.
+      //
+      this->seconds.clear ();
+      this->nanoSeconds.clear ();
+      this->values.clear ();
+      this->status.clear ();
+      this->severity.clear ();
+      this->displayable.clear ();
+      this->tree.clear ();
+      this->treeBase = 0;
+      this->head = 0;
+      this->number = 0;
+
+   } else if (this->head == 0) {
+      // The points are held in order - just shorten the columns.
+      //
+      this->seconds.resize (newCount);
+      this->nanoSeconds.resize (newCount);
+      this->values.resize (newCount);
+      this->status.resize (newCount);
+      this->severity.resize (newCount);
+      this->displayable.resize (newCount);
+      this->number = newCount;
+
+   } else {
+      // The ring has wrapped - the removed positions are overwritten as
+      // new points are appended.
+      //
+      this->number = newCount;
+   }
+
+   // The newest point's bucket includes removed points, and its weight was
+   // the time to the next (now removed) point.
+   //
+   if (this->number > 0) {
+      this->updateBucket (this->physical (this->number - 1) / BUCKET_SIZE);
+   }
+
+   this->appendCount -= removed;
+   this->truncatedTo [this->truncations % TRUNCATION_HISTORY] = this->appendCount;
+   this->truncations++;
+}
+
+//------------------------------------------------------------------------------
+//
+bool QEStripChartDataBuffer::getTruncatedTo (const int since, qint64& result) const
+{
+   if ((since > this->truncations) ||
+       (this->truncations - since > TRUNCATION_HISTORY)) return false;
+
+   result = this->appendCount;
+   for (int t = since; t < this->truncations; t++) {
+      result = MIN (result, this->truncatedTo [t % TRUNCATION_HISTORY]);
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartDataBuffer::assign (const QCaDataPointList& list)
+{
+   const int n = list.count ();
+
+   this->clear ();
+   for (int j = (n > this->capacity) ? n - this->capacity : 0; j < n; j++) {
+      this->append (list.value (j));
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+QCaDataPoint QEStripChartDataBuffer::value (const int j) const
+{
+   QCaDataPoint result;
+
+   if ((j >= 0) && (j < this->number)) {
+      const int p = this->physical (j);
+      result.value = this->values [p];
+      result.datetime = QCaDateTime (this->seconds [p], this->nanoSeconds [p]);
+      result.alarm = QCaAlarmInfo (this->status [p], this->severity [p]);
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+QCaDataPoint QEStripChartDataBuffer::last () const
+{
+   return this->value (this->number - 1);
+}
+
+//------------------------------------------------------------------------------
+//
+double QEStripChartDataBuffer::timeAt (const int j) const
+{
+   const int p = this->physical (j);
+   return (double) this->seconds [p] + 1.0E-9 * (double) this->nanoSeconds [p];
+}
+
+//------------------------------------------------------------------------------
+//
+double QEStripChartDataBuffer::valueAt (const int j) const
+{
+   return this->values [this->physical (j)];
+}
+
+//------------------------------------------------------------------------------
+//
+bool QEStripChartDataBuffer::isDisplayableAt (const int j) const
+{
+   return this->displayable [this->physical (j)];
+}
+
+//------------------------------------------------------------------------------
+//
+int QEStripChartDataBuffer::lowerBound (const double t) const
+{
+   int lo = 0;
+   int hi = this->number;
+
+   while (lo < hi) {
+      const int mid = (lo + hi) / 2;
+      if (this->timeAt (mid) < t) {
+         lo = mid + 1;
+      } else {
+         hi = mid;
+      }
+   }
+   return lo;
+}
+
+//------------------------------------------------------------------------------
+//
+int QEStripChartDataBuffer::upperBound (const double t) const
+{
+   int lo = 0;
+   int hi = this->number;
+
+   while (lo < hi) {
+      const int mid = (lo + hi) / 2;
+      if (this->timeAt (mid) <= t) {
+         lo = mid + 1;
+      } else {
+         hi = mid;
+      }
+   }
+   return lo;
+}
+
+//------------------------------------------------------------------------------
+//
+QEStripChartDataBuffer::Summary QEStripChartDataBuffer::getSummary (const int firstIn,
+                                                                    const int lastIn) const
+{
+   Summary result;
+   clearSummary (result);
+
+   const int first = (firstIn >= 0) ? firstIn : 0;
+   const int last = (lastIn < this->number) ? lastIn : this->number - 1;
+
+   if (first > last) return result;  // empty range
+
+   // Map to physical positions. The range is either one contiguous run of
+   // the columns, or it wraps around the end of the ring.
+   //
+   const int p0 = this->physical (first);
+   const int p1 = this->physical (last);
+
+   if (p0 <= p1) {
+      this->physicalSummary (p0, p1, result);
+   } else {
+      this->physicalSummary (p0, this->values.count () - 1, result);
+      this->physicalSummary (0, p1, result);
+   }
+
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+QEDisplayRanges QEStripChartDataBuffer::getMinMax (const int first, const int last) const
+{
+   QEDisplayRanges result;
+   const Summary summary = this->getSummary (first, last);
+
+   if (summary.number > 0) {
+      result.setRange (summary.minimum, summary.maximum);
+   }
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+QEDisplayRanges QEStripChartDataBuffer::getMinMax () const
+{
+   return this->getMinMax (0, this->number - 1);
+}
+
+//------------------------------------------------------------------------------
+//
+QEDisplayRanges QEStripChartDataBuffer::getMinMax (const double startTime,
+                                                   const double endTime) const
+{
+   const int first = this->lowerBound (startTime);
+   const int last = this->upperBound (endTime) - 1;
+
+   // Include the point before the window (if any) - getSummary ignores index -1.
+   //
+   return this->getMinMax (first - 1, last);
+}
+
+//------------------------------------------------------------------------------
+//
+QEStripChartDataBuffer::Summary QEStripChartDataBuffer::getSummary (const double startTime,
+                                                                    const double endTime) const
+{
+   const int first = this->lowerBound (startTime);
+   const int last = this->upperBound (endTime) - 1;
+   Summary result;
+
+   clearSummary (result);
+
+   // The point before the window only contributes its value held from the
+   // start of the window up to the first point (or end of the window).
+   //
+   if ((first > 0) && this->isDisplayableAt (first - 1)) {
+      const double until = (first <= last) ? this->timeAt (first) : endTime;
+      addWeight (result, this->valueAt (first - 1), until - startTime);
+   }
+
+   if (first > last) return result;   // no points within the window
+
+   // All but the last point in the window - weights are the time until the
+   // next point, which is within the window, so may be taken from the tree.
+   //
+   mergeSummary (result, this->getSummary (first, last - 1));
+
+   // The last point's weight is clipped to the end of the window.
+   //
+   if (this->isDisplayableAt (last)) {
+      const double t = this->timeAt (last);
+      const double until = (last + 1 < this->number) ?
+                           MIN (this->timeAt (last + 1), endTime) : endTime;
+      Summary lastPoint;
+      clearSummary (lastPoint);
+      addPoint (lastPoint, t, this->valueAt (last), until - t);
+      mergeSummary (result, lastPoint);
+   }
+
+   return result;
+}
+
+//------------------------------------------------------------------------------
+// Append the (unique) indices of a run of displayable points within a pixel column
+// in time order. The run is defined by its first, min, max and last points.
+//
+static void appendRun (QVector<int>& result,
+                       const int runFirst, const int runMin,
+                       const int runMax, const int runLast)
+{
+   if (runFirst < 0) return;   // empty run
+
+   int list [4] = { runFirst, runMin, runMax, runLast };
+
+   // Sort the four indices - insertion sort is fine for four items.
+   //
+   for (int i = 1; i < 4; i++) {
+      const int x = list [i];
+      int k = i - 1;
+      while ((k >= 0) && (list [k] > x)) {
+         list [k + 1] = list [k];
+         k--;
+      }
+      list [k + 1] = x;
+   }
+
+   for (int i = 0; i < 4; i++) {
+      if ((i == 0) || (list [i] != list [i - 1])) {
+         result.append (list [i]);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//
+QVector<int> QEStripChartDataBuffer::decimate (const int firstIn, const int lastIn,
+                                               const double origin,
+                                               const double columnWidth) const
+{
+   QVector<int> result;
+
+   const int first = (firstIn >= 0) ? firstIn : 0;
+   const int last = (lastIn < this->number) ? lastIn : this->number - 1;
+
+   if (first > last) return result;   // nothing to plot
+
+   if (columnWidth <= 0.0) {
+      result.reserve (last - first + 1);
+      for (int j = first; j <= last; j++) {
+         result.append (j);
+      }
+      return result;
+   }
+
+   bool previousIsDisplayable = true;
+   int j = first;
+
+   while (j <= last) {
+      const qint64 column = columnOf (this->timeAt (j), origin, columnWidth);
+
+      int runFirst = -1;
+      int runMin = -1;
+      int runMax = -1;
+      int runLast = -1;
+      double minValue = 0.0;
+      double maxValue = 0.0;
+
+      // Process all the points in this column.
+      //
+      for (; j <= last; j++) {
+         const int p = this->physical (j);
+         if (columnOf (this->physicalTime (p), origin, columnWidth) != column) break;
+
+         if (this->displayable [p]) {
+            const double v = this->values [p];
+            if (runFirst < 0) {
+               runFirst = runMin = runMax = j;
+               minValue = maxValue = v;
+            } else if (v < minValue) {
+               runMin = j;
+               minValue = v;
+            } else if (v > maxValue) {
+               runMax = j;
+               maxValue = v;
+            }
+            runLast = j;
+            previousIsDisplayable = true;
+
+         } else {
+            // Non-displayable point - this breaks the line, so close off the
+            // run so far and keep this point (unless the previous point
+            // already broke the line).
+            //
+            appendRun (result, runFirst, runMin, runMax, runLast);
+            runFirst = -1;
+
+            if (previousIsDisplayable) {
+               result.append (j);
+            }
+            previousIsDisplayable = false;
+         }
+      }
+
+      appendRun (result, runFirst, runMin, runMax, runLast);
+   }
+
+   return result;
+}
+
+//------------------------------------------------------------------------------
+// static
+qint64 QEStripChartDataBuffer::columnOf (const double t, const double origin,
+                                         const double columnWidth)
+{
+   return (qint64) floor ((t - origin) / columnWidth);
+}
+
+//------------------------------------------------------------------------------
+// static
+double QEStripChartDataBuffer::toSeconds (const QCaDateTime& datetime)
+{
+   return (double) datetime.getSeconds () + 1.0E-9 * (double) datetime.getNanoSeconds ();
+}
+
+//------------------------------------------------------------------------------
+//
+int QEStripChartDataBuffer::physical (const int j) const
+{
+   int p = this->head + j;
+   if (p >= this->capacity) p -= this->capacity;
+   return p;
+}
+
+//------------------------------------------------------------------------------
+//
+double QEStripChartDataBuffer::physicalTime (const int p) const
+{
+   return (double) this->seconds [p] + 1.0E-9 * (double) this->nanoSeconds [p];
+}
+
+//------------------------------------------------------------------------------
+// The weight of the point at physical position p, i.e. the time to the next
+// point. The newest point has no next point, so has no weight (yet).
+//
+double QEStripChartDataBuffer::physicalWeight (const int p) const
+{
+   if (p == this->physical (this->number - 1)) return 0.0;
+
+   const int next = (p + 1 < this->capacity) ? p + 1 : 0;
+   const double w = this->physicalTime (next) - this->physicalTime (p);
+   return (w > 0.0) ? w : 0.0;   // guard against out of order points
+}
+
+//------------------------------------------------------------------------------
+// Re-allocate the segment tree with at least the given number of leaves. The
+// number of leaves is doubled (up to that required for the capacity) so that
+// the cost of growing the tree is amortised over the points added.
+//
+void QEStripChartDataBuffer::growTree (const int buckets)
+{
+   const int maxBuckets = (this->capacity + BUCKET_SIZE - 1) / BUCKET_SIZE;
+   int base = MAX (2 * this->treeBase, 1);
+
+   while (base < buckets) {
+      base *= 2;
+   }
+   // No need to go past the power of two required for the capacity.
+   //
+   while ((base > 1) && (base / 2 >= maxBuckets)) {
+      base /= 2;
+   }
+   if (base <= this->treeBase) return;
+
+   Summary empty;
+   clearSummary (empty);
+
+   QVector<Summary> grown (2 * base, empty);
+
+   // Copy the existing leaves and rebuild the nodes above them.
+   //
+   for (int bucket = 0; bucket < this->treeBase; bucket++) {
+      grown [base + bucket] = this->tree [this->treeBase + bucket];
+   }
+   for (int node = base - 1; node >= 1; node--) {
+      grown [node] = grown [2 * node];
+      mergeSummary (grown [node], grown [2 * node + 1]);
+   }
+
+   this->tree = grown;
+   this->treeBase = base;
+}
+
+//------------------------------------------------------------------------------
+// Recalculate a bucket's summary from its points, and update the tree above it.
+// The whole bucket is rescanned (rather than merging the new point) as once the
+// buffer is full the point overwritten may have been the bucket's min or max.
+//
+void QEStripChartDataBuffer::updateBucket (const int bucket)
+{
+   const int from = bucket * BUCKET_SIZE;
+   int to = from + BUCKET_SIZE - 1;
+   if (to >= this->values.count ()) to = this->values.count () - 1;
+
+   int node = this->treeBase + bucket;
+   clearSummary (this->tree [node]);
+   this->scanSummary (from, to, this->tree [node]);
+
+   for (node = node / 2; node >= 1; node = node / 2) {
+      Summary& s = this->tree [node];
+      s = this->tree [2 * node];
+      mergeSummary (s, this->tree [2 * node + 1]);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Merge points at physical positions from to to (inclusive) into the summary.
+//
+void QEStripChartDataBuffer::scanSummary (const int from, const int to,
+                                          Summary& summary) const
+{
+   for (int p = from; p <= to; p++) {
+      if (this->displayable [p]) {
+         addPoint (summary, this->physicalTime (p), this->values [p],
+                   this->physicalWeight (p));
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// Merge points at physical positions from to to (inclusive) into the summary.
+// Buckets wholly within the range come from the segment tree, only the partial
+// buckets at each end are scanned.
+//
+void QEStripChartDataBuffer::physicalSummary (const int from, const int to,
+                                              Summary& summary) const
+{
+   const int size = this->values.count ();
+
+   // First and last buckets wholly within the range. The last bucket may be
+   // short if the buffer is not full - it is whole if the range reaches its end.
+   //
+   const int firstWhole = (from + BUCKET_SIZE - 1) / BUCKET_SIZE;
+   const int lastWhole = ((to == size - 1) ? (to / BUCKET_SIZE + 1) : ((to + 1) / BUCKET_SIZE)) - 1;
+
+   if (firstWhole > lastWhole) {
+      // Range within (at most) two buckets - just scan it.
+      //
+      this->scanSummary (from, to, summary);
+      return;
+   }
+
+   this->scanSummary (from, firstWhole * BUCKET_SIZE - 1, summary);
+
+   // Standard bottom up segment tree query over the half open range [l, r).
+   // The nodes on the right are collected separately so that the summaries
+   // are merged in time order, as needed for the first and last points.
+   //
+   Summary right;
+   clearSummary (right);
+
+   int l = this->treeBase + firstWhole;
+   int r = this->treeBase + lastWhole + 1;
+   while (l < r) {
+      if (l & 1) mergeSummary (summary, this->tree [l++]);
+      if (r & 1) {
+         Summary node = this->tree [--r];
+         mergeSummary (node, right);
+         right = node;
+      }
+      l = l / 2;
+      r = r / 2;
+   }
+   mergeSummary (summary, right);
+
+   this->scanSummary ((lastWhole + 1) * BUCKET_SIZE, to, summary);
+}
+
+//------------------------------------------------------------------------------
+// static
+void QEStripChartDataBuffer::clearSummary (Summary& summary)
+{
+   summary.minimum = 0.0;
+   summary.maximum = 0.0;
+   summary.sum = 0.0;
+   summary.number = 0;
+
+   summary.firstTime = 0.0;
+   summary.firstValue = 0.0;
+   summary.lastTime = 0.0;
+   summary.lastValue = 0.0;
+
+   summary.meanTime = 0.0;
+   summary.meanValue = 0.0;
+   summary.m2Time = 0.0;
+   summary.coMoment = 0.0;
+
+   summary.weight = 0.0;
+   summary.weightedMean = 0.0;
+   summary.weightedM2 = 0.0;
+}
+
+//------------------------------------------------------------------------------
+// static
+void QEStripChartDataBuffer::mergeSummary (Summary& summary, const Summary& other)
+{
+   // The weighted part is merged first - a summary may have weight but no points,
+   // i.e. when it only holds the value of the point before a window.
+   //
+   if (other.weight > 0.0) {
+      const double w = summary.weight + other.weight;
+      const double delta = other.weightedMean - summary.weightedMean;
+
+      summary.weightedM2 += other.weightedM2 + delta * delta * summary.weight * other.weight / w;
+      summary.weightedMean += delta * other.weight / w;
+      summary.weight = w;
+   }
+
+   if (other.number == 0) return;
+
+   if (summary.number == 0) {
+      const double weight = summary.weight;
+      const double weightedMean = summary.weightedMean;
+      const double weightedM2 = summary.weightedM2;
+
+      summary = other;
+      summary.weight = weight;
+      summary.weightedMean = weightedMean;
+      summary.weightedM2 = weightedM2;
+      return;
+   }
+
+   if (other.minimum < summary.minimum) summary.minimum = other.minimum;
+   if (other.maximum > summary.maximum) summary.maximum = other.maximum;
+   summary.sum += other.sum;
+
+   summary.lastTime = other.lastTime;
+   summary.lastValue = other.lastValue;
+
+   const double na = summary.number;
+   const double nb = other.number;
+   const double n = na + nb;
+   const double dt = other.meanTime - summary.meanTime;
+   const double dv = other.meanValue - summary.meanValue;
+
+   summary.m2Time += other.m2Time + dt * dt * na * nb / n;
+   summary.coMoment += other.coMoment + dt * dv * na * nb / n;
+   summary.meanTime += dt * nb / n;
+   summary.meanValue += dv * nb / n;
+   summary.number += other.number;
+}
+
+//------------------------------------------------------------------------------
+// static - Welford's algorithm.
+//
+void QEStripChartDataBuffer::addPoint (Summary& summary, const double t,
+                                       const double v, const double w)
+{
+   if (summary.number == 0) {
+      summary.minimum = v;
+      summary.maximum = v;
+      summary.firstTime = t;
+      summary.firstValue = v;
+   } else {
+      if (v < summary.minimum) summary.minimum = v;
+      if (v > summary.maximum) summary.maximum = v;
+   }
+   summary.lastTime = t;
+   summary.lastValue = v;
+   summary.sum += v;
+   summary.number++;
+
+   const double dt = t - summary.meanTime;
+   const double dv = v - summary.meanValue;
+   summary.meanTime += dt / summary.number;
+   summary.meanValue += dv / summary.number;
+   summary.m2Time += dt * (t - summary.meanTime);
+   summary.coMoment += dt * (v - summary.meanValue);
+
+   addWeight (summary, v, w);
+}
+
+//------------------------------------------------------------------------------
+// static - weighted form of Welford's algorithm (West).
+//
+void QEStripChartDataBuffer::addWeight (Summary& summary, const double v, const double w)
+{
+   if (w <= 0.0) return;
+
+   summary.weight += w;
+   const double delta = v - summary.weightedMean;
+   summary.weightedMean += delta * w / summary.weight;
+   summary.weightedM2 += w * delta * (v - summary.weightedMean);
+}
+
+//==============================================================================
+//
+QEStripChartCurveCache::QEStripChartCurveCache ()
+{
+   this->generation = -1;
+   this->reset ();
+}
+
+//------------------------------------------------------------------------------
+//
+QEStripChartCurveCache::~QEStripChartCurveCache ()
+{
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartCurveCache::reset ()
+{
+   this->curves.clear ();
+   this->curves.append (Curve ());
+   this->previousIsDisplayable = false;
+   this->origin = 0.0;
+   this->columnWidth = 0.0;
+   this->truncations = 0;
+   this->processed = 0;
+   this->resumeStates.clear ();
+}
+
+//------------------------------------------------------------------------------
+//
+bool QEStripChartCurveCache::update (const QEStripChartDataBuffer& buffer,
+                                     const double startTime, const double endTime,
+                                     const double columnWidthIn, const bool rebuild)
+{
+   // Sequence number of the point at index 0 in the buffer.
+   //
+   const qint64 base = buffer.getAppendCount () - buffer.count ();
+   const int last = buffer.upperBound (endTime) - 1;
+   bool isRebuild;
+   int next = 0;
+
+   isRebuild = rebuild ||
+               (buffer.getGeneration () != this->generation) ||
+               (columnWidthIn != this->columnWidth);
+
+   if (!isRebuild) {
+      this->trim (startTime);
+
+      // The first point to (re)process is the first new point, or the first
+      // point that replaced points removed by truncation.
+      //
+      qint64 from = this->processed;
+      if (buffer.getTruncations () != this->truncations) {
+         qint64 truncatedTo;
+         if (buffer.getTruncatedTo (this->truncations, truncatedTo)) {
+            from = MIN (from, truncatedTo);
+         } else {
+            from = -1;    // unknown - rebuild
+         }
+         this->truncations = buffer.getTruncations ();
+      }
+
+      // Nothing more to do if there are no new or replaced points up to the end time.
+      //
+      if ((from == this->processed) && (base + last < this->processed)) return false;
+
+      // Discard the vertices from the column of that point on, and decimate
+      // again from the start of that column. Otherwise start again.
+      //
+      if ((from >= 0) && this->resume (from) && (this->resumeStates.last ().sequence >= base)) {
+         next = (int) (this->resumeStates.last ().sequence - base);
+         this->resumeStates.removeLast ();    // re-added when the column is processed
+      } else {
+         isRebuild = true;
+      }
+   }
+
+   if (isRebuild) {
+      this->reset ();
+      this->generation = buffer.getGeneration ();
+      this->truncations = buffer.getTruncations ();
+      this->columnWidth = columnWidthIn > 0.0 ? columnWidthIn : 1.0;
+      this->origin = startTime;
+
+      // Start from the last point before the chart start time, as its value
+      // holds at the start of the chart.
+      //
+      next = buffer.lowerBound (startTime) - 1;
+      if (next < 0) next = 0;
+   }
+
+   const QVector<int> indices = buffer.decimate (next, last, this->origin, this->columnWidth);
+
+   qint64 lastColumn = 0;
+   for (int k = 0; k < indices.count (); k++) {
+      const int j = indices.value (k);
+      const double t = buffer.timeAt (j);
+      const qint64 column = QEStripChartDataBuffer::columnOf (t, this->origin, this->columnWidth);
+
+      // Note the state at the start of each column.
+      //
+      if ((k == 0) || (column != lastColumn)) {
+         ResumeState state;
+         state.sequence = base + j;
+         state.curves = this->curves.count ();
+         state.start = this->curves.last ().t.count ();
+         state.previousIsDisplayable = this->previousIsDisplayable;
+         this->resumeStates.append (state);
+         if (this->resumeStates.count () > MAXIMUM_RESUME_STATES) {
+            this->resumeStates.removeFirst ();
+         }
+         lastColumn = column;
+      }
+
+      this->addPoint (t - this->origin, buffer.valueAt (j), buffer.isDisplayableAt (j));
+   }
+
+   this->processed = base + MAX (last + 1, next);
+
+   return isRebuild;
+}
+
+//------------------------------------------------------------------------------
+// Restores the curves to their state before the column that includes the point
+// with the given sequence number was added. Returns false if that state is not
+// known, i.e. it is not one of the most recent columns. On success, the last
+// resume state is that of the column.
+//
+bool QEStripChartCurveCache::resume (const qint64 sequence)
+{
+   while (!this->resumeStates.isEmpty () && (this->resumeStates.last ().sequence > sequence)) {
+      this->resumeStates.removeLast ();
+   }
+   if (this->resumeStates.isEmpty ()) return false;
+
+   const ResumeState& state = this->resumeStates.last ();
+
+   while (this->curves.count () > state.curves) {
+      this->curves.removeLast ();
+   }
+   Curve& curve = this->curves.last ();
+   curve.t.resize (state.start);
+   curve.y.resize (state.start);
+   this->previousIsDisplayable = state.previousIsDisplayable;
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartCurveCache::getCurve (const int n, const double endTime,
+                                       QVector<double>& tdata, QVector<double>& ydata) const
+{
+   const Curve& curve = this->curves.at (n);
+   const double offset = this->origin - endTime;
+   const int count = curve.t.count ();
+
+   tdata.resize (count);
+   ydata.resize (count);
+   for (int j = 0; j < count; j++) {
+      tdata [j] = curve.t [j] + offset;
+      ydata [j] = curve.y [j];
+   }
+}
+
+//------------------------------------------------------------------------------
+// Do steps - do it like this as using qwt Step mode is not quite what is wanted.
+//
+void QEStripChartCurveCache::addPoint (const double t, const double v,
+                                       const bool isDisplayable)
+{
+   Curve& curve = this->curves.last ();
+
+   if (!isDisplayable) {
+      // The current point is unplotable (invalid/disconnected).
+      // Create a valid stopper point consisting of prev. point value and this
+      // point time, and start a new curve. Consecutive unplotable points have
+      // no further effect.
+      //
+      if (this->previousIsDisplayable && !curve.t.isEmpty ()) {
+         curve.t.append (t);
+         curve.y.append (curve.y.last ());
+         this->curves.append (Curve ());
+      }
+      this->previousIsDisplayable = false;
+      return;
+   }
+
+   if (!curve.t.isEmpty ()) {
+      curve.t.append (t);
+      curve.y.append (curve.y.last ());
+   }
+   curve.t.append (t);
+   curve.y.append (v);
+   this->previousIsDisplayable = true;
+}
+
+//------------------------------------------------------------------------------
+// Discard curves and vertices wholly before the start time. The last vertex
+// before the start time is kept so the line still reaches the chart edge.
+// Vertices are only removed in bulk to keep the cost of removal low.
+// The vertices from the oldest resumable column on are kept.
+//
+void QEStripChartCurveCache::trim (const double startTime)
+{
+   const double start = startTime - this->origin;
+   const int oldestCurves = this->resumeStates.isEmpty () ?
+                            this->curves.count () : this->resumeStates.first ().curves;
+
+   // Whole curves (before the oldest resumable column's curve) that end before
+   // the start time.
+   //
+   int removeCurves = 0;
+   while ((removeCurves < oldestCurves - 1) &&
+          (this->curves.at (removeCurves).t.last () < start)) {
+      removeCurves++;
+   }
+   if (removeCurves > 0) {
+      for (int j = 0; j < removeCurves; j++) {
+         this->curves.removeFirst ();
+      }
+      for (int j = 0; j < this->resumeStates.count (); j++) {
+         this->resumeStates [j].curves -= removeCurves;
+      }
+   }
+
+   Curve& curve = this->curves.first ();
+   const int count = curve.t.count ();
+   int k = 0;
+   while ((k < count) && (curve.t [k] < start)) k++;
+
+   int remove = k - 1;   // keep one vertex before start
+   if (remove < count / 2) return;   // not worth it yet
+
+   if ((oldestCurves - removeCurves == 1) && !this->resumeStates.isEmpty ()) {
+      remove = MIN (remove, this->resumeStates.first ().start);
+   }
+   if (remove <= 0) return;
+
+   curve.t.remove (0, remove);
+   curve.y.remove (0, remove);
+   for (int j = 0; j < this->resumeStates.count (); j++) {
+      if (this->resumeStates [j].curves == 1) {
+         this->resumeStates [j].start -= remove;
+      }
+   }
+}
+
+// end
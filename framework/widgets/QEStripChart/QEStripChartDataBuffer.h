@@ -0,0 +1,301 @@
+/*  QEStripChartDataBuffer.h
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ *
+ */
+
+#ifndef QSTRIPCHARTDATABUFFER_H
+#define QSTRIPCHARTDATABUFFER_H
+
+#include <QList>
+#include <QVector>
+
+#include <QCaDataPoint.h>
+#include <QCaDateTime.h>
+#include <QEDisplayRanges.h>
+
+//==============================================================================
+// Fixed capacity ring buffer of data points used to hold a strip chart item's
+// real time and historical data.
+//
+// Points are held by column (time, value, alarm) rather than as a list of
+// QCaDataPoint objects. Once full, each new point overwrites the oldest point.
+// Points are indexed from 0 (oldest) to count () - 1 (newest).
+//
+// The points are also grouped into fixed size buckets, and a segment tree holds
+// a summary of the displayable values in each bucket and each group of buckets.
+// Together with a binary search on time, this allows the range of values, and
+// the statistics, over any time window to be found in O(log n) without scanning
+// the points, so the buffer may hold millions of points.
+//
+// Note: the time search assumes points are appended in time order. Points that
+// arrive out of order are still held and plotted, but may be missed or included
+// at the edges of a time window.
+//
+class QEStripChartDataBuffer {
+public:
+   explicit QEStripChartDataBuffer (const int capacity);
+   ~QEStripChartDataBuffer ();
+
+   // Summary of the displayable values within a range of points.
+   //
+   // The means and sums of squared deviations are accumulated using Welford's
+   // algorithm, and summaries combined using the parallel form of the same
+   // (Chan et al), which avoids the loss of precision of sum of squares methods.
+   //
+   struct Summary {
+      double minimum;
+      double maximum;
+      double sum;
+      int number;          // number of displayable points
+
+      double firstTime;    // first and last displayable points (time order)
+      double firstValue;
+      double lastTime;
+      double lastValue;
+
+      double meanTime;     // seconds since EPICS epoch
+      double meanValue;
+      double m2Time;       // sum of (t - meanTime)^2
+      double coMoment;     // sum of (t - meanTime)*(v - meanValue)
+
+      // Time weighted, i.e. sample and hold, statistics - each point's weight is
+      // the time (seconds) until the next point, whether displayable or not.
+      //
+      double weight;
+      double weightedMean;
+      double weightedM2;   // sum of weight*(v - weightedMean)^2
+   };
+
+   void clear ();
+   int count () const { return this->number; }
+   int getCapacity () const { return this->capacity; }
+
+   // Users of the buffer may note these to determine which points are new.
+   // The generation changes whenever the buffer is cleared (or assigned), and
+   // the append count is the number of points appended since then, so the point
+   // at index j was the (getAppendCount () - count () + j)th point appended.
+   //
+   int getGeneration () const { return this->generation; }
+   qint64 getAppendCount () const { return this->appendCount; }
+
+   // Add a point, overwriting the oldest point if full.
+   //
+   void append (const QCaDataPoint& point);
+
+   // Removes the newest points, so that only the first newCount points remain.
+   // The append count is reduced by the number of points removed, i.e. the
+   // points subsequently appended re-use the removed points' append sequence.
+   // Users of the buffer note the number of truncations, and use getTruncatedTo
+   // to find the lowest append count truncated to since then. That returns false
+   // if this is no longer known, i.e. too many truncations since.
+   //
+   void truncate (const int newCount);
+   int getTruncations () const { return this->truncations; }
+   bool getTruncatedTo (const int since, qint64& appendCount) const;
+
+   // Replaces the buffer contents with the list of points.
+   // If the list exceeds the capacity, only the newest points are kept.
+   //
+   void assign (const QCaDataPointList& list);
+
+   // Point access.
+   //
+   QCaDataPoint value (const int j) const;
+   QCaDataPoint last () const;
+   double timeAt (const int j) const;      // seconds since EPICS epoch
+   double valueAt (const int j) const;
+   bool isDisplayableAt (const int j) const;
+
+   // Return the index of the first point with a time >= t (lowerBound) or
+   // with a time > t (upperBound). Returns count () if there is no such point.
+   //
+   int lowerBound (const double t) const;
+   int upperBound (const double t) const;
+
+   // Summarise the displayable values of points first to last inclusive.
+   //
+   Summary getSummary (const int first, const int last) const;
+   QEDisplayRanges getMinMax (const int first, const int last) const;
+   QEDisplayRanges getMinMax () const;    // all points
+
+   // Range of values plotted over a time window, i.e. the points within the
+   // window together with the last point before the window, as its value
+   // holds at the start of the window.
+   //
+   QEDisplayRanges getMinMax (const double startTime, const double endTime) const;
+
+   // Statistics over a time window. The point counts, min/max and first/last
+   // values are those of the points within the window. The time weighting is
+   // clipped to the window, and includes the point before the window, as its
+   // value holds at the start of the window. The newest point's value holds
+   // until the end of the window.
+   //
+   Summary getSummary (const double startTime, const double endTime) const;
+
+   // Combine summaries - the other summary must be for later points.
+   //
+   static void mergeSummary (Summary& summary, const Summary& other);
+   static void clearSummary (Summary& summary);
+
+   // Return the indices of the points first to last inclusive that are required
+   // to plot them across pixel columns of the given width (in seconds), where
+   // column boundaries are at origin + k * columnWidth.
+   // Within each column only the first, minimum, maximum and last displayable
+   // points are kept, so the plotted line still covers the full range of values.
+   // Non-displayable points are kept (as they break the line) but consecutive
+   // non-displayable points are reduced to the first.
+   //
+   QVector<int> decimate (const int first, const int last,
+                          const double origin, const double columnWidth) const;
+
+   // Return the pixel column of a time, as used by decimate.
+   //
+   static qint64 columnOf (const double t, const double origin, const double columnWidth);
+
+   // Convert a date time to seconds since EPICS epoch, as used for time searches.
+   //
+   static double toSeconds (const QCaDateTime& datetime);
+
+private:
+   enum { BUCKET_SIZE = 64,        // points per segment tree leaf
+          TRUNCATION_HISTORY = 16  // number of recent truncations held
+   };
+
+   int physical (const int j) const;
+   void growTree (const int buckets);
+   void updateBucket (const int bucket);
+   double physicalTime (const int p) const;
+   double physicalWeight (const int p) const;
+   void scanSummary (const int from, const int to, Summary& summary) const;
+   void physicalSummary (const int from, const int to, Summary& summary) const;
+
+   static void addPoint (Summary& summary, const double t, const double v, const double w);
+   static void addWeight (Summary& summary, const double v, const double w);
+
+   int capacity;
+   int head;         // physical index of the oldest point when full
+   int number;       // number of points held
+   int generation;   // incremented each time the buffer is cleared
+   qint64 appendCount;  // number of points appended since last cleared
+   int truncations;     // number of truncations
+   qint64 truncatedTo [TRUNCATION_HISTORY];   // append count after each recent truncation
+
+   // Data columns, indexed by physical position in the ring.
+   //
+   QVector<quint32> seconds;
+   QVector<quint32> nanoSeconds;
+   QVector<double> values;
+   QVector<quint16> status;
+   QVector<quint16> severity;
+   QVector<bool> displayable;
+
+   // Segment tree - leaves are at treeBase + bucket, the root is at 1.
+   // The number of leaves grows (as a power of two) as points are added.
+   //
+   QVector<Summary> tree;
+   int treeBase;
+};
+
+//==============================================================================
+// Holds the curves plotted for a data buffer, so that in real time mode only
+// points that have arrived since the previous plot need be processed.
+//
+// The points are decimated to pixel columns using QEStripChartDataBuffer::decimate,
+// and then converted to step curve vertices. Non-displayable points break the
+// line, so the vertices are held as a number of separate curves.
+//
+// Vertex times, and the decimation columns, are relative to a fixed origin rather
+// than to the chart end time, so they remain valid as the chart end time advances.
+// As new points may fall in the last column plotted, the vertices of that column
+// are discarded and the column decimated again on the next update. Likewise, if
+// the buffer has been truncated, the vertices from the column of the first point
+// removed are discarded, provided that column is one of the most recent columns.
+// Vertices that scroll off the start of the chart are discarded.
+//
+class QEStripChartCurveCache {
+public:
+   explicit QEStripChartCurveCache ();
+   ~QEStripChartCurveCache ();
+
+   void reset ();
+
+   // Bring the curves up to date with the buffer for a chart window from startTime
+   // to endTime, decimated into columns of the given width (in seconds).
+   // Only new points are processed unless rebuild is requested, or the buffer
+   // has been cleared or has overwritten points not yet processed, or has been
+   // truncated to before the most recent columns, or the column width has changed.
+   // Returns true if the curves were rebuilt.
+   //
+   bool update (const QEStripChartDataBuffer& buffer,
+                const double startTime, const double endTime,
+                const double columnWidth, const bool rebuild);
+
+   // Access the curves. Vertex times are returned relative to endTime.
+   //
+   int numberOfCurves () const { return this->curves.count (); }
+   void getCurve (const int n, const double endTime,
+                  QVector<double>& tdata, QVector<double>& ydata) const;
+
+   // True if the last curve is still open, i.e. the last point processed was
+   // displayable, so the value holds until (at least) the end of the chart.
+   //
+   bool lastCurveIsOpen () const { return this->previousIsDisplayable; }
+
+private:
+   struct Curve {
+      QVector<double> t;
+      QVector<double> y;
+   };
+
+   // State of the curves before a column was added, so that the curves can be
+   // restored to that state, and the column decimated again, when more points
+   // arrive or the buffer is truncated.
+   //
+   struct ResumeState {
+      qint64 sequence;        // buffer append sequence of first point of the column
+      int curves;             // number of curves
+      int start;              // number of vertices in the last curve
+      bool previousIsDisplayable;
+   };
+
+   enum { MAXIMUM_RESUME_STATES = 64 };   // number of recent columns that may be resumed
+
+   void addPoint (const double t, const double v, const bool isDisplayable);
+   bool resume (const qint64 sequence);     // restore state as at column of sequence
+   void trim (const double startTime);      // discard vertices before start time
+
+   QList<Curve> curves;       // the last curve is the one points are added to
+   bool previousIsDisplayable;
+
+   double origin;             // absolute time (seconds since EPICS epoch) vertex times relative to
+   double columnWidth;        // seconds
+   int generation;            // buffer generation processed
+   int truncations;           // buffer truncations processed
+   qint64 processed;          // buffer append sequence of next point to process
+
+   QList<ResumeState> resumeStates;   // most recent columns, oldest first
+};
+
+#endif  // QSTRIPCHARTDATABUFFER_H
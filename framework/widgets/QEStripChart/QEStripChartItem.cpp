@@ -44,9 +44,19 @@
 
 #define DEBUG  qDebug () <<  "QEStripChartItem::" <<  __FUNCTION__  << ":" << __LINE__
 
-// Standard Channel Access archiver only support 10K points
+// Maximum number of real time and historical points held for each PV.
+// Storage is only allocated as points arrive.
 //
-#define MAXIMUM_POINTS  10000
+#define MAXIMUM_POINTS  1000000
+
+// Number of merged input time points evaluated at a time by calculation items.
+//
+#define CALCULATION_CHUNK_SIZE  4096
+
+// Absolute times, seconds since EPICS epoch, before/after any real time.
+//
+#define BEFORE_ALL_TIME  (-1.0E25)
+#define AFTER_ALL_TIME   (+1.0E25)
 
 // Define colours: essentially RGB byte triplets
 //
@@ -73,7 +83,11 @@ static const QString regularTip ("Use context menu to modify PV attributes or do
 //
 QEStripChartItem::QEStripChartItem (QEStripChart* chartIn,
                                     unsigned int slotIn,
-                                    QWidget* parent) : QWidget (parent), QEWidget (this)
+                                    QWidget* parent) :
+   QWidget (parent),
+   QEWidget (this),
+   historicalTimeDataPoints (MAXIMUM_POINTS),
+   realTimeDataPoints (MAXIMUM_POINTS)
 {
    QColor defaultColour;
 
@@ -92,6 +106,8 @@ QEStripChartItem::QEStripChartItem (QEStripChart* chartIn,
    this->calculator = new QEExpressionEvaluation ();
    this->expression = "";
    this->expressionIsValid = false;
+   this->calcSplitTime = AFTER_ALL_TIME;
+   this->calcLastTime = BEFORE_ALL_TIME;
 
    // Set up other properties.
    //
@@ -139,7 +155,7 @@ QEStripChartItem::QEStripChartItem (QEStripChart* chartIn,
 
    // Assign the chart widget message source id the the associated archive access object.
    //
-   this->archiveAccess.setMessageSourceId (chartIn->getMessageSourceId ());
+   this->archiveCache.setMessageSourceId (chartIn->getMessageSourceId ());
 
    // Set up a connection to recieve variable name property changes.  The variable
    // name property manager class only delivers an updated variable name after the
@@ -150,10 +166,10 @@ QEStripChartItem::QEStripChartItem (QEStripChart* chartIn,
                      this,                        SLOT   (newVariableNameProperty (QString, QString, unsigned int)));
 
 
-   // Set up connection to archive access mamanger.
+   // Set up connection to archive data cache.
    //
-   QObject::connect (&this->archiveAccess, SIGNAL (setArchiveData (const QObject *, const bool, const QCaDataPointList &)),
-                     this,                 SLOT   (setArchiveData (const QObject *, const bool, const QCaDataPointList &)));
+   QObject::connect (&this->archiveCache, SIGNAL (dataChanged ()),
+                     this,                SLOT   (archiveDataChanged ()));
 
 
    this->connect (this->pvName, SIGNAL (customContextMenuRequested (const QPoint &)),
@@ -194,7 +210,7 @@ QEStripChartItem::QEStripChartItem (QEStripChart* chartIn,
 //
 QEStripChartItem::~QEStripChartItem ()
 {
-   // Place holder
+   delete this->calculator;
 }
 
 //------------------------------------------------------------------------------
@@ -242,10 +258,17 @@ void QEStripChartItem::clear ()
    this->previousQcaItem = NULL;
 
    this->displayedMinMax.clear ();
-   this->historicalMinMax.clear ();
-   this->realTimeMinMax.clear ();
    this->historicalTimeDataPoints.clear ();
    this->realTimeDataPoints.clear ();
+   this->archiveCache.clear ();
+
+   this->expression = "";
+   this->expressionIsValid = false;
+   this->calcGenerations.clear ();
+   this->calcSplitTime = AFTER_ALL_TIME;
+   this->calcLastTime = BEFORE_ALL_TIME;
+   this->calcMerged.clear ();
+   this->calcTruncations.clear ();
 
    this->useReceiveTime = false;
    this->archiveReadHow = QEArchiveInterface::Linear;
@@ -299,6 +322,24 @@ void QEStripChartItem::setPvName (QString pvName, QString substitutions)
    this->clear ();
    this->chart->evaluateAllowDrop ();   // move to strip chart proper??
 
+   // Has the user defined a calculation (as opposed to a PV name)?
+   // Note: no valid PV name starts with =.
+   //
+   const QString trimmedName = pvName.trimmed ();
+   if (trimmedName.left (1).compare (QString ("=")) == 0) {
+      this->expression = trimmedName.mid (1).trimmed ();
+      this->expressionIsValid = this->calculator->initialise (this->expression);
+      if (!this->expressionIsValid) {
+         DEBUG << "invalid expression" << this->expression << this->calculator->getCalcError ();
+      }
+
+      this->caLabel->setStyleSheet (inuseStyle);
+      this->dataKind = CalculationData;
+      this->setCaption ();
+      this->chart->setRecalcIsRequired ();
+      return;
+   }
+
    // We "know" that a QELabel has only one PV (index = 0).
    //
    this->caLabel->setVariableNameAndSubstitutions (pvName.trimmed (), substitutions, 0);
@@ -321,6 +362,9 @@ void QEStripChartItem::setPvName (QString pvName, QString substitutions)
 //
 QString QEStripChartItem::getPvName ()
 {
+   if (this->isCalculation ()) {
+      return QString ("=") + this->expression;
+   }
    return this->isInUse () ? this->caLabel->getSubstitutedVariableName (0) : "";
 }
 
@@ -340,8 +384,15 @@ void QEStripChartItem::setCaption ()
          caption.append (" ");
       }
 
-      substitutedPVName = this->caLabel->getSubstitutedVariableName (0);
-      caption.append (substitutedPVName);
+      if (this->isCalculation ()) {
+         caption.append ("=").append (this->expression);
+         if (!this->expressionIsValid) {
+            caption.append ("  (invalid)");
+         }
+      } else {
+         substitutedPVName = this->caLabel->getSubstitutedVariableName (0);
+         caption.append (substitutedPVName);
+      }
    }
 
    this->pvName->setText (caption);
@@ -415,8 +466,8 @@ QEDisplayRanges QEStripChartItem::getBufferedMinMax (bool doScale)
 {
    QEDisplayRanges result;
 
-   result = this->historicalMinMax;
-   result.merge (this->realTimeMinMax);
+   result = this->historicalTimeDataPoints.getMinMax ();
+   result.merge (this->realTimeDataPoints.getMinMax ());
 
    if (doScale) {
        result = this->scaling.value (result);
@@ -426,29 +477,18 @@ QEDisplayRanges QEStripChartItem::getBufferedMinMax (bool doScale)
 
 //------------------------------------------------------------------------------
 //
-void QEStripChartItem::plotDataPoints (const QCaDataPointList & dataPoints,
+void QEStripChartItem::plotDataPoints (const QEStripChartDataBuffer& dataPoints,
+                                       QEStripChartCurveCache& curves,
                                        const bool isRealTime,
-                                       QEDisplayRanges & plottedTrackRange)
+                                       const bool isIncremental)
 {
-
-// macro functions to convert real-world values to a plot values, doing safe log conversion if required.
-//
-#define PLOT_T(t) (t)
-#define PLOT_Y(y) (this->scaling.value (y))
-
-   const QCaDateTime end_time = this->chart->getEndDateTime ();
    const double duration = this->chart->getDuration ();
+   const double endSeconds = QEStripChartDataBuffer::toSeconds (this->chart->getEndDateTime ());
    QEGraphic* graphic = this->chart->plotArea;
 
    QVector<double> tdata;
    QVector<double> ydata;
-   int count;
-   int j;
-   QCaDataPoint point;
-   QCaDataPoint previous;
-   bool doesPreviousExist;
-   bool isFirstPoint;
-   double t;
+   int columns;
 
    if (!graphic) return;   // sanity check
 
@@ -456,117 +496,67 @@ void QEStripChartItem::plotDataPoints (const QCaDataPointList & dataPoints,
    graphic->setCurveStyle (QwtPlotCurve::Lines);
    graphic->setCurvePen (this->getPen ());
 
-   // Both values zero is deemed to be undefined.
+   // Decimate to a few points per pixel column, so that the cost of creating and
+   // rendering the curves depends on the plot width rather than the number of points.
    //
-   plottedTrackRange.clear ();
-   isFirstPoint = true;
-   doesPreviousExist = false;
+   columns = graphic->getCanvasSize ().width ();
+   if (columns <= 0) {
+      columns = graphic->width ();
+   }
+   columns = MAX (columns, 1);
 
-   count = dataPoints.count ();
-   for (j = 0; j < count; j++) {
-      point = dataPoints.value (j);
+   // Only new points are processed unless a full rebuild is required (or the
+   // cache decides one is required, e.g. because the canvas has been resized).
+   //
+   curves.update (dataPoints, endSeconds - duration, endSeconds,
+                  duration / double (columns), !isIncremental);
 
-      // Calculate the time of this point (in seconds) relative to the end of the chart.
-      //
-      t = end_time.secondsTo (point.datetime);
+   const int n = curves.numberOfCurves ();
+   for (int c = 0; c < n; c++) {
+      curves.getCurve (c, endSeconds, tdata, ydata);
 
-      if (t < -duration) {
-         // Point time is before current time range of the chart.
-         //
-         // Just save this point. Last time it is saved it will be the
-         // pen-ultimate point before the chart start time.
-         //
-         previous = point;
-
-         // Only "exists" if plottable.
+      // Real time extention to time now required?
+      //
+      if (isRealTime && (c == n - 1) && curves.lastCurveIsOpen () && (ydata.count () >= 1)) {
+         // Replicate last value upto end of chart.
          //
-         doesPreviousExist = point.isDisplayable ();  // (previous.alarm.isInvalid () == false);
-
+         tdata.append (0.0);
+         ydata.append (ydata.last ());
       }
-      else if ((t >= -duration) && (t <= 0.0)) {
-         // Point time is within current time range of the chart.
-         //
-         // Is it a valid point - can we sensible plot it?
-         //
-         if (point.isDisplayable ()) {
-            if (!this->firstPointIsDefined) {
-               this->firstPointIsDefined = true;
-               this->firstPoint = point;
-            }
-            // Yes we can.
-            //
-            // start edge effect required?
-            //
-            if (isFirstPoint && doesPreviousExist) {
-                tdata.append (PLOT_T (-duration));
-                ydata.append (PLOT_Y (previous.value));
-                plottedTrackRange.merge (previous.value);
-            }
-
-            // Do steps - do it like this as using qwt Step mode is not quite what I want.
-            //
-            if (ydata.count () >= 1) {
-               tdata.append (PLOT_T (t));
-               ydata.append (ydata.last ());   // copy don't need PLOT_Y
-            }
-
-            tdata.append (PLOT_T (t));
-            ydata.append (PLOT_Y (point.value));
-            plottedTrackRange.merge (point.value);
 
-         } else {
-            // plot what we have so far (need at least 2 points).
-            //
-            if (tdata.count () >= 1) {
-               // The current pont is unplotable (invalid/disconneted).
-               // Create  a valid stopper point consisting of prev. point value and this point time.
-               //
-               tdata.append (PLOT_T (t));
-               ydata.append (ydata.last ());   // is a copy - no PLOT_Y required.
-
-               graphic->plotCurveData (tdata, ydata);
-
-               tdata.clear ();
-               ydata.clear ();
-            }
+      if (ydata.count () >= 1) {
+         for (int j = 0; j < ydata.count (); j++) {
+            ydata [j] = this->scaling.value (ydata [j]);
          }
-
-         // We have processed at least one point now.
-         //
-         isFirstPoint = false;
-
-      } else {
-         // Point time is after current plot time of the chart.
-         // Move along - nothing more to see here.
-         //
-         break;
+         graphic->plotCurveData (tdata, ydata);
       }
    }
+}
 
-   // Start edge special required?
-   //
-   if (isFirstPoint && doesPreviousExist) {
-       tdata.append (PLOT_T (-duration));
-       ydata.append (PLOT_Y (previous.value));
-       plottedTrackRange.merge (previous.value);
-   }
+//------------------------------------------------------------------------------
+// Finds the first displayable point within the current time range of the chart.
+//
+bool QEStripChartItem::getFirstPlottedPoint (QCaDataPoint& point) const
+{
+   const double endSeconds = QEStripChartDataBuffer::toSeconds (this->chart->getEndDateTime ());
+   const double startSeconds = endSeconds - this->chart->getDuration ();
+   const QEStripChartDataBuffer* listArray [2];
 
-   // Plot what we have accumulated.
-   //
-   if (ydata.count () >= 1) {
-      // Real time extention to time now required?
-      //
-      if (isRealTime) {
-         // Replicate last value upto end of chart.
-         //
-         tdata.append (PLOT_T (0.0));
-         ydata.append (ydata.last ());   // is a copy - no PLOT_Y required.
+   listArray [0] = &this->historicalTimeDataPoints;
+   listArray [1] = &this->realTimeDataPoints;
+
+   for (int i = 0; i < 2; i++) {
+      const QEStripChartDataBuffer* list = listArray [i];
+      const int after = list->upperBound (endSeconds);
+
+      for (int j = list->lowerBound (startSeconds); j < after; j++) {
+         if (list->isDisplayableAt (j)) {
+            point = list->value (j);
+            return true;
+         }
       }
-      graphic->plotCurveData (tdata, ydata);
    }
-
-#undef PLOT_T
-#undef PLOT_Y
+   return false;
 }
 
 //------------------------------------------------------------------------------
@@ -575,14 +565,13 @@ QCaDataPointList QEStripChartItem::determinePlotPoints ()
 {
    const QCaDateTime end_time = this->chart->getEndDateTime ();
    const double duration = this->chart->getDuration ();
+   const double endSeconds = QEStripChartDataBuffer::toSeconds (end_time);
 
    QCaDataPointList result;
 
-   int count;
-   QCaDataPoint point;
-   double t;
-   bool isFirst;
-   QCaDataPointList* listArray [2];
+   int first;
+   int after;
+   const QEStripChartDataBuffer* listArray [2];
 
    // Create an array so that we loop over both lists.
    //
@@ -590,32 +579,28 @@ QCaDataPointList QEStripChartItem::determinePlotPoints ()
    listArray [1] = &this->realTimeDataPoints;
 
    for (int i = 0; i < 2; i++) {
-      QCaDataPointList* list = listArray [i];
-      isFirst = true;
-      count = list->count ();
-      for (int j = 0; j < count; j++) {
-         point = list->value (j);
+      const QEStripChartDataBuffer* list = listArray [i];
 
-         // Calculate the time of this point (in seconds) relative to the end of the chart.
-         //
-         t = end_time.secondsTo (point.datetime);
+      // Find the points within the current time range of the chart.
+      //
+      first = list->lowerBound (endSeconds - duration);
+      after = list->upperBound (endSeconds);
 
-         if ((t >= -duration) && (t <= 0.0)) {
-            // Point time is within current time range of the chart.
+      if (first < after) {
+         if (first > 0) {
+            // do one previous point.
             //
-            if (isFirst && (j > 0)) {
-               // do one previous point.
-               //
-               result.append (list->value (j - 1));
-            }
-            isFirst = false;
-            result.append (point);
-         } else if (t > 0.0) {
-            // do one follwing point, then  skip the rest.
-            result.append (point);
-            break;
+            result.append (list->value (first - 1));
+         }
+         for (int j = first; j < after; j++) {
+            result.append (list->value (j));
          }
       }
+
+      if (after < list->count ()) {
+         // do one follwing point, then  skip the rest.
+         result.append (list->value (after));
+      }
    }
 
    return result;
@@ -623,20 +608,80 @@ QCaDataPointList QEStripChartItem::determinePlotPoints ()
 
 //------------------------------------------------------------------------------
 //
-void QEStripChartItem::plotData ()
+QEStripChartDataBuffer::Summary QEStripChartItem::getStatistics (QCaDateTime& startTime,
+                                                                 QCaDateTime& endTime,
+                                                                 int& numberOfPoints) const
 {
-   QEDisplayRanges temp;
+   const double duration = this->chart->getDuration ();
+   QEStripChartDataBuffer::Summary result;
+   double endSeconds;
+   double startSeconds;
+   double splitSeconds;
+
+   endTime = this->chart->getEndDateTime ();
+   startTime = endTime.addSeconds (-duration);
+
+   endSeconds = QEStripChartDataBuffer::toSeconds (endTime);
+   startSeconds = endSeconds - duration;
 
+   // The historical data is truncated at the first real time point, so split
+   // the window there. Both queries are O(log n).
+   //
+   splitSeconds = endSeconds;
+   if (this->realTimeDataPoints.count () > 0) {
+      splitSeconds = this->realTimeDataPoints.timeAt (0);
+      splitSeconds = MAX (splitSeconds, startSeconds);
+      splitSeconds = MIN (splitSeconds, endSeconds);
+   }
+
+   result = this->historicalTimeDataPoints.getSummary (startSeconds, splitSeconds);
+   numberOfPoints = this->historicalTimeDataPoints.upperBound (splitSeconds) -
+                    this->historicalTimeDataPoints.lowerBound (startSeconds);
+
+   if (this->realTimeDataPoints.count () > 0) {
+      QEStripChartDataBuffer::mergeSummary
+            (result, this->realTimeDataPoints.getSummary (splitSeconds, endSeconds));
+      numberOfPoints += this->realTimeDataPoints.upperBound (endSeconds) -
+                        this->realTimeDataPoints.lowerBound (splitSeconds);
+   }
+
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartItem::plotData (const bool isIncremental)
+{
    this->displayedMinMax.clear ();
-   this->firstPointIsDefined = false;
+
+   // Input items are earlier slots, so have already been brought up to date.
+   //
+   if (this->isCalculation ()) {
+      this->calculateData ();
+   }
+
+   // Once the archive has been read, navigating through history takes data
+   // from the archive cache - missing tiles are requested as needs be.
+   //
+   if (!isIncremental && this->archiveCache.isActive () &&
+       (this->chart->chartTimeMode != QEStripChartNames::tmRealTime)) {
+      if (this->archiveCache.setWindow (this->chart->getStartDateTime (),
+                                        this->chart->getEndDateTime (), false)) {
+         this->setHistoricalData (this->archiveCache.getData ());
+      }
+   }
 
    if (this->lineDrawMode != QEStripChartNames::ldmHide) {
+      const double endSeconds = QEStripChartDataBuffer::toSeconds (this->chart->getEndDateTime ());
+      const double startSeconds = endSeconds - this->chart->getDuration ();
 
-      this->plotDataPoints (this->historicalTimeDataPoints, false, temp);
-      this->displayedMinMax.merge (temp);
+      this->plotDataPoints (this->historicalTimeDataPoints, this->historicalCurves,
+                            false, isIncremental);
+      this->displayedMinMax.merge (this->historicalTimeDataPoints.getMinMax (startSeconds, endSeconds));
 
-      this->plotDataPoints (this->realTimeDataPoints, true, temp);
-      this->displayedMinMax.merge (temp);
+      this->plotDataPoints (this->realTimeDataPoints, this->realTimeCurves,
+                            true, isIncremental);
+      this->displayedMinMax.merge (this->realTimeDataPoints.getMinMax (startSeconds, endSeconds));
    }
 
    // Sometimes the qca Item first used is not the qca Item we end up with, due the
@@ -673,17 +718,11 @@ void QEStripChartItem::setDataConnection (QCaConnectionInfo& connectionInfo, con
       point = this->realTimeDataPoints.last ();
       point.datetime = QDateTime::currentDateTime ().toUTC ();
       this->realTimeDataPoints.append (point);
-      if (this->realTimeDataPoints.count () > MAXIMUM_POINTS) {
-         this->realTimeDataPoints.removeFirst ();
-      }
 
       // create a dummy point with same time but marked invalid.
       //
       point.alarm = QCaAlarmInfo (NO_ALARM, INVALID_ALARM);
       this->realTimeDataPoints.append (point);
-      if (this->realTimeDataPoints.count () > MAXIMUM_POINTS) {
-         this->realTimeDataPoints.removeFirst ();
-      }
 
       this->chart->setRecalcIsRequired ();
    }
@@ -734,118 +773,417 @@ void QEStripChartItem::setDataValue (const QVariant& value, QCaAlarmInfo& alarm,
       point.datetime = datetime;
    }
 
-   if (point.isDisplayable ()) {
-      this->realTimeMinMax.merge (point.value);
-   }
+   // Once full, the oldest point is overwritten.
+   //
    this->realTimeDataPoints.append (point);
 
-   if (this->realTimeDataPoints.count () > MAXIMUM_POINTS) {
-      this->realTimeDataPoints.removeFirst ();
-   }
-
    this->chart->setRecalcIsRequired ();
 }
 
 //------------------------------------------------------------------------------
 //
-void QEStripChartItem::setArchiveData (const QObject *userData, const bool okay,
-                                       const QCaDataPointList & archiveData)
+void QEStripChartItem::setHistoricalData (const QCaDataPointList & archiveData)
 {
+   QCaDataPointList historicalData;
    QCaDateTime firstRealTime;
    QCaDateTime pointTime;
    int count;
    int j, last;
    QCaDataPoint point;
 
-   if ((userData == this) && (okay)) {
+   // Clear any existing data and save new data.
+   // Note: the archive cache has already stitched the tiles together.
+   //
+   historicalData = archiveData;
 
-      // Clear any existing data and save new data
-      // Maybe would could/should do some stiching together
+   // Have any data points been returned?
+   //
+   count = historicalData.count ();
+   if (count > 0) {
+
+      // Now throw away any historical data that overlaps with the real time data,
+      // there is no need for two copies. We keep the real time data as it is of
+      // a better quality.
       //
-      this->historicalTimeDataPoints.clear ();
-      this->historicalTimeDataPoints = archiveData;
+      // Find trucate time
+      //
+      if (this->realTimeDataPoints.count () > 0) {
+         firstRealTime = this->realTimeDataPoints.value (0).datetime;
+      } else {
+         firstRealTime = QDateTime::currentDateTime ().toUTC ();
+      }
 
+      // Purge all points with a time >= firstRealTime, except for the
+      // the very first point after first time.
+      //
+      last = count - 1;
+      for (j = last - 1; j >= 0; j--) {
+         point = historicalData.value (j);
+         pointTime = point.datetime;
+         if (pointTime >= firstRealTime) {
+            historicalData.removeLast ();  // i.e. j+1
+         } else {
+            // purge complete
+            break;
+         }
+      }
 
-      // Have any data points been returned?
+      // Tuncate the time of the last point left in historicalData
+      // to firstTime if needs be.
       //
-      count = this->historicalTimeDataPoints.count ();
-      if (count > 0) {
+      last = historicalData.count () - 1;
+      if (last >= 0) {
+         point = historicalData.value (last);
+         if (point.datetime > firstRealTime) {
+             point.datetime = firstRealTime;
+             historicalData.replace (last, point);
+         }
+      }
+   }
 
-         // Now throw away any historical data that overlaps with the real time data,
-         // there is no need for two copies. We keep the real time data as it is of
-         // a better quality.
-         //
-         // Find trucate time
-         //
-         if (this->realTimeDataPoints.count () > 0) {
-            firstRealTime = this->realTimeDataPoints.value (0).datetime;
-         } else {
-            firstRealTime = QDateTime::currentDateTime ().toUTC ();
+   // The min and max values of the remaining data points are available
+   // from the buffer's segment tree - no need to scan them here.
+   //
+   this->historicalTimeDataPoints.assign (historicalData);
+}
+
+//==============================================================================
+// A calculation input is the combined historical and real time data of an
+// input item. The historical data is truncated at the first real time point,
+// so the historical points followed by the real time points are in time order.
+//
+struct CalculationInput {
+   const QEStripChartDataBuffer* historical;
+   const QEStripChartDataBuffer* realTime;
+   int argument;              // user argument index, 0 => A, 1 => B etc.
+   int next;                  // index of the next point to be merged
+
+   // Sample and hold, i.e. current, value.
+   //
+   bool isHeld;
+   bool isDisplayable;
+   double value;
+   QCaAlarmInfo alarm;
+
+   int count () const {
+      return this->historical->count () + this->realTime->count ();
+   }
+
+   double timeAt (const int j) const {
+      const int h = this->historical->count ();
+      return (j < h) ? this->historical->timeAt (j) : this->realTime->timeAt (j - h);
+   }
+
+   QCaDataPoint pointAt (const int j) const {
+      const int h = this->historical->count ();
+      return (j < h) ? this->historical->value (j) : this->realTime->value (j - h);
+   }
+
+   // Index of the first point with a time > t.
+   //
+   int upperBound (const double t) const {
+      const int h = this->historical->count ();
+      const int j = this->historical->upperBound (t);
+      return (j < h) ? j : h + this->realTime->upperBound (t);
+   }
+
+   void hold (const int j) {
+      const QCaDataPoint point = this->pointAt (j);
+      this->isHeld = true;
+      this->isDisplayable = point.isDisplayable ();
+      this->value = point.value;
+      this->alarm = point.alarm;
+   }
+};
+
+//------------------------------------------------------------------------------
+// Returns the time of the first point of the buffer not yet merged, given the
+// buffer's append count and number of truncations as at the last merge, or
+// AFTER_ALL_TIME if all points have been merged.
+//
+static double firstUnmergedTime (const QEStripChartDataBuffer& buffer,
+                                 const qint64 merged, const int truncations)
+{
+   qint64 from = merged;
+
+   // Points merged and then removed by truncation have been replaced.
+   //
+   if (buffer.getTruncations () != truncations) {
+      qint64 truncatedTo;
+      if (buffer.getTruncatedTo (truncations, truncatedTo)) {
+         from = MIN (from, truncatedTo);
+      } else {
+         from = 0;    // unknown - assume all replaced
+      }
+   }
+
+   const qint64 base = buffer.getAppendCount () - buffer.count ();
+   const int j = (int) MAX (from - base, (qint64) 0);
+   return (j < buffer.count ()) ? buffer.timeAt (j) : AFTER_ALL_TIME;
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartItem::calculateData ()
+{
+   if (!this->isCalculation ()) return;
+
+   QList<CalculationInput> inputs;
+   QVector<int> generations;
+   double splitTime = AFTER_ALL_TIME;
+
+   // Only arguments used by the expression are inputs. Unused slots, or slots
+   // not in use, provide the default value of 0.0.
+   //
+   if (this->expressionIsValid) {
+      for (unsigned int arg = 0; arg < this->slot; arg++) {
+         if (!this->calculator->isArgumentUsed (QEExpressionEvaluation::Normal, arg)) continue;
+
+         QEStripChartItem* item = this->chart->getItem (arg);
+         if (!item || !item->isInUse ()) continue;
+
+         CalculationInput input;
+         input.historical = &item->historicalTimeDataPoints;
+         input.realTime = &item->realTimeDataPoints;
+         input.argument = arg;
+         input.next = 0;
+         input.isHeld = false;
+         input.isDisplayable = false;
+         input.value = 0.0;
+         inputs.append (input);
+
+         generations << arg << input.historical->getGeneration ()
+                     << input.realTime->getGeneration ();
+
+         if (input.realTime->count () > 0) {
+            splitTime = MIN (splitTime, input.realTime->timeAt (0));
          }
+      }
+   }
 
-         // Purge all points with a time >= firstRealTime, except for the
-         // the very first point after first time.
-         //
-         last = count - 1;
-         for (j = last - 1; j >= 0; j--) {
-            point = this->historicalTimeDataPoints.value (j);
-            pointTime = point.datetime;
-            if (pointTime >= firstRealTime) {
-               this->historicalTimeDataPoints.removeLast ();  // i.e. j+1
-            } else {
-               // purge complete
-               break;
+   // Start again if the inputs have changed or have been cleared or replaced,
+   // e.g. by new archive data, or the real time data has just started.
+   //
+   if ((generations != this->calcGenerations) ||
+       ((this->calcSplitTime >= AFTER_ALL_TIME) && (splitTime < AFTER_ALL_TIME))) {
+      this->calcGenerations = generations;
+      this->calcSplitTime = splitTime;
+      this->calcLastTime = BEFORE_ALL_TIME;
+      this->calcMerged.fill (0, 2 * inputs.count ());
+      this->calcTruncations.resize (2 * inputs.count ());
+      for (int k = 0; k < inputs.count (); k++) {
+         this->calcTruncations [2 * k] = inputs [k].historical->getTruncations ();
+         this->calcTruncations [2 * k + 1] = inputs [k].realTime->getTruncations ();
+      }
+      this->historicalTimeDataPoints.clear ();
+      this->realTimeDataPoints.clear ();
+   }
+
+   const int numberOfInputs = inputs.count ();
+   if (numberOfInputs == 0) return;
+
+   // Find the earliest input point not yet merged. Nothing to do if none.
+   //
+   double resumeTime = AFTER_ALL_TIME;
+   for (int k = 0; k < numberOfInputs; k++) {
+      const CalculationInput& input = inputs [k];
+      resumeTime = MIN (resumeTime,
+                        firstUnmergedTime (*input.historical, this->calcMerged [2 * k],
+                                           this->calcTruncations [2 * k]));
+      resumeTime = MIN (resumeTime,
+                        firstUnmergedTime (*input.realTime, this->calcMerged [2 * k + 1],
+                                           this->calcTruncations [2 * k + 1]));
+   }
+   if (resumeTime >= AFTER_ALL_TIME) return;
+
+   // A point arrived late, i.e. it is not newer than the last calculated point.
+   // Discard the calculated points from its time on, and recalculate from there.
+   //
+   if (resumeTime <= this->calcLastTime) {
+      this->historicalTimeDataPoints.truncate (this->historicalTimeDataPoints.lowerBound (resumeTime));
+      this->realTimeDataPoints.truncate (this->realTimeDataPoints.lowerBound (resumeTime));
+
+      const int h = this->historicalTimeDataPoints.count ();
+      const int r = this->realTimeDataPoints.count ();
+      this->calcLastTime = (r > 0) ? this->realTimeDataPoints.timeAt (r - 1) :
+                           (h > 0) ? this->historicalTimeDataPoints.timeAt (h - 1) :
+                           BEFORE_ALL_TIME;
+   }
+
+   // Resume from the last calculated point, holding the input values as at then.
+   //
+   int remaining = 0;
+   for (int k = 0; k < numberOfInputs; k++) {
+      CalculationInput& input = inputs [k];
+      input.next = input.upperBound (this->calcLastTime);
+      if (input.next > 0) {
+         input.hold (input.next - 1);
+      }
+      remaining += input.count () - input.next;
+   }
+
+   // There is at most one column per input point - size the column buffers
+   // to suit, up to the chunk size.
+   //
+   const int chunkSize = LIMIT (remaining, 1, CALCULATION_CHUNK_SIZE);
+
+   QEExpressionEvaluation::CalculateArguments userArguments;
+   QEExpressionEvaluation::CalculateArrayArguments arrayArguments;
+   const QCaAlarmInfo invalidAlarm (NO_ALARM, INVALID_ALARM);
+
+   this->calcTimes.resize (chunkSize);
+   this->calcDateTimes.resize (chunkSize);
+   this->calcAlarms.resize (chunkSize);
+   this->calcValid.resize (chunkSize);
+
+   QEExpressionEvaluation::clear (userArguments);
+   QEExpressionEvaluation::clear (arrayArguments);
+   for (int k = 0; k < numberOfInputs; k++) {
+      const int arg = inputs [k].argument;
+      this->calcArguments [arg].resize (chunkSize);
+      arrayArguments [QEExpressionEvaluation::Normal][arg] = &this->calcArguments [arg];
+   }
+
+   bool appended = false;
+   bool isMore = true;
+   while (isMore) {
+      // Merge the input time series, one column per distinct input point time,
+      // each column holding the input values as at that time.
+      //
+      int m = 0;
+      while (m < chunkSize) {
+         int which = -1;
+         double t = AFTER_ALL_TIME;
+         for (int k = 0; k < numberOfInputs; k++) {
+            const CalculationInput& input = inputs [k];
+            if (input.next < input.count ()) {
+               const double nextTime = input.timeAt (input.next);
+               if (nextTime < t) {
+                  t = nextTime;
+                  which = k;
+               }
             }
          }
 
-         // Tuncate the time of the last point left in historicalTimeDataPoints
-         // to firstTime if needs be.
-         //
-         last = this->historicalTimeDataPoints.count () - 1;
-         if (last >= 0) {
-            point = this->historicalTimeDataPoints.value (last);
-            if (point.datetime > firstRealTime) {
-                point.datetime = firstRealTime;
-                this->historicalTimeDataPoints.replace (last, point);
-            }
+         if (which < 0) {
+            isMore = false;    // all input points have been merged
+            break;
          }
 
-         // Now determine the min and max values of the remaining data points.
-         //
-         this->historicalMinMax.clear ();
-         count = this->historicalTimeDataPoints.count ();
-         for (j = 0; j < count; j++) {
-            point = this->historicalTimeDataPoints.value (j);
-            if (point.isDisplayable ()) {
-               this->historicalMinMax.merge (point.value);
+         this->calcDateTimes [m] = inputs [which].pointAt (inputs [which].next).datetime;
+         this->calcTimes [m] = t;
+
+         bool isValid = true;
+         int worst = 0;        // 0 => no alarm, 1 => minor, 2 => major
+         QCaAlarmInfo alarm;
+
+         for (int k = 0; k < numberOfInputs; k++) {
+            CalculationInput& input = inputs [k];
+            while ((input.next < input.count ()) && (input.timeAt (input.next) <= t)) {
+               input.hold (input.next);
+               input.next++;
+            }
+
+            if (!input.isHeld || !input.isDisplayable) {
+               isValid = false;     // no value yet or invalid value
+               continue;
+            }
+
+            this->calcArguments [input.argument][m] = input.value;
+
+            const int rank = input.alarm.isMajor () ? 2 : (input.alarm.isMinor () ? 1 : 0);
+            if (rank > worst) {
+               worst = rank;
+               alarm = input.alarm;
             }
          }
+
+         this->calcValid [m] = isValid;
+         this->calcAlarms [m] = isValid ? alarm : invalidAlarm;
+         m++;
       }
 
-      // and replot the data
+      if (m == 0) break;
+
+      // Evaluate the whole chunk of columns in one go.
       //
-      this->chart->setReplotIsRequired ();
+      this->calculator->evaluateArray (userArguments, arrayArguments, m, this->calcResults);
 
-   } else {
-      DEBUG << "wrong item and/or data response not okay";
+      for (int c = 0; c < m; c++) {
+         QCaDataPoint point;
+         point.value = this->calcValid [c] ? this->calcResults [c] : 0.0;
+         point.datetime = this->calcDateTimes [c];
+         point.alarm = this->calcAlarms [c];
+
+         if (this->calcTimes [c] < this->calcSplitTime) {
+            this->historicalTimeDataPoints.append (point);
+         } else {
+            this->realTimeDataPoints.append (point);
+         }
+      }
+
+      this->calcLastTime = this->calcTimes [m - 1];
+      appended = true;
+   }
+
+   // All input points have now been merged.
+   //
+   for (int k = 0; k < numberOfInputs; k++) {
+      const CalculationInput& input = inputs [k];
+      this->calcMerged [2 * k] = input.historical->getAppendCount ();
+      this->calcMerged [2 * k + 1] = input.realTime->getAppendCount ();
+      this->calcTruncations [2 * k] = input.historical->getTruncations ();
+      this->calcTruncations [2 * k + 1] = input.realTime->getTruncations ();
+   }
+
+   if (appended) {
+      const QCaDataPoint last = (this->realTimeDataPoints.count () > 0) ?
+                                 this->realTimeDataPoints.last () :
+                                 this->historicalTimeDataPoints.last ();
+      this->caLabel->setText (last.isDisplayable () ? QString::number (last.value, 'g', 6) : "-");
    }
 }
 
+//------------------------------------------------------------------------------
+//
+void QEStripChartItem::archiveDataChanged ()
+{
+   // More tiles have arrived from the archive - re-splice and replot the data.
+   //
+   this->setHistoricalData (this->archiveCache.getData ());
+   this->chart->setRecalcIsRequired ();     // for any dependent calculations
+   this->chart->setReplotIsRequired ();
+}
+
 //------------------------------------------------------------------------------
 //
 void QEStripChartItem::readArchive ()
 {
+   // Calculations are derived from the (archive) data of their inputs.
+   //
+   if (this->isCalculation ()) {
+      this->chart->setRecalcIsRequired ();
+      return;
+   }
+
    const QDateTime startDateTime = this->chart->getStartDateTime ();
    const QDateTime endDateTime   = this->chart->getEndDateTime ();
 
    // Assign the chart widget message source id the the associated archive access object.
    // We re-assign just before each read in case it has changed.
    //
-   this->archiveAccess.setMessageSourceId (this->chart->getMessageSourceId ());
+   this->archiveCache.setMessageSourceId (this->chart->getMessageSourceId ());
 
-   this->archiveAccess.readArchive
-         (this, this->getPvName (),  startDateTime, endDateTime,
-          4000, this->archiveReadHow, 0);
+   // Only tiles not already held (or which may be incomplete) are read from
+   // the archive. Any held tiles are displayed straight away.
+   //
+   this->archiveCache.setPvName (this->getPvName ());
+   this->archiveCache.setHow (this->archiveReadHow);
+   this->archiveCache.setWindow (startDateTime, endDateTime, true);
+
+   this->setHistoricalData (this->archiveCache.getData ());
+   this->chart->setRecalcIsRequired ();     // for any dependent calculations
+   this->chart->setReplotIsRequired ();
 }
 
 //------------------------------------------------------------------------------
@@ -1049,12 +1387,11 @@ void QEStripChartItem::generateStatistics ()
 {
    qcaobject::QCaObject* qca = this->getQcaItem ();
    QString egu = qca ? qca->getEgu() : "";
-   QCaDataPointList dataPoints = this->determinePlotPoints ();
    QEStripChartStatistics* pvStatistics;
 
    // Create new statistic widget.
    //
-   pvStatistics = new QEStripChartStatistics (this->getPvName (), egu, dataPoints, this, NULL);
+   pvStatistics = new QEStripChartStatistics (this->getPvName (), egu, this, NULL);
 
    // Scale statistics widget to current application scaling.
    //
@@ -1133,6 +1470,7 @@ void QEStripChartItem::contextMenuRequested (const QPoint & pos)
 void QEStripChartItem::contextMenuSelected (const QEStripChartNames::ContextMenuOptions option)
 {
    QEDisplayRanges range;
+   QCaDataPoint point;
    double min, max;
    double midway;
    bool status;
@@ -1224,9 +1562,9 @@ void QEStripChartItem::contextMenuSelected (const QEStripChartNames::ContextMenu
          break;
 
       case QEStripChartNames::SCCM_SCALE_PV_CENTRE:
-         if (this->firstPointIsDefined) {
+         if (this->getFirstPlottedPoint (point)) {
             midway = (chart->getYMinimum () + this->chart->getYMaximum () ) / 2.0;
-            this->scaling.set (this->firstPoint.value, 1.0, midway);
+            this->scaling.set (point.value, 1.0, midway);
             this->setCaption ();
             this->chart->setReplotIsRequired ();
          }
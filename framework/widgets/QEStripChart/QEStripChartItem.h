@@ -55,7 +55,9 @@
 #include "QEStripChart.h"
 #include "QEStripChartNames.h"
 #include "QEStripChartAdjustPVDialog.h"
+#include "QEStripChartArchiveCache.h"
 #include "QEStripChartContextMenu.h"
+#include "QEStripChartDataBuffer.h"
 #include "QEStripChartUtilities.h"
 
 //==============================================================================
@@ -100,10 +102,31 @@ public:
    QEDisplayRanges getBufferedMinMax (bool doScale);    // returns range of values that could be plotted
    QCaDataPointList determinePlotPoints ();
 
+   // Statistics of the data within the current chart time window, combining the
+   // historical and real time data. Also returns the window and total number of
+   // points (displayable or not) within the window.
+   //
+   QEStripChartDataBuffer::Summary getStatistics (QCaDateTime& startTime,
+                                                  QCaDateTime& endTime,
+                                                  int& numberOfPoints) const;
+
    void readArchive ();
    void normalise ();
 
-   void plotData ();
+   // For calculation items, (re)calculates the historical and real time data from
+   // the data of the input items, i.e. A is slot 0, B is slot 1 etc. Inputs must
+   // be earlier slots. Only input points not yet merged are processed unless an
+   // input's data has been cleared or replaced. If any such point is not newer
+   // than the last calculated point, e.g. one input's update arrived after
+   // another's later update, the calculated points from that point's time on are
+   // discarded and calculated again.
+   //
+   void calculateData ();
+
+   // When isIncremental is true, only points added since the previous call are
+   // processed - used for real time updates. Otherwise the curves are rebuilt.
+   //
+   void plotData (const bool isIncremental = false);
 
    void saveConfiguration (PMElement & parentElement);
    void restoreConfiguration (PMElement & parentElement);
@@ -125,14 +148,18 @@ private:
    void highLight (bool isHigh);
 
    QPen getPen ();
-   void plotDataPoints (const QCaDataPointList& dataPoints,
+   void plotDataPoints (const QEStripChartDataBuffer& dataPoints,
+                        QEStripChartCurveCache& curves,
                         const bool isRealTime,
-                        QEDisplayRanges& plottedTrackRange);
+                        const bool isIncremental);
+   bool getFirstPlottedPoint (QCaDataPoint& point) const;
 
    // Perform a pvNameDropEvent 'drop'.
    //
    void pvNameDropEvent (QDropEvent *event);
 
+   void setHistoricalData (const QCaDataPointList& archiveData);
+
    void writeTraceToFile ();
    void generateStatistics ();
 
@@ -147,16 +174,14 @@ private:
    QColor colour;
    ValueScaling scaling;
 
-   QCaDataPointList historicalTimeDataPoints;
-   QCaDataPointList realTimeDataPoints;
-   QEDisplayRanges historicalMinMax;
-   QEDisplayRanges realTimeMinMax;
+   QEStripChartDataBuffer historicalTimeDataPoints;
+   QEStripChartDataBuffer realTimeDataPoints;
 
-   bool firstPointIsDefined;
-   QCaDataPoint firstPoint;
+   QEStripChartCurveCache historicalCurves;
+   QEStripChartCurveCache realTimeCurves;
    QEDisplayRanges displayedMinMax;
 
-   QEArchiveAccess archiveAccess;
+   QEStripChartArchiveCache archiveCache;
 
    QEStripChartAdjustPVDialog *adjustPVDialog;
 
@@ -169,6 +194,23 @@ private:
    bool expressionIsValid;
    QEExpressionEvaluation* calculator;
 
+   // Calculation state - see calculateData.
+   //
+   QVector<int> calcGenerations;  // input identities and buffer generations
+   double calcSplitTime;          // calculated points before this time are historical
+   double calcLastTime;           // time of the last calculated point
+   QVector<qint64> calcMerged;    // input buffer append counts merged, historical then real time
+   QVector<int> calcTruncations;  // input buffer truncations processed, historical then real time
+
+   // Calculation column buffers, re-used from one call to the next.
+   //
+   QVector<double> calcTimes;
+   QVector<QCaDateTime> calcDateTimes;
+   QVector<QCaAlarmInfo> calcAlarms;
+   QVector<bool> calcValid;
+   QVector<double> calcResults;
+   QVector<double> calcArguments [QEStripChart::NUMBER_OF_PVS];
+
    // Internal widgets.
    //
    QEStripChart *chart;
@@ -192,7 +234,7 @@ private slots:
    void setDataConnection (QCaConnectionInfo& connectionInfo, const unsigned int& variableIndex);
    void setDataValue (const QVariant& value, QCaAlarmInfo& alarm, QCaDateTime& datetime, const unsigned int& variableIndex);
 
-   void setArchiveData (const QObject *userData, const bool okay, const QCaDataPointList &archiveData);
+   void archiveDataChanged ();
 
    void letterButtonClicked (bool checked);
    void contextMenuRequested (const QPoint & pos);
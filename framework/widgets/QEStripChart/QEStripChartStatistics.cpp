@@ -38,7 +38,6 @@
 //
 QEStripChartStatistics::QEStripChartStatistics (const QString& pvNameIn,
                                                 const QString& eguIn,
-                                                const QCaDataPointList& dataList,
                                                 QEStripChartItem* ownerIn,
                                                 QWidget *parent) :
    QWidget (parent),
@@ -53,154 +52,103 @@ QEStripChartStatistics::QEStripChartStatistics (const QString& pvNameIn,
    QObject::connect (this->ui->updateButton, SIGNAL (clicked       (bool)),
                      this,                   SLOT   (updateClicked (bool)));
 
-   this->processDataList (dataList);
+   // The statistics are maintained incrementally by the item's data buffers,
+   // so are cheap to re-evaluate - keep them live.
+   //
+   this->updateTimer = new QTimer (this);
+   QObject::connect (this->updateTimer, SIGNAL (timeout       ()),
+                     this,              SLOT   (updateTimeout ()));
+   this->updateTimer->start (1000);
+
+   this->processStatistics ();
 }
 
 //------------------------------------------------------------------------------
 //
 void QEStripChartStatistics::updateClicked (bool)
 {
-   if (this->owner) {
-      processDataList (this->owner->determinePlotPoints ());
+   this->processStatistics ();
+}
+
+//------------------------------------------------------------------------------
+//
+void QEStripChartStatistics::updateTimeout ()
+{
+   if (this->isVisible ()) {
+      this->processStatistics ();
    }
 }
 
 //------------------------------------------------------------------------------
 //
-void QEStripChartStatistics::processDataList (const QCaDataPointList& dataList)
+void QEStripChartStatistics::processStatistics ()
 {
    // Do stats - populate fields.
    // This form is not directly EPICS aware. Can use a basic form.
    //
-   const int n = dataList.count ();
-
    this->clearLabels ();
 
    this->ui->pvNameLabel->setText (pvName);
-   this->ui->numberOfPointsLabel->setText (QString ("%1").arg (n));
 
-   if (n <= 0) return;
+   if (!this->owner) return;
 
    QCaDateTime startTime;
    QCaDateTime endTime;
+   int n;
+
+   const QEStripChartDataBuffer::Summary summary =
+         this->owner->getStatistics (startTime, endTime, n);
+
+   this->ui->numberOfPointsLabel->setText (QString ("%1").arg (n));
+
    QString format ("yyyy-MM-dd hh:mm:ss");
 
-   startTime = dataList.value (0).datetime;
    this->ui->startTimeLabel->setText (startTime.toString (format) + "  " + QEUtilities::getTimeZoneTLA (startTime));
-
-   endTime = dataList.value (n - 1).datetime;
    this->ui->endTimeLabel->setText (endTime.toString (format) + "  " + QEUtilities::getTimeZoneTLA (endTime));
 
    double duration = startTime.secondsTo (endTime);
 
    this->ui->durationLabel->setText (QEUtilities::intervalToString (duration, 0, true));
 
-   int validCount = 0;
-   double minimum = +9.99E+99;
-   double maximum = -9.99E+99;
-   double initialValue = 0.0;
-   double finalValue = 0.0;
-
-   double sumWeight = 0.0;
-   double sumValue = 0.0;
-   double sumValueSquared = 0.0;
-
-   double sumX = 0.0;     // X here is time - relative to first time.
-   double sumY = 0.0;
-   double sumXX = 0.0;
-   double sumXY = 0.0;
-
-   for (int j = 0; j < n; j++) {
-      QCaDataPoint point = dataList.value (j);
-
-      if (point.isDisplayable()) {
-         validCount++;
-
-         minimum = MIN (minimum, point.value);
-         maximum = MAX (maximum, point.value);
-
-         if (validCount == 1) {
-            // Save first point value.
-            //
-            initialValue = point.value;
-         }
-
-         // This may be the last valid point - keep it.
-         //
-         finalValue = point.value;
-
-         // Values are time weighed - determine weight.
-         //
-         double weight;
-         if (j < (n - 1)) {
-            // This is not the last point - use the duration from this
-            // point to the next point as the weight.
-            //
-            QCaDateTime nextTime = dataList.value (j + 1).datetime;
-            weight = point.datetime.secondsTo (nextTime);
-
-         } else {
-            // There is no next point - use an arbitary weight.
-            //
-            weight = 1.0;
-         }
-
-         sumWeight += weight;
-         sumValue += point.value * weight;
-         sumValueSquared += point.value * point.value * weight;
-
-         // Least squares.
-         // For x, use time from first point.
-         //
-         double x = startTime.secondsTo (point.datetime);
-
-         sumX += x;
-         sumY += point.value;
-         sumXX += x * x;
-         sumXY += x * point.value;
-      }
-   }
+   const int validCount = summary.number;
 
    this->ui->validPointsLabel->setText (QString ("%1").arg (validCount));
 
    // Can we do any sensible stats?
    //
    if (validCount > 0) {
-      // Yes - let's do some sums.
+      // Yes - values are time weighted, i.e. sample and hold.
+      // If no time has elapsed, fall back to the simple mean.
       //
-      // Avoid the divide by zero.
-      //
-      sumWeight = MAX (1.0E-8, sumWeight);
-
-      double mean = sumValue / sumWeight;
-
-      // Variance:  mean (x^2) - mean (x)^2
-      //
-      double variance = (sumValueSquared / sumWeight) - (mean * mean);
-      double stdDev = sqrt (variance);
+      double mean = summary.meanValue;
+      double variance = 0.0;
+      if (summary.weight > 0.0) {
+         mean = summary.weightedMean;
+         variance = summary.weightedM2 / summary.weight;
+      }
+      double stdDev = sqrt (MAX (0.0, variance));
 
       // Least Squares
       //
       double slope = 0.0;
-      if (validCount >= 2) {
-         double delta = (validCount * sumXX) - (sumX * sumX);
-         slope = ((validCount * sumXY) - (sumX * sumY)) / delta;
+      if ((validCount >= 2) && (summary.m2Time > 0.0)) {
+         slope = summary.coMoment / summary.m2Time;
       }
 
-      // Recall sumValue += (value * weight);, and weight in seconds.
+      // Weight in seconds.
       //
-      double integral = sumValue;
+      double integral = summary.weightedMean * summary.weight;
 
       // Populate form fields.
       //
       const QString units = egu.isEmpty() ? "" : " " + egu;
 
       this->ui->meanLabel->setText (QString ("%1%2").arg (mean).arg (units));
-      this->ui->minimumLabel->setText (QString ("%1%2").arg (minimum).arg (units));
-      this->ui->maximumLabel->setText (QString ("%1%2").arg (maximum).arg (units));
-      this->ui->minMaxDiffLabel->setText (QString ("%1%2").arg (maximum - minimum).arg (units));
+      this->ui->minimumLabel->setText (QString ("%1%2").arg (summary.minimum).arg (units));
+      this->ui->maximumLabel->setText (QString ("%1%2").arg (summary.maximum).arg (units));
+      this->ui->minMaxDiffLabel->setText (QString ("%1%2").arg (summary.maximum - summary.minimum).arg (units));
 
-      this->ui->firstLastDiffLabel->setText (QString ("%1%2").arg (finalValue - initialValue).arg (units));
+      this->ui->firstLastDiffLabel->setText (QString ("%1%2").arg (summary.lastValue - summary.firstValue).arg (units));
       this->ui->standardDeviationLabel->setText (QString ("%1%2").arg (stdDev).arg (units));
       this->ui->meanRateOfChangeLabel->setText (QString ("%1%2/sec").arg (slope).arg (units));
       this->ui->areaUnderCurveLabel->setText (QString ("%1%2-sec").arg (integral).arg (units));
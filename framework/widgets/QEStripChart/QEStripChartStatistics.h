@@ -28,7 +28,9 @@
 #ifndef QESTRIPCHARTSTATISTICS_H
 #define QESTRIPCHARTSTATISTICS_H
 
+#include <QPointer>
 #include <QString>
+#include <QTimer>
 #include <QWidget>
 #include <QCaDataPoint.h>
 
@@ -38,6 +40,9 @@ class QEStripChartStatistics;
 
 class QEStripChartItem;
 
+// Displays the statistics of a strip chart item's data over the current chart
+// time window. The statistics are updated once a second while displayed.
+//
 class QEStripChartStatistics : public QWidget
 {
    Q_OBJECT
@@ -45,21 +50,22 @@ class QEStripChartStatistics : public QWidget
 public:
    explicit QEStripChartStatistics (const QString& pvName,
                                     const QString& egu,
-                                    const QCaDataPointList& dataList,
                                     QEStripChartItem* owner,
                                     QWidget *parent = 0);
    ~QEStripChartStatistics();
    
 private:
-   void processDataList (const QCaDataPointList& dataList);
+   void processStatistics ();
    void clearLabels ();
    Ui::QEStripChartStatistics *ui;
-   QEStripChartItem* owner;
+   QPointer<QEStripChartItem> owner;    // guard against item deletion
+   QTimer* updateTimer;
    QString pvName;
    QString egu;
 
 private slots:
    void updateClicked (bool);
+   void updateTimeout ();
 
 };
 
@@ -0,0 +1,222 @@
+/*  QEExpressionBenchmark.cpp
+ *
+ *  This file is part of the EPICS QT Framework, initially developed at the
+ *  Australian Synchrotron.
+ *
+ *  The EPICS QT Framework is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  The EPICS QT Framework is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the EPICS QT Framework.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright (c) 2026 Australian Synchrotron
+ *
+ *  Author:
+ *    QE Framework developers
+ *  Contact details:
+ *    http://sourceforge.net/projects/epicsqt/
+ */
+
+// Times QEExpressionEvaluation::evaluate called per element against
+// QEExpressionEvaluation::evaluateArray, and checks that the results are
+// bit for bit identical (any NaN matching any NaN, as per verifyByteCode).
+//
+// usage: qeexpressionbenchmark [number_of_elements [repeats]]
+//
+// Exit status is 0 if all results match, otherwise 1.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+#include <QEExpressionEvaluation.h>
+
+// Expressions using the byte code and, last, ones that fall back to calcPerform.
+//
+static const char* expressionList [] = {
+   "A + B",
+   "A * B + C",
+   "(A - B) / (C + 1)",
+   "A ** 2 + SQRT (ABS (B))",
+   "SIN (A) * COS (B) + LN (ABS (C) + 1)",
+   "-A + B' * 1.5E-3",
+   "A > B ? A : B",
+   "MAX (A, B, C)"
+};
+
+//------------------------------------------------------------------------------
+// Deterministic pseudo random numbers in [0, 1), so that runs are comparable.
+//
+static double nextRandom (unsigned int& seed)
+{
+   seed = seed * 1103515245u + 12345u;
+   return (double) ((seed >> 8) & 0xFFFFFF) / (double) 0x1000000;
+}
+
+//------------------------------------------------------------------------------
+// Waveform like data - a noisy sine wave (period about 1000 elements), a ramp
+// or wide band noise, plus a few special values (zero, negative zero, infinities,
+// NaN and denormals) as found in real waveforms from disconnected or saturated
+// channels.
+//
+static QVector<double> makeArray (const int number, const int kind, unsigned int& seed)
+{
+   QVector<double> result (number);
+
+   for (int j = 0; j < number; j++) {
+      const double noise = nextRandom (seed) - 0.5;
+      double value;
+
+      switch (kind) {
+         case 0:
+            value = 10.0 * sin (j / 159.15494) + noise;
+            break;
+         case 1:
+            value = -50.0 + 100.0 * j / (double) number + 0.01 * noise;
+            break;
+         default:
+            value = 1.0E6 * noise;
+            break;
+      }
+      result [j] = value;
+   }
+
+   static const double specials [] = {
+      0.0, -0.0, 1.0, -1.0, HUGE_VAL, -HUGE_VAL, NAN, 4.9E-324, 1.0E308, -1.0E308
+   };
+   const int numberSpecials = sizeof (specials) / sizeof (specials [0]);
+
+   for (int j = kind; j < number; j += 997) {
+      result [j] = specials [(j / 997) % numberSpecials];
+   }
+
+   return result;
+}
+
+//------------------------------------------------------------------------------
+//
+static bool isSame (const double a, const double b)
+{
+   return (memcmp (&a, &b, sizeof (double)) == 0) || ((a != a) && (b != b));
+}
+
+//------------------------------------------------------------------------------
+//
+int main (int argc, char* argv [])
+{
+   QCoreApplication app (argc, argv);
+
+   const int number = (argc >= 2) ? atoi (argv [1]) : 1000000;
+   const int repeats = (argc >= 3) ? atoi (argv [2]) : 5;
+
+   if ((number <= 0) || (repeats <= 0)) {
+      fprintf (stderr, "usage: %s [number_of_elements [repeats]]\n", argv [0]);
+      return 2;
+   }
+
+   // B is deliberately shorter than the other arrays, so that the scalar
+   // value is used for the remaining elements.
+   //
+   unsigned int seed = 12345;
+   const QVector<double> a = makeArray (number, 0, seed);
+   const QVector<double> b = makeArray (number - number / 10, 1, seed);
+   const QVector<double> c = makeArray (number, 2, seed);
+
+   QEExpressionEvaluation::CalculateArguments userArgs;
+   QEExpressionEvaluation::CalculateArrayArguments arrayArgs;
+
+   QEExpressionEvaluation::clear (userArgs);
+   QEExpressionEvaluation::clear (arrayArgs);
+
+   userArgs [QEExpressionEvaluation::Normal][1] = 7.25;     // B beyond its array
+   userArgs [QEExpressionEvaluation::Primed][1] = -3.5;     // B' scalar only
+   arrayArgs [QEExpressionEvaluation::Normal][0] = &a;
+   arrayArgs [QEExpressionEvaluation::Normal][1] = &b;
+   arrayArgs [QEExpressionEvaluation::Normal][2] = &c;
+
+   const int numberExpressions = sizeof (expressionList) / sizeof (expressionList [0]);
+   bool allSame = true;
+
+   printf ("%d elements, best of %d runs\n\n", number, repeats);
+   printf ("%-40s %12s %12s %8s  %s\n", "expression", "evaluate", "array", "speedup", "check");
+
+   for (int e = 0; e < numberExpressions; e++) {
+      QEExpressionEvaluation calculator;
+
+      if (!calculator.initialise (expressionList [e])) {
+         printf ("%-40s %s\n", expressionList [e],
+                 calculator.getCalcError ().toLatin1 ().constData ());
+         allSame = false;
+         continue;
+      }
+
+      QVector<double> expected (number);
+      QVector<double> actual;
+      qint64 bestElement = -1;
+      qint64 bestArray = -1;
+      QElapsedTimer timer;
+
+      for (int r = 0; r < repeats; r++) {
+         // Per element evaluate, as used before evaluateArray.
+         //
+         QEExpressionEvaluation::CalculateArguments elementArgs;
+         memcpy (elementArgs, userArgs, sizeof (elementArgs));
+
+         timer.start ();
+         for (int j = 0; j < number; j++) {
+            for (int k = 0; k < 3; k++) {
+               const QVector<double>* array = arrayArgs [QEExpressionEvaluation::Normal][k];
+               elementArgs [QEExpressionEvaluation::Normal][k] =
+                     (j < array->count ()) ? array->at (j) : userArgs [QEExpressionEvaluation::Normal][k];
+            }
+            expected [j] = calculator.evaluate (elementArgs);
+         }
+         qint64 elapsed = timer.nsecsElapsed ();
+         if ((bestElement < 0) || (elapsed < bestElement)) bestElement = elapsed;
+
+         timer.start ();
+         calculator.evaluateArray (userArgs, arrayArgs, number, actual);
+         elapsed = timer.nsecsElapsed ();
+         if ((bestArray < 0) || (elapsed < bestArray)) bestArray = elapsed;
+      }
+
+      int mismatch = -1;
+      for (int j = 0; j < number; j++) {
+         if (!isSame (expected.at (j), actual.at (j))) {
+            mismatch = j;
+            break;
+         }
+      }
+
+      QString check = "identical";
+      if (mismatch >= 0) {
+         check = QString ("MISMATCH at %1: %2 != %3").arg (mismatch)
+               .arg (expected.at (mismatch), 0, 'g', 17)
+               .arg (actual.at (mismatch), 0, 'g', 17);
+         allSame = false;
+      }
+
+      printf ("%-40s %9.3f ms %9.3f ms %7.1fx  %s\n", expressionList [e],
+              bestElement * 1.0E-6, bestArray * 1.0E-6,
+              (double) bestElement / (double) qMax (bestArray, (qint64) 1),
+              check.toLatin1 ().constData ());
+   }
+
+   return allSame ? 0 : 1;
+}
+
+// end
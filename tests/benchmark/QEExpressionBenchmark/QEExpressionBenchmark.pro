@@ -0,0 +1,65 @@
+# This file is part of the EPICS QT Framework, initially developed at the Australian Synchrotron.
+# The EPICS QT Framework is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+# The EPICS QT Framework is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+# You should have received a copy of the GNU Lesser General Public License
+# along with the EPICS QT Framework. If not, see <http://www.gnu.org/licenses/>.
+# Copyright (c) 2026 Australian Synchrotron
+# Author:
+# QE Framework developers
+# Contact details:
+# http://sourceforge.net/projects/epicsqt/
+
+# Stand alone benchmark for QEExpressionEvaluation::evaluateArray.
+# This is not part of the epicsqt.pro build - build the framework first, then
+# run qmake and make in this directory, and run bin/qeexpressionbenchmark.
+
+QT -= gui
+
+TARGET = qeexpressionbenchmark
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+
+# Place all intermediate generated files in architecture specific directories
+#
+MOC_DIR        = O.$$(EPICS_HOST_ARCH)/moc
+OBJECTS_DIR    = O.$$(EPICS_HOST_ARCH)/obj
+RCC_DIR        = O.$$(EPICS_HOST_ARCH)/rcc
+
+# Determine EPICS_BASE
+_QE_EPICS_BASE = $$(QE_EPICS_BASE)
+isEmpty( _QE_EPICS_BASE ) {
+    _QE_EPICS_BASE = $$(EPICS_BASE)
+    message( QE_EPICS_BASE is not defined. Using EPICS_BASE instead - currently $$_QE_EPICS_BASE )
+}
+
+# Check EPICS dependancies
+isEmpty( _QE_EPICS_BASE ) {
+    error( "EPICS_BASE or QE_EPICS_BASE must be defined. Ensure EPICS is installed and EPICS_BASE or QE_EPICS_BASE is set up." )
+}
+_EPICS_HOST_ARCH = $$(EPICS_HOST_ARCH)
+isEmpty( _EPICS_HOST_ARCH ) {
+    error( "EPICS_HOST_ARCH must be defined. Ensure EPICS is installed and EPICS_HOST_ARCH is set up." )
+}
+
+DESTDIR = bin
+
+#===========================================================
+# Project files
+#
+SOURCES += \
+   ./QEExpressionBenchmark.cpp
+
+INCLUDEPATH += . \
+   ../../../framework/common \
+   ../../../framework/widgets/QEWidget
+
+LIBS += -L../../../framework/designer -lQEPlugin
+LIBS += -L$$_QE_EPICS_BASE/lib/$$(EPICS_HOST_ARCH) -lca -lCom
+# end